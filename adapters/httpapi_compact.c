@@ -15,6 +15,7 @@
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/http_response_parser.h"
 
 #ifdef _MSC_VER
 #define snprintf _snprintf
@@ -104,74 +105,6 @@ static int ParseStringToHexadecimal(const char *src, size_t* dst)
     return result;
 }
 
-/*the following function does the same as sscanf(buf, "HTTP/%*d.%*d %d %*[^\r\n]", &ret) */
-/*this function only exists because some of platforms do not have sscanf. This is not a full implementation; it only works with well-defined HTTP response. */
-static int  ParseHttpResponse(const char* src, int* dst)
-{
-    int result;
-    static const char HTTPPrefix[] = "HTTP/";
-    bool fail;
-    const char* runPrefix;
-
-    if ((src == NULL) || (dst == NULL))
-    {
-        result = EOF;
-    }
-    else
-    {
-        fail = false;
-        runPrefix = HTTPPrefix;
-
-        while((*runPrefix) != '\0')
-        {
-            if ((*runPrefix) != (*src))
-            {
-                fail = true;
-                break;
-            }
-            src++;
-            runPrefix++;
-        }
-
-        if (!fail)
-        {
-            while ((*src) != '.')
-            {
-                if ((*src) == '\0')
-                {
-                    fail = true;
-                    break;
-                }
-                src++;
-            }
-        }
-
-        if (!fail)
-        {
-            while ((*src) != ' ')
-            {
-                if ((*src) == '\0')
-                {
-                    fail = true;
-                    break;
-                }
-                src++;
-            }
-        }
-
-        if (fail)
-        {
-            result = EOF;
-        }
-        else
-        {
-            result = ParseStringToDecimal(src, dst);
-        }
-    }
-
-    return result;
-}
-
 HTTPAPI_RESULT HTTPAPI_Init(void)
 {
 /*Codes_SRS_HTTPAPI_COMPACT_21_004: [ The HTTPAPI_Init shall allocate all memory to control the http protocol. ]*/
@@ -908,7 +841,7 @@ static HTTPAPI_RESULT ReceiveHeaderFromXIO(HTTP_HANDLE_DATA* http_instance, unsi
         result = HTTPAPI_READ_DATA_FAILED;
     }
     //Parse HTTP response
-    else if (ParseHttpResponse(buf, &ret) != 1)
+    else if (http_response_parser_parse_status_line(buf, strlen(buf), &ret) != 0)
     {
         //Cannot match string, error
         /*Codes_SRS_HTTPAPI_COMPACT_21_055: [ If the HTTPAPI_ExecuteRequest cannot parser the received message, it shall return HTTPAPI_RECEIVE_RESPONSE_FAILED. ]*/
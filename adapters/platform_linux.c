@@ -4,6 +4,7 @@
 #include "azure_c_shared_utility/platform.h"
 #include "azure_c_shared_utility/xio.h"
 #include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/optimize_size.h"
 #ifdef USE_OPENSSL
 #include "azure_c_shared_utility/tlsio_openssl.h"
 #endif
@@ -13,6 +14,9 @@
 #if USE_WOLFSSL
 #include "azure_c_shared_utility/tlsio_wolfssl.h"
 #endif
+#ifdef USE_EPOLL_REACTOR
+#include "azure_c_shared_utility/socket_reactor.h"
+#endif
 
 #include <stdlib.h>
 #include <unistd.h>
@@ -25,6 +29,16 @@ int platform_init(void)
     result = tlsio_openssl_init();
 #else
     result = 0;
+#endif
+#ifdef USE_EPOLL_REACTOR
+    if (result == 0 && socket_reactor_init() != 0)
+    {
+        LogError("Failed initializing the socket reactor.");
+#ifdef USE_OPENSSL
+        tlsio_openssl_deinit();
+#endif
+        result = __FAILURE__;
+    }
 #endif
     return result;
 }
@@ -62,6 +76,9 @@ STRING_HANDLE platform_get_platform_info(void)
 
 void platform_deinit(void)
 {
+#ifdef USE_EPOLL_REACTOR
+    socket_reactor_deinit();
+#endif
 #ifdef USE_OPENSSL
     tlsio_openssl_deinit();
 #endif
@@ -0,0 +1,316 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/socket_reactor.h"
+
+#define INVALID_EPOLL_FD               -1
+
+#ifndef SOCKET_REACTOR_MAX_EVENTS
+#define SOCKET_REACTOR_MAX_EVENTS      1024
+#endif
+
+typedef struct SOCKET_REACTOR_ENTRY_TAG
+{
+    int socket;
+    unsigned long visited_generation;
+    unsigned long readable_generation;
+    unsigned long writable_generation;
+    bool is_write_interested;
+} SOCKET_REACTOR_ENTRY;
+
+typedef struct SOCKET_REACTOR_TAG
+{
+    int epoll_fd;
+    LOCK_HANDLE lock;
+    unsigned long poll_generation;
+    bool poll_failed;
+} SOCKET_REACTOR;
+
+static SOCKET_REACTOR reactor = { INVALID_EPOLL_FD, NULL, 0, false };
+static struct epoll_event poll_events[SOCKET_REACTOR_MAX_EVENTS];
+
+/* the reactor is level triggered, so a socket that was not drained is simply reported again by the next poll */
+static void poll_sockets(void)
+{
+    int event_count = epoll_wait(reactor.epoll_fd, poll_events, SOCKET_REACTOR_MAX_EVENTS, 0);
+
+    reactor.poll_generation++;
+
+    if (event_count < 0)
+    {
+        if (errno != EINTR)
+        {
+            LogError("epoll_wait failed, errno=%d.", errno);
+        }
+
+        /* let every socket be read directly until the next successful poll */
+        reactor.poll_failed = true;
+    }
+    else
+    {
+        int i;
+
+        reactor.poll_failed = false;
+
+        for (i = 0; i < event_count; i++)
+        {
+            SOCKET_REACTOR_ENTRY* entry = (SOCKET_REACTOR_ENTRY*)poll_events[i].data.ptr;
+
+            if ((poll_events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) != 0)
+            {
+                entry->readable_generation = reactor.poll_generation;
+            }
+
+            /* errors and hangups are reported as writable too so that a pending send fails instead of waiting forever */
+            if ((poll_events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0)
+            {
+                entry->writable_generation = reactor.poll_generation;
+            }
+        }
+    }
+}
+
+int socket_reactor_init(void)
+{
+    int result;
+
+    if (reactor.epoll_fd != INVALID_EPOLL_FD)
+    {
+        result = 0;
+    }
+    else if ((reactor.lock = Lock_Init()) == NULL)
+    {
+        LogError("Failed creating the socket reactor lock.");
+        result = __FAILURE__;
+    }
+    else if ((reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == INVALID_EPOLL_FD)
+    {
+        LogError("epoll_create1 failed, errno=%d.", errno);
+        (void)Lock_Deinit(reactor.lock);
+        reactor.lock = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        reactor.poll_generation = 0;
+        reactor.poll_failed = false;
+        result = 0;
+    }
+
+    return result;
+}
+
+void socket_reactor_deinit(void)
+{
+    if (reactor.epoll_fd != INVALID_EPOLL_FD)
+    {
+        (void)close(reactor.epoll_fd);
+        reactor.epoll_fd = INVALID_EPOLL_FD;
+    }
+
+    if (reactor.lock != NULL)
+    {
+        (void)Lock_Deinit(reactor.lock);
+        reactor.lock = NULL;
+    }
+}
+
+SOCKET_REACTOR_ENTRY_HANDLE socket_reactor_register(int sock)
+{
+    SOCKET_REACTOR_ENTRY* result;
+
+    if (sock < 0)
+    {
+        LogError("Invalid argument: sock=%d.", sock);
+        result = NULL;
+    }
+    else if (reactor.epoll_fd == INVALID_EPOLL_FD)
+    {
+        /* reactor not running, the caller polls the socket itself */
+        result = NULL;
+    }
+    else if ((result = (SOCKET_REACTOR_ENTRY*)malloc(sizeof(SOCKET_REACTOR_ENTRY))) == NULL)
+    {
+        LogError("Failed allocating socket reactor entry.");
+    }
+    else if (Lock(reactor.lock) != LOCK_OK)
+    {
+        LogError("Failed acquiring the socket reactor lock.");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        struct epoll_event event;
+
+        result->socket = sock;
+        /* a new entry is read once before it takes part in a poll */
+        result->visited_generation = reactor.poll_generation - 1;
+        result->readable_generation = reactor.poll_generation;
+        result->writable_generation = reactor.poll_generation;
+        result->is_write_interested = false;
+
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = result;
+
+        if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, sock, &event) != 0)
+        {
+            LogError("epoll_ctl(EPOLL_CTL_ADD) failed, errno=%d.", errno);
+            free(result);
+            result = NULL;
+        }
+
+        (void)Unlock(reactor.lock);
+    }
+
+    return result;
+}
+
+void socket_reactor_unregister(SOCKET_REACTOR_ENTRY_HANDLE entry)
+{
+    if (entry == NULL)
+    {
+        LogError("Invalid argument: entry is NULL.");
+    }
+    else
+    {
+        if (reactor.lock != NULL && Lock(reactor.lock) == LOCK_OK)
+        {
+            if (reactor.epoll_fd != INVALID_EPOLL_FD &&
+                epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, entry->socket, NULL) != 0 &&
+                errno != ENOENT)
+            {
+                LogError("epoll_ctl(EPOLL_CTL_DEL) failed, errno=%d.", errno);
+            }
+
+            (void)Unlock(reactor.lock);
+        }
+
+        free(entry);
+    }
+}
+
+bool socket_reactor_is_readable(SOCKET_REACTOR_ENTRY_HANDLE entry)
+{
+    bool result;
+
+    if (entry == NULL)
+    {
+        LogError("Invalid argument: entry is NULL.");
+        result = true;
+    }
+    else if (reactor.lock == NULL || Lock(reactor.lock) != LOCK_OK)
+    {
+        result = true;
+    }
+    else
+    {
+        if (reactor.epoll_fd == INVALID_EPOLL_FD)
+        {
+            result = true;
+        }
+        else
+        {
+            /* the entry already saw the latest poll, so a new dowork round has started */
+            if (entry->visited_generation == reactor.poll_generation)
+            {
+                poll_sockets();
+            }
+
+            entry->visited_generation = reactor.poll_generation;
+            result = reactor.poll_failed || (entry->readable_generation == reactor.poll_generation);
+        }
+
+        (void)Unlock(reactor.lock);
+    }
+
+    return result;
+}
+
+int socket_reactor_set_write_interest(SOCKET_REACTOR_ENTRY_HANDLE entry, bool is_interested)
+{
+    int result;
+
+    if (entry == NULL)
+    {
+        LogError("Invalid argument: entry is NULL.");
+        result = __FAILURE__;
+    }
+    else if (reactor.lock == NULL || Lock(reactor.lock) != LOCK_OK)
+    {
+        LogError("Failed acquiring the socket reactor lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (reactor.epoll_fd == INVALID_EPOLL_FD || entry->is_write_interested == is_interested)
+        {
+            result = 0;
+        }
+        else
+        {
+            struct epoll_event event;
+
+            event.events = EPOLLIN | EPOLLRDHUP | (is_interested ? EPOLLOUT : 0);
+            event.data.ptr = entry;
+
+            if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_MOD, entry->socket, &event) != 0)
+            {
+                LogError("epoll_ctl(EPOLL_CTL_MOD) failed, errno=%d.", errno);
+                result = __FAILURE__;
+            }
+            else
+            {
+                entry->is_write_interested = is_interested;
+                /* the socket is tried once before the first poll that watches it for writability */
+                entry->writable_generation = reactor.poll_generation;
+                result = 0;
+            }
+        }
+
+        (void)Unlock(reactor.lock);
+    }
+
+    return result;
+}
+
+bool socket_reactor_is_writable(SOCKET_REACTOR_ENTRY_HANDLE entry)
+{
+    bool result;
+
+    if (entry == NULL)
+    {
+        LogError("Invalid argument: entry is NULL.");
+        result = true;
+    }
+    else if (reactor.lock == NULL || Lock(reactor.lock) != LOCK_OK)
+    {
+        result = true;
+    }
+    else
+    {
+        if (reactor.epoll_fd == INVALID_EPOLL_FD || !entry->is_write_interested)
+        {
+            result = true;
+        }
+        else
+        {
+            /* writability is only reported by the poll issued from socket_reactor_is_readable */
+            result = reactor.poll_failed || (entry->writable_generation == reactor.poll_generation);
+        }
+
+        (void)Unlock(reactor.lock);
+    }
+
+    return result;
+}
@@ -18,6 +18,7 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
@@ -25,6 +26,8 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <sys/uio.h>
+#include <limits.h>
 #ifdef TIZENRT
 #include <net/lwip/tcp.h>
 #else
@@ -34,12 +37,19 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <time.h>
+#include "dns_async.h"
+#include "socket_async.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/optionhandler.h"
 #include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/tickcounter.h"
 #include "azure_c_shared_utility/xlogging.h"
+#ifdef USE_EPOLL_REACTOR
+#include "azure_c_shared_utility/socket_reactor.h"
+#endif
 #include <sys/ioctl.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -55,6 +65,20 @@
 // connect timeout in seconds
 #define CONNECT_TIMEOUT         10
 
+// delay before the next address is tried while earlier connect attempts are still pending (RFC 8305)
+#ifndef CONNECTION_ATTEMPT_DELAY_MS
+#define CONNECTION_ATTEMPT_DELAY_MS    250
+#endif
+
+// maximum number of pending IOs flushed by a single sendmsg
+#ifndef PENDING_IO_MAX_IOV
+#ifdef IOV_MAX
+#define PENDING_IO_MAX_IOV      IOV_MAX
+#else
+#define PENDING_IO_MAX_IOV      16
+#endif
+#endif
+
 typedef enum IO_STATE_TAG
 {
     IO_STATE_CLOSED,
@@ -66,13 +90,51 @@ typedef enum IO_STATE_TAG
 
 typedef struct PENDING_SOCKET_IO_TAG
 {
-    unsigned char* bytes;
+    const unsigned char* bytes;
     size_t size;
+    size_t offset;
+    CONSTBUFFER_HANDLE const_buffer;
     ON_SEND_COMPLETE on_send_complete;
     void* callback_context;
     SINGLYLINKEDLIST_HANDLE pending_io_list;
 } PENDING_SOCKET_IO;
 
+typedef enum SOCKET_TUNING_OPTION_INDEX_TAG
+{
+    SOCKET_TUNING_OPTION_TCP_NODELAY,
+    SOCKET_TUNING_OPTION_SO_SNDBUF,
+    SOCKET_TUNING_OPTION_SO_RCVBUF,
+    SOCKET_TUNING_OPTION_TCP_QUICKACK,
+    SOCKET_TUNING_OPTION_SO_BUSY_POLL,
+    SOCKET_TUNING_OPTION_COUNT
+} SOCKET_TUNING_OPTION_INDEX;
+
+typedef struct SOCKET_TUNING_OPTION_TAG
+{
+    const char* name;
+    int level;
+    int option_name;
+    bool is_supported;
+} SOCKET_TUNING_OPTION;
+
+/* integer socket options that are stored by setoption and applied to every socket this instance opens */
+static const SOCKET_TUNING_OPTION socket_tuning_options[SOCKET_TUNING_OPTION_COUNT] =
+{
+    [SOCKET_TUNING_OPTION_TCP_NODELAY] = { "tcp_nodelay", IPPROTO_TCP, TCP_NODELAY, true },
+    [SOCKET_TUNING_OPTION_SO_SNDBUF] = { "so_sndbuf", SOL_SOCKET, SO_SNDBUF, true },
+    [SOCKET_TUNING_OPTION_SO_RCVBUF] = { "so_rcvbuf", SOL_SOCKET, SO_RCVBUF, true },
+#ifdef TCP_QUICKACK
+    [SOCKET_TUNING_OPTION_TCP_QUICKACK] = { "tcp_quickack", IPPROTO_TCP, TCP_QUICKACK, true },
+#else
+    [SOCKET_TUNING_OPTION_TCP_QUICKACK] = { "tcp_quickack", IPPROTO_TCP, 0, false },
+#endif
+#ifdef SO_BUSY_POLL
+    [SOCKET_TUNING_OPTION_SO_BUSY_POLL] = { "so_busy_poll", SOL_SOCKET, SO_BUSY_POLL, true }
+#else
+    [SOCKET_TUNING_OPTION_SO_BUSY_POLL] = { "so_busy_poll", SOL_SOCKET, 0, false }
+#endif
+};
+
 typedef struct SOCKET_IO_INSTANCE_TAG
 {
     int socket;
@@ -85,7 +147,31 @@ typedef struct SOCKET_IO_INSTANCE_TAG
     char* target_mac_address;
     IO_STATE io_state;
     SINGLYLINKEDLIST_HANDLE pending_io_list;
-    unsigned char recv_bytes[RECEIVE_BYTES_VALUE];
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    DNS_ASYNC_HANDLE dns;
+    TICK_COUNTER_HANDLE tick_counter;
+    tickcounter_ms_t connect_start_time;
+    tickcounter_ms_t last_attempt_time;
+    size_t address_count;
+    size_t next_address;
+    int connect_sockets[DNS_ASYNC_MAX_ADDRESSES];
+#ifdef USE_EPOLL_REACTOR
+    SOCKET_REACTOR_ENTRY_HANDLE reactor_entry;
+#endif
+    unsigned char* recv_bytes;
+    size_t recv_bytes_size;
+    size_t recv_buffer_size;
+    size_t recv_buffer_limit;
+    bool adaptive_recv_buffer;
+    int tuning_option_values[SOCKET_TUNING_OPTION_COUNT];
+    bool is_tuning_option_set[SOCKET_TUNING_OPTION_COUNT];
+    XIO_STATISTICS statistics;
+    size_t send_queue_high_watermark;
+    size_t send_queue_low_watermark;
+    bool is_send_blocked;
+    ON_IO_WRITABLE on_io_writable;
+    void* on_io_writable_context;
 } SOCKET_IO_INSTANCE;
 
 typedef struct NETWORK_INTERFACE_DESCRIPTION_TAG
@@ -96,6 +182,23 @@ typedef struct NETWORK_INTERFACE_DESCRIPTION_TAG
     struct NETWORK_INTERFACE_DESCRIPTION_TAG* next;
 } NETWORK_INTERFACE_DESCRIPTION;
 
+static int find_socket_tuning_option(const char* name)
+{
+    int result = -1;
+    size_t i;
+
+    for (i = 0; i < SOCKET_TUNING_OPTION_COUNT; i++)
+    {
+        if (strcmp(name, socket_tuning_options[i].name) == 0)
+        {
+            result = (int)i;
+            break;
+        }
+    }
+
+    return result;
+}
+
 /*this function will clone an option given by name and value*/
 static void* socketio_CloneOption(const char* name, const void* value)
 {
@@ -125,6 +228,59 @@ static void* socketio_CloneOption(const char* name, const void* value)
                 }
             }
         }
+        else if (find_socket_tuning_option(name) >= 0)
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(int))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(int*)result = *(const int*)value;
+            }
+        }
+        else if (strcmp(name, OPTION_RECEIVE_BUFFER_SIZE) == 0 ||
+            strcmp(name, OPTION_SEND_QUEUE_HIGH_WATERMARK) == 0 ||
+            strcmp(name, OPTION_SEND_QUEUE_LOW_WATERMARK) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(size_t*)result = *(const size_t*)value;
+            }
+        }
+        else if (strcmp(name, OPTION_ADAPTIVE_RECEIVE_BUFFER) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(bool*)result = *(const bool*)value;
+            }
+        }
+        else if (strcmp(name, OPTION_ON_IO_WRITABLE) == 0 ||
+            strcmp(name, OPTION_ON_IO_WRITABLE_CONTEXT) == 0)
+        {
+            /* the callback and its context are owned by the caller, only the pointer is kept */
+            result = (void*)value;
+        }
         else
         {
             LogError("Cannot clone option %s (not suppported)", name);
@@ -139,7 +295,13 @@ static void socketio_DestroyOption(const char* name, const void* value)
 {
     if (name != NULL)
     {
-        if (strcmp(name, OPTION_NET_INT_MAC_ADDRESS) == 0 && value != NULL)
+        if ((strcmp(name, OPTION_NET_INT_MAC_ADDRESS) == 0 ||
+            strcmp(name, OPTION_RECEIVE_BUFFER_SIZE) == 0 ||
+            strcmp(name, OPTION_ADAPTIVE_RECEIVE_BUFFER) == 0 ||
+            strcmp(name, OPTION_SEND_QUEUE_HIGH_WATERMARK) == 0 ||
+            strcmp(name, OPTION_SEND_QUEUE_LOW_WATERMARK) == 0 ||
+            find_socket_tuning_option(name) >= 0) &&
+            value != NULL)
         {
             free((void*)value);
         }
@@ -171,6 +333,51 @@ static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
             OptionHandler_Destroy(result);
             result = NULL;
         }
+        /* the adaptive flag goes first so that a replayed receive_buffer_size keeps its adaptive meaning */
+        else if (socket_io_instance->adaptive_recv_buffer &&
+            OptionHandler_AddOption(result, OPTION_ADAPTIVE_RECEIVE_BUFFER, &socket_io_instance->adaptive_recv_buffer) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding adaptive_receive_buffer)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->recv_buffer_limit != 0 &&
+            OptionHandler_AddOption(result, OPTION_RECEIVE_BUFFER_SIZE, &socket_io_instance->recv_buffer_limit) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding receive_buffer_size)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->send_queue_high_watermark != 0 &&
+            OptionHandler_AddOption(result, OPTION_SEND_QUEUE_HIGH_WATERMARK, &socket_io_instance->send_queue_high_watermark) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding send_queue_high_watermark)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->send_queue_low_watermark != 0 &&
+            OptionHandler_AddOption(result, OPTION_SEND_QUEUE_LOW_WATERMARK, &socket_io_instance->send_queue_low_watermark) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding send_queue_low_watermark)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < SOCKET_TUNING_OPTION_COUNT; i++)
+            {
+                if (socket_io_instance->is_tuning_option_set[i] &&
+                    OptionHandler_AddOption(result, socket_tuning_options[i].name, &socket_io_instance->tuning_option_values[i]) != OPTIONHANDLER_OK)
+                {
+                    LogError("failed retrieving options (failed adding %s)", socket_tuning_options[i].name);
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                    break;
+                }
+            }
+        }
     }
 
     return result;
@@ -185,7 +392,9 @@ static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
     socketio_close,
     socketio_send,
     socketio_dowork,
-    socketio_setoption
+    socketio_setoption,
+    socketio_send_constbuffer,
+    socketio_get_statistics
 };
 
 static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
@@ -196,154 +405,540 @@ static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
     }
 }
 
-static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned char* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+static void register_with_reactor(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+#ifdef USE_EPOLL_REACTOR
+    /* a NULL entry (reactor not running) simply means the socket is polled directly in dowork */
+    socket_io_instance->reactor_entry = socket_reactor_register(socket_io_instance->socket);
+#else
+    (void)socket_io_instance;
+#endif
+}
+
+static void unregister_from_reactor(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+#ifdef USE_EPOLL_REACTOR
+    if (socket_io_instance->reactor_entry != NULL)
+    {
+        socket_reactor_unregister(socket_io_instance->reactor_entry);
+        socket_io_instance->reactor_entry = NULL;
+    }
+#else
+    (void)socket_io_instance;
+#endif
+}
+
+static int is_socket_readable(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+#ifdef USE_EPOLL_REACTOR
+    return (socket_io_instance->reactor_entry == NULL) || socket_reactor_is_readable(socket_io_instance->reactor_entry);
+#else
+    (void)socket_io_instance;
+    return 1;
+#endif
+}
+
+/* only meaningful after is_socket_readable, which issues the reactor poll for the current dowork round */
+static int is_socket_writable(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+#ifdef USE_EPOLL_REACTOR
+    return (socket_io_instance->reactor_entry == NULL) || socket_reactor_is_writable(socket_io_instance->reactor_entry);
+#else
+    (void)socket_io_instance;
+    return 1;
+#endif
+}
+
+/* the socket is watched for writability only while the kernel refused some of the queued bytes */
+static void update_write_interest(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+#ifdef USE_EPOLL_REACTOR
+    if (socket_io_instance->reactor_entry != NULL &&
+        socket_reactor_set_write_interest(socket_io_instance->reactor_entry, singlylinkedlist_get_head_item(socket_io_instance->pending_io_list) != NULL) != 0)
+    {
+        /* without EPOLLOUT the queue would never be flushed, so fall back to sending on every dowork */
+        LogError("Failure: unable to update the reactor write interest, polling the socket directly.");
+        socket_reactor_unregister(socket_io_instance->reactor_entry);
+        socket_io_instance->reactor_entry = NULL;
+    }
+#else
+    (void)socket_io_instance;
+#endif
+}
+
+/* the largest chunk a single recv may use, receive_buffer_size when it was set */
+static size_t get_receive_buffer_limit(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    size_t result;
+
+    if (socket_io_instance->recv_buffer_limit != 0)
+    {
+        result = socket_io_instance->recv_buffer_limit;
+    }
+    else if (socket_io_instance->adaptive_recv_buffer)
+    {
+        result = RECEIVE_BYTES_MAX_VALUE;
+    }
+    else
+    {
+        result = RECEIVE_BYTES_VALUE;
+    }
+
+    return result;
+}
+
+static int resize_receive_buffer(SOCKET_IO_INSTANCE* socket_io_instance, size_t new_size)
 {
     int result;
-    PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO));
-    if (pending_socket_io == NULL)
+
+    if ((socket_io_instance->recv_bytes != NULL) &&
+        (socket_io_instance->recv_bytes_size == new_size))
     {
-        result = __FAILURE__;
+        result = 0;
     }
     else
     {
-        pending_socket_io->bytes = (unsigned char*)malloc(size);
-        if (pending_socket_io->bytes == NULL)
+        unsigned char* new_recv_bytes = (unsigned char*)realloc(socket_io_instance->recv_bytes, new_size);
+        if (new_recv_bytes == NULL)
         {
-            LogError("Allocation Failure: Unable to allocate pending list.");
-            free(pending_socket_io);
+            LogError("Failure: cannot allocate %lu bytes receive buffer.", (unsigned long)new_size);
             result = __FAILURE__;
         }
         else
         {
-            pending_socket_io->size = size;
-            pending_socket_io->on_send_complete = on_send_complete;
-            pending_socket_io->callback_context = callback_context;
-            pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
-            (void)memcpy(pending_socket_io->bytes, buffer, size);
-
-            if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
-            {
-                LogError("Failure: Unable to add socket to pending list.");
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                result = __FAILURE__;
-            }
-            else
-            {
-                result = 0;
-            }
+            socket_io_instance->recv_bytes = new_recv_bytes;
+            socket_io_instance->recv_bytes_size = new_size;
+            socket_io_instance->recv_buffer_size = new_size;
+            result = 0;
         }
     }
 
     return result;
 }
 
-static void signal_callback(int signum)
-{
-    LogError("Socket received signal %d.", signum);
-}
-
-#ifndef __APPLE__
-static void destroy_network_interface_descriptions(NETWORK_INTERFACE_DESCRIPTION* nid)
+/* a chunk that came back full means more data is waiting, so the next recv asks for twice as much */
+static void grow_receive_buffer(SOCKET_IO_INSTANCE* socket_io_instance)
 {
-    if (nid != NULL)
+    size_t limit = get_receive_buffer_limit(socket_io_instance);
+    if (socket_io_instance->recv_bytes_size < limit)
     {
-        if (nid->next != NULL)
-        {
-            destroy_network_interface_descriptions(nid->next);
-        }
-    
-        if (nid->name != NULL)
+        size_t new_size = socket_io_instance->recv_bytes_size * 2;
+        if (new_size > limit)
         {
-            free(nid->name);
+            new_size = limit;
         }
 
-        if (nid->mac_address != NULL)
-        {
-            free(nid->mac_address);
-        }
-        
-        if (nid->ip_address != NULL)
+        /* on failure the current buffer is kept */
+        (void)resize_receive_buffer(socket_io_instance, new_size);
+    }
+}
+
+/* idle connections give memory back a halving at a time */
+static void shrink_receive_buffer(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if ((socket_io_instance->recv_bytes != NULL) &&
+        (socket_io_instance->recv_bytes_size > RECEIVE_BYTES_VALUE))
+    {
+        size_t new_size = socket_io_instance->recv_bytes_size / 2;
+        if (new_size < RECEIVE_BYTES_VALUE)
         {
-            free(nid->ip_address);
+            new_size = RECEIVE_BYTES_VALUE;
         }
 
-        free(nid);
+        (void)resize_receive_buffer(socket_io_instance, new_size);
     }
 }
 
-static NETWORK_INTERFACE_DESCRIPTION* create_network_interface_description(struct ifreq *ifr, NETWORK_INTERFACE_DESCRIPTION* previous_nid)
+/* applies a new receive_buffer_size or adaptive_receive_buffer setting, the buffer itself is resized by the next dowork */
+static void configure_receive_buffer(SOCKET_IO_INSTANCE* socket_io_instance)
 {
-    NETWORK_INTERFACE_DESCRIPTION* result;
-    
-    if ((result = (NETWORK_INTERFACE_DESCRIPTION*)malloc(sizeof(NETWORK_INTERFACE_DESCRIPTION))) == NULL)
+    size_t limit = get_receive_buffer_limit(socket_io_instance);
+
+    if (!socket_io_instance->adaptive_recv_buffer)
     {
-        LogError("Failed allocating NETWORK_INTERFACE_DESCRIPTION");
+        socket_io_instance->recv_buffer_size = limit;
     }
-    else if ((result->name = (char*)malloc(sizeof(char) * (strlen(ifr->ifr_name) + 1))) == NULL)
+    else if (socket_io_instance->recv_buffer_size > limit)
     {
-        LogError("failed setting interface description name (malloc failed)");
-        destroy_network_interface_descriptions(result);
-        result = NULL;
+        socket_io_instance->recv_buffer_size = limit;
     }
-    else if (strcpy(result->name, ifr->ifr_name) == NULL)
+    else if (socket_io_instance->recv_buffer_size < RECEIVE_BYTES_VALUE)
     {
-        LogError("failed setting interface description name (strcpy failed)");
-        destroy_network_interface_descriptions(result);
-        result = NULL;
+        socket_io_instance->recv_buffer_size = (limit < RECEIVE_BYTES_VALUE) ? limit : RECEIVE_BYTES_VALUE;
+    }
+}
+
+static int apply_socket_tuning_option(SOCKET_IO_INSTANCE* socket_io_instance, int sock, SOCKET_TUNING_OPTION_INDEX index)
+{
+    int result;
+
+    if (setsockopt(sock, socket_tuning_options[index].level, socket_tuning_options[index].option_name, &socket_io_instance->tuning_option_values[index], sizeof(int)) != 0)
+    {
+        LogError("Failure: setting %s to %d failed, errno=%d.", socket_tuning_options[index].name, socket_io_instance->tuning_option_values[index], errno);
+        result = __FAILURE__;
     }
     else
     {
-        char* ip_address;
-        unsigned char* mac = (unsigned char*)ifr->ifr_hwaddr.sa_data;
+        result = 0;
+    }
 
-        if ((result->mac_address = (char*)malloc(sizeof(char) * MAC_ADDRESS_STRING_LENGTH)) == NULL)
-        {
-            LogError("failed formatting mac address (malloc failed)");
-            destroy_network_interface_descriptions(result);
-            result = NULL;
-        }
-        else if (sprintf(result->mac_address, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0],mac[1],mac[2],mac[3],mac[4],mac[5]) <= 0)
-        {
-            LogError("failed formatting mac address (sprintf failed)");
-            destroy_network_interface_descriptions(result);
-            result = NULL;
-        }
-        else if ((ip_address = inet_ntoa(((struct sockaddr_in*)&ifr->ifr_addr)->sin_addr)) == NULL)
-        {
-            LogError("failed setting the ip address (inet_ntoa failed)");
-            destroy_network_interface_descriptions(result);
-            result = NULL;
-        }
-        else if ((result->ip_address = (char*)malloc(sizeof(char) * (strlen(ip_address) + 1))) == NULL)
-        {
-            LogError("failed setting the ip address (malloc failed)");
-            destroy_network_interface_descriptions(result);
-            result = NULL;
-        }
-        else if (strcpy(result->ip_address, ip_address) == NULL)
-        {
-            LogError("failed setting the ip address (strcpy failed)");
-            destroy_network_interface_descriptions(result);
-            result = NULL;
-        }
-        else
-        {
-            result->next = NULL;
+    return result;
+}
 
-            if (previous_nid != NULL)
-            {
-                previous_nid->next = result;
-            }
+/* the buffer sizes have to be in place before connect, so that the kernel can pick the right window scaling */
+static int apply_socket_tuning_options(SOCKET_IO_INSTANCE* socket_io_instance, int sock)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; i < SOCKET_TUNING_OPTION_COUNT; i++)
+    {
+        if (socket_io_instance->is_tuning_option_set[i] &&
+            apply_socket_tuning_option(socket_io_instance, sock, (SOCKET_TUNING_OPTION_INDEX)i) != 0)
+        {
+            result = __FAILURE__;
+            break;
         }
     }
-    
+
     return result;
 }
 
-static int get_network_interface_descriptions(int socket, NETWORK_INTERFACE_DESCRIPTION** nid)
+static uint64_t get_monotonic_time_us(void)
 {
-    int result;
+    uint64_t result;
+    struct timespec now;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+    }
+
+    return result;
+}
+
+static void record_dowork_duration(SOCKET_IO_INSTANCE* socket_io_instance, uint64_t dowork_start_us)
+{
+    uint64_t dowork_end_us = get_monotonic_time_us();
+    uint64_t duration_us = (dowork_end_us > dowork_start_us) ? (dowork_end_us - dowork_start_us) : 0;
+
+    socket_io_instance->statistics.dowork_count++;
+    socket_io_instance->statistics.dowork_total_us += duration_us;
+    if (duration_us > socket_io_instance->statistics.dowork_max_us)
+    {
+        socket_io_instance->statistics.dowork_max_us = duration_us;
+    }
+}
+
+static void free_pending_io(PENDING_SOCKET_IO* pending_socket_io)
+{
+    if (pending_socket_io->const_buffer != NULL)
+    {
+        /* the bytes belong to the caller's CONSTBUFFER, only our reference is released */
+        CONSTBUFFER_Destroy(pending_socket_io->const_buffer);
+    }
+    else
+    {
+        free((void*)pending_socket_io->bytes);
+    }
+
+    free(pending_socket_io);
+}
+
+/* when const_buffer is not NULL the pending IO keeps a reference to it instead of copying the bytes */
+static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned char* buffer, size_t size, CONSTBUFFER_HANDLE const_buffer, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO));
+    if (pending_socket_io == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (const_buffer != NULL)
+        {
+            pending_socket_io->const_buffer = CONSTBUFFER_Clone(const_buffer);
+            pending_socket_io->bytes = (pending_socket_io->const_buffer == NULL) ? NULL : buffer;
+        }
+        else
+        {
+            unsigned char* bytes_copy = (unsigned char*)malloc(size);
+            if (bytes_copy != NULL)
+            {
+                (void)memcpy(bytes_copy, buffer, size);
+            }
+
+            pending_socket_io->const_buffer = NULL;
+            pending_socket_io->bytes = bytes_copy;
+        }
+
+        if (pending_socket_io->bytes == NULL)
+        {
+            LogError("Allocation Failure: Unable to allocate pending list.");
+            free(pending_socket_io);
+            result = __FAILURE__;
+        }
+        else
+        {
+            pending_socket_io->size = size;
+            pending_socket_io->offset = 0;
+            pending_socket_io->on_send_complete = on_send_complete;
+            pending_socket_io->callback_context = callback_context;
+            pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
+
+            if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
+            {
+                LogError("Failure: Unable to add socket to pending list.");
+                free_pending_io(pending_socket_io);
+                result = __FAILURE__;
+            }
+            else
+            {
+                socket_io_instance->statistics.queued_bytes += size;
+                socket_io_instance->statistics.queued_send_count++;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void remove_first_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, LIST_ITEM_HANDLE first_pending_io, PENDING_SOCKET_IO* pending_socket_io)
+{
+    socket_io_instance->statistics.queued_bytes -= pending_socket_io->size - pending_socket_io->offset;
+    socket_io_instance->statistics.queued_send_count--;
+    free_pending_io(pending_socket_io);
+    if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
+    {
+        socket_io_instance->io_state = IO_STATE_ERROR;
+        indicate_error(socket_io_instance);
+        LogError("Failure: unable to remove socket from list");
+    }
+}
+
+/* flushes as many pending IOs as possible with a single sendmsg; a partial write only advances the offset of the IO it stopped in */
+static void send_pending_ios(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    struct iovec iov[PENDING_IO_MAX_IOV];
+    struct msghdr message;
+    int iov_count = 0;
+    size_t batch_size = 0;
+    LIST_ITEM_HANDLE pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+
+    while (pending_io != NULL && iov_count < PENDING_IO_MAX_IOV)
+    {
+        PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(pending_io);
+        if (pending_socket_io == NULL)
+        {
+            break;
+        }
+
+        iov[iov_count].iov_base = (void*)(pending_socket_io->bytes + pending_socket_io->offset);
+        iov[iov_count].iov_len = pending_socket_io->size - pending_socket_io->offset;
+        batch_size += iov[iov_count].iov_len;
+        iov_count++;
+
+        pending_io = singlylinkedlist_get_next_item(pending_io);
+    }
+
+    if (iov_count == 0)
+    {
+        socket_io_instance->io_state = IO_STATE_ERROR;
+        indicate_error(socket_io_instance);
+        LogError("Failure: retrieving socket from list");
+    }
+    else
+    {
+        ssize_t send_result;
+
+        (void)memset(&message, 0, sizeof(message));
+        message.msg_iov = iov;
+        message.msg_iovlen = iov_count;
+
+        signal(SIGPIPE, SIG_IGN);
+
+        send_result = sendmsg(socket_io_instance->socket, &message, 0);
+        if (send_result < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                socket_io_instance->statistics.would_block_count++;
+            }
+            else /*EAGAIN means "come back later" - likely the socket buffer cannot accept more data*/
+            {
+                LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+                PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
+
+                LogError("Failure: sending Socket information. errno=%d (%s).", errno, strerror(errno));
+                remove_first_pending_io(socket_io_instance, first_pending_io, pending_socket_io);
+                socket_io_instance->io_state = IO_STATE_ERROR;
+                indicate_error(socket_io_instance);
+            }
+        }
+        else
+        {
+            size_t remaining = (size_t)send_result;
+
+            socket_io_instance->statistics.bytes_sent += (uint64_t)send_result;
+
+            /* the IOs left out of the batch because of PENDING_IO_MAX_IOV were not refused by the kernel */
+            if (remaining < batch_size)
+            {
+                socket_io_instance->statistics.would_block_count++;
+            }
+
+            while (socket_io_instance->io_state != IO_STATE_ERROR)
+            {
+                LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+                PENDING_SOCKET_IO* pending_socket_io;
+                size_t pending_size;
+
+                if (first_pending_io == NULL ||
+                    (pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io)) == NULL)
+                {
+                    break;
+                }
+
+                if (remaining == 0)
+                {
+                    break;
+                }
+
+                pending_size = pending_socket_io->size - pending_socket_io->offset;
+                if (remaining < pending_size)
+                {
+                    /* simply wait until next dowork */
+                    pending_socket_io->offset += remaining;
+                    socket_io_instance->statistics.queued_bytes -= remaining;
+                    break;
+                }
+
+                remaining -= pending_size;
+                if (pending_socket_io->on_send_complete != NULL)
+                {
+                    pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
+                }
+
+                remove_first_pending_io(socket_io_instance, first_pending_io, pending_socket_io);
+            }
+        }
+    }
+
+    update_write_interest(socket_io_instance);
+}
+
+static void signal_callback(int signum)
+{
+    LogError("Socket received signal %d.", signum);
+}
+
+#ifndef __APPLE__
+static void destroy_network_interface_descriptions(NETWORK_INTERFACE_DESCRIPTION* nid)
+{
+    if (nid != NULL)
+    {
+        if (nid->next != NULL)
+        {
+            destroy_network_interface_descriptions(nid->next);
+        }
+    
+        if (nid->name != NULL)
+        {
+            free(nid->name);
+        }
+
+        if (nid->mac_address != NULL)
+        {
+            free(nid->mac_address);
+        }
+        
+        if (nid->ip_address != NULL)
+        {
+            free(nid->ip_address);
+        }
+
+        free(nid);
+    }
+}
+
+static NETWORK_INTERFACE_DESCRIPTION* create_network_interface_description(struct ifreq *ifr, NETWORK_INTERFACE_DESCRIPTION* previous_nid)
+{
+    NETWORK_INTERFACE_DESCRIPTION* result;
+    
+    if ((result = (NETWORK_INTERFACE_DESCRIPTION*)malloc(sizeof(NETWORK_INTERFACE_DESCRIPTION))) == NULL)
+    {
+        LogError("Failed allocating NETWORK_INTERFACE_DESCRIPTION");
+    }
+    else if ((result->name = (char*)malloc(sizeof(char) * (strlen(ifr->ifr_name) + 1))) == NULL)
+    {
+        LogError("failed setting interface description name (malloc failed)");
+        destroy_network_interface_descriptions(result);
+        result = NULL;
+    }
+    else if (strcpy(result->name, ifr->ifr_name) == NULL)
+    {
+        LogError("failed setting interface description name (strcpy failed)");
+        destroy_network_interface_descriptions(result);
+        result = NULL;
+    }
+    else
+    {
+        char* ip_address;
+        unsigned char* mac = (unsigned char*)ifr->ifr_hwaddr.sa_data;
+
+        if ((result->mac_address = (char*)malloc(sizeof(char) * MAC_ADDRESS_STRING_LENGTH)) == NULL)
+        {
+            LogError("failed formatting mac address (malloc failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else if (sprintf(result->mac_address, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0],mac[1],mac[2],mac[3],mac[4],mac[5]) <= 0)
+        {
+            LogError("failed formatting mac address (sprintf failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else if ((ip_address = inet_ntoa(((struct sockaddr_in*)&ifr->ifr_addr)->sin_addr)) == NULL)
+        {
+            LogError("failed setting the ip address (inet_ntoa failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else if ((result->ip_address = (char*)malloc(sizeof(char) * (strlen(ip_address) + 1))) == NULL)
+        {
+            LogError("failed setting the ip address (malloc failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else if (strcpy(result->ip_address, ip_address) == NULL)
+        {
+            LogError("failed setting the ip address (strcpy failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else
+        {
+            result->next = NULL;
+
+            if (previous_nid != NULL)
+            {
+                previous_nid->next = result;
+            }
+        }
+    }
+    
+    return result;
+}
+
+static int get_network_interface_descriptions(int socket, NETWORK_INTERFACE_DESCRIPTION** nid)
+{
+    int result;
 
     struct ifreq ifr;
     struct ifconf ifc;
@@ -460,6 +1055,38 @@ static int set_target_network_interface(int socket, char* mac_address)
 }
 #endif //__APPLE__
 
+/* closes the connect attempts that did not win and releases the DNS lookup */
+static void release_open_resources(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    size_t i;
+
+    for (i = 0; i < DNS_ASYNC_MAX_ADDRESSES; i++)
+    {
+        if (socket_io_instance->connect_sockets[i] != INVALID_SOCKET)
+        {
+            close(socket_io_instance->connect_sockets[i]);
+            socket_io_instance->connect_sockets[i] = INVALID_SOCKET;
+        }
+    }
+
+    if (socket_io_instance->dns != NULL)
+    {
+        dns_async_destroy(socket_io_instance->dns);
+        socket_io_instance->dns = NULL;
+    }
+
+    if (socket_io_instance->tick_counter != NULL)
+    {
+        tickcounter_destroy(socket_io_instance->tick_counter);
+        socket_io_instance->tick_counter = NULL;
+    }
+
+    socket_io_instance->address_count = 0;
+    socket_io_instance->next_address = 0;
+}
+
+static void complete_open(SOCKET_IO_INSTANCE* socket_io_instance, IO_OPEN_RESULT open_result);
+
 CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
 {
     SOCKETIO_CONFIG* socket_io_config = io_create_parameters;
@@ -516,6 +1143,37 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
                     result->on_bytes_received_context = NULL;
                     result->on_io_error_context = NULL;
                     result->io_state = IO_STATE_CLOSED;
+                    result->on_io_open_complete = NULL;
+                    result->on_io_open_complete_context = NULL;
+                    result->dns = NULL;
+                    result->tick_counter = NULL;
+                    result->connect_start_time = 0;
+                    result->last_attempt_time = 0;
+                    result->address_count = 0;
+                    result->next_address = 0;
+                    for (size_t i = 0; i < DNS_ASYNC_MAX_ADDRESSES; i++)
+                    {
+                        result->connect_sockets[i] = INVALID_SOCKET;
+                    }
+                    result->recv_bytes = NULL;
+                    result->recv_bytes_size = 0;
+                    result->recv_buffer_size = RECEIVE_BYTES_VALUE;
+                    result->recv_buffer_limit = 0;
+                    result->adaptive_recv_buffer = false;
+                    for (size_t i = 0; i < SOCKET_TUNING_OPTION_COUNT; i++)
+                    {
+                        result->tuning_option_values[i] = 0;
+                        result->is_tuning_option_set[i] = false;
+                    }
+#ifdef USE_EPOLL_REACTOR
+                    result->reactor_entry = NULL;
+#endif
+                    (void)memset(&result->statistics, 0, sizeof(result->statistics));
+                    result->send_queue_high_watermark = 0;
+                    result->send_queue_low_watermark = 0;
+                    result->is_send_blocked = false;
+                    result->on_io_writable = NULL;
+                    result->on_io_writable_context = NULL;
                 }
             }
         }
@@ -533,243 +1191,538 @@ void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
     if (socket_io != NULL)
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state == IO_STATE_OPENING)
+        {
+            /* the open callback is owed to the caller, even when the instance goes away before the connect finished */
+            complete_open(socket_io_instance, IO_OPEN_CANCELLED);
+        }
+
+        unregister_from_reactor(socket_io_instance);
+        release_open_resources(socket_io_instance);
+
         /* we cannot do much if the close fails, so just ignore the result */
         if (socket_io_instance->socket != INVALID_SOCKET)
         {
             close(socket_io_instance->socket);
         }
 
-        /* clear allpending IOs */
-        LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-        while (first_pending_io != NULL)
-        {
-            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-            if (pending_socket_io != NULL)
-            {
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-            }
+        /* clear allpending IOs */
+        LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+        while (first_pending_io != NULL)
+        {
+            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
+            if (pending_socket_io != NULL)
+            {
+                free_pending_io(pending_socket_io);
+            }
+
+            (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
+            first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+        }
+
+        singlylinkedlist_destroy(socket_io_instance->pending_io_list);
+        free(socket_io_instance->hostname);
+        free(socket_io_instance->target_mac_address);
+        free(socket_io_instance->recv_bytes);
+        free(socket_io);
+    }
+}
+
+/* starts a non-blocking connect to one resolved address and returns the connecting socket */
+static int start_connect(SOCKET_IO_INSTANCE* socket_io_instance, const struct sockaddr* address, size_t address_length)
+{
+    int result;
+    int flags;
+    struct sockaddr_storage server_address;
+
+    (void)memcpy(&server_address, address, address_length);
+    if (server_address.ss_family == AF_INET6)
+    {
+        ((struct sockaddr_in6*)&server_address)->sin6_port = htons((uint16_t)socket_io_instance->port);
+    }
+    else
+    {
+        ((struct sockaddr_in*)&server_address)->sin_port = htons((uint16_t)socket_io_instance->port);
+    }
+
+    result = socket(server_address.ss_family, SOCK_STREAM, 0);
+    if (result < SOCKET_SUCCESS)
+    {
+        LogError("Failure: socket create failure %d.", result);
+        result = INVALID_SOCKET;
+    }
+#ifndef __APPLE__
+    else if (socket_io_instance->target_mac_address != NULL &&
+             set_target_network_interface(result, socket_io_instance->target_mac_address) != 0)
+    {
+        LogError("Failure: failed selecting target network interface (MACADDR=%s).", socket_io_instance->target_mac_address);
+        close(result);
+        result = INVALID_SOCKET;
+    }
+#endif //__APPLE__
+    else if (apply_socket_tuning_options(socket_io_instance, result) != 0)
+    {
+        LogError("Failure: failed applying socket options.");
+        close(result);
+        result = INVALID_SOCKET;
+    }
+    else if ((-1 == (flags = fcntl(result, F_GETFL, 0))) ||
+        (fcntl(result, F_SETFL, flags | O_NONBLOCK) == -1))
+    {
+        LogError("Failure: fcntl failure.");
+        close(result);
+        result = INVALID_SOCKET;
+    }
+    else if ((connect(result, (const struct sockaddr*)&server_address, (socklen_t)address_length) != 0) &&
+        (errno != EINPROGRESS))
+    {
+        LogError("Failure: connect failure %d.", errno);
+        close(result);
+        result = INVALID_SOCKET;
+    }
+
+    /* even an immediate connect is reported by the next socket_async_is_create_complete */
+    return result;
+}
+
+static void complete_open(SOCKET_IO_INSTANCE* socket_io_instance, IO_OPEN_RESULT open_result)
+{
+    release_open_resources(socket_io_instance);
+
+    if (open_result == IO_OPEN_OK)
+    {
+        socket_io_instance->io_state = IO_STATE_OPEN;
+        register_with_reactor(socket_io_instance);
+    }
+    else
+    {
+        if (socket_io_instance->socket != INVALID_SOCKET)
+        {
+            close(socket_io_instance->socket);
+            socket_io_instance->socket = INVALID_SOCKET;
+        }
+
+        socket_io_instance->io_state = IO_STATE_CLOSED;
+    }
+
+    if (socket_io_instance->on_io_open_complete != NULL)
+    {
+        socket_io_instance->on_io_open_complete(socket_io_instance->on_io_open_complete_context, open_result);
+    }
+}
+
+/* checks the pending connect attempts; returns the index of the first connected one, or DNS_ASYNC_MAX_ADDRESSES if none is connected yet */
+static size_t poll_connect_attempts(SOCKET_IO_INSTANCE* socket_io_instance, size_t* pending_count)
+{
+    size_t result = DNS_ASYNC_MAX_ADDRESSES;
+    size_t i;
+
+    *pending_count = 0;
+
+    for (i = 0; i < socket_io_instance->next_address && result == DNS_ASYNC_MAX_ADDRESSES; i++)
+    {
+        bool is_complete = false;
+        int sock = socket_io_instance->connect_sockets[i];
+
+        if (sock == INVALID_SOCKET)
+        {
+            continue;
+        }
+
+        if (socket_async_is_create_complete(sock, &is_complete) != 0)
+        {
+            LogError("Failure: checking the connect state failed.");
+            close(sock);
+            socket_io_instance->connect_sockets[i] = INVALID_SOCKET;
+        }
+        else if (!is_complete)
+        {
+            (*pending_count)++;
+        }
+        else
+        {
+            int so_error = 0;
+            socklen_t len = sizeof(so_error);
+            if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &so_error, &len) != 0)
+            {
+                LogError("Failure: getsockopt failure %d.", errno);
+                close(sock);
+                socket_io_instance->connect_sockets[i] = INVALID_SOCKET;
+            }
+            else if (so_error != 0)
+            {
+                LogError("Failure: connect failure %d.", so_error);
+                close(sock);
+                socket_io_instance->connect_sockets[i] = INVALID_SOCKET;
+            }
+            else
+            {
+                result = i;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* starts the connect attempt to the next resolved address that can be tried, returns false if none is left */
+static bool start_next_connect_attempt(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    bool result = false;
+
+    while (!result && socket_io_instance->next_address < socket_io_instance->address_count)
+    {
+        size_t address_length;
+        size_t index = socket_io_instance->next_address++;
+        const struct sockaddr* address = dns_async_get_address(socket_io_instance->dns, index, &address_length);
+
+        if (address != NULL &&
+            (socket_io_instance->connect_sockets[index] = start_connect(socket_io_instance, address, address_length)) != INVALID_SOCKET)
+        {
+            (void)tickcounter_get_current_ms(socket_io_instance->tick_counter, &socket_io_instance->last_attempt_time);
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+/* moves an open in progress one step further: first the DNS lookup, then the connect attempts.
+   The resolved addresses are raced Happy Eyeballs style: a new attempt is started whenever the
+   previous ones failed or did not complete within CONNECTION_ATTEMPT_DELAY_MS, the first connected socket wins.
+   The whole open, DNS lookup included, has to finish within CONNECT_TIMEOUT seconds of socketio_open. */
+static void continue_open(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    tickcounter_ms_t now;
+
+    if (tickcounter_get_current_ms(socket_io_instance->tick_counter, &now) != 0)
+    {
+        LogError("Failure: cannot read the tick counter.");
+        complete_open(socket_io_instance, IO_OPEN_ERROR);
+    }
+    else if (socket_io_instance->address_count == 0)
+    {
+        if (!dns_async_is_lookup_complete(socket_io_instance->dns))
+        {
+            /* a lookup that never answers counts against the same timeout as the connect */
+            if (now - socket_io_instance->connect_start_time >= (tickcounter_ms_t)CONNECT_TIMEOUT * 1000)
+            {
+                LogError("Failure: DNS lookup for %s timed out.", socket_io_instance->hostname);
+                complete_open(socket_io_instance, IO_OPEN_ERROR);
+            }
+        }
+        else
+        {
+            socket_io_instance->address_count = dns_async_get_address_count(socket_io_instance->dns);
+
+            if (socket_io_instance->address_count == 0)
+            {
+                LogError("Failure: DNS lookup for %s failed.", socket_io_instance->hostname);
+                complete_open(socket_io_instance, IO_OPEN_ERROR);
+            }
+            else if (!start_next_connect_attempt(socket_io_instance))
+            {
+                complete_open(socket_io_instance, IO_OPEN_ERROR);
+            }
+        }
+    }
+    else
+    {
+        size_t pending_count;
+        size_t connected_index = poll_connect_attempts(socket_io_instance, &pending_count);
+
+        if (connected_index != DNS_ASYNC_MAX_ADDRESSES)
+        {
+            socket_io_instance->socket = socket_io_instance->connect_sockets[connected_index];
+            socket_io_instance->connect_sockets[connected_index] = INVALID_SOCKET;
+            complete_open(socket_io_instance, IO_OPEN_OK);
+        }
+        else if (now - socket_io_instance->connect_start_time >= (tickcounter_ms_t)CONNECT_TIMEOUT * 1000)
+        {
+            LogError("Failure: connect to %s timed out.", socket_io_instance->hostname);
+            complete_open(socket_io_instance, IO_OPEN_ERROR);
+        }
+        else if ((pending_count == 0 || now - socket_io_instance->last_attempt_time >= CONNECTION_ATTEMPT_DELAY_MS) &&
+            !start_next_connect_attempt(socket_io_instance) &&
+            pending_count == 0)
+        {
+            LogError("Failure: cannot connect to any address of %s.", socket_io_instance->hostname);
+            complete_open(socket_io_instance, IO_OPEN_ERROR);
+        }
+    }
+}
+
+int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    bool is_open_pending = false;
+    /* both address families are resolved so that IPv6 and IPv4 can be raced against each other */
+    DNS_ASYNC_OPTIONS dns_options = { true };
+
+    SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+    if (socket_io == NULL)
+    {
+        LogError("Invalid argument: SOCKET_IO_INSTANCE is NULL");
+        result = __FAILURE__;
+    }
+    else if (socket_io_instance->io_state != IO_STATE_CLOSED)
+    {
+        LogError("Failure: socket state is not closed.");
+        result = __FAILURE__;
+    }
+    else if (socket_io_instance->socket != INVALID_SOCKET)
+    {
+        // Opening an accepted socket
+        socket_io_instance->on_bytes_received_context = on_bytes_received_context;
+        socket_io_instance->on_bytes_received = on_bytes_received;
+        socket_io_instance->on_io_error = on_io_error;
+        socket_io_instance->on_io_error_context = on_io_error_context;
+
+        socket_io_instance->io_state = IO_STATE_OPEN;
+        register_with_reactor(socket_io_instance);
+
+        result = 0;
+    }
+    else if ((socket_io_instance->tick_counter = tickcounter_create()) == NULL)
+    {
+        LogError("Failure: cannot create the tick counter.");
+        result = __FAILURE__;
+    }
+    else if (tickcounter_get_current_ms(socket_io_instance->tick_counter, &socket_io_instance->connect_start_time) != 0)
+    {
+        LogError("Failure: cannot read the tick counter.");
+        release_open_resources(socket_io_instance);
+        result = __FAILURE__;
+    }
+    else if ((socket_io_instance->dns = dns_async_create(socket_io_instance->hostname, &dns_options)) == NULL)
+    {
+        LogError("Failure: cannot start DNS lookup for %s.", socket_io_instance->hostname);
+        release_open_resources(socket_io_instance);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* the DNS lookup and the connect are finished by socketio_dowork, which reports the open result */
+        socket_io_instance->on_bytes_received = on_bytes_received;
+        socket_io_instance->on_bytes_received_context = on_bytes_received_context;
+        socket_io_instance->on_io_error = on_io_error;
+        socket_io_instance->on_io_error_context = on_io_error_context;
+        socket_io_instance->on_io_open_complete = on_io_open_complete;
+        socket_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+
+        socket_io_instance->io_state = IO_STATE_OPENING;
+        is_open_pending = true;
+        result = 0;
+    }
+
+    if (!is_open_pending && on_io_open_complete != NULL)
+    {
+        on_io_open_complete(on_io_open_complete_context, result == 0 ? IO_OPEN_OK : IO_OPEN_ERROR);
+    }
+
+    return result;
+}
+
+int socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result = 0;
+
+    if (socket_io == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state == IO_STATE_OPENING)
+        {
+            complete_open(socket_io_instance, IO_OPEN_CANCELLED);
+        }
+        else if ((socket_io_instance->io_state != IO_STATE_CLOSED) && (socket_io_instance->io_state != IO_STATE_CLOSING))
+        {
+            // Only close if the socket isn't already in the closed or closing state
+            unregister_from_reactor(socket_io_instance);
+            (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
+            close(socket_io_instance->socket);
+            socket_io_instance->socket = INVALID_SOCKET;
+            socket_io_instance->io_state = IO_STATE_CLOSED;
+        }
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static void check_send_queue_drained(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    size_t low_watermark = socket_io_instance->send_queue_low_watermark;
+    if (low_watermark > socket_io_instance->send_queue_high_watermark)
+    {
+        low_watermark = socket_io_instance->send_queue_high_watermark;
+    }
+
+    if (socket_io_instance->is_send_blocked &&
+        socket_io_instance->statistics.queued_bytes <= low_watermark)
+    {
+        socket_io_instance->is_send_blocked = false;
 
-            (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
-            first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+        if (socket_io_instance->on_io_writable != NULL)
+        {
+            socket_io_instance->on_io_writable(socket_io_instance->on_io_writable_context);
         }
-
-        singlylinkedlist_destroy(socket_io_instance->pending_io_list);
-        free(socket_io_instance->hostname);
-        free(socket_io_instance->target_mac_address);
-        free(socket_io);
     }
 }
 
-int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+static int send_or_queue(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned char* buffer, size_t size, CONSTBUFFER_HANDLE const_buffer, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
-    int retval = -1;
-    int select_errno = 0;
 
-    SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-    if (socket_io == NULL)
+    LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+    if (socket_io_instance->send_queue_high_watermark != 0 &&
+        socket_io_instance->statistics.queued_bytes >= socket_io_instance->send_queue_high_watermark)
     {
-        LogError("Invalid argument: SOCKET_IO_INSTANCE is NULL");
-        result = __FAILURE__;
+        /* the caller is producing faster than the peer consumes, let it hold on to the data instead of queueing it */
+        socket_io_instance->is_send_blocked = true;
+        result = XIO_SEND_WOULD_BLOCK;
     }
-    else
+    else if (first_pending_io != NULL)
     {
-        if (socket_io_instance->io_state != IO_STATE_CLOSED)
+        if (add_pending_io(socket_io_instance, buffer, size, const_buffer, on_send_complete, callback_context) != 0)
         {
-            LogError("Failure: socket state is not closed.");
+            LogError("Failure: add_pending_io failed.");
             result = __FAILURE__;
         }
-        else if (socket_io_instance->socket != INVALID_SOCKET)
+        else
         {
-            // Opening an accepted socket
-            socket_io_instance->on_bytes_received_context = on_bytes_received_context;
-            socket_io_instance->on_bytes_received = on_bytes_received;
-            socket_io_instance->on_io_error = on_io_error;
-            socket_io_instance->on_io_error_context = on_io_error_context;
-
-            socket_io_instance->io_state = IO_STATE_OPEN;
-
             result = 0;
         }
-        else
+    }
+    else
+    {
+        struct iovec iov;
+        struct msghdr message;
+
+        iov.iov_base = (void*)buffer;
+        iov.iov_len = size;
+        (void)memset(&message, 0, sizeof(message));
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+
+        signal(SIGPIPE, SIG_IGN);
+
+        int send_result = (int)sendmsg(socket_io_instance->socket, &message, 0);
+        if (send_result > 0)
         {
-            struct addrinfo* addrInfo;
-            char portString[16];
+            socket_io_instance->statistics.bytes_sent += (uint64_t)send_result;
+        }
 
-            socket_io_instance->socket = socket(AF_INET, SOCK_STREAM, 0);
-            if (socket_io_instance->socket < SOCKET_SUCCESS)
-            {
-                LogError("Failure: socket create failure %d.", socket_io_instance->socket);
-                result = __FAILURE__;
-            }
-#ifndef __APPLE__
-            else if (socket_io_instance->target_mac_address != NULL &&
-                     set_target_network_interface(socket_io_instance->socket, socket_io_instance->target_mac_address) != 0)
+        if (send_result != size)
+        {
+            if (send_result == INVALID_SOCKET)
             {
-                LogError("Failure: failed selecting target network interface (MACADDR=%s).", socket_io_instance->target_mac_address);
-                close(socket_io_instance->socket);
-                socket_io_instance->socket = INVALID_SOCKET;
-                result = __FAILURE__;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
+                {
+                    socket_io_instance->statistics.would_block_count++;
+
+                    /* queue all the data, it is flushed by the next dowork */
+                    if (add_pending_io(socket_io_instance, buffer, size, const_buffer, on_send_complete, callback_context) != 0)
+                    {
+                        LogError("Failure: add_pending_io failed.");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        result = 0;
+                    }
+                }
+                else
+                {
+                    LogError("Failure: sending socket failed. errno=%d (%s).", errno, strerror(errno));
+                    result = __FAILURE__;
+                }
             }
-#endif //__APPLE__
             else
             {
-                struct addrinfo addrHint = { 0 };
-                addrHint.ai_family = AF_INET;
-                addrHint.ai_socktype = SOCK_STREAM;
-                addrHint.ai_protocol = 0;
-
-                sprintf(portString, "%u", socket_io_instance->port);
-                int err = getaddrinfo(socket_io_instance->hostname, portString, &addrHint, &addrInfo);
-                if (err != 0)
+                /* queue data */
+                socket_io_instance->statistics.would_block_count++;
+                if (add_pending_io(socket_io_instance, buffer + send_result, size - send_result, const_buffer, on_send_complete, callback_context) != 0)
                 {
-                    LogError("Failure: getaddrinfo failure %d.", err);
-                    close(socket_io_instance->socket);
-                    socket_io_instance->socket = INVALID_SOCKET;
+                    LogError("Failure: add_pending_io failed.");
                     result = __FAILURE__;
                 }
                 else
                 {
-                    int flags;
-                    if ((-1 == (flags = fcntl(socket_io_instance->socket, F_GETFL, 0))) ||
-                        (fcntl(socket_io_instance->socket, F_SETFL, flags | O_NONBLOCK) == -1))
-                    {
-                        LogError("Failure: fcntl failure.");
-                        close(socket_io_instance->socket);
-                        socket_io_instance->socket = INVALID_SOCKET;
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        err = connect(socket_io_instance->socket, addrInfo->ai_addr, sizeof(*addrInfo->ai_addr));
-                        if ((err != 0) && (errno != EINPROGRESS))
-                        {
-                            LogError("Failure: connect failure %d.", errno);
-                            close(socket_io_instance->socket);
-                            socket_io_instance->socket = INVALID_SOCKET;
-                            result = __FAILURE__;
-                        }
-                        else
-                        {
-                            if (err != 0)
-                            {
-                                fd_set fdset;
-                                struct timeval tv;
-
-                                FD_ZERO(&fdset);
-                                FD_SET(socket_io_instance->socket, &fdset);
-                                tv.tv_sec = CONNECT_TIMEOUT;
-                                tv.tv_usec = 0;
-
-                                do
-                                {
-                                    retval = select(socket_io_instance->socket + 1, NULL, &fdset, NULL, &tv);
-
-                                    if (retval < 0)
-                                    {
-                                        select_errno = errno;
-                                    }
-                                } while (retval < 0 && select_errno == EINTR);
-                                
-                                if (retval != 1)
-                                {
-                                    LogError("Failure: select failure.");
-                                    close(socket_io_instance->socket);
-                                    socket_io_instance->socket = INVALID_SOCKET;
-                                    result = __FAILURE__;
-                                }
-                                else
-                                {
-                                    int so_error = 0;
-                                    socklen_t len = sizeof(so_error);
-                                    err = getsockopt(socket_io_instance->socket, SOL_SOCKET, SO_ERROR, &so_error, &len);
-                                    if (err != 0)
-                                    {
-                                        LogError("Failure: getsockopt failure %d.", errno);
-                                        close(socket_io_instance->socket);
-                                        socket_io_instance->socket = INVALID_SOCKET;
-                                        result = __FAILURE__;
-                                    }
-                                    else if (so_error != 0)
-                                    {
-                                        err = so_error;
-                                        LogError("Failure: connect failure %d.", so_error);
-                                        close(socket_io_instance->socket);
-                                        socket_io_instance->socket = INVALID_SOCKET;
-                                        result = __FAILURE__;
-                                    }
-                                }
-                            }
-                            if (err == 0)
-                            {
-                                socket_io_instance->on_bytes_received = on_bytes_received;
-                                socket_io_instance->on_bytes_received_context = on_bytes_received_context;
-
-                                socket_io_instance->on_io_error = on_io_error;
-                                socket_io_instance->on_io_error_context = on_io_error_context;
-
-                                socket_io_instance->io_state = IO_STATE_OPEN;
-
-                                result = 0;
-                            }
-                        }
-                    }
-                    freeaddrinfo(addrInfo);
+                    result = 0;
                 }
             }
         }
-    }
+        else
+        {
+            if (on_send_complete != NULL)
+            {
+                on_send_complete(callback_context, IO_SEND_OK);
+            }
 
-    if (on_io_open_complete != NULL)
-    {
-        on_io_open_complete(on_io_open_complete_context, result == 0 ? IO_OPEN_OK : IO_OPEN_ERROR);
+            result = 0;
+        }
     }
 
+    update_write_interest(socket_io_instance);
+
     return result;
 }
 
-int socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
-    int result = 0;
+    int result;
 
-    if (socket_io == NULL)
+    if ((socket_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
     {
+        /* Invalid arguments */
+        LogError("Invalid argument: send given invalid parameter");
         result = __FAILURE__;
     }
     else
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        if ((socket_io_instance->io_state != IO_STATE_CLOSED) && (socket_io_instance->io_state != IO_STATE_CLOSING))
+        if (socket_io_instance->io_state != IO_STATE_OPEN)
         {
-            // Only close if the socket isn't already in the closed or closing state
-            (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
-            close(socket_io_instance->socket);
-            socket_io_instance->socket = INVALID_SOCKET;
-            socket_io_instance->io_state = IO_STATE_CLOSED;
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
         }
-
-        if (on_io_close_complete != NULL)
+        else
         {
-            on_io_close_complete(callback_context);
+            result = send_or_queue(socket_io_instance, (const unsigned char*)buffer, size, NULL, on_send_complete, callback_context);
         }
-
-        result = 0;
     }
 
     return result;
 }
 
-int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+int socketio_send_constbuffer(CONCRETE_IO_HANDLE socket_io, CONSTBUFFER_HANDLE buffer, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
+    const CONSTBUFFER* content;
 
     if ((socket_io == NULL) ||
-        (buffer == NULL) ||
-        (size == 0))
+        (buffer == NULL))
     {
         /* Invalid arguments */
-        LogError("Invalid argument: send given invalid parameter");
+        LogError("Invalid argument: socket_io=%p, buffer=%p", socket_io, buffer);
+        result = __FAILURE__;
+    }
+    else if (((content = CONSTBUFFER_GetContent(buffer)) == NULL) ||
+        (content->size == 0))
+    {
+        LogError("Invalid argument: buffer has no content");
         result = __FAILURE__;
     }
     else
@@ -782,63 +1735,8 @@ int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size,
         }
         else
         {
-            LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-            if (first_pending_io != NULL)
-            {
-                if (add_pending_io(socket_io_instance, buffer, size, on_send_complete, callback_context) != 0)
-                {
-                    LogError("Failure: add_pending_io failed.");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    result = 0;
-                }
-            }
-            else
-            {
-                signal(SIGPIPE, SIG_IGN);
-
-                int send_result = send(socket_io_instance->socket, buffer, size, 0);
-                if (send_result != size)
-                {
-                    if (send_result == INVALID_SOCKET)
-                    {
-                        if (errno == EAGAIN) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
-                        {
-                            /*do nothing*/
-                            result = 0;
-                        }
-                        else
-                        {
-                            LogError("Failure: sending socket failed. errno=%d (%s).", errno, strerror(errno));
-                            result = __FAILURE__;
-                        }
-                    }
-                    else
-                    {
-                        /* queue data */
-                        if (add_pending_io(socket_io_instance, buffer + send_result, size - send_result, on_send_complete, callback_context) != 0)
-                        {
-                            LogError("Failure: add_pending_io failed.");
-                            result = __FAILURE__;
-                        }
-                        else
-                        {
-                            result = 0;
-                        }
-                    }
-                }
-                else
-                {
-                    if (on_send_complete != NULL)
-                    {
-                        on_send_complete(callback_context, IO_SEND_OK);
-                    }
-
-                    result = 0;
-                }
-            }
+            /* bytes that cannot be sent right away stay in the caller's buffer, only a reference is queued */
+            result = send_or_queue(socket_io_instance, content->buffer, content->size, buffer, on_send_complete, callback_context);
         }
     }
 
@@ -850,97 +1748,113 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
     if (socket_io != NULL)
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-        while (first_pending_io != NULL)
+        uint64_t dowork_start_us = get_monotonic_time_us();
+        bool is_readable;
+
+        if (socket_io_instance->io_state == IO_STATE_OPENING)
         {
-            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-            if (pending_socket_io == NULL)
+            continue_open(socket_io_instance);
+        }
+
+        /* when a reactor is running, idle sockets are skipped instead of being asked for data that is not there */
+        is_readable = (socket_io_instance->io_state == IO_STATE_OPEN) && is_socket_readable(socket_io_instance);
+
+        /* queued bytes are only retried once the reactor reports that the socket has room for them */
+        if (singlylinkedlist_get_head_item(socket_io_instance->pending_io_list) != NULL &&
+            is_socket_writable(socket_io_instance))
+        {
+            send_pending_ios(socket_io_instance);
+        }
+
+        check_send_queue_drained(socket_io_instance);
+
+        if (socket_io_instance->io_state == IO_STATE_OPEN && is_readable)
+        {
+            /* the receive buffer is only allocated once the connection actually has something to read */
+            if (resize_receive_buffer(socket_io_instance, socket_io_instance->recv_buffer_size) != 0)
             {
-                socket_io_instance->io_state = IO_STATE_ERROR;
+                LogError("Socketio_Failure: no receive buffer available.");
                 indicate_error(socket_io_instance);
-                LogError("Failure: retrieving socket from list");
-                break;
             }
-
-            signal(SIGPIPE, SIG_IGN);
-
-            int send_result = send(socket_io_instance->socket, pending_socket_io->bytes, pending_socket_io->size, 0);
-            if (send_result != pending_socket_io->size)
+            else
             {
-                if (send_result == INVALID_SOCKET)
+                int received = 0;
+                bool received_any = false;
+                do
                 {
-                    if (errno == EAGAIN) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
+                    received = recv(socket_io_instance->socket, socket_io_instance->recv_bytes, socket_io_instance->recv_bytes_size, 0);
+                    if (received > 0)
                     {
-                        /*do nothing until next dowork */
-                        break;
+                        received_any = true;
+                        socket_io_instance->statistics.bytes_received += (uint64_t)received;
+
+                        if (socket_io_instance->on_bytes_received != NULL)
+                        {
+                            /* Explicitly ignoring here the result of the callback */
+                            (void)socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, socket_io_instance->recv_bytes, received);
+                        }
+
+                        if (socket_io_instance->adaptive_recv_buffer &&
+                            (size_t)received == socket_io_instance->recv_bytes_size)
+                        {
+                            grow_receive_buffer(socket_io_instance);
+                        }
                     }
-                    else
+                    else if (received == 0)
                     {
-                        free(pending_socket_io->bytes);
-                        free(pending_socket_io);
-                        (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
-
-                        LogError("Failure: sending Socket information. errno=%d (%s).", errno, strerror(errno));
-                        socket_io_instance->io_state = IO_STATE_ERROR;
+                        // Do not log error here due to this is probably the socket being closed on the other end
                         indicate_error(socket_io_instance);
                     }
-                }
-                else
-                {
-                    /* simply wait until next dowork */
-                    (void)memmove(pending_socket_io->bytes, pending_socket_io->bytes + send_result, pending_socket_io->size - send_result);
-                    pending_socket_io->size -= send_result;
-                    break;
-                }
-            }
-            else
-            {
-                if (pending_socket_io->on_send_complete != NULL)
+                    else if (received < 0 && errno != EAGAIN)
+                    {
+                        LogError("Socketio_Failure: Receiving data from endpoint: errno=%d.", errno);
+                        indicate_error(socket_io_instance);
+                    }
+
+                } while (received > 0 && socket_io_instance->io_state == IO_STATE_OPEN);
+
+                if (socket_io_instance->adaptive_recv_buffer && !received_any)
                 {
-                    pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
+                    shrink_receive_buffer(socket_io_instance);
                 }
 
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
+                /* the kernel drops out of quick ack mode on its own, so it is re-armed after every read */
+                if (received_any &&
+                    socket_io_instance->io_state == IO_STATE_OPEN &&
+                    socket_io_instance->is_tuning_option_set[SOCKET_TUNING_OPTION_TCP_QUICKACK] &&
+                    socket_io_instance->tuning_option_values[SOCKET_TUNING_OPTION_TCP_QUICKACK] > 0)
                 {
-                    socket_io_instance->io_state = IO_STATE_ERROR;
-                    indicate_error(socket_io_instance);
-                    LogError("Failure: unable to remove socket from list");
+                    (void)apply_socket_tuning_option(socket_io_instance, socket_io_instance->socket, SOCKET_TUNING_OPTION_TCP_QUICKACK);
                 }
             }
-
-            first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
         }
-
-        if (socket_io_instance->io_state == IO_STATE_OPEN)
+        else if (socket_io_instance->adaptive_recv_buffer)
         {
-            int received = 0;
-            do
-            {
-                received = recv(socket_io_instance->socket, socket_io_instance->recv_bytes, RECEIVE_BYTES_VALUE, 0);
-                if (received > 0)
-                {
-                    if (socket_io_instance->on_bytes_received != NULL)
-                    {
-                        /* Explicitly ignoring here the result of the callback */
-                        (void)socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, socket_io_instance->recv_bytes, received);
-                    }
-                }
-                else if (received == 0)
-                {
-                    // Do not log error here due to this is probably the socket being closed on the other end
-                    indicate_error(socket_io_instance);
-                }
-                else if (received < 0 && errno != EAGAIN)
-                {
-                    LogError("Socketio_Failure: Receiving data from endpoint: errno=%d.", errno);
-                    indicate_error(socket_io_instance);
-                }
-
-            } while (received > 0 && socket_io_instance->io_state == IO_STATE_OPEN);
+            shrink_receive_buffer(socket_io_instance);
         }
+
+        /* this includes the time the upper layers spent in on_bytes_received */
+        record_dowork_duration(socket_io_instance, dowork_start_us);
+    }
+}
+
+int socketio_get_statistics(CONCRETE_IO_HANDLE socket_io, XIO_STATISTICS* statistics)
+{
+    int result;
+
+    if (socket_io == NULL || statistics == NULL)
+    {
+        LogError("Invalid argument: socket_io = %p, statistics = %p", socket_io, statistics);
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        *statistics = socket_io_instance->statistics;
+        result = 0;
     }
+
+    return result;
 }
 
 // Edison is missing this from netinet/tcp.h, but this code still works if we manually define it.
@@ -976,6 +1890,7 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
     else
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        int tuning_option_index;
 
         if (strcmp(optionName, "tcp_keepalive") == 0)
         {
@@ -1026,6 +1941,82 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
             }
 #endif
         }
+        else if ((tuning_option_index = find_socket_tuning_option(optionName)) >= 0)
+        {
+            if (!socket_tuning_options[tuning_option_index].is_supported)
+            {
+                LogError("option %s not supported on this platform.", optionName);
+                result = __FAILURE__;
+            }
+            else if (*(const int*)value < 0)
+            {
+                LogError("Invalid value %d for option %s.", *(const int*)value, optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                int previous_value = socket_io_instance->tuning_option_values[tuning_option_index];
+                bool was_set = socket_io_instance->is_tuning_option_set[tuning_option_index];
+                socket_io_instance->tuning_option_values[tuning_option_index] = *(const int*)value;
+                socket_io_instance->is_tuning_option_set[tuning_option_index] = true;
+
+                /* before open the value is only stored, it is applied when the socket gets created */
+                if (socket_io_instance->socket != INVALID_SOCKET &&
+                    apply_socket_tuning_option(socket_io_instance, socket_io_instance->socket, (SOCKET_TUNING_OPTION_INDEX)tuning_option_index) != 0)
+                {
+                    socket_io_instance->tuning_option_values[tuning_option_index] = previous_value;
+                    socket_io_instance->is_tuning_option_set[tuning_option_index] = was_set;
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+        }
+        else if (strcmp(optionName, OPTION_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            size_t recv_buffer_limit = *(const size_t*)value;
+            if ((recv_buffer_limit == 0) ||
+                (recv_buffer_limit > RECEIVE_BYTES_MAX_VALUE))
+            {
+                LogError("Invalid receive_buffer_size %lu, must be between 1 and %d.", (unsigned long)recv_buffer_limit, RECEIVE_BYTES_MAX_VALUE);
+                result = __FAILURE__;
+            }
+            else
+            {
+                socket_io_instance->recv_buffer_limit = recv_buffer_limit;
+                configure_receive_buffer(socket_io_instance);
+                result = 0;
+            }
+        }
+        else if (strcmp(optionName, OPTION_ADAPTIVE_RECEIVE_BUFFER) == 0)
+        {
+            socket_io_instance->adaptive_recv_buffer = *(const bool*)value;
+            configure_receive_buffer(socket_io_instance);
+            result = 0;
+        }
+        else if (strcmp(optionName, OPTION_SEND_QUEUE_HIGH_WATERMARK) == 0)
+        {
+            /* 0 disables backpressure, the queue then grows without bound */
+            socket_io_instance->send_queue_high_watermark = *(const size_t*)value;
+            result = 0;
+        }
+        else if (strcmp(optionName, OPTION_SEND_QUEUE_LOW_WATERMARK) == 0)
+        {
+            socket_io_instance->send_queue_low_watermark = *(const size_t*)value;
+            result = 0;
+        }
+        else if (strcmp(optionName, OPTION_ON_IO_WRITABLE) == 0)
+        {
+            socket_io_instance->on_io_writable = (ON_IO_WRITABLE)value;
+            result = 0;
+        }
+        else if (strcmp(optionName, OPTION_ON_IO_WRITABLE_CONTEXT) == 0)
+        {
+            socket_io_instance->on_io_writable_context = (void*)value;
+            result = 0;
+        }
         else
         {
             result = __FAILURE__;
@@ -7,11 +7,17 @@
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 #ifdef __cplusplus
+#include <cstddef>
 extern "C" {
+#else
+#include <stddef.h>
 #endif
 
 MOCKABLE_FUNCTION(, int, gb_rand);
 
+/* fills buffer with unpredictable bytes, served from a per thread block refilled from the platform CSPRNG */
+MOCKABLE_FUNCTION(, int, gb_rand_bytes, unsigned char*, buffer, size_t, size);
+
 #ifdef __cplusplus
 }
 #endif
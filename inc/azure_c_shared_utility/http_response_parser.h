@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef HTTP_RESPONSE_PARSER_H
+#define HTTP_RESPONSE_PARSER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#endif
+
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#define HTTP_RESPONSE_PARSER_RESULT_VALUES \
+    HTTP_RESPONSE_PARSER_NEED_MORE_BYTES, \
+    HTTP_RESPONSE_PARSER_COMPLETE, \
+    HTTP_RESPONSE_PARSER_ERROR
+
+DEFINE_ENUM(HTTP_RESPONSE_PARSER_RESULT, HTTP_RESPONSE_PARSER_RESULT_VALUES);
+
+/* Resumable parser for the head (status line and headers) of an HTTP/1.1 response.
+The bytes are owned by the caller, which keeps accumulating them in one buffer and passes the whole buffer
+on every call, so only offsets are kept here and the buffer may be reallocated between calls. */
+typedef struct HTTP_RESPONSE_PARSER_TAG
+{
+    size_t scanned_bytes;
+    size_t line_start;
+    size_t head_length;
+    int status_code;
+    bool is_status_line_parsed;
+} HTTP_RESPONSE_PARSER;
+
+MOCKABLE_FUNCTION(, void, http_response_parser_init, HTTP_RESPONSE_PARSER*, parser);
+MOCKABLE_FUNCTION(, HTTP_RESPONSE_PARSER_RESULT, http_response_parser_parse, HTTP_RESPONSE_PARSER*, parser, const unsigned char*, buffer, size_t, size);
+MOCKABLE_FUNCTION(, int, http_response_parser_parse_status_line, const char*, line, size_t, line_length, int*, status_code);
+MOCKABLE_FUNCTION(, bool, http_response_parser_get_header, const HTTP_RESPONSE_PARSER*, parser, const unsigned char*, buffer, const char*, header_name, const char**, value, size_t*, value_length);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* HTTP_RESPONSE_PARSER_H */
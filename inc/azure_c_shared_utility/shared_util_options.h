@@ -7,6 +7,8 @@
 #ifdef __cplusplus
 extern "C"
 {
+#else
+#include <stdbool.h>
 #endif
 
     typedef struct HTTP_PROXY_OPTIONS_TAG
@@ -36,7 +38,41 @@ extern "C"
 
     static const char* OPTION_NET_INT_MAC_ADDRESS = "net_interface_mac_address";
 
+    static const char* OPTION_RECEIVE_BUFFER_SIZE = "receive_buffer_size";
+    static const char* OPTION_ADAPTIVE_RECEIVE_BUFFER = "adaptive_receive_buffer";
+
+    static const char* OPTION_SEND_QUEUE_HIGH_WATERMARK = "send_queue_high_watermark";
+    static const char* OPTION_SEND_QUEUE_LOW_WATERMARK = "send_queue_low_watermark";
+    static const char* OPTION_ON_IO_WRITABLE = "on_io_writable";
+    static const char* OPTION_ON_IO_WRITABLE_CONTEXT = "on_io_writable_context";
+
     static const char* OPTION_TLS_VERSION = "tls_version";
+    static const char* OPTION_TLS_SESSION_RESUMPTION = "tls_session_resumption";
+    static const char* OPTION_TLS_SESSION = "tls_session";
+    static const char* OPTION_TLS_DECODE_BUFFER_SIZE = "tls_decode_buffer_size";
+    static const char* OPTION_TLS_DECODE_PER_RECORD = "tls_decode_per_record";
+    /* bool, runs the handshake steps on worker threads; the tls_validation_callback is then called from a worker thread */
+    static const char* OPTION_TLS_HANDSHAKE_OFFLOAD = "tls_handshake_offload";
+
+    /* permessage-deflate (RFC 7692) parameters, a window bits value of 0 means no limit is requested;
+       max_decompressed_message_size bounds the size a received message inflates to, 0 means 16 MB */
+    typedef struct WS_PERMESSAGE_DEFLATE_OPTIONS_TAG
+    {
+        bool client_no_context_takeover;
+        bool server_no_context_takeover;
+        int client_max_window_bits;
+        int server_max_window_bits;
+        size_t max_decompressed_message_size;
+    } WS_PERMESSAGE_DEFLATE_OPTIONS;
+
+    static const char* OPTION_WS_PERMESSAGE_DEFLATE = "ws_permessage_deflate";
+
+    /* size_t, frames sent between two dowork calls are packed into underlying sends of up to this many bytes, 0 disables it */
+    static const char* OPTION_WS_SEND_COALESCING_LIMIT = "ws_send_coalescing_limit";
+
+    /* ON_WS_FRAGMENT_RECEIVED and its context, data frame payload is then handed out as it arrives instead of as whole frames */
+    static const char* OPTION_WS_ON_FRAGMENT_RECEIVED = "ws_on_fragment_received";
+    static const char* OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT = "ws_on_fragment_received_context";
 
 #ifdef __cplusplus
 }
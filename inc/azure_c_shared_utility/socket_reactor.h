@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file socket_reactor.h
+ *	@brief	 Process-wide readiness reactor shared by socketio instances.
+ */
+
+#ifndef SOCKET_REACTOR_H
+#define SOCKET_REACTOR_H
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#else
+#include <stdbool.h>
+#endif /* __cplusplus */
+
+// The socket reactor lets many socketio instances share a single readiness poll. Instead of
+// each socketio_dowork issuing its own recv (which fails with EAGAIN for idle connections),
+// the reactor polls all registered sockets once per dowork round and socketio only reads from
+// the sockets reported as readable.
+//
+// The reactor is created by platform_init and destroyed by platform_deinit. When it is not
+// running socket_reactor_register returns NULL and callers fall back to polling the socket directly.
+
+typedef struct SOCKET_REACTOR_ENTRY_TAG* SOCKET_REACTOR_ENTRY_HANDLE;
+
+/**
+* @brief	Creates the process-wide reactor.
+*
+* @return	@c 0 if the reactor was created (or was already running), a non-zero value otherwise.
+*/
+MOCKABLE_FUNCTION(, int, socket_reactor_init);
+
+/**
+* @brief	Destroys the process-wide reactor. Entries still registered stop receiving readiness
+*           information and report themselves as always readable.
+*/
+MOCKABLE_FUNCTION(, void, socket_reactor_deinit);
+
+/**
+* @brief	Registers a connected socket with the reactor.
+*
+* @param	sock	The socket to be watched for incoming data.
+*
+* @return	A handle to the registration, or NULL if the reactor is not running or the socket could not be registered.
+*/
+MOCKABLE_FUNCTION(, SOCKET_REACTOR_ENTRY_HANDLE, socket_reactor_register, int, sock);
+
+/**
+* @brief	Removes a socket from the reactor. Must be called before the socket is closed.
+*
+* @param	entry	The handle returned by socket_reactor_register.
+*/
+MOCKABLE_FUNCTION(, void, socket_reactor_unregister, SOCKET_REACTOR_ENTRY_HANDLE, entry);
+
+/**
+* @brief	Indicates whether the socket has data (or a pending error/hangup) to be read.
+*           The reactor polls all registered sockets at most once per dowork round, the first
+*           time an entry is queried again after it has already observed the latest poll.
+*
+* @param	entry	The handle returned by socket_reactor_register.
+*
+* @return	@c true if the socket should be read, @c false if reading would block.
+*/
+MOCKABLE_FUNCTION(, bool, socket_reactor_is_readable, SOCKET_REACTOR_ENTRY_HANDLE, entry);
+
+/**
+* @brief	Adds or removes @c EPOLLOUT from the events watched for the socket. Callers should only
+*           be interested in writability while they have data queued that the socket refused.
+*
+* @param	entry	        The handle returned by socket_reactor_register.
+* @param	is_interested	@c true to watch the socket for writability, @c false to stop watching it.
+*
+* @return	@c 0 on success, a non-zero value otherwise.
+*/
+MOCKABLE_FUNCTION(, int, socket_reactor_set_write_interest, SOCKET_REACTOR_ENTRY_HANDLE, entry, bool, is_interested);
+
+/**
+* @brief	Indicates whether the latest poll reported the socket as writable. This does not poll by
+*           itself; it reports the poll issued by socket_reactor_is_readable for the current dowork round.
+*           Sockets that are not watched for writability are always reported as writable.
+*
+* @param	entry	The handle returned by socket_reactor_register.
+*
+* @return	@c true if the socket should be written, @c false if writing would block.
+*/
+MOCKABLE_FUNCTION(, bool, socket_reactor_is_writable, SOCKET_REACTOR_ENTRY_HANDLE, entry);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SOCKET_REACTOR_H */
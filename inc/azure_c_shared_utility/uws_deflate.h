@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UWS_DEFLATE_H
+#define UWS_DEFLATE_H
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+/* enough for an offer carrying every parameter, including the terminating zero */
+#define UWS_DEFLATE_MAX_OFFER_SIZE  160
+
+/* the bound used for received messages when max_decompressed_message_size is 0 */
+#ifndef UWS_DEFLATE_DEFAULT_MAX_DECOMPRESSED_MESSAGE_SIZE
+#define UWS_DEFLATE_DEFAULT_MAX_DECOMPRESSED_MESSAGE_SIZE (16 * 1024 * 1024)
+#endif
+
+/* returned by uws_deflate_decompress when a message inflates to more than max_decompressed_message_size bytes */
+#define UWS_DEFLATE_MESSAGE_TOO_BIG (-1)
+
+typedef struct UWS_DEFLATE_INSTANCE_TAG* UWS_DEFLATE_HANDLE;
+
+MOCKABLE_FUNCTION(, int, uws_deflate_format_offer, const WS_PERMESSAGE_DEFLATE_OPTIONS*, options, char*, buffer, size_t, buffer_size);
+MOCKABLE_FUNCTION(, int, uws_deflate_parse_response, const WS_PERMESSAGE_DEFLATE_OPTIONS*, offered_options, const char*, extensions, size_t, extensions_length, WS_PERMESSAGE_DEFLATE_OPTIONS*, negotiated_options, bool*, is_accepted);
+MOCKABLE_FUNCTION(, UWS_DEFLATE_HANDLE, uws_deflate_create, const WS_PERMESSAGE_DEFLATE_OPTIONS*, negotiated_options);
+MOCKABLE_FUNCTION(, void, uws_deflate_destroy, UWS_DEFLATE_HANDLE, uws_deflate);
+MOCKABLE_FUNCTION(, int, uws_deflate_compress, UWS_DEFLATE_HANDLE, uws_deflate, const unsigned char*, payload, size_t, size, bool, is_final, const unsigned char**, compressed, size_t*, compressed_size);
+MOCKABLE_FUNCTION(, void, uws_deflate_reset_compressor, UWS_DEFLATE_HANDLE, uws_deflate);
+MOCKABLE_FUNCTION(, int, uws_deflate_decompress, UWS_DEFLATE_HANDLE, uws_deflate, const unsigned char*, payload, size_t, size, bool, is_final, const unsigned char**, decompressed, size_t*, decompressed_size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UWS_DEFLATE_H */
@@ -16,6 +16,11 @@ MOCKABLE_FUNCTION(,int, x509_openssl_add_certificates, SSL_CTX*, ssl_ctx, const
 MOCKABLE_FUNCTION(,int, x509_openssl_add_credentials, SSL_CTX*, ssl_ctx, const char*, x509certificate, const char*, x509privatekey);
 MOCKABLE_FUNCTION(,int, x509_openssl_add_ecc_credentials, SSL_CTX*, ssl_ctx, const char*, ecc_alias_cert, const char*, ecc_alias_key);
 
+MOCKABLE_FUNCTION(, int, x509_openssl_init);
+MOCKABLE_FUNCTION(, void, x509_openssl_deinit);
+MOCKABLE_FUNCTION(, const char*, x509_openssl_pem_acquire, const char*, pem);
+MOCKABLE_FUNCTION(, void, x509_openssl_pem_release, const char*, pem);
+
 #ifdef __cplusplus
 }
 #endif 
@@ -5,15 +5,18 @@
 #define XIO_H
 
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/constbuffer.h"
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/macro_utils.h"
 
 #ifdef __cplusplus
 #include <cstddef>
+#include <cstdint>
 extern "C" {
 #else
 #include <stddef.h>
+#include <stdint.h>
 #endif /* __cplusplus */
 
 typedef struct XIO_INSTANCE_TAG* XIO_HANDLE;
@@ -38,6 +41,31 @@ typedef void(*ON_SEND_COMPLETE)(void* context, IO_SEND_RESULT send_result);
 typedef void(*ON_IO_OPEN_COMPLETE)(void* context, IO_OPEN_RESULT open_result);
 typedef void(*ON_IO_CLOSE_COMPLETE)(void* context);
 typedef void(*ON_IO_ERROR)(void* context);
+typedef void(*ON_IO_WRITABLE)(void* context);
+
+/* Returned by xio_send when the send queue is above its high watermark (see OPTION_SEND_QUEUE_HIGH_WATERMARK).
+   Nothing was queued and on_send_complete is not called; the data can be sent again once the
+   on_io_writable callback (OPTION_ON_IO_WRITABLE) reports that the queue drained below the low watermark. */
+#define XIO_SEND_WOULD_BLOCK    (-1)
+
+/* Counters kept by a concrete IO for the lifetime of the instance.
+   bytes_sent and bytes_received count the payload at the layer that is queried (plaintext for TLS,
+   message bytes for WebSockets). Layered IOs report the queue, would block and dowork counters of the
+   transport underneath them, since that is where a slow peer makes data pile up. */
+typedef struct XIO_STATISTICS_TAG
+{
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    /* bytes accepted by send that were not yet written to the transport, and the number of sends they belong to */
+    size_t queued_bytes;
+    size_t queued_send_count;
+    /* number of writes that could not complete because the transport would block (EAGAIN or a short write) */
+    uint64_t would_block_count;
+    /* number of dowork calls, and the total and longest time spent in them, in microseconds */
+    uint64_t dowork_count;
+    uint64_t dowork_total_us;
+    uint64_t dowork_max_us;
+} XIO_STATISTICS;
 
 typedef OPTIONHANDLER_HANDLE (*IO_RETRIEVEOPTIONS)(CONCRETE_IO_HANDLE concrete_io);
 typedef CONCRETE_IO_HANDLE(*IO_CREATE)(void* io_create_parameters);
@@ -47,6 +75,8 @@ typedef int(*IO_CLOSE)(CONCRETE_IO_HANDLE concrete_io, ON_IO_CLOSE_COMPLETE on_i
 typedef int(*IO_SEND)(CONCRETE_IO_HANDLE concrete_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context);
 typedef void(*IO_DOWORK)(CONCRETE_IO_HANDLE concrete_io);
 typedef int(*IO_SETOPTION)(CONCRETE_IO_HANDLE concrete_io, const char* optionName, const void* value);
+typedef int(*IO_SEND_CONSTBUFFER)(CONCRETE_IO_HANDLE concrete_io, CONSTBUFFER_HANDLE buffer, ON_SEND_COMPLETE on_send_complete, void* callback_context);
+typedef int(*IO_GET_STATISTICS)(CONCRETE_IO_HANDLE concrete_io, XIO_STATISTICS* statistics);
 
 
 typedef struct IO_INTERFACE_DESCRIPTION_TAG
@@ -59,6 +89,10 @@ typedef struct IO_INTERFACE_DESCRIPTION_TAG
     IO_SEND concrete_io_send;
     IO_DOWORK concrete_io_dowork;
     IO_SETOPTION concrete_io_setoption;
+    /* optional, IOs that leave it NULL receive a copy of the buffer content through concrete_io_send */
+    IO_SEND_CONSTBUFFER concrete_io_send_constbuffer;
+    /* optional, xio_get_statistics fails for IOs that leave it NULL */
+    IO_GET_STATISTICS concrete_io_get_statistics;
 } IO_INTERFACE_DESCRIPTION;
 
 MOCKABLE_FUNCTION(, XIO_HANDLE, xio_create, const IO_INTERFACE_DESCRIPTION*, io_interface_description, const void*, io_create_parameters);
@@ -66,9 +100,11 @@ MOCKABLE_FUNCTION(, void, xio_destroy, XIO_HANDLE, xio);
 MOCKABLE_FUNCTION(, int, xio_open, XIO_HANDLE, xio, ON_IO_OPEN_COMPLETE, on_io_open_complete, void*, on_io_open_complete_context, ON_BYTES_RECEIVED, on_bytes_received, void*, on_bytes_received_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context);
 MOCKABLE_FUNCTION(, int, xio_close, XIO_HANDLE, xio, ON_IO_CLOSE_COMPLETE, on_io_close_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, int, xio_send, XIO_HANDLE, xio, const void*, buffer, size_t, size, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+MOCKABLE_FUNCTION(, int, xio_send_constbuffer, XIO_HANDLE, xio, CONSTBUFFER_HANDLE, buffer, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, void, xio_dowork, XIO_HANDLE, xio);
 MOCKABLE_FUNCTION(, int, xio_setoption, XIO_HANDLE, xio, const char*, optionName, const void*, value);
 MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, xio_retrieveoptions, XIO_HANDLE, xio);
+MOCKABLE_FUNCTION(, int, xio_get_statistics, XIO_HANDLE, xio, XIO_STATISTICS*, statistics);
 
 #ifdef __cplusplus
 }
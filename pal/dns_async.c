@@ -2,6 +2,11 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+// getaddrinfo_a is a GNU extension
+#define _GNU_SOURCE
+#endif
+
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -24,19 +29,191 @@
 #define EXTRACT_IPV4(ptr) ((struct sockaddr_in *) ptr->ai_addr)->sin_addr.s_addr
 #endif
 
+typedef struct
+{
+    struct sockaddr_storage address;
+    size_t address_length;
+} DNS_ASYNC_ADDRESS;
+
 typedef struct
 {
     char* hostname;
+    int family;
     uint32_t ip_v4;
+    DNS_ASYNC_ADDRESS addresses[DNS_ASYNC_MAX_ADDRESSES];
+    size_t address_count;
     bool is_complete;
     bool is_failed;
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+    // The request and its hints are read by the resolver thread until the lookup completes
+    bool is_started;
+    struct addrinfo hints;
+    struct gaicb request;
+#endif
 } DNS_ASYNC_INSTANCE;
 
+static void add_address(DNS_ASYNC_INSTANCE* dns, const struct addrinfo* ptr)
+{
+    if ((ptr->ai_addrlen > 0) &&
+        (ptr->ai_addrlen <= sizeof(struct sockaddr_storage)) &&
+        (dns->address_count < DNS_ASYNC_MAX_ADDRESSES))
+    {
+        (void)memcpy(&dns->addresses[dns->address_count].address, ptr->ai_addr, ptr->ai_addrlen);
+        dns->addresses[dns->address_count].address_length = ptr->ai_addrlen;
+        dns->address_count++;
+    }
+}
+
+static void extract_addresses(DNS_ASYNC_INSTANCE* dns, struct addrinfo* addrInfo)
+{
+    struct addrinfo *ptr = NULL;
+    const struct addrinfo* by_family[2][DNS_ASYNC_MAX_ADDRESSES];
+    size_t family_count[2] = { 0, 0 };
+    size_t first_family = 0;
+    size_t i;
+
+    // If we find the AF_INET address, use it as the return value
+    for (ptr = addrInfo; ptr != NULL; ptr = ptr->ai_next)
+    {
+        size_t family_index;
+
+        switch (ptr->ai_family)
+        {
+        case AF_INET:
+            /* Codes_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the discovered IPv4 address. ]*/
+            dns->ip_v4 = EXTRACT_IPV4(ptr);
+            family_index = 0;
+            break;
+        default:
+            family_index = 1;
+            break;
+        }
+
+        if (ptr == addrInfo)
+        {
+            first_family = family_index;
+        }
+
+        if (family_count[family_index] < DNS_ASYNC_MAX_ADDRESSES)
+        {
+            by_family[family_index][family_count[family_index]++] = ptr;
+        }
+    }
+
+    /* Codes_SRS_DNS_ASYNC_01_004: [ The addresses shall alternate between address families, starting with the family of the first address returned by the resolver. ]*/
+    for (i = 0; i < DNS_ASYNC_MAX_ADDRESSES; i++)
+    {
+        if (i < family_count[first_family])
+        {
+            add_address(dns, by_family[first_family][i]);
+        }
+        if (i < family_count[1 - first_family])
+        {
+            add_address(dns, by_family[1 - first_family][i]);
+        }
+    }
+
+    /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
+    dns->is_failed = (dns->ip_v4 == 0) && (dns->address_count == 0);
+}
+
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+// Starts the lookup on the first call and polls it on the following ones. Returns true when the lookup is complete.
+static bool poll_lookup(DNS_ASYNC_INSTANCE* dns)
+{
+    bool result;
+
+    if (!dns->is_started)
+    {
+        struct gaicb* request_list[1];
+        int start_result;
+
+        memset(&dns->hints, 0, sizeof(dns->hints));
+        dns->hints.ai_family = dns->family;
+        dns->hints.ai_socktype = SOCK_STREAM;
+        dns->hints.ai_protocol = IPPROTO_TCP;
+
+        memset(&dns->request, 0, sizeof(dns->request));
+        dns->request.ar_name = dns->hostname;
+        dns->request.ar_request = &dns->hints;
+
+        request_list[0] = &dns->request;
+        /* Codes_SRS_DNS_ASYNC_01_030: [ The first call to dns_async_is_lookup_complete shall start the lookup by calling getaddrinfo_a in GAI_NOWAIT mode and return false. ]*/
+        start_result = getaddrinfo_a(GAI_NOWAIT, request_list, 1, NULL);
+        if (start_result != 0)
+        {
+            /* Codes_SRS_DNS_ASYNC_01_031: [ If getaddrinfo_a fails, dns_async_is_lookup_complete shall return true and the lookup shall be considered failed. ]*/
+            LogError("Failed starting DNS lookup for %s: %d", dns->hostname, start_result);
+            dns->is_failed = true;
+            result = true;
+        }
+        else
+        {
+            dns->is_started = true;
+            result = false;
+        }
+    }
+    else
+    {
+        int lookup_result = gai_error(&dns->request);
+        if (lookup_result == EAI_INPROGRESS)
+        {
+            /* Codes_SRS_DNS_ASYNC_01_032: [ The following calls shall return false as long as gai_error returns EAI_INPROGRESS. ]*/
+            result = false;
+        }
+        else
+        {
+            dns->is_started = false;
+
+            if (lookup_result == 0)
+            {
+                /* Codes_SRS_DNS_ASYNC_01_033: [ Once gai_error returns 0 the addresses shall be extracted from the result, which shall then be freed with freeaddrinfo. ]*/
+                extract_addresses(dns, dns->request.ar_result);
+                freeaddrinfo(dns->request.ar_result);
+            }
+            else
+            {
+                /* Codes_SRS_DNS_ASYNC_01_034: [ Once gai_error returns any other value the lookup shall be considered failed. ]*/
+                LogInfo("Failed DNS lookup for %s: %d", dns->hostname, lookup_result);
+                dns->is_failed = true;
+            }
+
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+// A lookup that cannot be cancelled still references the instance, so it has to finish before the instance is freed
+static void cancel_lookup(DNS_ASYNC_INSTANCE* dns)
+{
+    if (dns->is_started)
+    {
+        /* Codes_SRS_DNS_ASYNC_01_035: [ When built with DNS_ASYNC_USE_GETADDRINFO_A, a lookup still running shall be cancelled with gai_cancel. If it cannot be cancelled, dns_async_destroy shall wait for it with gai_suspend and free its result before deleting the DNS_ASYNC_HANDLE. ]*/
+        if (gai_cancel(&dns->request) == EAI_NOTCANCELED)
+        {
+            const struct gaicb* request_list[1];
+            request_list[0] = &dns->request;
+            while (gai_error(&dns->request) == EAI_INPROGRESS)
+            {
+                (void)gai_suspend(request_list, 1, NULL);
+            }
+        }
+
+        if (gai_error(&dns->request) == 0)
+        {
+            freeaddrinfo(dns->request.ar_result);
+        }
+
+        dns->is_started = false;
+    }
+}
+#endif
+
 DNS_ASYNC_HANDLE dns_async_create(const char* hostname, DNS_ASYNC_OPTIONS* options)
 {
-    /* Codes_SRS_DNS_ASYNC_30_012: [ The optional options parameter shall be ignored. ]*/
     DNS_ASYNC_INSTANCE* result;
-    (void)options;
     if (hostname == NULL)
     {
         /* Codes_SRS_DNS_ASYNC_30_011: [ If the hostname parameter is NULL, dns_async_create shall log an error and return NULL. ]*/
@@ -58,6 +235,13 @@ DNS_ASYNC_HANDLE dns_async_create(const char* hostname, DNS_ASYNC_OPTIONS* optio
             result->is_complete = false;
             result->is_failed = false;
             result->ip_v4 = 0;
+            result->address_count = 0;
+            /* Codes_SRS_DNS_ASYNC_01_001: [ If options is NULL or options->dual_stack is false, only IPv4 addresses shall be looked up. ]*/
+            /* Codes_SRS_DNS_ASYNC_01_002: [ If options->dual_stack is true, both IPv4 and IPv6 addresses shall be looked up. ]*/
+            result->family = (options != NULL && options->dual_stack) ? AF_UNSPEC : AF_INET;
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+            result->is_started = false;
+#endif
             /* Codes_SRS_DNS_ASYNC_30_010: [ dns_async_create shall make a copy of the hostname parameter to allow immediate deletion by the caller. ]*/
             ms_result = mallocAndStrcpy_s(&result->hostname, hostname);
             if (ms_result != 0)
@@ -92,8 +276,14 @@ bool dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns_in)
         }
         else
         {
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+            /* Codes_SRS_DNS_ASYNC_30_021: [ dns_async_is_create_complete shall perform the asynchronous work of DNS lookup and log any errors. ]*/
+            /* Codes_SRS_DNS_ASYNC_30_023: [ If the DNS lookup process is not yet complete, dns_async_is_create_complete shall return false. ]*/
+            /* Codes_SRS_DNS_ASYNC_30_022: [ If the DNS lookup process has completed, dns_async_is_create_complete shall return true. ]*/
+            dns->is_complete = poll_lookup(dns);
+            result = dns->is_complete;
+#else
             struct addrinfo *addrInfo = NULL;
-            struct addrinfo *ptr = NULL;
             struct addrinfo hints;
 			int getAddrResult;
 
@@ -106,7 +296,7 @@ bool dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns_in)
             // Setup the hints address info structure
             // which is passed to the getaddrinfo() function
             memset(&hints, 0, sizeof(hints));
-            hints.ai_family = AF_INET;
+            hints.ai_family = dns->family;
             hints.ai_socktype = SOCK_STREAM;
             hints.ai_protocol = IPPROTO_TCP;
 
@@ -118,19 +308,7 @@ bool dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns_in)
             getAddrResult = getaddrinfo(dns->hostname, NULL, &hints, &addrInfo);
             if (getAddrResult == 0)
             {
-                // If we find the AF_INET address, use it as the return value
-                for (ptr = addrInfo; ptr != NULL; ptr = ptr->ai_next)
-                {
-                    switch (ptr->ai_family)
-                    {
-                    case AF_INET:
-                        /* Codes_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the discovered IPv4 address. ]*/
-                        dns->ip_v4 = EXTRACT_IPV4(ptr);
-                        break;
-                    }
-                }
-                /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
-                dns->is_failed = (dns->ip_v4 == 0);
+                extract_addresses(dns, addrInfo);
                 freeaddrinfo(addrInfo);
             }
             else
@@ -143,6 +321,7 @@ bool dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns_in)
             /* Codes_SRS_DNS_ASYNC_30_023: [ If the DNS lookup process is not yet complete, dns_async_is_create_complete shall return false. ]*/
             /* Codes_SRS_DNS_ASYNC_30_022: [ If the DNS lookup process has completed, dns_async_is_create_complete shall return true. ]*/
             result = true;
+#endif
         }
     }
 
@@ -160,6 +339,9 @@ void dns_async_destroy(DNS_ASYNC_HANDLE dns_in)
     else
     {
         /* Codes_SRS_DNS_ASYNC_30_051: [ dns_async_destroy shall delete all acquired resources and delete the DNS_ASYNC_HANDLE. ]*/
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+        cancel_lookup(dns);
+#endif
         free(dns->hostname);
         free(dns);
     }
@@ -199,3 +381,52 @@ uint32_t dns_async_get_ipv4(DNS_ASYNC_HANDLE dns_in)
     }
     return result;
 }
+
+size_t dns_async_get_address_count(DNS_ASYNC_HANDLE dns_in)
+{
+    DNS_ASYNC_INSTANCE* dns = (DNS_ASYNC_INSTANCE*)dns_in;
+    size_t result;
+    if (dns == NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_01_010: [ If the dns parameter is NULL, dns_async_get_address_count shall log an error and return 0. ]*/
+        LogError("NULL dns");
+        result = 0;
+    }
+    else if (!dns->is_complete)
+    {
+        /* Codes_SRS_DNS_ASYNC_01_011: [ If dns_async_is_lookup_complete has not yet returned true, dns_async_get_address_count shall log an error and return 0. ]*/
+        LogError("dns_async_get_address_count when not complete");
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_DNS_ASYNC_01_012: [ Otherwise dns_async_get_address_count shall return the number of addresses found, at most DNS_ASYNC_MAX_ADDRESSES. ]*/
+        result = dns->address_count;
+    }
+    return result;
+}
+
+const struct sockaddr* dns_async_get_address(DNS_ASYNC_HANDLE dns_in, size_t index, size_t* address_length)
+{
+    DNS_ASYNC_INSTANCE* dns = (DNS_ASYNC_INSTANCE*)dns_in;
+    const struct sockaddr* result;
+    if (dns == NULL || address_length == NULL)
+    {
+        /* Codes_SRS_DNS_ASYNC_01_020: [ If the dns or address_length parameter is NULL, dns_async_get_address shall log an error and return NULL. ]*/
+        LogError("Invalid argument: dns=%p, address_length=%p", dns, address_length);
+        result = NULL;
+    }
+    else if (!dns->is_complete || index >= dns->address_count)
+    {
+        /* Codes_SRS_DNS_ASYNC_01_021: [ If the lookup is not complete or index is not lower than the address count, dns_async_get_address shall log an error and return NULL. ]*/
+        LogError("No address %lu available", (unsigned long)index);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_DNS_ASYNC_01_022: [ Otherwise dns_async_get_address shall return the address at position index and set address_length to its length. ]*/
+        result = (const struct sockaddr*)&dns->addresses[index].address;
+        *address_length = dns->addresses[index].address_length;
+    }
+    return result;
+}
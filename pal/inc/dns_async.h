@@ -12,13 +12,28 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
+// The largest number of addresses a lookup keeps for dns_async_get_address
+#ifndef DNS_ASYNC_MAX_ADDRESSES
+#define DNS_ASYNC_MAX_ADDRESSES 8
+#endif
+
+    struct sockaddr;
+
     typedef void* DNS_ASYNC_HANDLE;
 
-    // If options are added in future, DNS_ASYNC_OPTIONS will become a struct containing the options
-    typedef void DNS_ASYNC_OPTIONS;
+    typedef struct DNS_ASYNC_OPTIONS_TAG
+    {
+        // true to look up both IPv4 and IPv6 addresses, false (the default when no options are given) for IPv4 only
+        bool dual_stack;
+        // It is acceptable to extend this struct by adding members for future enhancement,
+        // but existing members must not be altered to ensure back-compatibility.
+    } DNS_ASYNC_OPTIONS;
 
     /**
     * @brief	Begin the process of an asynchronous DNS lookup.
@@ -47,6 +62,30 @@ extern "C" {
     */
     MOCKABLE_FUNCTION(, uint32_t, dns_async_get_ipv4, DNS_ASYNC_HANDLE, dns);
 
+    /**
+    * @brief	Return the number of addresses found by a completed lookup process. Call only after dns_async_is_lookup_complete indicates completion.
+    *           The addresses alternate between the IPv6 and IPv4 families, starting with the family of the
+    *           resolver's first answer, which is the order in which connection attempts should be made (RFC 8305).
+    *
+    * @param   dns	The DNS_ASYNC_HANDLE.
+    *
+    * @return	@c The number of addresses, at most DNS_ASYNC_MAX_ADDRESSES. 0 indicates failure or not finished.
+    */
+    MOCKABLE_FUNCTION(, size_t, dns_async_get_address_count, DNS_ASYNC_HANDLE, dns);
+
+    /**
+    * @brief	Return one of the addresses found by a completed lookup process.
+    *
+    * @param   dns	The DNS_ASYNC_HANDLE.
+    *
+    * @param   index	The address index, lower than dns_async_get_address_count.
+    *
+    * @param   address_length	Receives the length of the returned address.
+    *
+    * @return	@c The address, owned by the DNS_ASYNC_HANDLE, or NULL on failure. The port is not set.
+    */
+    MOCKABLE_FUNCTION(, const struct sockaddr*, dns_async_get_address, DNS_ASYNC_HANDLE, dns, size_t, index, size_t*, address_length);
+
     /**
     * @brief	Destroy the module.
     *
@@ -180,7 +180,7 @@ int socket_async_is_create_complete(SOCKET_ASYNC_HANDLE sock, bool* is_complete)
         FD_SET(sock, &errset);
 
         tv.tv_sec = 0;
-        tv.tv_sec = 0;
+        tv.tv_usec = 0;
         select_ret = select(sock + 1, NULL, &writeset, &errset, &tv);
         if (select_ret < 0)
         {
@@ -0,0 +1,296 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures how TLS handshake throughput scales with the number of threads. Every thread opens and
+// closes its own connections to the given server back to back; session resumption is turned off so
+// that each open is a full handshake.
+//
+// usage: tlsio_handshake_perf <host> <port> [max_threads] [handshakes_per_thread] [trusted_certs.pem]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/xio.h"
+
+#define DEFAULT_MAX_THREADS             8
+#define DEFAULT_HANDSHAKES_PER_THREAD   100
+
+typedef enum OPEN_STATE_TAG
+{
+    OPEN_STATE_PENDING,
+    OPEN_STATE_OPEN,
+    OPEN_STATE_FAILED
+} OPEN_STATE;
+
+typedef struct BENCHMARK_CONFIG_TAG
+{
+    const char* hostname;
+    int port;
+    const char* trusted_certs;
+    int handshake_count;
+} BENCHMARK_CONFIG;
+
+typedef struct WORKER_TAG
+{
+    const BENCHMARK_CONFIG* config;
+    int completed_count;
+    int failed_count;
+} WORKER;
+
+/* the tick counter only has a one second resolution on some platforms */
+static uint64_t get_time_ms(void)
+{
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64();
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000) + ((uint64_t)now.tv_nsec / 1000000);
+#endif
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    *(OPEN_STATE*)context = (open_result == IO_OPEN_OK) ? OPEN_STATE_OPEN : OPEN_STATE_FAILED;
+}
+
+static void on_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context, (void)buffer, (void)size;
+}
+
+static void on_io_error(void* context)
+{
+    *(OPEN_STATE*)context = OPEN_STATE_FAILED;
+}
+
+static bool do_handshake(const BENCHMARK_CONFIG* config)
+{
+    bool result = false;
+    TLSIO_CONFIG tlsio_config = { config->hostname, config->port, NULL, NULL };
+    XIO_HANDLE tlsio = xio_create(platform_get_default_tlsio(), &tlsio_config);
+
+    if (tlsio != NULL)
+    {
+        OPEN_STATE open_state = OPEN_STATE_PENDING;
+        bool tls_session_resumption = false;
+        int tls_version = 12;
+
+        (void)xio_setoption(tlsio, OPTION_TLS_SESSION_RESUMPTION, &tls_session_resumption);
+        (void)xio_setoption(tlsio, OPTION_TLS_VERSION, &tls_version);
+        if (config->trusted_certs != NULL)
+        {
+            (void)xio_setoption(tlsio, OPTION_TRUSTED_CERT, config->trusted_certs);
+        }
+
+        if (xio_open(tlsio, on_io_open_complete, &open_state, on_io_bytes_received, NULL, on_io_error, &open_state) == 0)
+        {
+            while (open_state == OPEN_STATE_PENDING)
+            {
+                xio_dowork(tlsio);
+            }
+
+            result = (open_state == OPEN_STATE_OPEN);
+            (void)xio_close(tlsio, NULL, NULL);
+        }
+
+        xio_destroy(tlsio);
+    }
+
+    return result;
+}
+
+static int worker_thread(void* arg)
+{
+    WORKER* worker = (WORKER*)arg;
+    int i;
+
+    for (i = 0; i < worker->config->handshake_count; i++)
+    {
+        if (do_handshake(worker->config))
+        {
+            worker->completed_count++;
+        }
+        else
+        {
+            worker->failed_count++;
+        }
+    }
+
+    return 0;
+}
+
+static int run_round(const BENCHMARK_CONFIG* config, int thread_count)
+{
+    int result;
+    THREAD_HANDLE* threads = (THREAD_HANDLE*)malloc(thread_count * sizeof(THREAD_HANDLE));
+    WORKER* workers = (WORKER*)malloc(thread_count * sizeof(WORKER));
+
+    if (threads == NULL || workers == NULL)
+    {
+        (void)printf("Cannot allocate the workers.\r\n");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uint64_t start_ms;
+        uint64_t end_ms;
+        int started_count;
+        int completed_count = 0;
+        int failed_count = 0;
+        int i;
+
+        start_ms = get_time_ms();
+
+        for (started_count = 0; started_count < thread_count; started_count++)
+        {
+            workers[started_count].config = config;
+            workers[started_count].completed_count = 0;
+            workers[started_count].failed_count = 0;
+
+            if (ThreadAPI_Create(&threads[started_count], worker_thread, &workers[started_count]) != THREADAPI_OK)
+            {
+                (void)printf("Cannot start thread %d.\r\n", started_count);
+                break;
+            }
+        }
+
+        for (i = 0; i < started_count; i++)
+        {
+            int thread_result;
+            (void)ThreadAPI_Join(threads[i], &thread_result);
+            completed_count += workers[i].completed_count;
+            failed_count += workers[i].failed_count;
+        }
+
+        end_ms = get_time_ms();
+
+        if (started_count != thread_count)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            uint64_t elapsed_ms = (end_ms > start_ms) ? (end_ms - start_ms) : 1;
+
+            (void)printf("threads=%3d handshakes=%6d failed=%4d elapsed_ms=%7lu handshakes/s=%9.1f\r\n",
+                thread_count, completed_count, failed_count, (unsigned long)elapsed_ms,
+                (double)completed_count * 1000.0 / (double)elapsed_ms);
+            result = 0;
+        }
+    }
+
+    free(workers);
+    free(threads);
+
+    return result;
+}
+
+static char* read_file(const char* path)
+{
+    char* result = NULL;
+    FILE* file = fopen(path, "rb");
+
+    if (file != NULL)
+    {
+        long size;
+
+        if (fseek(file, 0, SEEK_END) == 0 &&
+            (size = ftell(file)) > 0 &&
+            fseek(file, 0, SEEK_SET) == 0 &&
+            (result = (char*)malloc((size_t)size + 1)) != NULL)
+        {
+            if (fread(result, 1, (size_t)size, file) != (size_t)size)
+            {
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result[size] = '\0';
+            }
+        }
+
+        (void)fclose(file);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+
+    if (argc < 3)
+    {
+        (void)printf("usage: %s <host> <port> [max_threads] [handshakes_per_thread] [trusted_certs.pem]\r\n", argv[0]);
+        result = __FAILURE__;
+    }
+    else
+    {
+        BENCHMARK_CONFIG config;
+        char* trusted_certs = NULL;
+        int max_threads = (argc > 3) ? atoi(argv[3]) : DEFAULT_MAX_THREADS;
+
+        config.hostname = argv[1];
+        config.port = atoi(argv[2]);
+        config.handshake_count = (argc > 4) ? atoi(argv[4]) : DEFAULT_HANDSHAKES_PER_THREAD;
+        config.trusted_certs = NULL;
+
+        if (argc > 5 && (trusted_certs = read_file(argv[5])) == NULL)
+        {
+            (void)printf("Cannot read %s.\r\n", argv[5]);
+            result = __FAILURE__;
+        }
+        else if (max_threads <= 0 || config.handshake_count <= 0)
+        {
+            (void)printf("max_threads and handshakes_per_thread must be positive.\r\n");
+            result = __FAILURE__;
+        }
+        else if (platform_init() != 0)
+        {
+            (void)printf("Cannot initialize platform.\r\n");
+            result = __FAILURE__;
+        }
+        else
+        {
+            int thread_count;
+
+            config.trusted_certs = trusted_certs;
+            result = 0;
+
+            /* 1, 2, 4, ... threads, ending with max_threads */
+            for (thread_count = 1; result == 0; thread_count *= 2)
+            {
+                if (thread_count > max_threads)
+                {
+                    thread_count = max_threads;
+                }
+
+                result = run_round(&config, thread_count);
+
+                if (thread_count == max_threads)
+                {
+                    break;
+                }
+            }
+
+            platform_deinit();
+        }
+
+        free(trusted_certs);
+    }
+
+    return result;
+}
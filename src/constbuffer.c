@@ -102,6 +102,39 @@ CONSTBUFFER_HANDLE CONSTBUFFER_CreateFromBuffer(BUFFER_HANDLE buffer)
     return (CONSTBUFFER_HANDLE)result;
 }
 
+CONSTBUFFER_HANDLE CONSTBUFFER_CreateWithMoveMemory(unsigned char* source, size_t size)
+{
+    CONSTBUFFER_HANDLE_DATA* result;
+    /*Codes_SRS_CONSTBUFFER_01_001: [If source is NULL and size is different than 0 then CONSTBUFFER_CreateWithMoveMemory shall fail and return NULL.]*/
+    if (
+        (source == NULL) &&
+        (size != 0)
+        )
+    {
+        LogError("invalid arguments passes to CONSTBUFFER_CreateWithMoveMemory");
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_CONSTBUFFER_01_004: [The non-NULL handle returned by CONSTBUFFER_CreateWithMoveMemory shall have its ref count set to "1".]*/
+        result = REFCOUNT_TYPE_CREATE(CONSTBUFFER_HANDLE_DATA);
+        if (result == NULL)
+        {
+            /*Codes_SRS_CONSTBUFFER_01_005: [If any error occurs, CONSTBUFFER_CreateWithMoveMemory shall fail and return NULL.]*/
+            LogError("unable to malloc");
+            /*return as is*/
+        }
+        else
+        {
+            /*Codes_SRS_CONSTBUFFER_01_002: [Otherwise, CONSTBUFFER_CreateWithMoveMemory shall take ownership of the memory area pointed to by source, without copying it.]*/
+            /*Codes_SRS_CONSTBUFFER_01_003: [Otherwise CONSTBUFFER_CreateWithMoveMemory shall return a non-NULL handle.]*/
+            result->alias.buffer = source;
+            result->alias.size = size;
+        }
+    }
+    return (CONSTBUFFER_HANDLE)result;
+}
+
 CONSTBUFFER_HANDLE CONSTBUFFER_Clone(CONSTBUFFER_HANDLE constbufferHandle)
 {
     if (constbufferHandle == NULL)
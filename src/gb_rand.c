@@ -1,16 +1,236 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#ifdef _WIN32
+/* needed for rand_s */
+#define _CRT_RAND_S
+#elif defined(__linux__)
+/* needed for syscall */
+#define _DEFAULT_SOURCE
+#endif
+
 #ifdef __cplusplus
 #include <cstdlib>
+#include <cstddef>
+#include <cstring>
 #else
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+#if defined(__linux__)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
 #endif
 
 #include "azure_c_shared_utility/gb_rand.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/optimize_size.h"
+
+/* size of the per thread block of random bytes that gb_rand_bytes serves from */
+#define GB_RAND_BLOCK_SIZE 256
+
+#if defined(_MSC_VER)
+#define GB_RAND_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define GB_RAND_THREAD_LOCAL __thread
+#endif
+
+/* a forked child must not hand out the bytes its parent still has in the block */
+#if defined(GB_RAND_THREAD_LOCAL) && (defined(__linux__) || defined(__APPLE__))
+#define GB_RAND_DISCARD_ON_FORK
+#endif
 
 /*this is rand*/
 int gb_rand(void)
 {
     return rand();
 }
+
+/* fills buffer with size bytes from the platform CSPRNG */
+static int fill_from_platform(unsigned char* buffer, size_t size)
+{
+    int result;
+
+#if defined(__linux__)
+    size_t filled = 0;
+
+    result = 0;
+#ifdef SYS_getrandom
+    while (filled < size)
+    {
+        long read_bytes = syscall(SYS_getrandom, buffer + filled, size - filled, 0);
+        if (read_bytes < 0)
+        {
+            if (errno != EINTR)
+            {
+                break;
+            }
+        }
+        else
+        {
+            filled += (size_t)read_bytes;
+        }
+    }
+#endif
+
+    if (filled < size)
+    {
+        /* kernels older than 3.17 do not have getrandom */
+        int fd = open("/dev/urandom", O_RDONLY);
+        if (fd < 0)
+        {
+            LogError("Cannot open /dev/urandom");
+            result = __FAILURE__;
+        }
+        else
+        {
+            while (filled < size)
+            {
+                ssize_t read_bytes = read(fd, buffer + filled, size - filled);
+                if (read_bytes < 0)
+                {
+                    if (errno != EINTR)
+                    {
+                        LogError("Cannot read from /dev/urandom");
+                        result = __FAILURE__;
+                        break;
+                    }
+                }
+                else if (read_bytes == 0)
+                {
+                    LogError("Unexpected end of /dev/urandom");
+                    result = __FAILURE__;
+                    break;
+                }
+                else
+                {
+                    filled += (size_t)read_bytes;
+                }
+            }
+
+            (void)close(fd);
+        }
+    }
+#elif defined(_WIN32)
+    size_t i;
+
+    result = 0;
+    for (i = 0; i < size; i += sizeof(unsigned int))
+    {
+        unsigned int random_value;
+        size_t to_copy = size - i < sizeof(random_value) ? size - i : sizeof(random_value);
+
+        if (rand_s(&random_value) != 0)
+        {
+            LogError("rand_s failed");
+            result = __FAILURE__;
+            break;
+        }
+
+        (void)memcpy(buffer + i, &random_value, to_copy);
+    }
+#elif defined(__APPLE__)
+    arc4random_buf(buffer, size);
+    result = 0;
+#else
+    /* no CSPRNG known for this platform, fall back to rand */
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        buffer[i] = (unsigned char)rand();
+    }
+
+    result = 0;
+#endif
+
+    return result;
+}
+
+#ifdef GB_RAND_THREAD_LOCAL
+static GB_RAND_THREAD_LOCAL unsigned char random_block[GB_RAND_BLOCK_SIZE];
+static GB_RAND_THREAD_LOCAL size_t random_block_position = GB_RAND_BLOCK_SIZE;
+#endif
+
+#ifdef GB_RAND_DISCARD_ON_FORK
+static pthread_once_t fork_handler_once = PTHREAD_ONCE_INIT;
+
+/* runs in the child on the thread that called fork, the only thread the child has */
+static void discard_random_block(void)
+{
+    (void)memset(random_block, 0, sizeof(random_block));
+    random_block_position = GB_RAND_BLOCK_SIZE;
+}
+
+static void register_fork_handler(void)
+{
+    if (pthread_atfork(NULL, NULL, discard_random_block) != 0)
+    {
+        LogError("Cannot register the fork handler");
+    }
+}
+#endif
+
+int gb_rand_bytes(unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if ((buffer == NULL) && (size > 0))
+    {
+        LogError("Invalid arguments: NULL buffer, size=%u", (unsigned int)size);
+        result = __FAILURE__;
+    }
+#ifdef GB_RAND_THREAD_LOCAL
+    else if (size > GB_RAND_BLOCK_SIZE / 4)
+    {
+        /* large requests do not go through the block, they would just drain it */
+        result = fill_from_platform(buffer, size);
+    }
+    else
+    {
+        result = 0;
+
+        if (GB_RAND_BLOCK_SIZE - random_block_position < size)
+        {
+#ifdef GB_RAND_DISCARD_ON_FORK
+            /* the block only holds bytes once it has been filled, so registering here is early enough */
+            (void)pthread_once(&fork_handler_once, register_fork_handler);
+#endif
+
+            if (fill_from_platform(random_block, GB_RAND_BLOCK_SIZE) != 0)
+            {
+                LogError("Cannot refill random block");
+                result = __FAILURE__;
+            }
+            else
+            {
+                random_block_position = 0;
+            }
+        }
+
+        if (result == 0)
+        {
+            (void)memcpy(buffer, random_block + random_block_position, size);
+
+            /* bytes that were handed out are not kept around */
+            (void)memset(random_block + random_block_position, 0, size);
+            random_block_position += size;
+        }
+    }
+#else
+    else
+    {
+        result = fill_from_platform(buffer, size);
+    }
+#endif
+
+    return result;
+}
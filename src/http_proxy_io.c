@@ -13,6 +13,7 @@
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/http_proxy_io.h"
 #include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/http_response_parser.h"
 
 typedef enum HTTP_PROXY_IO_STATE_TAG
 {
@@ -44,6 +45,9 @@ typedef struct HTTP_PROXY_IO_INSTANCE_TAG
     XIO_HANDLE underlying_io;
     unsigned char* receive_buffer;
     size_t receive_buffer_size;
+    HTTP_RESPONSE_PARSER connect_response_parser;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
 } HTTP_PROXY_IO_INSTANCE;
 
 static CONCRETE_IO_HANDLE http_proxy_io_create(void* io_create_parameters)
@@ -186,6 +190,9 @@ static CONCRETE_IO_HANDLE http_proxy_io_create(void* io_create_parameters)
                                         result->proxy_port = http_proxy_io_config->proxy_port;
                                         result->receive_buffer = NULL;
                                         result->receive_buffer_size = 0;
+                                        http_response_parser_init(&result->connect_response_parser);
+                                        result->bytes_sent = 0;
+                                        result->bytes_received = 0;
                                         result->http_proxy_io_state = HTTP_PROXY_IO_STATE_CLOSED;
                                     }
                                 }
@@ -508,101 +515,6 @@ static void on_underlying_io_close_complete(void* context)
     }
 }
 
-/*the following function does the same as sscanf(pos2, "%d", &sec)*/
-/*this function only exists because some of platforms do not have sscanf. */
-static int ParseStringToDecimal(const char *src, int* dst)
-{
-    int result;
-    char* next;
-
-    (*dst) = (int)strtol(src, &next, 0);
-    if ((src == next) || ((((*dst) == INT_MAX) || ((*dst) == INT_MIN)) && (errno != 0)))
-    {
-        result = __LINE__;
-    }
-    else
-    {
-        result = 0;
-    }
-
-    return result;
-}
-
-/*the following function does the same as sscanf(buf, "HTTP/%*d.%*d %d %*[^\r\n]", &ret) */
-/*this function only exists because some of platforms do not have sscanf. This is not a full implementation; it only works with well-defined HTTP response. */
-static int ParseHttpResponse(const char* src, int* dst)
-{
-    int result;
-    static const char HTTPPrefix[] = "HTTP/";
-    bool fail;
-    const char* runPrefix;
-
-    if ((src == NULL) || (dst == NULL))
-    {
-        result = __LINE__;
-    }
-    else
-    {
-        fail = false;
-        runPrefix = HTTPPrefix;
-
-        while ((*runPrefix) != '\0')
-        {
-            if ((*runPrefix) != (*src))
-            {
-                fail = true;
-                break;
-            }
-            src++;
-            runPrefix++;
-        }
-
-        if (!fail)
-        {
-            while ((*src) != '.')
-            {
-                if ((*src) == '\0')
-                {
-                    fail = true;
-                    break;
-                }
-                src++;
-            }
-        }
-
-        if (!fail)
-        {
-            while ((*src) != ' ')
-            {
-                if ((*src) == '\0')
-                {
-                    fail = true;
-                    break;
-                }
-                src++;
-            }
-        }
-
-        if (fail)
-        {
-            result = __LINE__;
-        }
-        else
-        {
-            if (ParseStringToDecimal(src, dst) != 0)
-            {
-                result = __LINE__;
-            }
-            else
-            {
-                result = 0;
-            }
-        }
-    }
-
-    return result;
-}
-
 static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
     if (context == NULL)
@@ -630,7 +542,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
         case HTTP_PROXY_IO_STATE_WAITING_FOR_CONNECT_RESPONSE:
         {
             /* Codes_SRS_HTTP_PROXY_IO_01_065: [ When bytes are received and the response to the CONNECT request was not yet received, the bytes shall be accumulated until a double new-line is detected. ]*/
-            unsigned char* new_receive_buffer = (unsigned char*)realloc(http_proxy_io_instance->receive_buffer, http_proxy_io_instance->receive_buffer_size + size + 1);
+            unsigned char* new_receive_buffer = (unsigned char*)realloc(http_proxy_io_instance->receive_buffer, http_proxy_io_instance->receive_buffer_size + size);
             if (new_receive_buffer == NULL)
             {
                 /* Codes_SRS_HTTP_PROXY_IO_01_067: [ If allocating memory for the buffered bytes fails, the `on_open_complete` callback shall be triggered with `IO_OPEN_ERROR`, passing also the `on_open_complete_context` argument as `context`. ]*/
@@ -639,35 +551,31 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
             }
             else
             {
+                HTTP_RESPONSE_PARSER_RESULT parse_result;
+
                 http_proxy_io_instance->receive_buffer = new_receive_buffer;
                 memcpy(http_proxy_io_instance->receive_buffer + http_proxy_io_instance->receive_buffer_size, buffer, size);
                 http_proxy_io_instance->receive_buffer_size += size;
-            }
 
-            if (http_proxy_io_instance->receive_buffer_size >= 4)
-            {
-                const char* request_end_ptr;
-
-                http_proxy_io_instance->receive_buffer[http_proxy_io_instance->receive_buffer_size] = 0;
+                /* This part should really be done with the HTTPAPI, but that has to be done as a separate step
+                as the HTTPAPI has to expose somehow the underlying IO and currently this would be a too big of a change. */
 
                 /* Codes_SRS_HTTP_PROXY_IO_01_066: [ When a double new-line is detected the response shall be parsed in order to extract the status code. ]*/
-                if ((http_proxy_io_instance->receive_buffer_size >= 4) &&
-                    ((request_end_ptr = strstr((const char*)http_proxy_io_instance->receive_buffer, "\r\n\r\n")) != NULL))
+                /* Codes_SRS_HTTP_PROXY_IO_01_102: [ The buffered bytes shall be parsed by calling `http_response_parser_parse`, so that only the bytes received since the previous call are scanned for the double new-line. ]*/
+                parse_result = http_response_parser_parse(&http_proxy_io_instance->connect_response_parser, http_proxy_io_instance->receive_buffer, http_proxy_io_instance->receive_buffer_size);
+                if (parse_result == HTTP_RESPONSE_PARSER_ERROR)
                 {
-                    int status_code;
-
-                    /* This part should really be done with the HTTPAPI, but that has to be done as a separate step
-                    as the HTTPAPI has to expose somehow the underlying IO and currently this would be a too big of a change. */
+                    /* Codes_SRS_HTTP_PROXY_IO_01_068: [ If parsing the CONNECT response fails, the `on_open_complete` callback shall be triggered with `IO_OPEN_ERROR`, passing also the `on_open_complete_context` argument as `context`. ]*/
+                    LogError("Cannot decode HTTP response");
+                    indicate_open_complete_error_and_close(http_proxy_io_instance);
+                }
+                else if (parse_result == HTTP_RESPONSE_PARSER_COMPLETE)
+                {
+                    int status_code = http_proxy_io_instance->connect_response_parser.status_code;
 
-                    if (ParseHttpResponse((const char*)http_proxy_io_instance->receive_buffer, &status_code) != 0)
-                    {
-                        /* Codes_SRS_HTTP_PROXY_IO_01_068: [ If parsing the CONNECT response fails, the `on_open_complete` callback shall be triggered with `IO_OPEN_ERROR`, passing also the `on_open_complete_context` argument as `context`. ]*/
-                        LogError("Cannot decode HTTP response");
-                        indicate_open_complete_error_and_close(http_proxy_io_instance);
-                    }
                     /* Codes_SRS_HTTP_PROXY_IO_01_069: [ Any successful (2xx) response to a CONNECT request indicates that the proxy has established a connection to the requested host and port, and has switched to tunneling the current connection to that server connection. ]*/
                     /* Codes_SRS_HTTP_PROXY_IO_01_090: [ Any successful (2xx) response to a CONNECT request indicates that the proxy has established a connection to the requested host and port, and has switched to tunneling the current connection to that server connection. ]*/
-                    else if ((status_code < 200) || (status_code > 299))
+                    if ((status_code < 200) || (status_code > 299))
                     {
                         /* Codes_SRS_HTTP_PROXY_IO_01_071: [ If the status code is not successful, the `on_open_complete` callback shall be triggered with `IO_OPEN_ERROR`, passing also the `on_open_complete_context` argument as `context`. ]*/
                         LogError("Bad status (%d) received in CONNECT response", status_code);
@@ -675,7 +583,8 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                     }
                     else
                     {
-                        size_t length_remaining = http_proxy_io_instance->receive_buffer + http_proxy_io_instance->receive_buffer_size - ((const unsigned char *)request_end_ptr + 4);
+                        size_t head_length = http_proxy_io_instance->connect_response_parser.head_length;
+                        size_t length_remaining = http_proxy_io_instance->receive_buffer_size - head_length;
 
                         /* Codes_SRS_HTTP_PROXY_IO_01_073: [ Once a success status code was parsed, the IO shall be OPEN. ]*/
                         http_proxy_io_instance->http_proxy_io_state = HTTP_PROXY_IO_STATE_OPEN;
@@ -685,7 +594,8 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         if (length_remaining > 0)
                         {
                             /* Codes_SRS_HTTP_PROXY_IO_01_072: [ Any bytes that are extra (not consumed by the CONNECT response), shall be indicated as received by calling the `on_bytes_received` callback and passing the `on_bytes_received_context` as context argument. ]*/
-                            http_proxy_io_instance->on_bytes_received(http_proxy_io_instance->on_bytes_received_context, (const unsigned char*)request_end_ptr + 4, length_remaining);
+                            http_proxy_io_instance->bytes_received += length_remaining;
+                            http_proxy_io_instance->on_bytes_received(http_proxy_io_instance->on_bytes_received_context, http_proxy_io_instance->receive_buffer + head_length, length_remaining);
                         }
                     }
                 }
@@ -694,6 +604,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
         }
         case HTTP_PROXY_IO_STATE_OPEN:
             /* Codes_SRS_HTTP_PROXY_IO_01_074: [ If `on_underlying_io_bytes_received` is called while OPEN, all bytes shall be indicated as received by calling the `on_bytes_received` callback and passing the `on_bytes_received_context` as context argument. ]*/
+            http_proxy_io_instance->bytes_received += size;
             http_proxy_io_instance->on_bytes_received(http_proxy_io_instance->on_bytes_received_context, buffer, size);
             break;
         }
@@ -740,6 +651,10 @@ static int http_proxy_io_open(CONCRETE_IO_HANDLE http_proxy_io, ON_IO_OPEN_COMPL
 
             http_proxy_io_instance->http_proxy_io_state = HTTP_PROXY_IO_STATE_OPENING_UNDERLYING_IO;
 
+            /* Codes_SRS_HTTP_PROXY_IO_01_103: [ `http_proxy_io_open` shall discard any bytes buffered from a previous CONNECT response and reset the response parser by calling `http_response_parser_init`. ]*/
+            http_proxy_io_instance->receive_buffer_size = 0;
+            http_response_parser_init(&http_proxy_io_instance->connect_response_parser);
+
             /* Codes_SRS_HTTP_PROXY_IO_01_019: [ `http_proxy_io_open` shall open the underlying IO by calling `xio_open` on the underlying IO handle created in `http_proxy_io_create`, while passing to it the callbacks `on_underlying_io_open_complete`, `on_underlying_io_bytes_received` and `on_underlying_io_error`. ]*/
             if (xio_open(http_proxy_io_instance->underlying_io, on_underlying_io_open_complete, http_proxy_io_instance, on_underlying_io_bytes_received, http_proxy_io_instance, on_underlying_io_error, http_proxy_io_instance) != 0)
             {
@@ -852,7 +767,13 @@ static int http_proxy_io_send(CONCRETE_IO_HANDLE http_proxy_io, const void* buff
         else
         {
             /* Codes_SRS_HTTP_PROXY_IO_01_033: [ `http_proxy_io_send` shall send the bytes by calling `xio_send` on the underlying IO created in `http_proxy_io_create` and passing `buffer` and `size` as arguments. ]*/
-            if (xio_send(http_proxy_io_instance->underlying_io, buffer, size, on_send_complete, on_send_complete_context) != 0)
+            int send_result = xio_send(http_proxy_io_instance->underlying_io, buffer, size, on_send_complete, on_send_complete_context);
+            if (send_result == XIO_SEND_WOULD_BLOCK)
+            {
+                /* Codes_SRS_HTTP_PROXY_IO_01_101: [ If `xio_send` returns `XIO_SEND_WOULD_BLOCK`, `http_proxy_io_send` shall return `XIO_SEND_WOULD_BLOCK`. ]*/
+                result = XIO_SEND_WOULD_BLOCK;
+            }
+            else if (send_result != 0)
             {
                 /* Codes_SRS_HTTP_PROXY_IO_01_055: [ If `xio_send` fails, `http_proxy_io_send` shall fail and return a non-zero value. ]*/
                 result = __LINE__;
@@ -860,6 +781,8 @@ static int http_proxy_io_send(CONCRETE_IO_HANDLE http_proxy_io, const void* buff
             }
             else
             {
+                http_proxy_io_instance->bytes_sent += size;
+
                 /* Codes_SRS_HTTP_PROXY_IO_01_029: [ `http_proxy_io_send` shall send the `size` bytes pointed to by `buffer` and on success it shall return 0. ]*/
                 result = 0;
             }
@@ -948,6 +871,40 @@ static OPTIONHANDLER_HANDLE http_proxy_io_retrieve_options(CONCRETE_IO_HANDLE ht
     return result;
 }
 
+static int http_proxy_io_get_statistics(CONCRETE_IO_HANDLE http_proxy_io, XIO_STATISTICS* statistics)
+{
+    int result;
+
+    /* Codes_SRS_HTTP_PROXY_IO_01_096: [ If any of the arguments `http_proxy_io` or `statistics` is NULL, `http_proxy_io_get_statistics` shall fail and return a non-zero value. ]*/
+    if ((http_proxy_io == NULL) ||
+        (statistics == NULL))
+    {
+        result = __LINE__;
+        LogError("Bad arguments: http_proxy_io = %p, statistics = %p.",
+            http_proxy_io, statistics);
+    }
+    else
+    {
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io;
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_097: [ `http_proxy_io_get_statistics` shall obtain the statistics of the underlying IO by calling `xio_get_statistics`. ]*/
+        if (xio_get_statistics(http_proxy_io_instance->underlying_io, statistics) != 0)
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_01_098: [ If `xio_get_statistics` fails, all the counters shall be reported as 0. ]*/
+            (void)memset(statistics, 0, sizeof(XIO_STATISTICS));
+        }
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_099: [ `bytes_sent` and `bytes_received` shall only count the bytes tunneled after the CONNECT request completed. ]*/
+        statistics->bytes_sent = http_proxy_io_instance->bytes_sent;
+        statistics->bytes_received = http_proxy_io_instance->bytes_received;
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_100: [ On success, `http_proxy_io_get_statistics` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
 static const IO_INTERFACE_DESCRIPTION http_proxy_io_interface_description =
 {
     http_proxy_io_retrieve_options,
@@ -957,7 +914,9 @@ static const IO_INTERFACE_DESCRIPTION http_proxy_io_interface_description =
     http_proxy_io_close,
     http_proxy_io_send,
     http_proxy_io_dowork,
-    http_proxy_io_set_option
+    http_proxy_io_set_option,
+    NULL,
+    http_proxy_io_get_statistics
 };
 
 const IO_INTERFACE_DESCRIPTION* http_proxy_io_get_interface_description(void)
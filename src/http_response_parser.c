@@ -0,0 +1,268 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include "azure_c_shared_utility/http_response_parser.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+static const char HTTP_PREFIX[] = "HTTP/";
+
+/* enough digits for any status code while staying far from INT_MAX */
+#define MAX_STATUS_CODE_DIGITS  9
+
+/* Returns the LF ending the first CRLF terminated line that starts at line, looking for it from search on.
+A bare LF is part of the line. Returns NULL if no CRLF is found before end. */
+static const unsigned char* find_line_end(const unsigned char* line, const unsigned char* search, const unsigned char* end)
+{
+    const unsigned char* result = NULL;
+
+    while ((result == NULL) &&
+        (search < end))
+    {
+        const unsigned char* line_feed = (const unsigned char*)memchr(search, '\n', (size_t)(end - search));
+        if (line_feed == NULL)
+        {
+            search = end;
+        }
+        else if ((line_feed > line) && (line_feed[-1] == '\r'))
+        {
+            result = line_feed;
+        }
+        else
+        {
+            search = line_feed + 1;
+        }
+    }
+
+    return result;
+}
+
+void http_response_parser_init(HTTP_RESPONSE_PARSER* parser)
+{
+    if (parser == NULL)
+    {
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_001: [ If `parser` is NULL, `http_response_parser_init` shall do nothing. ]*/
+        LogError("NULL parser");
+    }
+    else
+    {
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_002: [ `http_response_parser_init` shall reset `parser` so that it starts parsing a new response from the first byte of the buffer. ]*/
+        parser->scanned_bytes = 0;
+        parser->line_start = 0;
+        parser->head_length = 0;
+        parser->status_code = 0;
+        parser->is_status_line_parsed = false;
+    }
+}
+
+HTTP_RESPONSE_PARSER_RESULT http_response_parser_parse(HTTP_RESPONSE_PARSER* parser, const unsigned char* buffer, size_t size)
+{
+    HTTP_RESPONSE_PARSER_RESULT result;
+
+    if ((parser == NULL) ||
+        ((buffer == NULL) && (size > 0)))
+    {
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_003: [ If `parser` is NULL, or `buffer` is NULL while `size` is not 0, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_ERROR`. ]*/
+        LogError("Invalid arguments: parser=%p, buffer=%p, size=%u", parser, buffer, (unsigned int)size);
+        result = HTTP_RESPONSE_PARSER_ERROR;
+    }
+    else if (parser->head_length > 0)
+    {
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_004: [ Once the end of the head was found, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_COMPLETE` without looking at `buffer`. ]*/
+        result = HTTP_RESPONSE_PARSER_COMPLETE;
+    }
+    else if (size < parser->scanned_bytes)
+    {
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_005: [ If `size` is smaller than the number of bytes already scanned, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_ERROR`. ]*/
+        LogError("Buffer shrunk from %u to %u bytes while parsing", (unsigned int)parser->scanned_bytes, (unsigned int)size);
+        result = HTTP_RESPONSE_PARSER_ERROR;
+    }
+    else
+    {
+        result = HTTP_RESPONSE_PARSER_NEED_MORE_BYTES;
+
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_006: [ `buffer` shall hold all the bytes of the response received so far, and only the bytes after the ones scanned by previous calls shall be scanned. ]*/
+        while ((result == HTTP_RESPONSE_PARSER_NEED_MORE_BYTES) &&
+            (parser->scanned_bytes < size))
+        {
+            const unsigned char* line_feed = find_line_end(buffer + parser->line_start, buffer + parser->scanned_bytes, buffer + size);
+            if (line_feed == NULL)
+            {
+                /* Codes_SRS_HTTP_RESPONSE_PARSER_01_007: [ If no complete CRLF terminated line is left in `buffer`, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_NEED_MORE_BYTES`. ]*/
+                parser->scanned_bytes = size;
+            }
+            else
+            {
+                size_t line_length = (size_t)(line_feed - (buffer + parser->line_start)) - 1;
+
+                parser->scanned_bytes = (size_t)(line_feed - buffer) + 1;
+
+                if (!parser->is_status_line_parsed)
+                {
+                    /* Codes_SRS_HTTP_RESPONSE_PARSER_01_008: [ The first line shall be parsed as the status line by calling `http_response_parser_parse_status_line`. ]*/
+                    if (http_response_parser_parse_status_line((const char*)buffer + parser->line_start, line_length, &parser->status_code) != 0)
+                    {
+                        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_009: [ If the status line cannot be parsed, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_ERROR`. ]*/
+                        LogError("Cannot parse the HTTP status line");
+                        result = HTTP_RESPONSE_PARSER_ERROR;
+                    }
+                    else
+                    {
+                        parser->is_status_line_parsed = true;
+                    }
+                }
+                else if (line_length == 0)
+                {
+                    /* Codes_SRS_HTTP_RESPONSE_PARSER_01_010: [ When the empty line ending the head is found, `head_length` shall be set to the number of bytes of the head including that line and `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_COMPLETE`. ]*/
+                    parser->head_length = parser->scanned_bytes;
+                    result = HTTP_RESPONSE_PARSER_COMPLETE;
+                }
+
+                parser->line_start = parser->scanned_bytes;
+            }
+        }
+    }
+
+    return result;
+}
+
+int http_response_parser_parse_status_line(const char* line, size_t line_length, int* status_code)
+{
+    int result;
+
+    if ((line == NULL) ||
+        (status_code == NULL))
+    {
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_011: [ If `line` or `status_code` is NULL, `http_response_parser_parse_status_line` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: line=%p, status_code=%p", line, status_code);
+        result = __FAILURE__;
+    }
+    else if ((line_length < sizeof(HTTP_PREFIX) - 1) ||
+        (memcmp(line, HTTP_PREFIX, sizeof(HTTP_PREFIX) - 1) != 0))
+    {
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_012: [ If `line` does not start with `HTTP/`, `http_response_parser_parse_status_line` shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t position = sizeof(HTTP_PREFIX) - 1;
+        size_t digit_count = 0;
+        int value = 0;
+
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_013: [ The version shall be skipped up to and including its dot, then up to the space that follows it. ]*/
+        while ((position < line_length) && (line[position] != '.'))
+        {
+            position++;
+        }
+
+        while ((position < line_length) && (line[position] != ' '))
+        {
+            position++;
+        }
+
+        while ((position < line_length) && (line[position] == ' '))
+        {
+            position++;
+        }
+
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_014: [ The status code shall be read from the decimal digits that follow the spaces. ]*/
+        while ((position < line_length) &&
+            (digit_count <= MAX_STATUS_CODE_DIGITS) &&
+            (isdigit((unsigned char)line[position])))
+        {
+            value = (value * 10) + (line[position] - '0');
+            digit_count++;
+            position++;
+        }
+
+        if ((digit_count == 0) ||
+            (digit_count > MAX_STATUS_CODE_DIGITS))
+        {
+            /* Codes_SRS_HTTP_RESPONSE_PARSER_01_015: [ If the dot, the space or the status code digits are missing, or the status code has more than 9 digits, `http_response_parser_parse_status_line` shall fail and return a non-zero value. ]*/
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_HTTP_RESPONSE_PARSER_01_016: [ On success `http_response_parser_parse_status_line` shall set `status_code` and return 0. ]*/
+            *status_code = value;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+bool http_response_parser_get_header(const HTTP_RESPONSE_PARSER* parser, const unsigned char* buffer, const char* header_name, const char** value, size_t* value_length)
+{
+    bool result = false;
+
+    if ((parser == NULL) ||
+        (buffer == NULL) ||
+        (header_name == NULL) ||
+        (value == NULL) ||
+        (value_length == NULL))
+    {
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_017: [ If any argument is NULL, `http_response_parser_get_header` shall return false. ]*/
+        LogError("Invalid arguments: parser=%p, buffer=%p, header_name=%p, value=%p, value_length=%p", parser, buffer, header_name, value, value_length);
+    }
+    else if (parser->head_length == 0)
+    {
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_018: [ If the head was not completely parsed yet, `http_response_parser_get_header` shall return false. ]*/
+        LogError("The response head is not complete");
+    }
+    else
+    {
+        size_t header_name_length = strlen(header_name);
+        const unsigned char* head_end = buffer + parser->head_length;
+        const unsigned char* line = find_line_end(buffer, buffer, head_end) + 1;
+
+        /* Codes_SRS_HTTP_RESPONSE_PARSER_01_019: [ The header lines of the head shall be looked up for the first one whose name matches `header_name`, compared case insensitive, and is followed by a colon. ]*/
+        while ((result == false) &&
+            (line < head_end))
+        {
+            const unsigned char* line_feed = find_line_end(line, line, head_end);
+            const unsigned char* line_end = line_feed - 1;
+            size_t i;
+
+            for (i = 0; (i < header_name_length) && (line + i < line_end); i++)
+            {
+                if (tolower(line[i]) != tolower((unsigned char)header_name[i]))
+                {
+                    break;
+                }
+            }
+
+            if ((i == header_name_length) &&
+                (line + i < line_end) &&
+                (line[i] == ':'))
+            {
+                const unsigned char* value_start = line + header_name_length + 1;
+                const unsigned char* value_end = line_end;
+
+                /* Codes_SRS_HTTP_RESPONSE_PARSER_01_020: [ On success `value` shall point to the header value in `buffer` without leading whitespace, `value_length` shall exclude trailing whitespace and `http_response_parser_get_header` shall return true. ]*/
+                while ((value_start < value_end) && ((*value_start == ' ') || (*value_start == '\t')))
+                {
+                    value_start++;
+                }
+
+                while ((value_end > value_start) && ((value_end[-1] == ' ') || (value_end[-1] == '\t')))
+                {
+                    value_end--;
+                }
+
+                *value = (const char*)value_start;
+                *value_length = (size_t)(value_end - value_start);
+                result = true;
+            }
+
+            line = line_feed + 1;
+        }
+    }
+
+    return result;
+}
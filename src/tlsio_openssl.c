@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <limits.h>
 #include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/tlsio_openssl.h"
@@ -19,6 +20,10 @@
 #include "azure_c_shared_utility/x509_openssl.h"
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/gballoc.h"
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#endif
 
 typedef enum TLSIO_STATE_TAG
 {
@@ -50,6 +55,16 @@ static bool is_an_opening_state(TLSIO_STATE state)
 
 typedef int(*TLS_CERTIFICATE_VALIDATION_CALLBACK)(X509_STORE_CTX*, void*);
 
+/* a handshake step is one SSL_do_handshake call; with tls_handshake_offload it runs on a worker
+   thread, which owns the SSL object from QUEUED until the thread calling dowork sees DONE */
+typedef enum TLS_HANDSHAKE_STEP_STATE_TAG
+{
+    TLS_HANDSHAKE_STEP_IDLE,
+    TLS_HANDSHAKE_STEP_QUEUED,
+    TLS_HANDSHAKE_STEP_RUNNING,
+    TLS_HANDSHAKE_STEP_DONE
+} TLS_HANDSHAKE_STEP_STATE;
+
 typedef struct TLS_IO_INSTANCE_TAG
 {
     XIO_HANDLE underlying_io;
@@ -63,10 +78,15 @@ typedef struct TLS_IO_INSTANCE_TAG
     void* on_io_error_context;
     SSL* ssl;
     SSL_CTX* ssl_context;
-    BIO* in_bio;
-    BIO* out_bio;
+    const unsigned char* received_bytes;
+    size_t received_bytes_size;
+    unsigned char* pending_received_bytes;
+    size_t pending_received_bytes_size;
+    struct TLS_SEND_CONTEXT_TAG* current_send_context;
+    struct TLS_SEND_CONTEXT_TAG* send_contexts;
+    struct TLS_SEND_CONTEXT_TAG* free_send_contexts;
     TLSIO_STATE tlsio_state;
-    char* certificate;
+    const char* certificate;
     const char* x509certificate;
     const char* x509privatekey;
     const char* x509_ecc_cert;
@@ -74,17 +94,116 @@ typedef struct TLS_IO_INSTANCE_TAG
     TLSIO_VERSION tls_version;
     TLS_CERTIFICATE_VALIDATION_CALLBACK tls_validation_callback;
     void* tls_validation_callback_data;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    size_t send_queue_high_watermark;
+    size_t send_queue_low_watermark;
+    bool is_send_blocked;
+    ON_IO_WRITABLE on_io_writable;
+    void* on_io_writable_context;
+    char* hostname;
+    int port;
+    bool tls_session_resumption;
+    SSL_SESSION* tls_session;
+    unsigned char* decode_buffer;
+    size_t decode_buffer_size;
+    size_t decode_buffer_option;
+    bool decode_per_record;
+    bool handshake_offload;
+    TLS_HANDSHAKE_STEP_STATE handshake_step_state;
+    int handshake_step_result;
+    int handshake_step_ssl_error;
+    unsigned long handshake_step_error_code;
+    unsigned char* handshake_output;
+    size_t handshake_output_size;
+    unsigned char* handshake_backlog;
+    size_t handshake_backlog_size;
+    struct TLS_IO_INSTANCE_TAG* next_handshake_step;
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+    COND_HANDLE handshake_step_done;
+#endif
 } TLS_IO_INSTANCE;
 
+/* one send can be split by OpenSSL in several records, each of them written separately to the
+   underlying IO; the caller's on_send_complete is called once all of them are done.
+   The contexts are owned by the instance and reused once complete, so a send does not allocate
+   unless more sends than ever before are in flight. */
+typedef struct TLS_SEND_CONTEXT_TAG
+{
+    TLS_IO_INSTANCE* tls_io_instance;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    size_t pending_record_count;
+    bool is_sealed;
+    IO_SEND_RESULT send_result;
+    struct TLS_SEND_CONTEXT_TAG* next;
+    struct TLS_SEND_CONTEXT_TAG* next_free;
+} TLS_SEND_CONTEXT;
+
+/* the options a connection authenticates with, holding references to the interned PEM options */
+typedef struct TLS_CREDENTIALS_TAG
+{
+    TLSIO_VERSION tls_version;
+    const char* certificate;
+    const char* x509certificate;
+    const char* x509privatekey;
+    const char* x509_ecc_cert;
+    const char* x509_ecc_aliaskey;
+    TLS_CERTIFICATE_VALIDATION_CALLBACK tls_validation_callback;
+    void* tls_validation_callback_data;
+} TLS_CREDENTIALS;
+
+/* the key is the credentials the context was built from */
+typedef struct SSL_CONTEXT_CACHE_ENTRY_TAG
+{
+    SSL_CTX* ssl_context;
+    size_t ref_count;
+    TLS_CREDENTIALS credentials;
+    struct SSL_CONTEXT_CACHE_ENTRY_TAG* next;
+} SSL_CONTEXT_CACHE_ENTRY;
+
+#ifndef TLS_SESSION_CACHE_MAX_ENTRIES
+#define TLS_SESSION_CACHE_MAX_ENTRIES       256
+#endif
+
+/* the last resumable session negotiated with each host/port and set of credentials, most recently used first;
+   a session is never offered by a connection that authenticates differently than the one that negotiated it */
+typedef struct TLS_SESSION_CACHE_ENTRY_TAG
+{
+    char* hostname;
+    int port;
+    TLS_CREDENTIALS credentials;
+    SSL_SESSION* session;
+    struct TLS_SESSION_CACHE_ENTRY_TAG* next;
+} TLS_SESSION_CACHE_ENTRY;
+
+/* OpenSSL 1.1.0 and later do their own locking, the locking callbacks are only needed before that */
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || defined(LIBRESSL_VERSION_NUMBER)
+#define TLSIO_OPENSSL_LOCK_CALLBACKS
+#endif
+
+#ifdef TLSIO_OPENSSL_LOCK_CALLBACKS
 struct CRYPTO_dynlock_value
 {
     LOCK_HANDLE lock;
 };
+#endif
 
 #define OPTION_UNDERLYING_IO_OPTIONS        "underlying_io_options"
+/* plaintext of a full TLS record */
+#define TLS_DECODE_BUFFER_DEFAULT_SIZE      SSL3_RT_MAX_PLAIN_LENGTH
 #define SSL_DO_HANDSHAKE_SUCCESS 1
 
 
+static void tls_session_add_ref(SSL_SESSION* session)
+{
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || defined(LIBRESSL_VERSION_NUMBER)
+    (void)CRYPTO_add(&session->references, 1, CRYPTO_LOCK_SSL_SESSION);
+#else
+    (void)SSL_SESSION_up_ref(session);
+#endif
+}
+
 /*this function will clone an option given by name and value*/
 static void* tlsio_openssl_CloneOption(const char* name, const void* value)
 {
@@ -104,10 +223,10 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
         }
         else if (strcmp(name, OPTION_TRUSTED_CERT) == 0)
         {
-            if (mallocAndStrcpy_s((char**)&result, value) != 0)
+            /*the PEM strings are interned, so a clone only adds a reference*/
+            if ((result = (void*)x509_openssl_pem_acquire((const char*)value)) == NULL)
             {
-                LogError("unable to mallocAndStrcpy_s TrustedCerts value");
-                result = NULL;
+                LogError("unable to x509_openssl_pem_acquire TrustedCerts value");
             }
             else
             {
@@ -116,10 +235,9 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
         }
         else if (strcmp(name, SU_OPTION_X509_CERT) == 0)
         {
-            if (mallocAndStrcpy_s((char**)&result, value) != 0)
+            if ((result = (void*)x509_openssl_pem_acquire((const char*)value)) == NULL)
             {
-                LogError("unable to mallocAndStrcpy_s x509certificate value");
-                result = NULL;
+                LogError("unable to x509_openssl_pem_acquire x509certificate value");
             }
             else
             {
@@ -128,10 +246,9 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
         }
         else if (strcmp(name, SU_OPTION_X509_PRIVATE_KEY) == 0)
         {
-            if (mallocAndStrcpy_s((char**)&result, value) != 0)
+            if ((result = (void*)x509_openssl_pem_acquire((const char*)value)) == NULL)
             {
-                LogError("unable to mallocAndStrcpy_s x509privatekey value");
-                result = NULL;
+                LogError("unable to x509_openssl_pem_acquire x509privatekey value");
             }
             else
             {
@@ -140,10 +257,9 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
         }
         else if (strcmp(name, OPTION_X509_ECC_CERT) == 0)
         {
-            if (mallocAndStrcpy_s((char**)&result, value) != 0)
+            if ((result = (void*)x509_openssl_pem_acquire((const char*)value)) == NULL)
             {
-                LogError("unable to mallocAndStrcpy_s x509EccCertificate value");
-                result = NULL;
+                LogError("unable to x509_openssl_pem_acquire x509EccCertificate value");
             }
             else
             {
@@ -152,10 +268,9 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
         }
         else if (strcmp(name, OPTION_X509_ECC_KEY) == 0)
         {
-            if (mallocAndStrcpy_s((char**)&result, value) != 0)
+            if ((result = (void*)x509_openssl_pem_acquire((const char*)value)) == NULL)
             {
-                LogError("unable to mallocAndStrcpy_s x509EccKey value");
-                result = NULL;
+                LogError("unable to x509_openssl_pem_acquire x509EccKey value");
             }
             else
             {
@@ -204,9 +319,69 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
                 result = value_clone;
             }
         }
+        else if (strcmp(name, OPTION_TLS_DECODE_BUFFER_SIZE) == 0)
+        {
+            size_t* value_clone;
+
+            if ((value_clone = (size_t*)malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed clonning tls_decode_buffer_size option");
+            }
+            else
+            {
+                *value_clone = *(const size_t*)value;
+            }
+
+            result = value_clone;
+        }
+        else if (
+            (strcmp(name, OPTION_TLS_SESSION_RESUMPTION) == 0) ||
+            (strcmp(name, OPTION_TLS_DECODE_PER_RECORD) == 0) ||
+            (strcmp(name, OPTION_TLS_HANDSHAKE_OFFLOAD) == 0)
+            )
+        {
+            bool* value_clone;
+
+            if ((value_clone = (bool*)malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed clonning %s option", name);
+            }
+            else
+            {
+                *value_clone = *(const bool*)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_SESSION) == 0)
+        {
+            /* sessions are reference counted, the clone is another reference */
+            tls_session_add_ref((SSL_SESSION*)value);
+            result = (void*)value;
+        }
+        else if (
+            (strcmp(name, OPTION_SEND_QUEUE_HIGH_WATERMARK) == 0) ||
+            (strcmp(name, OPTION_SEND_QUEUE_LOW_WATERMARK) == 0)
+            )
+        {
+            size_t* value_clone;
+
+            if ((value_clone = (size_t*)malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed clonning %s option", name);
+            }
+            else
+            {
+                *value_clone = *(const size_t*)value;
+            }
+
+            result = value_clone;
+        }
         else if (
             (strcmp(name, "tls_validation_callback") == 0) ||
-            (strcmp(name, "tls_validation_callback_data") == 0)
+            (strcmp(name, "tls_validation_callback_data") == 0) ||
+            (strcmp(name, OPTION_ON_IO_WRITABLE) == 0) ||
+            (strcmp(name, OPTION_ON_IO_WRITABLE_CONTEXT) == 0)
             )
         {
             result = (void*)value;
@@ -223,7 +398,6 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
 /*this function destroys an option previously created*/
 static void tlsio_openssl_DestroyOption(const char* name, const void* value)
 {
-    /*since all options for this layer are actually string copies., disposing of one is just calling free*/
     if (
         (name == NULL) || (value == NULL)
         )
@@ -237,15 +411,28 @@ static void tlsio_openssl_DestroyOption(const char* name, const void* value)
             (strcmp(name, SU_OPTION_X509_CERT) == 0) ||
             (strcmp(name, SU_OPTION_X509_PRIVATE_KEY) == 0) ||
             (strcmp(name, OPTION_X509_ECC_CERT) == 0) ||
-            (strcmp(name, OPTION_X509_ECC_KEY) == 0) ||
-            (strcmp(name, OPTION_TLS_VERSION) == 0)
+            (strcmp(name, OPTION_X509_ECC_KEY) == 0)
+            )
+        {
+            x509_openssl_pem_release((const char*)value);
+        }
+        else if (
+            (strcmp(name, OPTION_TLS_VERSION) == 0) ||
+            (strcmp(name, OPTION_TLS_SESSION_RESUMPTION) == 0) ||
+            (strcmp(name, OPTION_TLS_DECODE_BUFFER_SIZE) == 0) ||
+            (strcmp(name, OPTION_TLS_DECODE_PER_RECORD) == 0) ||
+            (strcmp(name, OPTION_TLS_HANDSHAKE_OFFLOAD) == 0) ||
+            (strcmp(name, OPTION_SEND_QUEUE_HIGH_WATERMARK) == 0) ||
+            (strcmp(name, OPTION_SEND_QUEUE_LOW_WATERMARK) == 0)
             )
         {
             free((void*)value);
         }
         else if (
             (strcmp(name, "tls_validation_callback") == 0) ||
-            (strcmp(name, "tls_validation_callback_data") == 0)
+            (strcmp(name, "tls_validation_callback_data") == 0) ||
+            (strcmp(name, OPTION_ON_IO_WRITABLE) == 0) ||
+            (strcmp(name, OPTION_ON_IO_WRITABLE_CONTEXT) == 0)
             )
         {
             // nothing to free.
@@ -254,6 +441,10 @@ static void tlsio_openssl_DestroyOption(const char* name, const void* value)
         {
             OptionHandler_Destroy((OPTIONHANDLER_HANDLE)value);
         }
+        else if (strcmp(name, OPTION_TLS_SESSION) == 0)
+        {
+            SSL_SESSION_free((SSL_SESSION*)value);
+        }
         else
         {
             LogError("not handled option : %s", name);
@@ -336,6 +527,69 @@ static OPTIONHANDLER_HANDLE tlsio_openssl_retrieveoptions(CONCRETE_IO_HANDLE han
                 OptionHandler_Destroy(result);
                 result = NULL;
             }
+            else if (
+                (!tls_io_instance->tls_session_resumption) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_SESSION_RESUMPTION, &tls_io_instance->tls_session_resumption) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_session_resumption option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->tls_session != NULL) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_SESSION, tls_io_instance->tls_session) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_session option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->decode_buffer_option != TLS_DECODE_BUFFER_DEFAULT_SIZE) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_DECODE_BUFFER_SIZE, &tls_io_instance->decode_buffer_option) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_decode_buffer_size option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->decode_per_record) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_DECODE_PER_RECORD, &tls_io_instance->decode_per_record) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_decode_per_record option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->handshake_offload) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_HANDSHAKE_OFFLOAD, &tls_io_instance->handshake_offload) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_handshake_offload option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->send_queue_high_watermark != 0) &&
+                (OptionHandler_AddOption(result, OPTION_SEND_QUEUE_HIGH_WATERMARK, &tls_io_instance->send_queue_high_watermark) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save send_queue_high_watermark option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->send_queue_low_watermark != 0) &&
+                (OptionHandler_AddOption(result, OPTION_SEND_QUEUE_LOW_WATERMARK, &tls_io_instance->send_queue_low_watermark) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save send_queue_low_watermark option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
             else if (tls_io_instance->tls_version != 0)
             {
                 if (OptionHandler_AddOption(result, OPTION_TLS_VERSION, &tls_io_instance->tls_version) != OPTIONHANDLER_OK)
@@ -385,29 +639,52 @@ static const IO_INTERFACE_DESCRIPTION tlsio_openssl_interface_description =
     tlsio_openssl_close,
     tlsio_openssl_send,
     tlsio_openssl_dowork,
-    tlsio_openssl_setoption
+    tlsio_openssl_setoption,
+    NULL,
+    tlsio_openssl_get_statistics
 };
 
+#ifdef TLSIO_OPENSSL_LOCK_CALLBACKS
 static LOCK_HANDLE * openssl_locks = NULL;
+#endif
 
+static LOCK_HANDLE ssl_context_cache_lock = NULL;
+static SSL_CONTEXT_CACHE_ENTRY* ssl_context_cache = NULL;
 
-static void openssl_lock_unlock_helper(LOCK_HANDLE lock, int lock_mode, const char* file, int line)
+static LOCK_HANDLE tls_session_cache_lock = NULL;
+static TLS_SESSION_CACHE_ENTRY* tls_session_cache = NULL;
+
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+#ifndef TLSIO_HANDSHAKE_WORKER_COUNT
+#define TLSIO_HANDSHAKE_WORKER_COUNT        2
+#endif
+typedef struct TLS_HANDSHAKE_POOL_TAG
 {
-    if (lock_mode & CRYPTO_LOCK)
-    {
-        if (Lock(lock) != 0)
-        {
-            LogError("Failed to lock openssl lock (%s:%d)", file, line);
-        }
-    }
-    else
-    {
-        if (Unlock(lock) != 0)
-        {
-            LogError("Failed to unlock openssl lock (%s:%d)", file, line);
-        }
-    }
-}
+    LOCK_HANDLE lock;
+    COND_HANDLE work_available;
+    THREAD_HANDLE workers[TLSIO_HANDSHAKE_WORKER_COUNT];
+    size_t worker_count;
+    bool is_stopping;
+    TLS_IO_INSTANCE* queue_head;
+    TLS_IO_INSTANCE* queue_tail;
+} TLS_HANDSHAKE_POOL;
+
+/* shared by all the instances, the workers are started by the first offloaded handshake */
+static TLS_HANDSHAKE_POOL handshake_pool = { NULL, NULL, { NULL }, 0, false, NULL, NULL };
+#endif
+
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || defined(LIBRESSL_VERSION_NUMBER)
+static BIO_METHOD* tlsio_bio_method = NULL;
+#define TLSIO_BIO_GET_DATA(bio)             ((bio)->ptr)
+#define TLSIO_BIO_SET_DATA(bio, data)       ((bio)->ptr = (data))
+#define TLSIO_BIO_SET_INIT(bio, value)      ((bio)->init = (value))
+#else
+static BIO_METHOD* tlsio_bio_method = NULL;
+#define TLSIO_BIO_GET_DATA(bio)             BIO_get_data(bio)
+#define TLSIO_BIO_SET_DATA(bio, data)       BIO_set_data((bio), (data))
+#define TLSIO_BIO_SET_INIT(bio, value)      BIO_set_init((bio), (value))
+#endif
+
 
 static void log_ERR_get_error(const char* message)
 {
@@ -429,6 +706,25 @@ static void log_ERR_get_error(const char* message)
     }
 }
 
+#ifdef TLSIO_OPENSSL_LOCK_CALLBACKS
+static void openssl_lock_unlock_helper(LOCK_HANDLE lock, int lock_mode, const char* file, int line)
+{
+    if (lock_mode & CRYPTO_LOCK)
+    {
+        if (Lock(lock) != 0)
+        {
+            LogError("Failed to lock openssl lock (%s:%d)", file, line);
+        }
+    }
+    else
+    {
+        if (Unlock(lock) != 0)
+        {
+            LogError("Failed to unlock openssl lock (%s:%d)", file, line);
+        }
+    }
+}
+
 static struct CRYPTO_dynlock_value* openssl_dynamic_locks_create_cb(const char* file, int line)
 {
     struct CRYPTO_dynlock_value* result;
@@ -570,6 +866,7 @@ static int openssl_static_locks_install(void)
     }
     return result;
 }
+#endif
 
 static void indicate_error(TLS_IO_INSTANCE* tls_io_instance)
 {
@@ -595,146 +892,1127 @@ static void indicate_open_complete(TLS_IO_INSTANCE* tls_io_instance, IO_OPEN_RES
     }
 }
 
-static int write_outgoing_bytes(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+
+static int append_bytes(unsigned char** buffer, size_t* buffer_size, const unsigned char* bytes, size_t size)
 {
     int result;
 
-    size_t pending = BIO_ctrl_pending(tls_io_instance->out_bio);
-
-    if (pending == 0)
+    if (size == 0)
     {
         result = 0;
     }
     else
     {
-        unsigned char* bytes_to_send = malloc(pending);
-        if (bytes_to_send == NULL)
+        unsigned char* new_buffer = (unsigned char*)realloc(*buffer, *buffer_size + size);
+        if (new_buffer == NULL)
         {
-            LogError("NULL bytes_to_send.");
+            LogError("Failed allocating %lu bytes.", (unsigned long)(*buffer_size + size));
             result = __FAILURE__;
         }
         else
         {
-            if (BIO_read(tls_io_instance->out_bio, bytes_to_send, (int)pending) != (int)pending)
-            {
-                log_ERR_get_error("BIO_read not in pending state.");
-                result = __FAILURE__;
-            }
-            else
-            {
-                if (xio_send(tls_io_instance->underlying_io, bytes_to_send, pending, on_send_complete, callback_context) != 0)
-                {
-                    LogError("Error in xio_send.");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    result = 0;
-                }
-            }
-
-            free(bytes_to_send);
+            (void)memcpy(new_buffer + *buffer_size, bytes, size);
+            *buffer = new_buffer;
+            *buffer_size += size;
+            result = 0;
         }
     }
 
     return result;
 }
 
-// Non-NULL tls_io_instance is guaranteed by callers. 
-// We are in TLSIO_STATE_IN_HANDSHAKE when entering this method.
-static void send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
+static TLS_SEND_CONTEXT* get_send_context(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
-    int hsret;
-    // ERR_clear_error must be called before any call that might set an
-    // SSL_get_error result
-    ERR_clear_error();
-    hsret = SSL_do_handshake(tls_io_instance->ssl);
-    if (hsret != SSL_DO_HANDSHAKE_SUCCESS)
+    TLS_SEND_CONTEXT* result = tls_io_instance->free_send_contexts;
+
+    if (result != NULL)
     {
-        int ssl_err = SSL_get_error(tls_io_instance->ssl, hsret);
-        if (ssl_err != SSL_ERROR_WANT_READ && ssl_err != SSL_ERROR_WANT_WRITE)
-        {
-            if (ssl_err == SSL_ERROR_SSL)
-            {
-                LogInfo(ERR_error_string(ERR_get_error(), NULL));
-            }
-            else
-            {
-                LogInfo("SSL handshake failed: %d", ssl_err);
-            }
-            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
-        }
-        else
-        {
-            if (write_outgoing_bytes(tls_io_instance, NULL, NULL) != 0)
-            {
-                LogError("Error in write_outgoing_bytes.");
-                tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
-            }
-        }
+        tls_io_instance->free_send_contexts = result->next_free;
     }
-    else
+    else if ((result = (TLS_SEND_CONTEXT*)malloc(sizeof(TLS_SEND_CONTEXT))) == NULL)
     {
-        tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
-        indicate_open_complete(tls_io_instance, IO_OPEN_OK);
+        LogError("Failed allocating the send context.");
     }
-}
-
-static void close_openssl_instance(TLS_IO_INSTANCE* tls_io_instance)
-{
-    if (tls_io_instance->ssl != NULL)
+    else
     {
-        SSL_free(tls_io_instance->ssl);
-        tls_io_instance->ssl = NULL;
+        result->tls_io_instance = tls_io_instance;
+        result->next = tls_io_instance->send_contexts;
+        tls_io_instance->send_contexts = result;
     }
-    if (tls_io_instance->ssl_context != NULL)
+
+    if (result != NULL)
     {
-        SSL_CTX_free(tls_io_instance->ssl_context);
-        tls_io_instance->ssl_context = NULL;
+        result->on_send_complete = on_send_complete;
+        result->callback_context = callback_context;
+        result->pending_record_count = 0;
+        result->is_sealed = false;
+        result->send_result = IO_SEND_OK;
+        result->next_free = NULL;
     }
+
+    return result;
 }
 
-static void on_underlying_io_close_complete(void* context)
+static void complete_send_context(TLS_SEND_CONTEXT* send_context)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    TLS_IO_INSTANCE* tls_io_instance = send_context->tls_io_instance;
 
-    switch (tls_io_instance->tlsio_state)
+    if (send_context->on_send_complete != NULL)
     {
-    default:
-    case TLSIO_STATE_NOT_OPEN:
-    case TLSIO_STATE_OPEN:
-    case TLSIO_STATE_IN_HANDSHAKE:
-    case TLSIO_STATE_HANDSHAKE_FAILED:
-    case TLSIO_STATE_ERROR:
-        break;
+        send_context->on_send_complete(send_context->callback_context, send_context->send_result);
+    }
 
-    case TLSIO_STATE_OPENING_UNDERLYING_IO:
-        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
-        break;
+    send_context->next_free = tls_io_instance->free_send_contexts;
+    tls_io_instance->free_send_contexts = send_context;
+}
 
-    case TLSIO_STATE_CLOSING:
-        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+static void on_underlying_io_record_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    TLS_SEND_CONTEXT* send_context = (TLS_SEND_CONTEXT*)context;
 
-        if (tls_io_instance->on_io_close_complete != NULL)
-        {
-            tls_io_instance->on_io_close_complete(tls_io_instance->on_io_close_complete_context);
-        }
-        break;
+    if (send_result != IO_SEND_OK && send_context->send_result == IO_SEND_OK)
+    {
+        send_context->send_result = send_result;
     }
 
-    close_openssl_instance(tls_io_instance);
+    send_context->pending_record_count--;
+    if (send_context->is_sealed && send_context->pending_record_count == 0)
+    {
+        complete_send_context(send_context);
+    }
 }
 
-static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+/* The BIO below sits between OpenSSL and the underlying IO. Encrypted records are written straight
+   to xio_send (which only copies what it cannot send right away) and received bytes are read straight
+   from the buffer given to on_underlying_io_bytes_received; only the tail of a partially received
+   record is kept until the rest of it arrives. */
+static int tlsio_bio_write(BIO* bio, const char* buffer, int size)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    int result;
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)TLSIO_BIO_GET_DATA(bio);
+    TLS_SEND_CONTEXT* send_context = tls_io_instance->current_send_context;
 
-    if (tls_io_instance->tlsio_state == TLSIO_STATE_OPENING_UNDERLYING_IO)
+    BIO_clear_retry_flags(bio);
+
+    if (tls_io_instance->handshake_step_state == TLS_HANDSHAKE_STEP_RUNNING)
     {
-        if (open_result == IO_OPEN_OK)
+        /* on a handshake worker: the underlying IO is only used by the thread calling dowork, which sends these bytes */
+        result = (append_bytes(&tls_io_instance->handshake_output, &tls_io_instance->handshake_output_size, (const unsigned char*)buffer, (size_t)size) == 0) ? size : -1;
+    }
+    else
+    {
+        int send_result;
+
+        if (send_context != NULL)
         {
-            tls_io_instance->tlsio_state = TLSIO_STATE_IN_HANDSHAKE;
+            send_context->pending_record_count++;
+        }
+
+        send_result = xio_send(tls_io_instance->underlying_io, buffer, (size_t)size,
+            (send_context == NULL) ? NULL : on_underlying_io_record_send_complete, send_context);
+        if (send_result != 0)
+        {
+            if (send_context != NULL)
+            {
+                send_context->pending_record_count--;
+            }
+
+            if (send_result == XIO_SEND_WOULD_BLOCK)
+            {
+                /* the underlying IO took none of the bytes, OpenSSL keeps the record and writes it again on the next SSL_write */
+                tls_io_instance->is_send_blocked = true;
+                BIO_set_retry_write(bio);
+            }
+            else
+            {
+                LogError("Error in xio_send.");
+            }
+
+            result = -1;
+        }
+        else
+        {
+            result = size;
+        }
+    }
+
+    return result;
+}
+
+static int tlsio_bio_read(BIO* bio, char* buffer, int size)
+{
+    int result = 0;
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)TLSIO_BIO_GET_DATA(bio);
+    size_t copy_size;
+
+    BIO_clear_retry_flags(bio);
+
+    /* bytes left over from earlier chunks come first */
+    if (tls_io_instance->pending_received_bytes_size > 0)
+    {
+        copy_size = ((size_t)size < tls_io_instance->pending_received_bytes_size) ? (size_t)size : tls_io_instance->pending_received_bytes_size;
+        (void)memcpy(buffer, tls_io_instance->pending_received_bytes, copy_size);
+        tls_io_instance->pending_received_bytes_size -= copy_size;
+        (void)memmove(tls_io_instance->pending_received_bytes, tls_io_instance->pending_received_bytes + copy_size, tls_io_instance->pending_received_bytes_size);
+        result = (int)copy_size;
+    }
+
+    if ((result < size) && (tls_io_instance->received_bytes_size > 0))
+    {
+        copy_size = ((size_t)(size - result) < tls_io_instance->received_bytes_size) ? (size_t)(size - result) : tls_io_instance->received_bytes_size;
+        (void)memcpy(buffer + result, tls_io_instance->received_bytes, copy_size);
+        tls_io_instance->received_bytes += copy_size;
+        tls_io_instance->received_bytes_size -= copy_size;
+        result += (int)copy_size;
+    }
+
+    if (result == 0)
+    {
+        BIO_set_retry_read(bio);
+        result = -1;
+    }
+
+    return result;
+}
+
+static long tlsio_bio_ctrl(BIO* bio, int cmd, long num, void* ptr)
+{
+    long result;
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)TLSIO_BIO_GET_DATA(bio);
+
+    (void)num;
+    (void)ptr;
+
+    switch (cmd)
+    {
+    case BIO_CTRL_FLUSH:
+        result = 1;
+        break;
+    case BIO_CTRL_PENDING:
+        result = (tls_io_instance == NULL) ? 0 : (long)(tls_io_instance->pending_received_bytes_size + tls_io_instance->received_bytes_size);
+        break;
+    default:
+        result = 0;
+        break;
+    }
+
+    return result;
+}
+
+static int tlsio_bio_create(BIO* bio)
+{
+    TLSIO_BIO_SET_DATA(bio, NULL);
+    TLSIO_BIO_SET_INIT(bio, 1);
+    return 1;
+}
+
+static int tlsio_bio_destroy(BIO* bio)
+{
+    /* the instance owns all the data the BIO points to */
+    TLSIO_BIO_SET_DATA(bio, NULL);
+    return 1;
+}
+
+static int create_tlsio_bio_method(void)
+{
+    int result;
+
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || defined(LIBRESSL_VERSION_NUMBER)
+    static BIO_METHOD tlsio_bio_method_instance =
+    {
+        BIO_TYPE_SOURCE_SINK,
+        "tlsio_openssl",
+        tlsio_bio_write,
+        tlsio_bio_read,
+        NULL,
+        NULL,
+        tlsio_bio_ctrl,
+        tlsio_bio_create,
+        tlsio_bio_destroy,
+        NULL
+    };
+
+    tlsio_bio_method = &tlsio_bio_method_instance;
+    result = 0;
+#else
+    if ((tlsio_bio_method = BIO_meth_new(BIO_TYPE_SOURCE_SINK, "tlsio_openssl")) == NULL)
+    {
+        log_ERR_get_error("Failed creating the BIO method.");
+        result = __FAILURE__;
+    }
+    else if ((BIO_meth_set_write(tlsio_bio_method, tlsio_bio_write) != 1) ||
+        (BIO_meth_set_read(tlsio_bio_method, tlsio_bio_read) != 1) ||
+        (BIO_meth_set_ctrl(tlsio_bio_method, tlsio_bio_ctrl) != 1) ||
+        (BIO_meth_set_create(tlsio_bio_method, tlsio_bio_create) != 1) ||
+        (BIO_meth_set_destroy(tlsio_bio_method, tlsio_bio_destroy) != 1))
+    {
+        log_ERR_get_error("Failed setting up the BIO method.");
+        BIO_meth_free(tlsio_bio_method);
+        tlsio_bio_method = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+#endif
+
+    return result;
+}
+
+static void destroy_tlsio_bio_method(void)
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && !defined(LIBRESSL_VERSION_NUMBER)
+    if (tlsio_bio_method != NULL)
+    {
+        BIO_meth_free(tlsio_bio_method);
+    }
+#endif
+    tlsio_bio_method = NULL;
+}
+
+static void run_handshake_step(TLS_IO_INSTANCE* tls_io_instance, int* hsret, int* ssl_err, unsigned long* error_code)
+{
+    // ERR_clear_error must be called before any call that might set an
+    // SSL_get_error result
+    ERR_clear_error();
+    *hsret = SSL_do_handshake(tls_io_instance->ssl);
+    *ssl_err = (*hsret == SSL_DO_HANDSHAKE_SUCCESS) ? SSL_ERROR_NONE : SSL_get_error(tls_io_instance->ssl, *hsret);
+    /* the error queue is per thread, the code is taken here for the thread that reports it */
+    *error_code = (*ssl_err == SSL_ERROR_SSL) ? ERR_get_error() : 0;
+}
+
+static void complete_handshake_step(TLS_IO_INSTANCE* tls_io_instance, int hsret, int ssl_err, unsigned long error_code)
+{
+    if (hsret != SSL_DO_HANDSHAKE_SUCCESS)
+    {
+        if (ssl_err != SSL_ERROR_WANT_READ && ssl_err != SSL_ERROR_WANT_WRITE)
+        {
+            if (ssl_err == SSL_ERROR_SSL)
+            {
+                LogInfo(ERR_error_string(error_code, NULL));
+            }
+            else
+            {
+                LogInfo("SSL handshake failed: %d", ssl_err);
+            }
+            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
+        }
+    }
+    else
+    {
+        tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
+        indicate_open_complete(tls_io_instance, IO_OPEN_OK);
+    }
+}
+
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+static int handshake_worker_thread(void* arg)
+{
+    (void)arg;
+
+    if (Lock(handshake_pool.lock) != LOCK_OK)
+    {
+        LogError("Failed acquiring the handshake pool lock.");
+    }
+    else
+    {
+        while (!handshake_pool.is_stopping)
+        {
+            TLS_IO_INSTANCE* tls_io_instance = handshake_pool.queue_head;
+
+            if (tls_io_instance == NULL)
+            {
+                (void)Condition_Wait(handshake_pool.work_available, handshake_pool.lock, 0);
+            }
+            else
+            {
+                handshake_pool.queue_head = tls_io_instance->next_handshake_step;
+                if (handshake_pool.queue_head == NULL)
+                {
+                    handshake_pool.queue_tail = NULL;
+                }
+
+                tls_io_instance->next_handshake_step = NULL;
+                tls_io_instance->handshake_step_state = TLS_HANDSHAKE_STEP_RUNNING;
+                (void)Unlock(handshake_pool.lock);
+
+                run_handshake_step(tls_io_instance, &tls_io_instance->handshake_step_result, &tls_io_instance->handshake_step_ssl_error, &tls_io_instance->handshake_step_error_code);
+
+                (void)Lock(handshake_pool.lock);
+                tls_io_instance->handshake_step_state = TLS_HANDSHAKE_STEP_DONE;
+                (void)Condition_Post(tls_io_instance->handshake_step_done);
+            }
+        }
+
+        (void)Unlock(handshake_pool.lock);
+    }
+
+    return 0;
+}
+
+/* called with the pool lock held */
+static int start_handshake_workers(void)
+{
+    int result;
+
+    if (handshake_pool.worker_count > 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < TLSIO_HANDSHAKE_WORKER_COUNT; i++)
+        {
+            if (ThreadAPI_Create(&handshake_pool.workers[i], handshake_worker_thread, NULL) != THREADAPI_OK)
+            {
+                LogError("Failed starting handshake worker %lu.", (unsigned long)i);
+                break;
+            }
+        }
+
+        handshake_pool.worker_count = i;
+        result = (i > 0) ? 0 : __FAILURE__;
+    }
+
+    return result;
+}
+
+static int start_handshake_step(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    if ((handshake_pool.lock == NULL) ||
+        (Lock(handshake_pool.lock) != LOCK_OK))
+    {
+        LogError("Failed acquiring the handshake pool lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (start_handshake_workers() != 0)
+        {
+            result = __FAILURE__;
+        }
+        /* signalled by the worker when the step is done, only the thread closing the instance waits on it */
+        else if ((tls_io_instance->handshake_step_done == NULL) &&
+            ((tls_io_instance->handshake_step_done = Condition_Init()) == NULL))
+        {
+            LogError("Failed creating the handshake step condition.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            tls_io_instance->handshake_step_state = TLS_HANDSHAKE_STEP_QUEUED;
+            tls_io_instance->next_handshake_step = NULL;
+
+            if (handshake_pool.queue_tail == NULL)
+            {
+                handshake_pool.queue_head = tls_io_instance;
+            }
+            else
+            {
+                handshake_pool.queue_tail->next_handshake_step = tls_io_instance;
+            }
+            handshake_pool.queue_tail = tls_io_instance;
+
+            (void)Condition_Post(handshake_pool.work_available);
+            result = 0;
+        }
+
+        (void)Unlock(handshake_pool.lock);
+    }
+
+    return result;
+}
+#endif
+
+// Non-NULL tls_io_instance is guaranteed by callers. 
+// We are in TLSIO_STATE_IN_HANDSHAKE when entering this method.
+static void send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+    if (tls_io_instance->handshake_offload &&
+        (start_handshake_step(tls_io_instance) == 0))
+    {
+        /* the result is picked up by tlsio_openssl_dowork */
+    }
+    else
+#endif
+    {
+        int hsret;
+        int ssl_err;
+        unsigned long error_code;
+
+        run_handshake_step(tls_io_instance, &hsret, &ssl_err, &error_code);
+        complete_handshake_step(tls_io_instance, hsret, ssl_err, error_code);
+    }
+}
+
+/* waits for a handshake step still owned by a worker, the SSL object is about to go away */
+static void cancel_handshake_step(TLS_IO_INSTANCE* tls_io_instance)
+{
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+    if (tls_io_instance->handshake_step_state != TLS_HANDSHAKE_STEP_IDLE)
+    {
+        if (Lock(handshake_pool.lock) != LOCK_OK)
+        {
+            LogError("Failed acquiring the handshake pool lock.");
+        }
+        else
+        {
+            if (tls_io_instance->handshake_step_state == TLS_HANDSHAKE_STEP_QUEUED)
+            {
+                TLS_IO_INSTANCE* previous = NULL;
+                TLS_IO_INSTANCE* current = handshake_pool.queue_head;
+
+                while (current != NULL && current != tls_io_instance)
+                {
+                    previous = current;
+                    current = current->next_handshake_step;
+                }
+
+                if (current != NULL)
+                {
+                    if (previous == NULL)
+                    {
+                        handshake_pool.queue_head = current->next_handshake_step;
+                    }
+                    else
+                    {
+                        previous->next_handshake_step = current->next_handshake_step;
+                    }
+
+                    if (handshake_pool.queue_tail == current)
+                    {
+                        handshake_pool.queue_tail = previous;
+                    }
+                }
+            }
+
+            while (tls_io_instance->handshake_step_state == TLS_HANDSHAKE_STEP_RUNNING)
+            {
+                (void)Condition_Wait(tls_io_instance->handshake_step_done, handshake_pool.lock, 0);
+            }
+
+            tls_io_instance->handshake_step_state = TLS_HANDSHAKE_STEP_IDLE;
+            tls_io_instance->next_handshake_step = NULL;
+            (void)Unlock(handshake_pool.lock);
+        }
+    }
+#endif
+
+    free(tls_io_instance->handshake_output);
+    tls_io_instance->handshake_output = NULL;
+    tls_io_instance->handshake_output_size = 0;
+    free(tls_io_instance->handshake_backlog);
+    tls_io_instance->handshake_backlog = NULL;
+    tls_io_instance->handshake_backlog_size = 0;
+}
+
+static int add_certificate_to_store(SSL_CTX* ssl_context, const char* certValue)
+{
+    int result;
+
+    if (certValue == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        /* certValue is interned, so its certificates are parsed once for all the contexts using it */
+        result = x509_openssl_add_certificates(ssl_context, certValue);
+    }
+
+    return result;
+}
+
+/* interned options with the same content are the same pointer */
+static bool are_options_equal(const char* left, const char* right)
+{
+    return (left == right);
+}
+
+static bool are_credentials_equal(const TLS_CREDENTIALS* credentials, const TLS_IO_INSTANCE* tls_io_instance)
+{
+    return (credentials->tls_version == tls_io_instance->tls_version) &&
+        (credentials->tls_validation_callback == tls_io_instance->tls_validation_callback) &&
+        (credentials->tls_validation_callback_data == tls_io_instance->tls_validation_callback_data) &&
+        are_options_equal(credentials->certificate, tls_io_instance->certificate) &&
+        are_options_equal(credentials->x509certificate, tls_io_instance->x509certificate) &&
+        are_options_equal(credentials->x509privatekey, tls_io_instance->x509privatekey) &&
+        are_options_equal(credentials->x509_ecc_cert, tls_io_instance->x509_ecc_cert) &&
+        are_options_equal(credentials->x509_ecc_aliaskey, tls_io_instance->x509_ecc_aliaskey);
+}
+
+static int copy_option(const char** destination, const char* source)
+{
+    int result;
+
+    if (source == NULL)
+    {
+        *destination = NULL;
+        result = 0;
+    }
+    else if ((*destination = x509_openssl_pem_acquire(source)) == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void release_credentials(TLS_CREDENTIALS* credentials)
+{
+    x509_openssl_pem_release(credentials->certificate);
+    x509_openssl_pem_release(credentials->x509certificate);
+    x509_openssl_pem_release(credentials->x509privatekey);
+    x509_openssl_pem_release(credentials->x509_ecc_cert);
+    x509_openssl_pem_release(credentials->x509_ecc_aliaskey);
+}
+
+/* credentials has to be zeroed, it is left safe to release on failure */
+static int copy_credentials(TLS_CREDENTIALS* credentials, const TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    if ((copy_option(&credentials->certificate, tls_io_instance->certificate) != 0) ||
+        (copy_option(&credentials->x509certificate, tls_io_instance->x509certificate) != 0) ||
+        (copy_option(&credentials->x509privatekey, tls_io_instance->x509privatekey) != 0) ||
+        (copy_option(&credentials->x509_ecc_cert, tls_io_instance->x509_ecc_cert) != 0) ||
+        (copy_option(&credentials->x509_ecc_aliaskey, tls_io_instance->x509_ecc_aliaskey) != 0))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        credentials->tls_version = tls_io_instance->tls_version;
+        credentials->tls_validation_callback = tls_io_instance->tls_validation_callback;
+        credentials->tls_validation_callback_data = tls_io_instance->tls_validation_callback_data;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void destroy_ssl_context_cache_entry(SSL_CONTEXT_CACHE_ENTRY* entry)
+{
+    release_credentials(&entry->credentials);
+    free(entry);
+}
+
+static SSL_CONTEXT_CACHE_ENTRY* create_ssl_context_cache_entry(const TLS_IO_INSTANCE* tls_io_instance, SSL_CTX* ssl_context)
+{
+    SSL_CONTEXT_CACHE_ENTRY* result = (SSL_CONTEXT_CACHE_ENTRY*)malloc(sizeof(SSL_CONTEXT_CACHE_ENTRY));
+
+    if (result == NULL)
+    {
+        LogError("Failed allocating the SSL context cache entry.");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(SSL_CONTEXT_CACHE_ENTRY));
+
+        if (copy_credentials(&result->credentials, tls_io_instance) != 0)
+        {
+            LogError("Failed copying the SSL context cache key.");
+            destroy_ssl_context_cache_entry(result);
+            result = NULL;
+        }
+        else
+        {
+            result->ssl_context = ssl_context;
+            result->ref_count = 1;
+        }
+    }
+
+    return result;
+}
+
+static SSL_CTX* create_ssl_context(TLS_IO_INSTANCE* tlsInstance)
+{
+    SSL_CTX* result;
+
+    const SSL_METHOD* method = NULL;
+
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || (OPENSSL_VERSION_NUMBER >= 0x20000000L)
+    if (tlsInstance->tls_version == VERSION_1_2)
+    {
+        method = TLSv1_2_method();
+    }
+    else if (tlsInstance->tls_version == VERSION_1_1)
+    {
+        method = TLSv1_1_method();
+    }
+    else
+    {
+        method = TLSv1_method();
+    }
+#else
+    {
+        method = TLS_method();
+    }
+#endif
+
+    result = SSL_CTX_new(method);
+    if (result == NULL)
+    {
+        log_ERR_get_error("Failed allocating OpenSSL context.");
+    }
+    else if (add_certificate_to_store(result, tlsInstance->certificate) != 0)
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        log_ERR_get_error("unable to add_certificate_to_store.");
+    }
+    /*x509 authentication can only be build before underlying connection is realized*/
+    else if (
+        (tlsInstance->x509certificate != NULL) &&
+        (tlsInstance->x509privatekey != NULL) &&
+        (x509_openssl_add_credentials(result, tlsInstance->x509certificate, tlsInstance->x509privatekey) != 0)
+        )
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        log_ERR_get_error("unable to use x509 authentication");
+    }
+    else if (
+        (tlsInstance->x509_ecc_cert != NULL) &&
+        (tlsInstance->x509_ecc_aliaskey != NULL) &&
+        (x509_openssl_add_ecc_credentials(result, tlsInstance->x509_ecc_cert, tlsInstance->x509_ecc_aliaskey) != 0)
+        )
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        LogError("unable to use x509 authentication");
+    }
+    else
+    {
+        SSL_CTX_set_cert_verify_callback(result, tlsInstance->tls_validation_callback, tlsInstance->tls_validation_callback_data);
+        SSL_CTX_set_verify(result, SSL_VERIFY_PEER, NULL);
+
+        // Specifies that the default locations for which CA certificates are loaded should be used.
+        if (SSL_CTX_set_default_verify_paths(result) != 1)
+        {
+            // This is only a warning to the user. They can still specify the certificate via SetOption.
+            LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
+        }
+    }
+
+    return result;
+}
+
+/* Connections with the same TLS version, trusted certificates, client credentials and validation callback
+   share one SSL_CTX, so the trusted certificates are parsed into a single X509_STORE */
+static SSL_CTX* acquire_ssl_context(TLS_IO_INSTANCE* tls_io_instance)
+{
+    SSL_CTX* result = NULL;
+    SSL_CONTEXT_CACHE_ENTRY* entry;
+
+    if ((ssl_context_cache_lock != NULL) && (Lock(ssl_context_cache_lock) != LOCK_OK))
+    {
+        LogError("Failed acquiring the SSL context cache lock.");
+    }
+    else
+    {
+        for (entry = ssl_context_cache; entry != NULL; entry = entry->next)
+        {
+            if (are_credentials_equal(&entry->credentials, tls_io_instance))
+            {
+                entry->ref_count++;
+                result = entry->ssl_context;
+                break;
+            }
+        }
+
+        if ((result == NULL) &&
+            ((result = create_ssl_context(tls_io_instance)) != NULL))
+        {
+            /* when the context cannot be cached it is simply owned by this connection alone */
+            if ((entry = create_ssl_context_cache_entry(tls_io_instance, result)) != NULL)
+            {
+                entry->next = ssl_context_cache;
+                ssl_context_cache = entry;
+            }
+        }
+
+        if (ssl_context_cache_lock != NULL)
+        {
+            (void)Unlock(ssl_context_cache_lock);
+        }
+    }
+
+    return result;
+}
+
+/* unlinks the cache entry that holds ssl_context, returning it only if the caller held the last reference */
+static SSL_CONTEXT_CACHE_ENTRY* remove_ssl_context_cache_reference(SSL_CTX* ssl_context, bool* is_cached)
+{
+    SSL_CONTEXT_CACHE_ENTRY* result = NULL;
+    SSL_CONTEXT_CACHE_ENTRY** entry_link;
+
+    *is_cached = false;
+
+    for (entry_link = &ssl_context_cache; *entry_link != NULL; entry_link = &(*entry_link)->next)
+    {
+        if ((*entry_link)->ssl_context == ssl_context)
+        {
+            *is_cached = true;
+
+            if (--(*entry_link)->ref_count == 0)
+            {
+                result = *entry_link;
+                *entry_link = result->next;
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+static void release_ssl_context(SSL_CTX* ssl_context)
+{
+    SSL_CONTEXT_CACHE_ENTRY* entry;
+    bool is_cached;
+
+    if ((ssl_context_cache_lock != NULL) && (Lock(ssl_context_cache_lock) != LOCK_OK))
+    {
+        LogError("Failed acquiring the SSL context cache lock, the SSL context is leaked.");
+    }
+    else
+    {
+        entry = remove_ssl_context_cache_reference(ssl_context, &is_cached);
+
+        if (ssl_context_cache_lock != NULL)
+        {
+            (void)Unlock(ssl_context_cache_lock);
+        }
+
+        if (entry != NULL)
+        {
+            destroy_ssl_context_cache_entry(entry);
+        }
+
+        if ((entry != NULL) || !is_cached)
+        {
+            SSL_CTX_free(ssl_context);
+        }
+    }
+}
+
+/* takes ssl_context out of the cache when the caller is its only user, so that it can be modified;
+   a context that other connections are using cannot be detached */
+static bool detach_ssl_context(SSL_CTX* ssl_context)
+{
+    bool result;
+    SSL_CONTEXT_CACHE_ENTRY* entry;
+    bool is_cached;
+
+    if ((ssl_context_cache_lock != NULL) && (Lock(ssl_context_cache_lock) != LOCK_OK))
+    {
+        LogError("Failed acquiring the SSL context cache lock.");
+        result = false;
+    }
+    else
+    {
+        entry = remove_ssl_context_cache_reference(ssl_context, &is_cached);
+        if ((entry == NULL) && is_cached)
+        {
+            /* still used by other connections, put the reference back */
+            SSL_CONTEXT_CACHE_ENTRY* shared_entry;
+            for (shared_entry = ssl_context_cache; shared_entry != NULL; shared_entry = shared_entry->next)
+            {
+                if (shared_entry->ssl_context == ssl_context)
+                {
+                    shared_entry->ref_count++;
+                    break;
+                }
+            }
+
+            result = false;
+        }
+        else
+        {
+            result = true;
+        }
+
+        if (ssl_context_cache_lock != NULL)
+        {
+            (void)Unlock(ssl_context_cache_lock);
+        }
+
+        if (entry != NULL)
+        {
+            destroy_ssl_context_cache_entry(entry);
+        }
+    }
+
+    return result;
+}
+
+static bool is_tls_session_resumable(const SSL_SESSION* session)
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L) && !defined(LIBRESSL_VERSION_NUMBER)
+    return SSL_SESSION_is_resumable(session) == 1;
+#else
+    (void)session;
+    return true;
+#endif
+}
+
+static bool is_tls_session_cache_match(const TLS_SESSION_CACHE_ENTRY* entry, const TLS_IO_INSTANCE* tls_io_instance)
+{
+    return (entry->port == tls_io_instance->port) &&
+        (strcmp(entry->hostname, tls_io_instance->hostname) == 0) &&
+        are_credentials_equal(&entry->credentials, tls_io_instance);
+}
+
+static void destroy_tls_session_cache_entry(TLS_SESSION_CACHE_ENTRY* entry)
+{
+    if (entry->session != NULL)
+    {
+        SSL_SESSION_free(entry->session);
+    }
+
+    release_credentials(&entry->credentials);
+    free(entry->hostname);
+    free(entry);
+}
+
+/* returns a new reference to the session cached for the host/port and credentials of tls_io_instance, or NULL */
+static SSL_SESSION* get_cached_tls_session(const TLS_IO_INSTANCE* tls_io_instance)
+{
+    SSL_SESSION* result = NULL;
+
+    if ((tls_io_instance->hostname != NULL) &&
+        (tls_session_cache_lock != NULL) &&
+        (Lock(tls_session_cache_lock) == LOCK_OK))
+    {
+        TLS_SESSION_CACHE_ENTRY* entry;
+
+        for (entry = tls_session_cache; entry != NULL; entry = entry->next)
+        {
+            if (is_tls_session_cache_match(entry, tls_io_instance))
+            {
+                tls_session_add_ref(entry->session);
+                result = entry->session;
+                break;
+            }
+        }
+
+        (void)Unlock(tls_session_cache_lock);
+    }
+
+    return result;
+}
+
+/* replaces the session cached for the host/port and credentials of tls_io_instance, a NULL session removes it */
+static void set_cached_tls_session(const TLS_IO_INSTANCE* tls_io_instance, SSL_SESSION* session)
+{
+    if ((tls_io_instance->hostname != NULL) &&
+        (tls_session_cache_lock != NULL) &&
+        (Lock(tls_session_cache_lock) == LOCK_OK))
+    {
+        TLS_SESSION_CACHE_ENTRY** entry_link;
+        TLS_SESSION_CACHE_ENTRY* entry = NULL;
+        size_t entry_count = 0;
+
+        for (entry_link = &tls_session_cache; *entry_link != NULL; entry_link = &(*entry_link)->next)
+        {
+            if (is_tls_session_cache_match(*entry_link, tls_io_instance))
+            {
+                entry = *entry_link;
+                *entry_link = entry->next;
+                break;
+            }
+
+            entry_count++;
+        }
+
+        if (entry != NULL)
+        {
+            SSL_SESSION_free(entry->session);
+            entry->session = NULL;
+
+            if (session == NULL)
+            {
+                destroy_tls_session_cache_entry(entry);
+                entry = NULL;
+            }
+        }
+        else if (session != NULL)
+        {
+            if ((entry = (TLS_SESSION_CACHE_ENTRY*)malloc(sizeof(TLS_SESSION_CACHE_ENTRY))) == NULL)
+            {
+                LogError("Failed allocating the TLS session cache entry.");
+            }
+            else
+            {
+                (void)memset(entry, 0, sizeof(TLS_SESSION_CACHE_ENTRY));
+
+                if ((mallocAndStrcpy_s(&entry->hostname, tls_io_instance->hostname) != 0) ||
+                    (copy_credentials(&entry->credentials, tls_io_instance) != 0))
+                {
+                    LogError("Failed copying the TLS session cache key.");
+                    destroy_tls_session_cache_entry(entry);
+                    entry = NULL;
+                }
+                else
+                {
+                    entry->port = tls_io_instance->port;
+
+                    /* the list is bounded, the least recently used entry is evicted first */
+                    for (; *entry_link != NULL; entry_link = &(*entry_link)->next)
+                    {
+                        if (++entry_count >= TLS_SESSION_CACHE_MAX_ENTRIES)
+                        {
+                            TLS_SESSION_CACHE_ENTRY* evicted = *entry_link;
+                            *entry_link = NULL;
+
+                            while (evicted != NULL)
+                            {
+                                TLS_SESSION_CACHE_ENTRY* next_evicted = evicted->next;
+                                destroy_tls_session_cache_entry(evicted);
+                                evicted = next_evicted;
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (entry != NULL)
+        {
+            tls_session_add_ref(session);
+            entry->session = session;
+            entry->next = tls_session_cache;
+            tls_session_cache = entry;
+        }
+
+        (void)Unlock(tls_session_cache_lock);
+    }
+}
+
+static void set_tls_session(TLS_IO_INSTANCE* tls_io_instance, SSL_SESSION* session)
+{
+    if (tls_io_instance->tls_session != NULL)
+    {
+        SSL_SESSION_free(tls_io_instance->tls_session);
+    }
+
+    if (session != NULL)
+    {
+        tls_session_add_ref(session);
+    }
+
+    tls_io_instance->tls_session = session;
+}
+
+/* keeps the session of a connection that was shut down cleanly so that the next open can resume it,
+   any other connection drops the session it offered in case that is what failed */
+static void save_tls_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (SSL_is_init_finished(tls_io_instance->ssl) &&
+        ((SSL_get_shutdown(tls_io_instance->ssl) & SSL_SENT_SHUTDOWN) != 0))
+    {
+        SSL_SESSION* session = SSL_get1_session(tls_io_instance->ssl);
+        if (session != NULL)
+        {
+            if (is_tls_session_resumable(session))
+            {
+                set_tls_session(tls_io_instance, session);
+                set_cached_tls_session(tls_io_instance, session);
+            }
+
+            SSL_SESSION_free(session);
+        }
+    }
+    else if (tls_io_instance->tls_session != NULL)
+    {
+        set_tls_session(tls_io_instance, NULL);
+        set_cached_tls_session(tls_io_instance, NULL);
+    }
+}
+
+static void close_openssl_instance(TLS_IO_INSTANCE* tls_io_instance)
+{
+    cancel_handshake_step(tls_io_instance);
+
+    if (tls_io_instance->ssl != NULL)
+    {
+        if (tls_io_instance->tls_session_resumption)
+        {
+            save_tls_session(tls_io_instance);
+        }
+
+        SSL_free(tls_io_instance->ssl);
+        tls_io_instance->ssl = NULL;
+    }
+    if (tls_io_instance->ssl_context != NULL)
+    {
+        release_ssl_context(tls_io_instance->ssl_context);
+        tls_io_instance->ssl_context = NULL;
+    }
+
+    free(tls_io_instance->pending_received_bytes);
+    tls_io_instance->pending_received_bytes = NULL;
+    tls_io_instance->pending_received_bytes_size = 0;
+
+    /* a closed connection does not hold on to a record sized buffer */
+    free(tls_io_instance->decode_buffer);
+    tls_io_instance->decode_buffer = NULL;
+    tls_io_instance->decode_buffer_size = 0;
+}
+
+static void on_underlying_io_close_complete(void* context)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    switch (tls_io_instance->tlsio_state)
+    {
+    default:
+    case TLSIO_STATE_NOT_OPEN:
+    case TLSIO_STATE_OPEN:
+    case TLSIO_STATE_IN_HANDSHAKE:
+    case TLSIO_STATE_HANDSHAKE_FAILED:
+    case TLSIO_STATE_ERROR:
+        break;
+
+    case TLSIO_STATE_OPENING_UNDERLYING_IO:
+        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+        break;
+
+    case TLSIO_STATE_CLOSING:
+        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+
+        if (tls_io_instance->on_io_close_complete != NULL)
+        {
+            tls_io_instance->on_io_close_complete(tls_io_instance->on_io_close_complete_context);
+        }
+        break;
+    }
+
+    close_openssl_instance(tls_io_instance);
+}
+
+static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    if (tls_io_instance->tlsio_state == TLSIO_STATE_OPENING_UNDERLYING_IO)
+    {
+        if (open_result == IO_OPEN_OK)
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_IN_HANDSHAKE;
 
             // Begin the handshake process here. It continues in on_underlying_io_bytes_received
             send_handshake_bytes(tls_io_instance);
@@ -769,13 +2047,69 @@ static void on_underlying_io_error(void* context)
     }
 }
 
+static void indicate_decoded_bytes(TLS_IO_INSTANCE* tls_io_instance, size_t size)
+{
+    if (tls_io_instance->on_bytes_received == NULL)
+    {
+        LogError("NULL on_bytes_received.");
+    }
+    else
+    {
+        tls_io_instance->bytes_received += (uint64_t)size;
+        tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, tls_io_instance->decode_buffer, size);
+    }
+}
+
+/* the buffer is only (re)allocated here, between two decodes, because the options can be changed
+   from within on_bytes_received while the current buffer is still being used */
+static int prepare_decode_buffer(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+    size_t needed_size = tls_io_instance->decode_buffer_option;
+
+    if (tls_io_instance->decode_per_record && needed_size < TLS_DECODE_BUFFER_DEFAULT_SIZE)
+    {
+        needed_size = TLS_DECODE_BUFFER_DEFAULT_SIZE;
+    }
+
+    if (tls_io_instance->decode_buffer != NULL && tls_io_instance->decode_buffer_size == needed_size)
+    {
+        result = 0;
+    }
+    else
+    {
+        unsigned char* new_buffer = (unsigned char*)malloc(needed_size);
+        if (new_buffer == NULL)
+        {
+            LogError("Failed allocating the %lu bytes decode buffer.", (unsigned long)needed_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            free(tls_io_instance->decode_buffer);
+            tls_io_instance->decode_buffer = new_buffer;
+            tls_io_instance->decode_buffer_size = needed_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/* Plaintext is gathered from as many records as fit in the decode buffer before on_bytes_received
+   is called, unless the per record mode asks for exactly one callback per record */
 static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
 {
     int result = 0;
-    unsigned char buffer[64];
+    size_t decoded_size = 0;
 
     int rcv_bytes = 1;
 
+    if (prepare_decode_buffer(tls_io_instance) != 0)
+    {
+        return __FAILURE__;
+    }
+
     while (rcv_bytes > 0)
     {
         if (tls_io_instance->ssl == NULL)
@@ -785,44 +2119,89 @@ static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
             return result;
         }
 
-        rcv_bytes = SSL_read(tls_io_instance->ssl, buffer, sizeof(buffer));
+        rcv_bytes = SSL_read(tls_io_instance->ssl, tls_io_instance->decode_buffer + decoded_size, (int)(tls_io_instance->decode_buffer_size - decoded_size));
         if (rcv_bytes > 0)
         {
-            if (tls_io_instance->on_bytes_received == NULL)
-            {
-                LogError("NULL on_bytes_received.");
-            }
-            else
+            decoded_size += (size_t)rcv_bytes;
+
+            if (tls_io_instance->decode_per_record ||
+                decoded_size == tls_io_instance->decode_buffer_size)
             {
-                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, rcv_bytes);
+                indicate_decoded_bytes(tls_io_instance, decoded_size);
+                decoded_size = 0;
             }
         }
     }
 
+    if (decoded_size > 0)
+    {
+        indicate_decoded_bytes(tls_io_instance, decoded_size);
+    }
+
+    return result;
+}
+
+/* keeps the bytes OpenSSL did not consume (the start of a record that is not complete yet) */
+static int keep_unconsumed_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    if (append_bytes(&tls_io_instance->pending_received_bytes, &tls_io_instance->pending_received_bytes_size, tls_io_instance->received_bytes, tls_io_instance->received_bytes_size) != 0)
+    {
+        LogError("Failed allocating memory for the partially received record.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    tls_io_instance->received_bytes = NULL;
+    tls_io_instance->received_bytes_size = 0;
+
     return result;
 }
 
 static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
     TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    bool is_handshake_step_needed = false;
 
-    int written = BIO_write(tls_io_instance->in_bio, buffer, (int)size);
-    if (written != (int)size)
+    if (tls_io_instance->handshake_step_state != TLS_HANDSHAKE_STEP_IDLE)
     {
-        tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
-        indicate_error(tls_io_instance);
-        log_ERR_get_error("Error in BIO_write.");
+        /* a worker owns the SSL object, the bytes wait for the end of its step */
+        if (append_bytes(&tls_io_instance->handshake_backlog, &tls_io_instance->handshake_backlog_size, buffer, size) != 0)
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
+        }
     }
     else
     {
+        tls_io_instance->received_bytes = buffer;
+        tls_io_instance->received_bytes_size = size;
+
         switch (tls_io_instance->tlsio_state)
         {
         default:
             break;
 
         case TLSIO_STATE_IN_HANDSHAKE:
+            if (tls_io_instance->handshake_offload)
+            {
+                /* the worker reads the bytes kept below */
+                is_handshake_step_needed = true;
+                break;
+            }
+
             send_handshake_bytes(tls_io_instance);
-            break;
+
+            /* application data that came in the same chunk as the end of the handshake */
+            if ((tls_io_instance->tlsio_state != TLSIO_STATE_OPEN) ||
+                (tls_io_instance->received_bytes_size + tls_io_instance->pending_received_bytes_size == 0))
+            {
+                break;
+            }
+            /* fall through */
 
         case TLSIO_STATE_OPEN:
             if (decode_ssl_received_bytes(tls_io_instance) != 0)
@@ -833,214 +2212,168 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
             }
             break;
         }
+
+        /* the connection may have been closed from within a callback, there is nothing to keep then */
+        if (tls_io_instance->ssl == NULL)
+        {
+            tls_io_instance->received_bytes = NULL;
+            tls_io_instance->received_bytes_size = 0;
+        }
+        else if (keep_unconsumed_received_bytes(tls_io_instance) != 0)
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+            indicate_error(tls_io_instance);
+        }
+        else if (is_handshake_step_needed)
+        {
+            send_handshake_bytes(tls_io_instance);
+        }
     }
 }
 
-static int add_certificate_to_store(TLS_IO_INSTANCE* tls_io_instance, const char* certValue)
+/* finishes an offloaded handshake step from the thread calling dowork */
+static void poll_handshake_step(TLS_IO_INSTANCE* tls_io_instance)
 {
-    int result = 0;
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+    bool is_step_done = false;
 
-    if (certValue != NULL)
+    if (Lock(handshake_pool.lock) != LOCK_OK)
+    {
+        LogError("Failed acquiring the handshake pool lock.");
+    }
+    else
     {
-        X509_STORE* cert_store = SSL_CTX_get_cert_store(tls_io_instance->ssl_context);
-        if (cert_store == NULL)
+        if (tls_io_instance->handshake_step_state == TLS_HANDSHAKE_STEP_DONE)
         {
-            log_ERR_get_error("failure in SSL_CTX_get_cert_store.");
-            result = __FAILURE__;
+            tls_io_instance->handshake_step_state = TLS_HANDSHAKE_STEP_IDLE;
+            is_step_done = true;
+        }
+
+        (void)Unlock(handshake_pool.lock);
+    }
+
+    if (is_step_done)
+    {
+        bool has_new_bytes = (tls_io_instance->handshake_backlog_size > 0);
+        bool is_step_ok;
+
+        if ((tls_io_instance->handshake_output_size > 0) &&
+            (xio_send(tls_io_instance->underlying_io, tls_io_instance->handshake_output, tls_io_instance->handshake_output_size, NULL, NULL) != 0))
+        {
+            LogError("Error in xio_send.");
+            is_step_ok = false;
         }
         else
         {
-#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
-            const BIO_METHOD* bio_method;
-#else
-            BIO_METHOD* bio_method;
-#endif
-            bio_method = BIO_s_mem();
-            if (bio_method == NULL)
+            is_step_ok = (append_bytes(&tls_io_instance->pending_received_bytes, &tls_io_instance->pending_received_bytes_size, tls_io_instance->handshake_backlog, tls_io_instance->handshake_backlog_size) == 0);
+        }
+
+        /* released before the next step is queued, whose worker starts filling handshake_output again */
+        free(tls_io_instance->handshake_output);
+        tls_io_instance->handshake_output = NULL;
+        tls_io_instance->handshake_output_size = 0;
+        free(tls_io_instance->handshake_backlog);
+        tls_io_instance->handshake_backlog = NULL;
+        tls_io_instance->handshake_backlog_size = 0;
+
+        if (!is_step_ok)
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
+        }
+        else if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
+        {
+            complete_handshake_step(tls_io_instance, tls_io_instance->handshake_step_result, tls_io_instance->handshake_step_ssl_error, tls_io_instance->handshake_step_error_code);
+
+            if (!has_new_bytes)
             {
-                log_ERR_get_error("failure in BIO_s_mem");
-                result = __FAILURE__;
+                /* the next step starts when more bytes arrive */
             }
-            else
+            else if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
             {
-                BIO* cert_memory_bio = BIO_new(bio_method);
-
-                if (cert_memory_bio == NULL)
-                {
-                    log_ERR_get_error("failure in BIO_new");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    int puts_result = BIO_puts(cert_memory_bio, certValue);
-                    if (puts_result < 0)
-                    {
-                        log_ERR_get_error("failure in BIO_puts");
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        if ((size_t)puts_result != strlen(certValue))
-                        {
-                            log_ERR_get_error("mismatching legths");
-                            result = __FAILURE__;
-                        }
-                        else
-                        {
-                            X509* certificate;
-                            while ((certificate = PEM_read_bio_X509(cert_memory_bio, NULL, NULL, NULL)) != NULL)
-                            {
-                                if (!X509_STORE_add_cert(cert_store, certificate))
-                                {
-                                    X509_free(certificate);
-                                    log_ERR_get_error("failure in X509_STORE_add_cert");
-                                    break;
-                                }
-                                X509_free(certificate);
-                            }
-                            if (certificate == NULL)
-                            {
-                                result = 0;/*all is fine*/
-                            }
-                            else
-                            {
-                                /*previous while loop terminated unfortunately*/
-                                result = __FAILURE__;
-                            }
-                        }
-                    }
-                    BIO_free(cert_memory_bio);
-                }
+                send_handshake_bytes(tls_io_instance);
+            }
+            else if ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+                (decode_ssl_received_bytes(tls_io_instance) != 0))
+            {
+                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+                indicate_error(tls_io_instance);
+                LogError("Error in decode_ssl_received_bytes.");
             }
         }
     }
-    return result;
+#else
+    (void)tls_io_instance;
+#endif
 }
 
 static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
 {
     int result;
 
-    const SSL_METHOD* method = NULL;
-
-#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || (OPENSSL_VERSION_NUMBER >= 0x20000000L)
-    if (tlsInstance->tls_version == VERSION_1_2)
-    {
-        method = TLSv1_2_method();
-    }
-    else if (tlsInstance->tls_version == VERSION_1_1)
-    {
-        method = TLSv1_1_method();
-    }
-    else
-    {
-        method = TLSv1_method();
-    }
-#else
-    {
-        method = TLS_method();
-    }
-#endif
-
-    tlsInstance->ssl_context = SSL_CTX_new(method);
+    tlsInstance->ssl_context = acquire_ssl_context(tlsInstance);
     if (tlsInstance->ssl_context == NULL)
     {
-        log_ERR_get_error("Failed allocating OpenSSL context.");
-        result = __FAILURE__;
-    }
-    else if (add_certificate_to_store(tlsInstance, tlsInstance->certificate) != 0)
-    {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
-        log_ERR_get_error("unable to add_certificate_to_store.");
-        result = __FAILURE__;
-    }
-    /*x509 authentication can only be build before underlying connection is realized*/
-    else if (
-        (tlsInstance->x509certificate != NULL) &&
-        (tlsInstance->x509privatekey != NULL) &&
-        (x509_openssl_add_credentials(tlsInstance->ssl_context, tlsInstance->x509certificate, tlsInstance->x509privatekey) != 0)
-        )
-    {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
-        log_ERR_get_error("unable to use x509 authentication");
-        result = __FAILURE__;
-    }
-    else if (
-        (tlsInstance->x509_ecc_cert != NULL) &&
-        (tlsInstance->x509_ecc_aliaskey != NULL) &&
-        (x509_openssl_add_ecc_credentials(tlsInstance->ssl_context, tlsInstance->x509_ecc_cert, tlsInstance->x509_ecc_aliaskey) != 0)
-        )
-    {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
-        LogError("unable to use x509 authentication");
+        LogError("Failed obtaining the OpenSSL context.");
         result = __FAILURE__;
     }
     else
     {
-        SSL_CTX_set_cert_verify_callback(tlsInstance->ssl_context, tlsInstance->tls_validation_callback, tlsInstance->tls_validation_callback_data);
-
-        tlsInstance->in_bio = BIO_new(BIO_s_mem());
-        if (tlsInstance->in_bio == NULL)
+        BIO* bio = BIO_new(tlsio_bio_method);
+        if (bio == NULL)
         {
-            SSL_CTX_free(tlsInstance->ssl_context);
+            release_ssl_context(tlsInstance->ssl_context);
             tlsInstance->ssl_context = NULL;
-            log_ERR_get_error("Failed BIO_new for in BIO.");
+            log_ERR_get_error("Failed BIO_new.");
             result = __FAILURE__;
         }
         else
         {
-            tlsInstance->out_bio = BIO_new(BIO_s_mem());
-            if (tlsInstance->out_bio == NULL)
+            TLSIO_BIO_SET_DATA(bio, tlsInstance);
+
+            tlsInstance->ssl = SSL_new(tlsInstance->ssl_context);
+            if (tlsInstance->ssl == NULL)
             {
-                (void)BIO_free(tlsInstance->in_bio);
-                SSL_CTX_free(tlsInstance->ssl_context);
+                (void)BIO_free(bio);
+                release_ssl_context(tlsInstance->ssl_context);
                 tlsInstance->ssl_context = NULL;
-                log_ERR_get_error("Failed BIO_new for out BIO.");
+                log_ERR_get_error("Failed creating OpenSSL instance.");
                 result = __FAILURE__;
             }
             else
             {
-                if ((BIO_set_mem_eof_return(tlsInstance->in_bio, -1) <= 0) ||
-                    (BIO_set_mem_eof_return(tlsInstance->out_bio, -1) <= 0))
-                {
-                    (void)BIO_free(tlsInstance->in_bio);
-                    (void)BIO_free(tlsInstance->out_bio);
-                    SSL_CTX_free(tlsInstance->ssl_context);
-                    tlsInstance->ssl_context = NULL;
-                    LogError("Failed BIO_set_mem_eof_return.");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    SSL_CTX_set_verify(tlsInstance->ssl_context, SSL_VERIFY_PEER, NULL);
+                /* the same BIO reads and writes, the SSL takes ownership of it */
+                SSL_set_bio(tlsInstance->ssl, bio, bio);
+                SSL_set_connect_state(tlsInstance->ssl);
 
-                    // Specifies that the default locations for which CA certificates are loaded should be used.
-                    if (SSL_CTX_set_default_verify_paths(tlsInstance->ssl_context) != 1)
-                    {
-                        // This is only a warning to the user. They can still specify the certificate via SetOption.
-                        LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
-                    }
+                /* a send refused with XIO_SEND_WOULD_BLOCK is retried by the caller, not necessarily from the same buffer */
+                (void)SSL_set_mode(tlsInstance->ssl, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 
-                    tlsInstance->ssl = SSL_new(tlsInstance->ssl_context);
-                    if (tlsInstance->ssl == NULL)
+                if (tlsInstance->tls_session_resumption)
+                {
+                    /* a session given through the options wins over the one cached for the host and credentials */
+                    SSL_SESSION* session = tlsInstance->tls_session;
+                    if (session != NULL)
                     {
-                        (void)BIO_free(tlsInstance->in_bio);
-                        (void)BIO_free(tlsInstance->out_bio);
-                        SSL_CTX_free(tlsInstance->ssl_context);
-                        tlsInstance->ssl_context = NULL;
-                        log_ERR_get_error("Failed creating OpenSSL instance.");
-                        result = __FAILURE__;
+                        tls_session_add_ref(session);
                     }
                     else
                     {
-                        SSL_set_bio(tlsInstance->ssl, tlsInstance->in_bio, tlsInstance->out_bio);
-                        SSL_set_connect_state(tlsInstance->ssl);
-                        result = 0;
+                        session = get_cached_tls_session(tlsInstance);
+                    }
+
+                    if (session != NULL)
+                    {
+                        if (SSL_set_session(tlsInstance->ssl, session) != 1)
+                        {
+                            /* not fatal, the handshake simply is a full one */
+                            log_ERR_get_error("Failed offering the TLS session for resumption.");
+                        }
+
+                        SSL_SESSION_free(session);
                     }
                 }
+
+                result = 0;
             }
         }
     }
@@ -1055,6 +2388,7 @@ int tlsio_openssl_init(void)
     ERR_load_BIO_strings();
     OpenSSL_add_all_algorithms();
 
+#ifdef TLSIO_OPENSSL_LOCK_CALLBACKS
     if (openssl_static_locks_install() != 0)
     {
         LogError("Failed to install static locks in OpenSSL!");
@@ -1062,18 +2396,120 @@ int tlsio_openssl_init(void)
     }
 
     openssl_dynamic_locks_install();
+#endif
+
+    if ((ssl_context_cache_lock == NULL) &&
+        ((ssl_context_cache_lock = Lock_Init()) == NULL))
+    {
+        LogError("Failed to create the SSL context cache lock!");
+        return __FAILURE__;
+    }
+
+    if (x509_openssl_init() != 0)
+    {
+        LogError("Failed to initialize the PEM cache!");
+        return __FAILURE__;
+    }
+
+    if ((tls_session_cache_lock == NULL) &&
+        ((tls_session_cache_lock = Lock_Init()) == NULL))
+    {
+        LogError("Failed to create the TLS session cache lock!");
+        return __FAILURE__;
+    }
+
+    if ((tlsio_bio_method == NULL) &&
+        (create_tlsio_bio_method() != 0))
+    {
+        LogError("Failed to create the tlsio BIO method!");
+        return __FAILURE__;
+    }
+
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+    if ((handshake_pool.lock == NULL) &&
+        (((handshake_pool.lock = Lock_Init()) == NULL) ||
+        ((handshake_pool.work_available = Condition_Init()) == NULL)))
+    {
+        LogError("Failed to create the handshake pool!");
+        return __FAILURE__;
+    }
+#endif
+
     return 0;
 }
 
 void tlsio_openssl_deinit(void)
 {
+    if (ssl_context_cache_lock != NULL)
+    {
+        (void)Lock_Deinit(ssl_context_cache_lock);
+        ssl_context_cache_lock = NULL;
+    }
+
+    while (tls_session_cache != NULL)
+    {
+        TLS_SESSION_CACHE_ENTRY* entry = tls_session_cache;
+        tls_session_cache = entry->next;
+        destroy_tls_session_cache_entry(entry);
+    }
+
+    x509_openssl_deinit();
+
+    if (tls_session_cache_lock != NULL)
+    {
+        (void)Lock_Deinit(tls_session_cache_lock);
+        tls_session_cache_lock = NULL;
+    }
+
+    destroy_tlsio_bio_method();
+
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+    if (handshake_pool.lock != NULL)
+    {
+        size_t i;
+
+        if (Lock(handshake_pool.lock) == LOCK_OK)
+        {
+            handshake_pool.is_stopping = true;
+            for (i = 0; i < handshake_pool.worker_count; i++)
+            {
+                (void)Condition_Post(handshake_pool.work_available);
+            }
+            (void)Unlock(handshake_pool.lock);
+        }
+
+        for (i = 0; i < handshake_pool.worker_count; i++)
+        {
+            int worker_result;
+            (void)ThreadAPI_Join(handshake_pool.workers[i], &worker_result);
+        }
+
+        if (handshake_pool.work_available != NULL)
+        {
+            Condition_Deinit(handshake_pool.work_available);
+        }
+        (void)Lock_Deinit(handshake_pool.lock);
+
+        handshake_pool.lock = NULL;
+        handshake_pool.work_available = NULL;
+        handshake_pool.worker_count = 0;
+        handshake_pool.is_stopping = false;
+        handshake_pool.queue_head = NULL;
+        handshake_pool.queue_tail = NULL;
+    }
+#endif
+
+#ifdef TLSIO_OPENSSL_LOCK_CALLBACKS
     openssl_dynamic_locks_uninstall();
     openssl_static_locks_uninstall();
+#endif
 #if  (OPENSSL_VERSION_NUMBER >= 0x00907000L) &&  (OPENSSL_VERSION_NUMBER < 0x20000000L)
     FIPS_mode_set(0);
 #endif
+#ifdef TLSIO_OPENSSL_LOCK_CALLBACKS
     CRYPTO_set_locking_callback(NULL);
     CRYPTO_set_id_callback(NULL);
+#endif
     ERR_free_strings();
     EVP_cleanup();
 
@@ -1109,6 +2545,8 @@ CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters)
         {
             const IO_INTERFACE_DESCRIPTION* underlying_io_interface;
             void* io_interface_parameters;
+            /* must stay in scope until xio_create below has used it */
+            SOCKETIO_CONFIG socketio_config;
 
             if (tls_io_config->underlying_io_interface != NULL)
             {
@@ -1117,8 +2555,6 @@ CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters)
             }
             else
             {
-                SOCKETIO_CONFIG socketio_config;
-
                 socketio_config.hostname = tls_io_config->hostname;
                 socketio_config.port = tls_io_config->port;
                 socketio_config.accepted_socket = NULL;
@@ -1136,8 +2572,13 @@ CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters)
             else
             {
                 result->certificate = NULL;
-                result->in_bio = NULL;
-                result->out_bio = NULL;
+                result->received_bytes = NULL;
+                result->received_bytes_size = 0;
+                result->pending_received_bytes = NULL;
+                result->pending_received_bytes_size = 0;
+                result->current_send_context = NULL;
+                result->send_contexts = NULL;
+                result->free_send_contexts = NULL;
                 result->on_bytes_received = NULL;
                 result->on_bytes_received_context = NULL;
                 result->on_io_open_complete = NULL;
@@ -1156,10 +2597,42 @@ CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters)
                 result->x509_ecc_aliaskey = NULL;
 
                 result->tls_version = VERSION_1_0;
-
-                result->underlying_io = xio_create(underlying_io_interface, io_interface_parameters);
-                if (result->underlying_io == NULL)
+                result->bytes_sent = 0;
+                result->bytes_received = 0;
+                result->send_queue_high_watermark = 0;
+                result->send_queue_low_watermark = 0;
+                result->is_send_blocked = false;
+                result->on_io_writable = NULL;
+                result->on_io_writable_context = NULL;
+                result->hostname = NULL;
+                result->port = tls_io_config->port;
+                result->tls_session_resumption = true;
+                result->tls_session = NULL;
+                result->decode_buffer = NULL;
+                result->decode_buffer_size = 0;
+                result->decode_buffer_option = TLS_DECODE_BUFFER_DEFAULT_SIZE;
+                result->decode_per_record = false;
+                result->handshake_offload = false;
+                result->handshake_step_state = TLS_HANDSHAKE_STEP_IDLE;
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+                result->handshake_step_done = NULL;
+#endif
+                result->handshake_output = NULL;
+                result->handshake_output_size = 0;
+                result->handshake_backlog = NULL;
+                result->handshake_backlog_size = 0;
+                result->next_handshake_step = NULL;
+
+                if ((tls_io_config->hostname != NULL) &&
+                    (mallocAndStrcpy_s(&result->hostname, tls_io_config->hostname) != 0))
+                {
+                    free(result);
+                    result = NULL;
+                    LogError("Failed copying the hostname.");
+                }
+                else if ((result->underlying_io = xio_create(underlying_io_interface, io_interface_parameters)) == NULL)
                 {
+                    free(result->hostname);
                     free(result);
                     result = NULL;
                     LogError("Failed xio_create.");
@@ -1184,21 +2657,33 @@ void tlsio_openssl_destroy(CONCRETE_IO_HANDLE tls_io)
     else
     {
         TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
-        if (tls_io_instance->certificate != NULL)
-        {
-            free(tls_io_instance->certificate);
-            tls_io_instance->certificate = NULL;
-        }
-        free((void*)tls_io_instance->x509certificate);
-        free((void*)tls_io_instance->x509privatekey);
-        free((void*)tls_io_instance->x509_ecc_cert);
-        free((void*)tls_io_instance->x509_ecc_aliaskey);
+        x509_openssl_pem_release(tls_io_instance->certificate);
+        tls_io_instance->certificate = NULL;
+        x509_openssl_pem_release(tls_io_instance->x509certificate);
+        x509_openssl_pem_release(tls_io_instance->x509privatekey);
+        x509_openssl_pem_release(tls_io_instance->x509_ecc_cert);
+        x509_openssl_pem_release(tls_io_instance->x509_ecc_aliaskey);
         close_openssl_instance(tls_io_instance);
+        set_tls_session(tls_io_instance, NULL);
+        free(tls_io_instance->hostname);
         if (tls_io_instance->underlying_io != NULL)
         {
             xio_destroy(tls_io_instance->underlying_io);
             tls_io_instance->underlying_io = NULL;
         }
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+        if (tls_io_instance->handshake_step_done != NULL)
+        {
+            Condition_Deinit(tls_io_instance->handshake_step_done);
+        }
+#endif
+        /* the underlying IO is gone, no record can still complete */
+        while (tls_io_instance->send_contexts != NULL)
+        {
+            TLS_SEND_CONTEXT* send_context = tls_io_instance->send_contexts;
+            tls_io_instance->send_contexts = send_context->next;
+            free(send_context);
+        }
         free(tls_io);
     }
 }
@@ -1295,6 +2780,9 @@ int tlsio_openssl_close(CONCRETE_IO_HANDLE tls_io, ON_IO_CLOSE_COMPLETE on_io_cl
             tls_io_instance->tlsio_state = TLSIO_STATE_CLOSING;
             tls_io_instance->on_io_close_complete = on_io_close_complete;
             tls_io_instance->on_io_close_complete_context = callback_context;
+            // Sending close_notify is what keeps the session resumable, OpenSSL invalidates the
+            // session of a connection that is torn down without it
+            (void)SSL_shutdown(tls_io_instance->ssl);
             // xio_close is guaranteed to succeed from the open state, and the callback completes the 
             // transition into TLSIO_STATE_NOT_OPEN
             if (xio_close(tls_io_instance->underlying_io, on_underlying_io_close_complete, tls_io_instance) != 0)
@@ -1321,6 +2809,47 @@ int tlsio_openssl_close(CONCRETE_IO_HANDLE tls_io, ON_IO_CLOSE_COMPLETE on_io_cl
     return result;
 }
 
+/* the watermarks are enforced here rather than in the underlying IO so that records OpenSSL produces
+   on its own (handshake, alerts) are never refused once they have been taken out of the BIO */
+static size_t get_underlying_queued_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    size_t result;
+    XIO_STATISTICS statistics;
+
+    if (xio_get_statistics(tls_io_instance->underlying_io, &statistics) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = statistics.queued_bytes;
+    }
+
+    return result;
+}
+
+static void check_send_queue_drained(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->is_send_blocked)
+    {
+        size_t low_watermark = tls_io_instance->send_queue_low_watermark;
+        if (low_watermark > tls_io_instance->send_queue_high_watermark)
+        {
+            low_watermark = tls_io_instance->send_queue_high_watermark;
+        }
+
+        if (get_underlying_queued_bytes(tls_io_instance) <= low_watermark)
+        {
+            tls_io_instance->is_send_blocked = false;
+
+            if (tls_io_instance->on_io_writable != NULL)
+            {
+                tls_io_instance->on_io_writable(tls_io_instance->on_io_writable_context);
+            }
+        }
+    }
+}
+
 int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
@@ -1342,6 +2871,8 @@ int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t siz
         else
         {
             int res;
+            TLS_SEND_CONTEXT* send_context;
+
             if (tls_io_instance->ssl == NULL)
             {
                 LogError("SSL channel closed in tlsio_openssl_send.");
@@ -1349,22 +2880,62 @@ int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t siz
                 return result;
             }
 
+            if (tls_io_instance->send_queue_high_watermark != 0 &&
+                get_underlying_queued_bytes(tls_io_instance) >= tls_io_instance->send_queue_high_watermark)
+            {
+                tls_io_instance->is_send_blocked = true;
+                return XIO_SEND_WOULD_BLOCK;
+            }
+
+            if (on_send_complete == NULL)
+            {
+                send_context = NULL;
+            }
+            else if ((send_context = get_send_context(tls_io_instance, on_send_complete, callback_context)) == NULL)
+            {
+                result = __FAILURE__;
+                return result;
+            }
+
+            /* the records are handed to the underlying IO by the BIO while SSL_write runs */
+            tls_io_instance->current_send_context = send_context;
             res = SSL_write(tls_io_instance->ssl, buffer, (int)size);
-            if (res != (int)size)
+            tls_io_instance->current_send_context = NULL;
+
+            if (res <= 0 && SSL_get_error(tls_io_instance->ssl, res) == SSL_ERROR_WANT_WRITE)
+            {
+                /* the caller sends the same bytes again after ON_IO_WRITABLE, OpenSSL then resumes with the record the underlying IO refused */
+                if (send_context != NULL)
+                {
+                    send_context->on_send_complete = NULL;
+                }
+
+                result = XIO_SEND_WOULD_BLOCK;
+            }
+            else if (res != (int)size)
             {
                 log_ERR_get_error("SSL_write error.");
+
+                if (send_context != NULL)
+                {
+                    /* the send failed, records already handed over finish without telling the caller */
+                    send_context->on_send_complete = NULL;
+                }
+
                 result = __FAILURE__;
             }
             else
             {
-                if (write_outgoing_bytes(tls_io_instance, on_send_complete, callback_context) != 0)
-                {
-                    LogError("Error in write_outgoing_bytes.");
-                    result = __FAILURE__;
-                }
-                else
+                tls_io_instance->bytes_sent += size;
+                result = 0;
+            }
+
+            if (send_context != NULL)
+            {
+                send_context->is_sealed = true;
+                if (send_context->pending_record_count == 0)
                 {
-                    result = 0;
+                    complete_send_context(send_context);
                 }
             }
         }
@@ -1373,37 +2944,59 @@ int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t siz
     return result;
 }
 
-void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
+int tlsio_openssl_get_statistics(CONCRETE_IO_HANDLE tls_io, XIO_STATISTICS* statistics)
 {
-    if (tls_io == NULL)
+    int result;
+
+    if (tls_io == NULL || statistics == NULL)
     {
-        LogError("NULL tls_io.");
+        LogError("Invalid argument: tls_io = %p, statistics = %p", tls_io, statistics);
+        result = __FAILURE__;
     }
     else
     {
         TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
 
-        switch (tls_io_instance->tlsio_state)
+        /* the queue and timing counters come from the transport, the byte counters are plaintext */
+        if (xio_get_statistics(tls_io_instance->underlying_io, statistics) != 0)
         {
-        case TLSIO_STATE_OPENING_UNDERLYING_IO:
-        case TLSIO_STATE_IN_HANDSHAKE:
-        case TLSIO_STATE_OPEN:
-            /* this is needed in order to pump out bytes produces by OpenSSL for things like renegotiation */
-            write_outgoing_bytes(tls_io_instance, NULL, NULL);
-            break;
-        case TLSIO_STATE_NOT_OPEN:
-        case TLSIO_STATE_HANDSHAKE_FAILED:
-        case TLSIO_STATE_CLOSING:
-        case TLSIO_STATE_ERROR:
-        default:
-            break;
+            (void)memset(statistics, 0, sizeof(XIO_STATISTICS));
         }
 
+        statistics->bytes_sent = tls_io_instance->bytes_sent;
+        statistics->bytes_received = tls_io_instance->bytes_received;
+        result = 0;
+    }
+
+    return result;
+}
+
+void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
+{
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io.");
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        /* bytes OpenSSL produces on its own (renegotiation, alerts) are written by the BIO as soon as they exist */
         if (tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN)
         {
             /* Same behavior as schannel */
             xio_dowork(tls_io_instance->underlying_io);
 
+            if (tls_io_instance->handshake_step_state != TLS_HANDSHAKE_STEP_IDLE)
+            {
+                poll_handshake_step(tls_io_instance);
+            }
+
+            if (tls_io_instance->tlsio_state == TLSIO_STATE_OPEN)
+            {
+                check_send_queue_drained(tls_io_instance);
+            }
+
             if (tls_io_instance->tlsio_state == TLSIO_STATE_HANDSHAKE_FAILED)
             {
                 // The handshake failed so we need to close. The tlsio becomes aware of the
@@ -1438,31 +3031,27 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
         if (strcmp(OPTION_TRUSTED_CERT, optionName) == 0)
         {
             const char* cert = (const char*)value;
-            size_t len;
 
-            if (tls_io_instance->certificate != NULL)
-            {
-                // Free the memory if it has been previously allocated
-                free(tls_io_instance->certificate);
-            }
+            // Release the previously set certificate
+            x509_openssl_pem_release(tls_io_instance->certificate);
 
-            // Store the certificate
-            len = strlen(cert);
-            tls_io_instance->certificate = malloc(len + 1);
+            // Store a reference to the interned certificate
+            tls_io_instance->certificate = x509_openssl_pem_acquire(cert);
             if (tls_io_instance->certificate == NULL)
             {
                 result = __FAILURE__;
             }
             else
             {
-                strcpy(tls_io_instance->certificate, cert);
                 result = 0;
             }
 
-            // If we're previously connected then add the cert to the context
-            if (tls_io_instance->ssl_context != NULL)
+            // If we're previously connected then add the cert to the context, unless other
+            // connections share it, in which case the cert is used from the next open on
+            if (tls_io_instance->ssl_context != NULL &&
+                detach_ssl_context(tls_io_instance->ssl_context))
             {
-                result = add_certificate_to_store(tls_io_instance, cert);
+                result = add_certificate_to_store(tls_io_instance->ssl_context, tls_io_instance->certificate);
             }
         }
         else if (strcmp(SU_OPTION_X509_CERT, optionName) == 0)
@@ -1474,10 +3063,10 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             }
             else
             {
-                /*let's make a copy of this option*/
-                if (mallocAndStrcpy_s((char**)&tls_io_instance->x509certificate, value) != 0)
+                /*let's take a reference to the interned option*/
+                if ((tls_io_instance->x509certificate = x509_openssl_pem_acquire((const char*)value)) == NULL)
                 {
-                    LogError("unable to mallocAndStrcpy_s");
+                    LogError("unable to x509_openssl_pem_acquire");
                     result = __FAILURE__;
                 }
                 else
@@ -1495,10 +3084,10 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             }
             else
             {
-                /*let's make a copy of this option*/
-                if (mallocAndStrcpy_s((char**)&tls_io_instance->x509privatekey, value) != 0)
+                /*let's take a reference to the interned option*/
+                if ((tls_io_instance->x509privatekey = x509_openssl_pem_acquire((const char*)value)) == NULL)
                 {
-                    LogError("unable to mallocAndStrcpy_s");
+                    LogError("unable to x509_openssl_pem_acquire");
                     result = __FAILURE__;
                 }
                 else
@@ -1521,10 +3110,10 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             }
             else
             {
-                /*let's make a copy of this option*/
-                if (mallocAndStrcpy_s((char**)&tls_io_instance->x509_ecc_aliaskey, value) != 0)
+                /*let's take a reference to the interned option*/
+                if ((tls_io_instance->x509_ecc_aliaskey = x509_openssl_pem_acquire((const char*)value)) == NULL)
                 {
-                    LogError("unable to mallocAndStrcpy_s");
+                    LogError("unable to x509_openssl_pem_acquire");
                     result = __FAILURE__;
                 }
                 else
@@ -1547,10 +3136,10 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             }
             else
             {
-                /*let's make a copy of this option*/
-                if (mallocAndStrcpy_s((char**)&tls_io_instance->x509_ecc_cert, value) != 0)
+                /*let's take a reference to the interned option*/
+                if ((tls_io_instance->x509_ecc_cert = x509_openssl_pem_acquire((const char*)value)) == NULL)
                 {
-                    LogError("unable to mallocAndStrcpy_s");
+                    LogError("unable to x509_openssl_pem_acquire");
                     result = __FAILURE__;
                 }
                 else
@@ -1566,7 +3155,8 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             tls_io_instance->tls_validation_callback = (TLS_CERTIFICATE_VALIDATION_CALLBACK)value;
 #pragma warning(pop)
 
-            if (tls_io_instance->ssl_context != NULL)
+            if (tls_io_instance->ssl_context != NULL &&
+                detach_ssl_context(tls_io_instance->ssl_context))
             {
                 SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
             }
@@ -1577,7 +3167,8 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
         {
             tls_io_instance->tls_validation_callback_data = (void*)value;
 
-            if (tls_io_instance->ssl_context != NULL)
+            if (tls_io_instance->ssl_context != NULL &&
+                detach_ssl_context(tls_io_instance->ssl_context))
             {
                 SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
             }
@@ -1630,6 +3221,69 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
         {
             result = 0;
         }
+        else if (strcmp(OPTION_TLS_DECODE_BUFFER_SIZE, optionName) == 0)
+        {
+            size_t decode_buffer_size = *(const size_t*)value;
+            if ((decode_buffer_size == 0) ||
+                (decode_buffer_size > INT_MAX))
+            {
+                LogError("Invalid tls_decode_buffer_size %lu.", (unsigned long)decode_buffer_size);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* applied by the next decode */
+                tls_io_instance->decode_buffer_option = decode_buffer_size;
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_TLS_DECODE_PER_RECORD, optionName) == 0)
+        {
+            tls_io_instance->decode_per_record = *(const bool*)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_TLS_HANDSHAKE_OFFLOAD, optionName) == 0)
+        {
+#ifdef TLSIO_OPENSSL_HANDSHAKE_OFFLOAD
+            /* applied by the next handshake step */
+            tls_io_instance->handshake_offload = *(const bool*)value;
+            result = 0;
+#else
+            LogError("tls_handshake_offload is not supported by this build.");
+            result = __FAILURE__;
+#endif
+        }
+        else if (strcmp(OPTION_TLS_SESSION_RESUMPTION, optionName) == 0)
+        {
+            tls_io_instance->tls_session_resumption = *(const bool*)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_TLS_SESSION, optionName) == 0)
+        {
+            /* offered on the next open, the current connection (if any) is not affected */
+            set_tls_session(tls_io_instance, (SSL_SESSION*)value);
+            result = 0;
+        }
+        else if (strcmp(OPTION_SEND_QUEUE_HIGH_WATERMARK, optionName) == 0)
+        {
+            tls_io_instance->send_queue_high_watermark = *(const size_t*)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_SEND_QUEUE_LOW_WATERMARK, optionName) == 0)
+        {
+            tls_io_instance->send_queue_low_watermark = *(const size_t*)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_ON_IO_WRITABLE, optionName) == 0)
+        {
+            tls_io_instance->on_io_writable = (ON_IO_WRITABLE)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_ON_IO_WRITABLE_CONTEXT, optionName) == 0)
+        {
+            tls_io_instance->on_io_writable_context = (void*)value;
+            result = 0;
+        }
         else
         {
             if (tls_io_instance->underlying_io == NULL)
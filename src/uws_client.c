@@ -18,6 +18,8 @@
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/uws_frame_encoder.h"
+#include "azure_c_shared_utility/uws_deflate.h"
+#include "azure_c_shared_utility/http_response_parser.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/utf8_checker.h"
 #include "azure_c_shared_utility/gb_rand.h"
@@ -25,6 +27,7 @@
 #include "azure_c_shared_utility/optionhandler.h"
 
 static const char* UWS_CLIENT_OPTIONS = "uWSClientOptions";
+static const char* SEC_WEBSOCKET_EXTENSIONS_HEADER = "Sec-WebSocket-Extensions";
 
 /* Requirements not needed as they are optional:
 Codes_SRS_UWS_CLIENT_01_254: [ If an endpoint receives a Ping frame and has not yet sent Pong frame(s) in response to previous Ping frame(s), the endpoint MAY elect to send a Pong frame for only the most recently processed Ping frame. ]
@@ -60,7 +63,8 @@ typedef enum UWS_FRAME_DECODER_STATE_TAG
     UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH,
     UWS_FRAME_DECODER_STATE_EXTENDED_LENGTH_16,
     UWS_FRAME_DECODER_STATE_EXTENDED_LENGTH_64,
-    UWS_FRAME_DECODER_STATE_PAYLOAD_BYTES
+    UWS_FRAME_DECODER_STATE_PAYLOAD_BYTES,
+    UWS_FRAME_DECODER_STATE_STREAMED_PAYLOAD_BYTES
 } UWS_FRAME_DECODER_STATE;
 
 typedef struct WS_INSTANCE_PROTOCOL_TAG
@@ -68,11 +72,19 @@ typedef struct WS_INSTANCE_PROTOCOL_TAG
     char* protocol;
 } WS_INSTANCE_PROTOCOL;
 
+/* One underlying send carrying several coalesced frames */
+typedef struct WS_COALESCED_SEND_TAG
+{
+    UWS_CLIENT_HANDLE uws_client;
+    uint64_t payload_size;
+} WS_COALESCED_SEND;
+
 typedef struct WS_PENDING_SEND_TAG
 {
     ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete;
     void* context;
     UWS_CLIENT_HANDLE uws_client;
+    WS_COALESCED_SEND* coalesced_send;
 } WS_PENDING_SEND;
 
 typedef struct UWS_CLIENT_INSTANCE_TAG
@@ -97,7 +109,30 @@ typedef struct UWS_CLIENT_INSTANCE_TAG
     void* on_ws_close_complete_context;
     unsigned char* received_bytes;
     size_t received_bytes_count;
+    size_t received_bytes_size;
+    HTTP_RESPONSE_PARSER upgrade_response_parser;
     UWS_FRAME_DECODER_STATE frame_decoder_state;
+    size_t frame_header_length;
+    uint64_t frame_payload_length;
+    uint64_t payload_bytes_sent;
+    uint64_t payload_bytes_received;
+    WS_PERMESSAGE_DEFLATE_OPTIONS* permessage_deflate_options;
+    UWS_DEFLATE_HANDLE uws_deflate;
+    bool is_receiving_compressed_message;
+    unsigned char compressed_message_opcode;
+    size_t send_coalescing_limit;
+    WS_COALESCED_SEND* coalesced_send;
+    unsigned char* coalesced_bytes;
+    size_t coalesced_bytes_count;
+    size_t coalesced_bytes_size;
+    bool is_coalesced_send_blocked;
+    ON_WS_FRAGMENT_RECEIVED on_ws_fragment_received;
+    void* on_ws_fragment_received_context;
+    unsigned char streamed_frame_first_byte;
+    uint64_t streamed_frame_remaining_length;
+    bool is_streamed_frame_started;
+    bool is_receiving_fragmented_message;
+    unsigned char fragmented_message_type;
 } UWS_CLIENT_INSTANCE;
 
 /* Codes_SRS_UWS_CLIENT_01_360: [ Connection confidentiality and integrity is provided by running the WebSocket Protocol over TLS (wss URIs). ]*/
@@ -267,6 +302,23 @@ UWS_CLIENT_HANDLE uws_client_create(const char* hostname, unsigned int port, con
                                 result->on_ws_close_complete_context = NULL;
                                 result->received_bytes = NULL;
                                 result->received_bytes_count = 0;
+                                result->received_bytes_size = 0;
+                                http_response_parser_init(&result->upgrade_response_parser);
+                                result->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+                                result->payload_bytes_sent = 0;
+                                result->payload_bytes_received = 0;
+                                result->permessage_deflate_options = NULL;
+                                result->uws_deflate = NULL;
+                                result->is_receiving_compressed_message = false;
+                                result->send_coalescing_limit = 0;
+                                result->coalesced_send = NULL;
+                                result->coalesced_bytes = NULL;
+                                result->coalesced_bytes_count = 0;
+                                result->coalesced_bytes_size = 0;
+                                result->is_coalesced_send_blocked = false;
+                                result->on_ws_fragment_received = NULL;
+                                result->on_ws_fragment_received_context = NULL;
+                                result->is_receiving_fragmented_message = false;
 
                                 result->protocol_count = protocol_count;
 
@@ -441,6 +493,23 @@ UWS_CLIENT_HANDLE uws_client_create_with_io(const IO_INTERFACE_DESCRIPTION* io_i
                                 result->on_ws_close_complete_context = NULL;
                                 result->received_bytes = NULL;
                                 result->received_bytes_count = 0;
+                                result->received_bytes_size = 0;
+                                http_response_parser_init(&result->upgrade_response_parser);
+                                result->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+                                result->payload_bytes_sent = 0;
+                                result->payload_bytes_received = 0;
+                                result->permessage_deflate_options = NULL;
+                                result->uws_deflate = NULL;
+                                result->is_receiving_compressed_message = false;
+                                result->send_coalescing_limit = 0;
+                                result->coalesced_send = NULL;
+                                result->coalesced_bytes = NULL;
+                                result->coalesced_bytes_count = 0;
+                                result->coalesced_bytes_size = 0;
+                                result->is_coalesced_send_blocked = false;
+                                result->on_ws_fragment_received = NULL;
+                                result->on_ws_fragment_received_context = NULL;
+                                result->is_receiving_fragmented_message = false;
 
                                 result->protocol_count = protocol_count;
 
@@ -510,6 +579,19 @@ UWS_CLIENT_HANDLE uws_client_create_with_io(const IO_INTERFACE_DESCRIPTION* io_i
     return result;
 }
 
+static void discard_coalesced_frames(UWS_CLIENT_INSTANCE* uws_client)
+{
+    /* the frames themselves are owned by the pending sends list */
+    if (uws_client->coalesced_send != NULL)
+    {
+        free(uws_client->coalesced_send);
+        uws_client->coalesced_send = NULL;
+        uws_client->coalesced_bytes_count = 0;
+    }
+
+    uws_client->is_coalesced_send_blocked = false;
+}
+
 void uws_client_destroy(UWS_CLIENT_HANDLE uws_client)
 {
     /* Codes_SRS_UWS_CLIENT_01_020: [ If `uws_client` is NULL, `uws_client_destroy` shall do nothing. ]*/
@@ -554,6 +636,25 @@ void uws_client_destroy(UWS_CLIENT_HANDLE uws_client)
             uws_client->underlying_io = NULL;
         }
 
+        if (uws_client->uws_deflate != NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_541: [ `uws_client_destroy` shall free the permessage-deflate instance negotiated for the last connection, if any, by calling `uws_deflate_destroy`. ]*/
+            uws_deflate_destroy(uws_client->uws_deflate);
+        }
+
+        if (uws_client->permessage_deflate_options != NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_542: [ `uws_client_destroy` shall free the permessage-deflate options set with `uws_client_set_option`. ]*/
+            free(uws_client->permessage_deflate_options);
+        }
+
+        /* Codes_SRS_UWS_CLIENT_01_584: [ `uws_client_destroy` shall free the memory used for coalescing frames. ]*/
+        discard_coalesced_frames(uws_client);
+        if (uws_client->coalesced_bytes != NULL)
+        {
+            free(uws_client->coalesced_bytes);
+        }
+
         /* Codes_SRS_UWS_CLIENT_01_024: [ `uws_client_destroy` shall free the list used to track the pending sends by calling `singlylinkedlist_destroy`. ]*/
         singlylinkedlist_destroy(uws_client->pending_sends);
         free(uws_client->resource_name);
@@ -601,6 +702,8 @@ static void unchecked_on_send_complete(void* context, IO_SEND_RESULT send_result
     (void)send_result;
 }
 
+static void flush_coalesced_frames(UWS_CLIENT_INSTANCE* uws_client);
+
 static int send_close_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned int close_error_code)
 {
     unsigned char* close_frame;
@@ -609,6 +712,8 @@ static int send_close_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned int close_
     int result;
     BUFFER_HANDLE close_frame_buffer;
 
+    flush_coalesced_frames(uws_client);
+
     close_frame_payload[0] = (unsigned char)(close_error_code >> 8);
     close_frame_payload[1] = (unsigned char)(close_error_code & 0xFF);
 
@@ -727,10 +832,36 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
                         "Sec-WebSocket-Key: %s\r\n"
                         "Sec-WebSocket-Protocol: %s\r\n"
                         "Sec-WebSocket-Version: 13\r\n"
+                        "%s"
                         "\r\n";
                     const char* base64_nonce_chars = STRING_c_str(base64_nonce);
+                    char extensions_header[UWS_DEFLATE_MAX_OFFER_SIZE + 32] = "";
+                    char extension_offer[UWS_DEFLATE_MAX_OFFER_SIZE];
+
+                    if (uws_client->permessage_deflate_options != NULL)
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_543: [ If permessage-deflate was enabled with `uws_client_set_option`, the upgrade request shall carry a `Sec-WebSocket-Extensions` header with the offer obtained by calling `uws_deflate_format_offer`. ]*/
+                        if (uws_deflate_format_offer(uws_client->permessage_deflate_options, extension_offer, sizeof(extension_offer)) != 0)
+                        {
+                            /* Codes_SRS_UWS_CLIENT_01_544: [ If `uws_deflate_format_offer` fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST`. ]*/
+                            upgrade_request_length = -1;
+                        }
+                        else
+                        {
+                            (void)sprintf(extensions_header, "%s: %s\r\n", SEC_WEBSOCKET_EXTENSIONS_HEADER, extension_offer);
+                            upgrade_request_length = 0;
+                        }
+                    }
+                    else
+                    {
+                        upgrade_request_length = 0;
+                    }
+
+                    if (upgrade_request_length == 0)
+                    {
+                        upgrade_request_length = (int)(strlen(upgrade_request_format) + strlen(uws_client->resource_name)+strlen(uws_client->hostname) + strlen(base64_nonce_chars) + strlen(uws_client->protocols[0].protocol) + strlen(extensions_header) + 5);
+                    }
 
-                    upgrade_request_length = (int)(strlen(upgrade_request_format) + strlen(uws_client->resource_name)+strlen(uws_client->hostname) + strlen(base64_nonce_chars) + strlen(uws_client->protocols[0].protocol)+5);
                     if (upgrade_request_length < 0)
                     {
                         /* Codes_SRS_UWS_CLIENT_01_408: [ If constructing of the WebSocket upgrade request fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST`. ]*/
@@ -754,7 +885,8 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
                                 uws_client->hostname,
                                 uws_client->port,
                                 base64_nonce_chars,
-                                uws_client->protocols[0].protocol);
+                                uws_client->protocols[0].protocol,
+                                extensions_header);
 
                             /* No need to have any send complete here, as we are monitoring the received bytes */
                             /* Codes_SRS_UWS_CLIENT_01_372: [ Once prepared the WebSocket upgrade request shall be sent by calling `xio_send`. ]*/
@@ -847,548 +979,777 @@ static void on_underlying_io_close_sent(void* context, IO_SEND_RESULT io_send_re
     }
 }
 
-/*the following function does the same as sscanf(pos2, "%d", &sec)*/
-/*this function only exists because some of platforms do not have sscanf. */
-static int ParseStringToDecimal(const char *src, int* dst)
+static int reserve_received_bytes(UWS_CLIENT_INSTANCE* uws_client, size_t needed_size)
 {
     int result;
-    char* next;
 
-    (*dst) = (int)strtol(src, &next, 0);
-    if ((src == next) || ((((*dst) == INT_MAX) || ((*dst) == INT_MIN)) && (errno != 0)))
+    if (needed_size <= uws_client->received_bytes_size)
     {
-        result = __FAILURE__;
+        result = 0;
     }
     else
     {
-        result = 0;
+        /* Codes_SRS_UWS_CLIENT_01_540: [ The memory used for accumulating received bytes shall be grown geometrically and kept across calls, so that it is not reallocated for every received chunk. ]*/
+        size_t new_size = uws_client->received_bytes_size * 2;
+        unsigned char* new_received_bytes;
+
+        if (new_size < needed_size)
+        {
+            new_size = needed_size;
+        }
+
+        new_received_bytes = (unsigned char*)realloc(uws_client->received_bytes, new_size);
+        if (new_received_bytes == NULL)
+        {
+            LogError("Cannot grow the received bytes buffer to %u bytes", (unsigned int)new_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            uws_client->received_bytes = new_received_bytes;
+            uws_client->received_bytes_size = new_size;
+            result = 0;
+        }
     }
 
     return result;
 }
 
-/*the following function does the same as sscanf(buf, "HTTP/%*d.%*d %d %*[^\r\n]", &ret) */
-/*this function only exists because some of platforms do not have sscanf. This is not a full implementation; it only works with well-defined HTTP response. */
-static int ParseHttpResponse(const char* src, int* dst)
+static int append_received_bytes(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* buffer, size_t size)
 {
     int result;
-    static const char HTTPPrefix[] = "HTTP/";
-    bool fail;
-    const char* runPrefix;
 
-    if ((src == NULL) || (dst == NULL))
+    if (reserve_received_bytes(uws_client, uws_client->received_bytes_count + size) != 0)
     {
         result = __FAILURE__;
     }
     else
     {
-        fail = false;
-        runPrefix = HTTPPrefix;
+        (void)memcpy(uws_client->received_bytes + uws_client->received_bytes_count, buffer, size);
+        uws_client->received_bytes_count += size;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void process_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned char opcode, const unsigned char* data_ptr, size_t length)
+{
+    switch (opcode)
+    {
+    default:
+        break;
+
+        /* Codes_SRS_UWS_CLIENT_01_153: [ *  %x1 denotes a text frame ]*/
+        /* Codes_SRS_UWS_CLIENT_01_258: [** Currently defined opcodes for data frames include 0x1 (Text), 0x2 (Binary). ]*/
+    case (unsigned char)WS_TEXT_FRAME:
+        /* Codes_SRS_UWS_CLIENT_01_386: [ When a WebSocket data frame is decoded succesfully it shall be indicated via the callback `on_ws_frame_received`. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_169: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
+        /* Codes_SRS_UWS_CLIENT_01_173: [ The "Payload data" is defined as "Extension data" concatenated with "Application data". ]*/
+        /* Codes_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
+        uws_client->payload_bytes_received += length;
+        uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_TEXT, data_ptr, length);
+        break;
+
+        /* Codes_SRS_UWS_CLIENT_01_154: [ *  %x2 denotes a binary frame ]*/
+    case (unsigned char)WS_BINARY_FRAME:
+        /* Codes_SRS_UWS_CLIENT_01_386: [ When a WebSocket data frame is decoded succesfully it shall be indicated via the callback `on_ws_frame_received`. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_169: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
+        /* Codes_SRS_UWS_CLIENT_01_173: [ The "Payload data" is defined as "Extension data" concatenated with "Application data". ]*/
+        /* Codes_SRS_UWS_CLIENT_01_264: [ The "Payload data" is arbitrary binary data whose interpretation is solely up to the application layer. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
+        uws_client->payload_bytes_received += length;
+        uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_BINARY, data_ptr, length);
+        break;
+
+        /* Codes_SRS_UWS_CLIENT_01_156: [ *  %x8 denotes a connection close ]*/
+        /* Codes_SRS_UWS_CLIENT_01_234: [ The Close frame contains an opcode of 0x8. ]*/
+    case (unsigned char)WS_CLOSE_FRAME:
+    {
+        uint16_t close_code;
+        uint16_t* close_code_ptr;
+        const unsigned char* extra_data_ptr;
+        size_t extra_data_length;
+        unsigned char* close_frame_bytes;
+        size_t close_frame_length;
+        bool utf8_error = false;
+
+        /* Codes_SRS_UWS_CLIENT_01_235: [ The Close frame MAY contain a body (the "Application data" portion of the frame) that indicates a reason for closing, such as an endpoint shutting down, an endpoint having received a frame too large, or an endpoint having received a frame that does not conform to the format expected by the endpoint. ]*/
+        if (length >= 2)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_236: [ If there is a body, the first two bytes of the body MUST be a 2-byte unsigned integer (in network byte order) representing a status code with value /code/ defined in Section 7.4. ]*/
+            close_code = (data_ptr[0] << 8) + data_ptr[1];
+
+            /* Codes_SRS_UWS_CLIENT_01_461: [ The argument `close_code` shall be set to point to the code extracted from the CLOSE frame. ]*/
+            close_code_ptr = &close_code;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_CLIENT_01_462: [ If no code can be extracted then `close_code` shall be NULL. ]*/
+            close_code_ptr = NULL;
+        }
 
-        while ((*runPrefix) != '\0')
+        if (length > 2)
         {
-            if ((*runPrefix) != (*src))
+            /* Codes_SRS_UWS_CLIENT_01_463: [ The extra bytes (besides the close code) shall be passed to the `on_ws_peer_closed` callback by using `extra_data` and `extra_data_length`. ]*/
+            extra_data_ptr = data_ptr + 2;
+            extra_data_length = length - 2;
+
+            /* Codes_SRS_UWS_CLIENT_01_238: [ As the data is not guaranteed to be human readable, clients MUST NOT show it to end users. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_237: [ Following the 2-byte integer, the body MAY contain UTF-8-encoded data with value /reason/, the interpretation of which is not defined by this specification. ]*/
+            if (utf8_checker_is_valid_utf8(extra_data_ptr, extra_data_length) != true)
             {
-                fail = true;
-                break;
+                LogError("Reason in CLOSE frame is not UTF-8.");
+                extra_data_ptr = NULL;
+                extra_data_length = 0;
+                utf8_error = true;
             }
-            src++;
-            runPrefix++;
+        }
+        else
+        {
+            extra_data_ptr = NULL;
+            extra_data_length = 0;
         }
 
-        if (!fail)
+        if (utf8_error)
+        {
+            uws_client->uws_state = UWS_STATE_CLOSING_UNDERLYING_IO;
+            flush_coalesced_frames(uws_client);
+            if (xio_close(uws_client->underlying_io, on_underlying_io_close_complete, uws_client) != 0)
+            {
+                LogError("Could not close underlying IO");
+                indicate_ws_error(uws_client, WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO);
+                uws_client->uws_state = UWS_STATE_CLOSED;
+            }
+        }
+        else
         {
-            while ((*src) != '.')
+            BUFFER_HANDLE close_frame_buffer;
+
+            if (uws_client->uws_state == UWS_STATE_CLOSING_WAITING_FOR_CLOSE)
             {
-                if ((*src) == '\0')
+                uws_client->uws_state = UWS_STATE_CLOSING_UNDERLYING_IO;
+                if (xio_close(uws_client->underlying_io, on_underlying_io_close_complete, uws_client) != 0)
                 {
-                    fail = true;
-                    break;
+                    indicate_ws_close_complete(uws_client);
+                    uws_client->uws_state = UWS_STATE_CLOSED;
                 }
-                src++;
             }
-        }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_296: [ Upon either sending or receiving a Close control frame, it is said that _The WebSocket Closing Handshake is Started_ and that the WebSocket connection is in the CLOSING state. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_240: [ The application MUST NOT send any more data frames after sending a Close frame. ]*/
+                uws_client->uws_state = UWS_STATE_CLOSING_SENDING_CLOSE;
+            }
 
-        if (!fail)
-        {
-            while ((*src) != ' ')
+            flush_coalesced_frames(uws_client);
+
+            /* Codes_SRS_UWS_CLIENT_01_241: [ If an endpoint receives a Close frame and did not previously send a Close frame, the endpoint MUST send a Close frame in response. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_242: [ It SHOULD do so as soon as practical. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_239: [ Close frames sent from client to server must be masked as per Section 5.3. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+            close_frame_buffer = uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0);
+            if (close_frame_buffer == NULL)
+            {
+                LogError("Cannot encode the response CLOSE frame");
+
+                /* Codes_SRS_UWS_CLIENT_01_288: [ To _Close the WebSocket Connection_, an endpoint closes the underlying TCP connection. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_290: [ An endpoint MAY close the connection via any means available when necessary, such as when under attack. ]*/
+                uws_client->uws_state = UWS_STATE_CLOSING_UNDERLYING_IO;
+                if (xio_close(uws_client->underlying_io, on_underlying_io_close_complete, uws_client) != 0)
+                {
+                    indicate_ws_error(uws_client, WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO);
+                    uws_client->uws_state = UWS_STATE_CLOSED;
+                }
+            }
+            else
             {
-                if ((*src) == '\0')
+                close_frame_bytes = BUFFER_u_char(close_frame_buffer);
+                close_frame_length = BUFFER_length(close_frame_buffer);
+                if (xio_send(uws_client->underlying_io, close_frame_bytes, close_frame_length, on_underlying_io_close_sent, uws_client) != 0)
                 {
-                    fail = true;
-                    break;
+                    LogError("Cannot send the response CLOSE frame");
+
+                    /* Codes_SRS_UWS_CLIENT_01_288: [ To _Close the WebSocket Connection_, an endpoint closes the underlying TCP connection. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_290: [ An endpoint MAY close the connection via any means available when necessary, such as when under attack. ]*/
+                    uws_client->uws_state = UWS_STATE_CLOSING_UNDERLYING_IO;
+                    if (xio_close(uws_client->underlying_io, on_underlying_io_close_complete, uws_client) != 0)
+                    {
+                        indicate_ws_error(uws_client, WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO);
+                        uws_client->uws_state = UWS_STATE_CLOSED;
+                    }
                 }
-                src++;
+
+                BUFFER_delete(close_frame_buffer);
             }
         }
 
-        if (fail)
+        /* Codes_SRS_UWS_CLIENT_01_460: [ When a CLOSE frame is received the callback `on_ws_peer_closed` passed to `uws_client_open_async` shall be called, while passing to it the argument `on_ws_peer_closed_context`. ]*/
+        uws_client->on_ws_peer_closed(uws_client->on_ws_peer_closed_context, close_code_ptr, extra_data_ptr, extra_data_length);
+
+        break;
+    }
+
+        /* Codes_SRS_UWS_CLIENT_01_157: [ *  %x9 denotes a ping ]*/
+        /* Codes_SRS_UWS_CLIENT_01_247: [ The Ping frame contains an opcode of 0x9. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
+    case (unsigned char)WS_PING_FRAME:
+    {
+        /* Codes_SRS_UWS_CLIENT_01_249: [ Upon receipt of a Ping frame, an endpoint MUST send a Pong frame in response ]*/
+        /* Codes_SRS_UWS_CLIENT_01_250: [ It SHOULD respond with Pong frame as soon as is practical. ]*/
+        unsigned char* pong_frame;
+        size_t pong_frame_length;
+        BUFFER_HANDLE pong_frame_buffer;
+
+        uws_client->uws_state = UWS_STATE_ERROR;
+
+        /* Codes_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+        pong_frame_buffer = uws_frame_encoder_encode(WS_PONG_FRAME, data_ptr, length, true, true, 0);
+        if (pong_frame_buffer == NULL)
         {
-            result = __FAILURE__;
+            LogError("Encoding of PONG failed.");
         }
         else
         {
-            if (ParseStringToDecimal(src, dst) != 0)
+            /* Codes_SRS_UWS_CLIENT_01_248: [ A Ping frame MAY include "Application data". ]*/
+            pong_frame = BUFFER_u_char(pong_frame_buffer);
+            pong_frame_length = BUFFER_length(pong_frame_buffer);
+            if (xio_send(uws_client->underlying_io, pong_frame, pong_frame_length, unchecked_on_send_complete, NULL) != 0)
             {
-                result = __FAILURE__;
-            }
-            else
-            {
-                result = 0;
+                LogError("Sending CLOSE frame failed.");
             }
+
+            BUFFER_delete(pong_frame_buffer);
         }
-    }
 
-    return result;
+        break;
+    }
+    /* Codes_SRS_UWS_CLIENT_01_252: [ The Pong frame contains an opcode of 0xA. ]*/
+    case (unsigned char)WS_PONG_FRAME:
+        break;
+    }
 }
 
-static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+/* Inflates the payload of a frame that belongs to a permessage-deflate compressed message and processes the result
+as a frame of the message type. The frame carrying RSV1 starts the message, continuation frames carry the rest of it. */
+static void process_compressed_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned char opcode, bool is_final, const unsigned char* data_ptr, size_t length)
 {
-    /* Codes_SRS_UWS_CLIENT_01_415: [ If called with a NULL `context` argument, `on_underlying_io_bytes_received` shall do nothing. ]*/
-    if (context != NULL)
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int decompress_result;
+
+    if (opcode != (unsigned char)WS_CONTINUATION_FRAME)
     {
-        UWS_CLIENT_HANDLE uws_client = (UWS_CLIENT_HANDLE)context;
+        uws_client->compressed_message_opcode = opcode;
+    }
 
-        if ((buffer == NULL) ||
-            (size == 0))
+    uws_client->is_receiving_compressed_message = !is_final;
+
+    /* Codes_SRS_UWS_CLIENT_01_550: [ The payload of a data frame that has RSV1 set, and of the continuation frames that follow it, shall be decompressed by calling `uws_deflate_decompress`, passing whether the frame is the final frame of the message. ]*/
+    decompress_result = uws_deflate_decompress(uws_client->uws_deflate, data_ptr, length, is_final, &decompressed, &decompressed_size);
+    if (decompress_result != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_551: [ If `uws_deflate_decompress` fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1007 shall be sent. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_594: [ If `uws_deflate_decompress` returns `UWS_DEFLATE_MESSAGE_TOO_BIG`, the CLOSE frame shall be sent with status code 1009 instead. ]*/
+        LogError("Cannot decompress permessage-deflate frame");
+        uws_client->is_receiving_compressed_message = false;
+        indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, (decompress_result == UWS_DEFLATE_MESSAGE_TOO_BIG) ? 1009 : 1007);
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_552: [ The decompressed bytes shall be indicated as a frame of the message type. ]*/
+        process_frame(uws_client, uws_client->compressed_message_opcode, decompressed, decompressed_size);
+    }
+}
+
+/* Hands a piece of a data frame payload to the fragment callback as soon as it has been received.
+is_last_chunk tells whether the piece ends the payload of the frame started by streamed_frame_first_byte. */
+static void process_streamed_payload(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* data_ptr, size_t length, bool is_last_chunk)
+{
+    unsigned char opcode = uws_client->streamed_frame_first_byte & 0x0F;
+    bool is_final = ((uws_client->streamed_frame_first_byte & 0x80) != 0) && is_last_chunk;
+    bool is_first = (opcode != (unsigned char)WS_CONTINUATION_FRAME) && (uws_client->is_streamed_frame_started == false);
+
+    if ((opcode == (unsigned char)WS_CONTINUATION_FRAME) &&
+        (uws_client->is_receiving_fragmented_message == false))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_591: [ If a continuation frame is received while no fragmented message is in progress, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+        LogError("Continuation frame received without a message in progress");
+        uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+        indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, 1002);
+    }
+    else
+    {
+        const unsigned char* fragment = data_ptr;
+        size_t fragment_size = length;
+        bool is_fragment_valid = true;
+        int decompress_result;
+        bool is_compressed = ((uws_client->streamed_frame_first_byte & 0x40) != 0) ||
+            ((opcode == (unsigned char)WS_CONTINUATION_FRAME) && uws_client->is_receiving_compressed_message);
+
+        if (is_first)
         {
-            /* Codes_SRS_UWS_CLIENT_01_416: [ If called with NULL `buffer` or zero `size` and the state of the iws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS`. ]*/
-            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS);
+            uws_client->fragmented_message_type = (opcode == (unsigned char)WS_TEXT_FRAME) ? WS_FRAME_TYPE_TEXT : WS_FRAME_TYPE_BINARY;
         }
-        else
+
+        uws_client->is_streamed_frame_started = true;
+        uws_client->is_receiving_fragmented_message = !is_final;
+
+        if (is_compressed)
         {
-            unsigned char decode_stream = 1;
+            uws_client->is_receiving_compressed_message = !is_final;
 
-            switch (uws_client->uws_state)
+            /* Codes_SRS_UWS_CLIENT_01_592: [ Payload pieces of a permessage-deflate compressed message shall be decompressed by calling `uws_deflate_decompress` as they arrive, passing `true` as `is_final` only for the last piece of the final frame. ]*/
+            decompress_result = uws_deflate_decompress(uws_client->uws_deflate, data_ptr, length, is_final, &fragment, &fragment_size);
+            if (decompress_result != 0)
             {
-            default:
-            case UWS_STATE_CLOSED:
-                decode_stream = 0;
-                break;
+                /* Codes_SRS_UWS_CLIENT_01_551: [ If `uws_deflate_decompress` fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1007 shall be sent. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_594: [ If `uws_deflate_decompress` returns `UWS_DEFLATE_MESSAGE_TOO_BIG`, the CLOSE frame shall be sent with status code 1009 instead. ]*/
+                LogError("Cannot decompress permessage-deflate frame");
+                uws_client->is_receiving_compressed_message = false;
+                uws_client->is_receiving_fragmented_message = false;
+                uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+                indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, (decompress_result == UWS_DEFLATE_MESSAGE_TOO_BIG) ? 1009 : 1007);
+                is_fragment_valid = false;
+            }
+        }
 
-            case UWS_STATE_OPENING_UNDERLYING_IO:
-                /* Codes_SRS_UWS_CLIENT_01_417: [ When `on_underlying_io_bytes_received` is called while OPENING but before the `on_underlying_io_open_complete` has been called, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN`. ]*/
-                indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN);
-                decode_stream = 0;
-                break;
+        if (is_fragment_valid)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_590: [ Each piece shall be indicated by calling the fragment callback with its context, the message type, the piece bytes and size, `is_first` set only for the first piece of a message and `is_final` set only for the last piece of the final frame of a message. ]*/
+            uws_client->payload_bytes_received += fragment_size;
+            uws_client->on_ws_fragment_received(uws_client->on_ws_fragment_received_context, uws_client->fragmented_message_type, fragment, fragment_size, is_first, is_final);
+        }
+    }
+}
 
-            case UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE:
+/* Decodes at most one frame from the start of bytes. The header fields decoded so far are kept in the
+instance, so a frame that arrives over several calls is not parsed again from its first byte.
+Returns the number of bytes the frame occupies, or 0 if more bytes are needed or decoding failed. */
+static size_t decode_frame(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* bytes, size_t bytes_count)
+{
+    size_t result = 0;
+    bool frame_complete = false;
+    bool need_more_bytes = false;
+
+    while ((frame_complete == false) &&
+        (need_more_bytes == false) &&
+        (result == 0))
+    {
+        switch (uws_client->frame_decoder_state)
+        {
+        default:
+        case UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH:
+            /* Codes_SRS_UWS_CLIENT_01_277: [ To receive WebSocket data, an endpoint listens on the underlying network connection. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_278: [ Incoming data MUST be parsed as WebSocket frames as defined in Section 5.2. ]*/
+            if (bytes_count < 2)
             {
-                /* Codes_SRS_UWS_CLIENT_01_378: [ When `on_underlying_io_bytes_received` is called while the uws is OPENING, the received bytes shall be accumulated in order to attempt parsing the WebSocket Upgrade response. ]*/
-                unsigned char* new_received_bytes = (unsigned char*)realloc(uws_client->received_bytes, uws_client->received_bytes_count + size + 1);
-                if (new_received_bytes == NULL)
+                need_more_bytes = true;
+            }
+            /* Codes_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
+            else if ((bytes[1] & 0x80) != 0)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
+                LogError("Masked frame detected by WebSocket client");
+                indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, 1002);
+                need_more_bytes = true;
+            }
+            else if (((bytes[0] & 0x40) != 0) &&
+                ((uws_client->uws_deflate == NULL) ||
+                ((bytes[0] & 0x08) != 0) ||
+                ((bytes[0] & 0x0F) == (unsigned char)WS_CONTINUATION_FRAME)))
+            {
+                /* Codes_SRS_UWS_CLIENT_01_553: [ If a frame with RSV1 set is received while permessage-deflate was not negotiated, or RSV1 is set on a control frame or a continuation frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+                LogError("Unexpected RSV1 bit in received frame");
+                indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, 1002);
+                need_more_bytes = true;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
+                /* Codes_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
+                uws_client->frame_payload_length = bytes[1];
+
+                if (uws_client->frame_payload_length == 126)
                 {
-                    /* Codes_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
-                    indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY);
-                    decode_stream = 0;
+                    /* Codes_SRS_UWS_CLIENT_01_165: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
+                    uws_client->frame_header_length = 4;
+                    uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_EXTENDED_LENGTH_16;
+                }
+                else if (uws_client->frame_payload_length == 127)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_166: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
+                    uws_client->frame_header_length = 10;
+                    uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_EXTENDED_LENGTH_64;
                 }
                 else
                 {
-                    uws_client->received_bytes = new_received_bytes;
-                    (void)memcpy(uws_client->received_bytes + uws_client->received_bytes_count, buffer, size);
-                    uws_client->received_bytes_count += size;
-
-                    decode_stream = 1;
+                    uws_client->frame_header_length = 2;
+                    uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_PAYLOAD_BYTES;
                 }
-
-                break;
             }
+            break;
 
-            case UWS_STATE_OPEN:
-            case UWS_STATE_CLOSING_WAITING_FOR_CLOSE:
+        case UWS_FRAME_DECODER_STATE_EXTENDED_LENGTH_16:
+            if (bytes_count < 4)
             {
-                /* Codes_SRS_UWS_CLIENT_01_385: [ If the state of the uws instance is OPEN, the received bytes shall be used for decoding WebSocket frames. ]*/
-                unsigned char* new_received_bytes = (unsigned char*)realloc(uws_client->received_bytes, uws_client->received_bytes_count + size + 1);
-                if (new_received_bytes == NULL)
+                need_more_bytes = true;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
+                uws_client->frame_payload_length = ((uint64_t)(bytes[2]) << 8) + bytes[3];
+
+                if (uws_client->frame_payload_length < 126)
                 {
-                    /* Codes_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
-                    LogError("Cannot allocate memory for received data");
-                    indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
+                    /* Codes_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+                    LogError("Bad frame: received a %u length on the 16 bit length", (unsigned int)uws_client->frame_payload_length);
 
-                    decode_stream = 0;
+                    /* Codes_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+                    uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+                    indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+                    need_more_bytes = true;
                 }
                 else
                 {
-                    uws_client->received_bytes = new_received_bytes;
-                    (void)memcpy(uws_client->received_bytes + uws_client->received_bytes_count, buffer, size);
-                    uws_client->received_bytes_count += size;
-                
-                    decode_stream = 1;
+                    uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_PAYLOAD_BYTES;
                 }
+            }
+            break;
 
-                break;
+        case UWS_FRAME_DECODER_STATE_EXTENDED_LENGTH_64:
+            if (bytes_count < 10)
+            {
+                need_more_bytes = true;
+            }
+            else if ((bytes[2] & 0x80) != 0)
+            {
+                LogError("Bad frame: received a 64 bit length frame with the highest bit set");
+
+                /* Codes_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+                uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+                indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+                need_more_bytes = true;
             }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
+                uws_client->frame_payload_length = ((uint64_t)(bytes[2]) << 56) +
+                    (((uint64_t)bytes[3]) << 48) +
+                    (((uint64_t)bytes[4]) << 40) +
+                    (((uint64_t)bytes[5]) << 32) +
+                    (((uint64_t)bytes[6]) << 24) +
+                    (((uint64_t)bytes[7]) << 16) +
+                    (((uint64_t)bytes[8]) << 8) +
+                    (uint64_t)(bytes[9]);
+
+                if (uws_client->frame_payload_length < 65536)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+                    LogError("Bad frame: received a %u length on the 64 bit length", (unsigned int)uws_client->frame_payload_length);
+
+                    /* Codes_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+                    uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+                    indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+                    need_more_bytes = true;
+                }
+                else if (uws_client->frame_payload_length > (uint64_t)(SIZE_MAX - 10))
+                {
+                    LogError("Bad frame: payload length does not fit in memory");
+                    uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+                    indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+                    need_more_bytes = true;
+                }
+                else
+                {
+                    uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_PAYLOAD_BYTES;
+                }
             }
+            break;
+
+        case UWS_FRAME_DECODER_STATE_PAYLOAD_BYTES:
+        {
+            size_t frame_length = uws_client->frame_header_length + (size_t)uws_client->frame_payload_length;
 
-            while (decode_stream)
+            if ((uws_client->on_ws_fragment_received != NULL) &&
+                (((bytes[0] & 0x0F) == (unsigned char)WS_TEXT_FRAME) ||
+                ((bytes[0] & 0x0F) == (unsigned char)WS_BINARY_FRAME) ||
+                ((bytes[0] & 0x0F) == (unsigned char)WS_CONTINUATION_FRAME)))
             {
-                decode_stream = 0;
+                size_t available_payload_bytes = bytes_count - uws_client->frame_header_length;
 
-                switch (uws_client->uws_state)
+                if ((available_payload_bytes == 0) &&
+                    (uws_client->frame_payload_length > 0))
+                {
+                    need_more_bytes = true;
+                }
+                else
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_588: [ When a fragment callback is set, the payload of a received text, binary or continuation frame shall be indicated as soon as its bytes are received, without waiting for the complete frame. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_589: [ The header and the payload bytes indicated shall be consumed, so that no more than a frame header is ever buffered for such frames. ]*/
+                    size_t chunk_length = (available_payload_bytes < uws_client->frame_payload_length) ? available_payload_bytes : (size_t)uws_client->frame_payload_length;
+
+                    uws_client->streamed_frame_first_byte = bytes[0];
+                    uws_client->streamed_frame_remaining_length = uws_client->frame_payload_length - chunk_length;
+                    uws_client->is_streamed_frame_started = false;
+                    uws_client->frame_decoder_state = (uws_client->streamed_frame_remaining_length == 0) ? UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH : UWS_FRAME_DECODER_STATE_STREAMED_PAYLOAD_BYTES;
+                    process_streamed_payload(uws_client, bytes + uws_client->frame_header_length, chunk_length, uws_client->streamed_frame_remaining_length == 0);
+                    frame_complete = true;
+                    result = uws_client->frame_header_length + chunk_length;
+                }
+            }
+            else if (bytes_count < frame_length)
+            {
+                need_more_bytes = true;
+            }
+            else
+            {
+                uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+                if (((bytes[0] & 0x40) != 0) ||
+                    (((bytes[0] & 0x0F) == (unsigned char)WS_CONTINUATION_FRAME) && uws_client->is_receiving_compressed_message))
+                {
+                    process_compressed_frame(uws_client, bytes[0] & 0xF, (bytes[0] & 0x80) != 0, bytes + uws_client->frame_header_length, (size_t)uws_client->frame_payload_length);
+                }
+                else
                 {
-                default:
-                case UWS_STATE_CLOSED:
-                    break;
+                    process_frame(uws_client, bytes[0] & 0xF, bytes + uws_client->frame_header_length, (size_t)uws_client->frame_payload_length);
+                }
+                frame_complete = true;
+                result = frame_length;
+            }
+            break;
+        }
 
-                case UWS_STATE_OPENING_UNDERLYING_IO:
-                    /* Codes_SRS_UWS_CLIENT_01_417: [ When `on_underlying_io_bytes_received` is called while OPENING but before the `on_underlying_io_open_complete` has been called, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN`. ]*/
-                    indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN);
-                    break;
+        case UWS_FRAME_DECODER_STATE_STREAMED_PAYLOAD_BYTES:
+            if (bytes_count == 0)
+            {
+                need_more_bytes = true;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_588: [ When a fragment callback is set, the payload of a received text, binary or continuation frame shall be indicated as soon as its bytes are received, without waiting for the complete frame. ]*/
+                size_t chunk_length = (bytes_count < uws_client->streamed_frame_remaining_length) ? bytes_count : (size_t)uws_client->streamed_frame_remaining_length;
 
-                case UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE:
+                uws_client->streamed_frame_remaining_length -= chunk_length;
+                if (uws_client->streamed_frame_remaining_length == 0)
                 {
-                    const char* request_end_ptr;
+                    uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+                }
 
-                    /* Make sure it is zero terminated */
-                    uws_client->received_bytes[uws_client->received_bytes_count] = '\0';
+                process_streamed_payload(uws_client, bytes, chunk_length, uws_client->streamed_frame_remaining_length == 0);
+                frame_complete = true;
+                result = chunk_length;
+            }
+            break;
+        }
+    }
 
-                    /* Codes_SRS_UWS_CLIENT_01_380: [ If an WebSocket Upgrade request can be parsed from the accumulated bytes, the status shall be read from the WebSocket upgrade response. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
-                    if ((uws_client->received_bytes_count >= 4) &&
-                        ((request_end_ptr = strstr((const char*)uws_client->received_bytes, "\r\n\r\n")) != NULL))
-                    {
-                        int status_code;
+    return result;
+}
 
-                        /* This part should really be done with the HTTPAPI, but that has to be done as a separate step
-                        as the HTTPAPI has to expose somehow the underlying IO and currently this would be a too big of a change. */
+/* Decodes as many complete frames as are available in bytes, in place, and returns how many bytes were consumed. */
+static size_t decode_frames(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* bytes, size_t bytes_count)
+{
+    size_t consumed_bytes = 0;
 
-                        /* Codes_SRS_UWS_CLIENT_01_382: [ If a negative status is decoded from the WebSocket upgrade request, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_RESPONSE_STATUS`. ]*/
-                        /* Codes_SRS_UWS_CLIENT_01_478: [ A Status-Line with a 101 response code as per RFC 2616 [RFC2616]. ]*/
-                        if (ParseHttpResponse((const char*)uws_client->received_bytes, &status_code) != 0)
-                        {
-                            /* Codes_SRS_UWS_CLIENT_01_383: [ If the WebSocket upgrade request cannot be decoded an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
-                            LogError("Cannot decode HTTP response");
-                            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE);
-                        }
-                        else if (status_code != 101)
-                        {
-                            /* Codes_SRS_UWS_CLIENT_01_382: [ If a negative status is decoded from the WebSocket upgrade request, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_RESPONSE_STATUS`. ]*/
-                            LogError("Bad status (%d) received in WebSocket Upgrade response", status_code);
-                            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_RESPONSE_STATUS);
-                        }
-                        else
-                        {
-                            /* Codes_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
-                            consume_received_bytes(uws_client, request_end_ptr - (char*)uws_client->received_bytes + 4);
+    while ((uws_client->uws_state == UWS_STATE_OPEN) ||
+        (uws_client->uws_state == UWS_STATE_CLOSING_WAITING_FOR_CLOSE))
+    {
+        size_t frame_length = decode_frame(uws_client, bytes + consumed_bytes, bytes_count - consumed_bytes);
+        if (frame_length == 0)
+        {
+            break;
+        }
 
-                            /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
-                            uws_client->uws_state = UWS_STATE_OPEN;
+        consumed_bytes += frame_length;
+    }
 
-                            /* Codes_SRS_UWS_CLIENT_01_065: [ When the client is to _Establish a WebSocket Connection_ given a set of (/host/, /port/, /resource name/, and /secure/ flag), along with a list of /protocols/ and /extensions/ to be used, and an /origin/ in the case of web browsers, it MUST open a connection, send an opening handshake, and read the server's handshake in response. ]*/
-                            /* Codes_SRS_UWS_CLIENT_01_115: [ If the server's response is validated as provided for above, it is said that _The WebSocket Connection is Established_ and that the WebSocket Connection is in the OPEN state. ]*/
-                            uws_client->on_ws_open_complete(uws_client->on_ws_open_complete_context, WS_OPEN_OK);
+    return consumed_bytes;
+}
 
-                            decode_stream = 1;
-                        }
-                    }
+/* Applies the extensions accepted in the upgrade response. Returns WS_OPEN_OK or the error to report. */
+static WS_OPEN_RESULT negotiate_extensions(UWS_CLIENT_INSTANCE* uws_client)
+{
+    WS_OPEN_RESULT result;
 
-                    break;
-                }
+    if (uws_client->permessage_deflate_options == NULL)
+    {
+        result = WS_OPEN_OK;
+    }
+    else
+    {
+        const char* extensions = NULL;
+        size_t extensions_length = 0;
+        WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+        bool is_accepted = false;
+
+        /* Codes_SRS_UWS_CLIENT_01_545: [ If permessage-deflate was offered, the `Sec-WebSocket-Extensions` header of the upgrade response (compared case insensitive, an absent header meaning no extensions were accepted) shall be parsed by calling `uws_deflate_parse_response`. ]*/
+        (void)http_response_parser_get_header(&uws_client->upgrade_response_parser, uws_client->received_bytes, SEC_WEBSOCKET_EXTENSIONS_HEADER, &extensions, &extensions_length);
+        if (uws_deflate_parse_response(uws_client->permessage_deflate_options, extensions, extensions_length, &negotiated_options, &is_accepted) != 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_546: [ If `uws_deflate_parse_response` fails, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+            LogError("Bad Sec-WebSocket-Extensions in the WebSocket upgrade response");
+            result = WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE;
+        }
+        else if (!is_accepted)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_547: [ If the server did not accept permessage-deflate, frames shall be exchanged uncompressed. ]*/
+            result = WS_OPEN_OK;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_CLIENT_01_548: [ If the server accepted permessage-deflate, a compression context shall be created by calling `uws_deflate_create` with the negotiated options. ]*/
+            uws_client->uws_deflate = uws_deflate_create(&negotiated_options);
+            if (uws_client->uws_deflate == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_549: [ If `uws_deflate_create` fails, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+                LogError("Cannot create the permessage-deflate context");
+                result = WS_OPEN_ERROR_NOT_ENOUGH_MEMORY;
+            }
+            else
+            {
+                result = WS_OPEN_OK;
+            }
+        }
+    }
 
-                case UWS_STATE_OPEN:
-                case UWS_STATE_CLOSING_WAITING_FOR_CLOSE:
-                {
-                    size_t needed_bytes = 2;
-                    size_t length;
+    return result;
+}
 
-                    /* Codes_SRS_UWS_CLIENT_01_277: [ To receive WebSocket data, an endpoint listens on the underlying network connection. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_278: [ Incoming data MUST be parsed as WebSocket frames as defined in Section 5.2. ]*/
-                    if (uws_client->received_bytes_count >= needed_bytes)
-                    {
-                        unsigned char has_error = 0;
+static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    /* Codes_SRS_UWS_CLIENT_01_415: [ If called with a NULL `context` argument, `on_underlying_io_bytes_received` shall do nothing. ]*/
+    if (context != NULL)
+    {
+        UWS_CLIENT_HANDLE uws_client = (UWS_CLIENT_HANDLE)context;
 
-                        /* Codes_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
-                        if ((uws_client->received_bytes[1] & 0x80) != 0)
-                        {
-                            /* Codes_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
-                            /* Codes_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
-                            LogError("Masked frame detected by WebSocket client");
-                            indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, 1002);
-                        }
+        if ((buffer == NULL) ||
+            (size == 0))
+        {
+            /* Codes_SRS_UWS_CLIENT_01_416: [ If called with NULL `buffer` or zero `size` and the state of the iws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS`. ]*/
+            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS);
+        }
+        else
+        {
+            switch (uws_client->uws_state)
+            {
+            default:
+            case UWS_STATE_CLOSED:
+                break;
 
-                        /* Codes_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
-                        /* Codes_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
-                        length = uws_client->received_bytes[1];
+            case UWS_STATE_OPENING_UNDERLYING_IO:
+                /* Codes_SRS_UWS_CLIENT_01_417: [ When `on_underlying_io_bytes_received` is called while OPENING but before the `on_underlying_io_open_complete` has been called, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN`. ]*/
+                indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN);
+                break;
 
-                        if (length == 126)
-                        {
-                            /* Codes_SRS_UWS_CLIENT_01_165: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
-                            needed_bytes += 2;
-                            if (uws_client->received_bytes_count >= needed_bytes)
-                            {
-                                /* Codes_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-                                length = ((uint64_t)(uws_client->received_bytes[2]) << 8) + uws_client->received_bytes[3];
+            case UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE:
+            {
+                /* Codes_SRS_UWS_CLIENT_01_378: [ When `on_underlying_io_bytes_received` is called while the uws is OPENING, the received bytes shall be accumulated in order to attempt parsing the WebSocket Upgrade response. ]*/
+                unsigned char* new_received_bytes = (unsigned char*)realloc(uws_client->received_bytes, uws_client->received_bytes_count + size);
+                if (new_received_bytes == NULL)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+                    indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY);
+                }
+                else
+                {
+                    HTTP_RESPONSE_PARSER_RESULT parse_result;
 
-                                if (length < 126)
-                                {
-                                    /* Codes_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-                                    LogError("Bad frame: received a %u length on the 16 bit length", (unsigned int)length);
+                    uws_client->received_bytes = new_received_bytes;
+                    uws_client->received_bytes_size = uws_client->received_bytes_count + size;
+                    (void)memcpy(uws_client->received_bytes + uws_client->received_bytes_count, buffer, size);
+                    uws_client->received_bytes_count += size;
 
-                                    /* Codes_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-                                    indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
-                                    has_error = 1;
-                                }
-                                else
-                                {
-                                    needed_bytes += (size_t)length;
-                                }
-                            }
-                        }
-                        else if (length == 127)
-                        {
-                            /* Codes_SRS_UWS_CLIENT_01_166: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
-                            needed_bytes += 8;
-                            if (uws_client->received_bytes_count >= needed_bytes)
-                            {
-                                if ((uws_client->received_bytes[2] & 0x80) != 0)
-                                {
-                                    LogError("Bad frame: received a 64 bit length frame with the highest bit set");
+                    /* This part should really be done with the HTTPAPI, but that has to be done as a separate step
+                    as the HTTPAPI has to expose somehow the underlying IO and currently this would be a too big of a change. */
 
-                                    /* Codes_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-                                    indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
-                                    has_error = 1;
-                                }
-                                else
-                                {
-                                    /* Codes_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-                                    length = (size_t)(((uint64_t)(uws_client->received_bytes[2]) << 56) +
-                                        (((uint64_t)uws_client->received_bytes[3]) << 48) +
-                                        (((uint64_t)uws_client->received_bytes[4]) << 40) +
-                                        (((uint64_t)uws_client->received_bytes[5]) << 32) +
-                                        (((uint64_t)uws_client->received_bytes[6]) << 24) +
-                                        (((uint64_t)uws_client->received_bytes[7]) << 16) +
-                                        (((uint64_t)uws_client->received_bytes[8]) << 8) +
-                                        (uint64_t)(uws_client->received_bytes[9]));
-
-                                    if (length < 65536)
-                                    {
-                                        /* Codes_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-                                        LogError("Bad frame: received a %u length on the 64 bit length", (unsigned int)length);
+                    /* Codes_SRS_UWS_CLIENT_01_380: [ If an WebSocket Upgrade request can be parsed from the accumulated bytes, the status shall be read from the WebSocket upgrade response. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_593: [ The accumulated bytes shall be parsed by calling `http_response_parser_parse`, so that only the bytes received since the previous call are scanned for the end of the response head. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_478: [ A Status-Line with a 101 response code as per RFC 2616 [RFC2616]. ]*/
+                    parse_result = http_response_parser_parse(&uws_client->upgrade_response_parser, uws_client->received_bytes, uws_client->received_bytes_count);
+                    if (parse_result == HTTP_RESPONSE_PARSER_ERROR)
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_383: [ If the WebSocket upgrade request cannot be decoded an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+                        LogError("Cannot decode HTTP response");
+                        indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE);
+                    }
+                    else if (parse_result == HTTP_RESPONSE_PARSER_COMPLETE)
+                    {
+                        WS_OPEN_RESULT negotiate_result;
 
-                                        /* Codes_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-                                        indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
-                                        has_error = 1;
-                                    }
-                                    else
-                                    {
-                                        needed_bytes += length;
-                                    }
-                                }
-                            }
+                        /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
+                        if (uws_client->upgrade_response_parser.status_code != 101)
+                        {
+                            /* Codes_SRS_UWS_CLIENT_01_382: [ If a negative status is decoded from the WebSocket upgrade request, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_RESPONSE_STATUS`. ]*/
+                            LogError("Bad status (%d) received in WebSocket Upgrade response", uws_client->upgrade_response_parser.status_code);
+                            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_RESPONSE_STATUS);
                         }
-                        else
+                        else if ((negotiate_result = negotiate_extensions(uws_client)) != WS_OPEN_OK)
                         {
-                            needed_bytes += length;
+                            indicate_ws_open_complete_error_and_close(uws_client, negotiate_result);
                         }
-
-                        if ((has_error == 0) &&
-                            (uws_client->received_bytes_count >= needed_bytes))
+                        else
                         {
-                            unsigned char opcode = uws_client->received_bytes[0] & 0xF;
-
-                            switch (opcode)
-                            {
-                            default:
-                                break;
-
-                                /* Codes_SRS_UWS_CLIENT_01_153: [ *  %x1 denotes a text frame ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_258: [** Currently defined opcodes for data frames include 0x1 (Text), 0x2 (Binary). ]*/
-                            case (unsigned char)WS_TEXT_FRAME:
-                                /* Codes_SRS_UWS_CLIENT_01_386: [ When a WebSocket data frame is decoded succesfully it shall be indicated via the callback `on_ws_frame_received`. ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_169: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_173: [ The "Payload data" is defined as "Extension data" concatenated with "Application data". ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
-                                uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_TEXT, uws_client->received_bytes + needed_bytes - length, length);
-                                decode_stream = 1;
-                                break;
-
-                                /* Codes_SRS_UWS_CLIENT_01_154: [ *  %x2 denotes a binary frame ]*/
-                            case (unsigned char)WS_BINARY_FRAME:
-                                /* Codes_SRS_UWS_CLIENT_01_386: [ When a WebSocket data frame is decoded succesfully it shall be indicated via the callback `on_ws_frame_received`. ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_169: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_173: [ The "Payload data" is defined as "Extension data" concatenated with "Application data". ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_264: [ The "Payload data" is arbitrary binary data whose interpretation is solely up to the application layer. ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
-                                uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_BINARY, uws_client->received_bytes + needed_bytes - length, length);
-                                decode_stream = 1;
-                                break;
-
-                                /* Codes_SRS_UWS_CLIENT_01_156: [ *  %x8 denotes a connection close ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_234: [ The Close frame contains an opcode of 0x8. ]*/
-                            case (unsigned char)WS_CLOSE_FRAME:
-                            {
-                                uint16_t close_code;
-                                uint16_t* close_code_ptr;
-                                const unsigned char* data_ptr = uws_client->received_bytes + needed_bytes - length;
-                                const unsigned char* extra_data_ptr;
-                                size_t extra_data_length;
-                                unsigned char* close_frame_bytes;
-                                size_t close_frame_length;
-                                bool utf8_error = false;
-
-                                /* Codes_SRS_UWS_CLIENT_01_235: [ The Close frame MAY contain a body (the "Application data" portion of the frame) that indicates a reason for closing, such as an endpoint shutting down, an endpoint having received a frame too large, or an endpoint having received a frame that does not conform to the format expected by the endpoint. ]*/
-                                if (length >= 2)
-                                {
-                                    /* Codes_SRS_UWS_CLIENT_01_236: [ If there is a body, the first two bytes of the body MUST be a 2-byte unsigned integer (in network byte order) representing a status code with value /code/ defined in Section 7.4. ]*/
-                                    close_code = (data_ptr[0] << 8) + data_ptr[1];
-
-                                    /* Codes_SRS_UWS_CLIENT_01_461: [ The argument `close_code` shall be set to point to the code extracted from the CLOSE frame. ]*/
-                                    close_code_ptr = &close_code;
-                                }
-                                else
-                                {
-                                    /* Codes_SRS_UWS_CLIENT_01_462: [ If no code can be extracted then `close_code` shall be NULL. ]*/
-                                    close_code_ptr = NULL;
-                                }
-
-                                if (length > 2)
-                                {
-                                    /* Codes_SRS_UWS_CLIENT_01_463: [ The extra bytes (besides the close code) shall be passed to the `on_ws_peer_closed` callback by using `extra_data` and `extra_data_length`. ]*/
-                                    extra_data_ptr = data_ptr + 2;
-                                    extra_data_length = length - 2;
-
-                                    /* Codes_SRS_UWS_CLIENT_01_238: [ As the data is not guaranteed to be human readable, clients MUST NOT show it to end users. ]*/
-                                    /* Codes_SRS_UWS_CLIENT_01_237: [ Following the 2-byte integer, the body MAY contain UTF-8-encoded data with value /reason/, the interpretation of which is not defined by this specification. ]*/
-                                    if (utf8_checker_is_valid_utf8(extra_data_ptr, extra_data_length) != true)
-                                    {
-                                        LogError("Reason in CLOSE frame is not UTF-8.");
-                                        extra_data_ptr = NULL;
-                                        extra_data_length = 0;
-                                        utf8_error = true;
-                                    }
-                                }
-                                else
-                                {
-                                    extra_data_ptr = NULL;
-                                    extra_data_length = 0;
-                                }
-
-                                if (utf8_error)
-                                {
-                                    uws_client->uws_state = UWS_STATE_CLOSING_UNDERLYING_IO;
-                                    if (xio_close(uws_client->underlying_io, on_underlying_io_close_complete, uws_client) != 0)
-                                    {
-                                        LogError("Could not close underlying IO");
-                                        indicate_ws_error(uws_client, WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO);
-                                        uws_client->uws_state = UWS_STATE_CLOSED;
-                                    }
-                                }
-                                else
-                                {
-                                    BUFFER_HANDLE close_frame_buffer;
-
-                                    if (uws_client->uws_state == UWS_STATE_CLOSING_WAITING_FOR_CLOSE)
-                                    {
-                                        uws_client->uws_state = UWS_STATE_CLOSING_UNDERLYING_IO;
-                                        if (xio_close(uws_client->underlying_io, on_underlying_io_close_complete, uws_client) != 0)
-                                        {
-                                            indicate_ws_close_complete(uws_client);
-                                            uws_client->uws_state = UWS_STATE_CLOSED;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        /* Codes_SRS_UWS_CLIENT_01_296: [ Upon either sending or receiving a Close control frame, it is said that _The WebSocket Closing Handshake is Started_ and that the WebSocket connection is in the CLOSING state. ]*/
-                                        /* Codes_SRS_UWS_CLIENT_01_240: [ The application MUST NOT send any more data frames after sending a Close frame. ]*/
-                                        uws_client->uws_state = UWS_STATE_CLOSING_SENDING_CLOSE;
-                                    }
-
-                                    /* Codes_SRS_UWS_CLIENT_01_241: [ If an endpoint receives a Close frame and did not previously send a Close frame, the endpoint MUST send a Close frame in response. ]*/
-                                    /* Codes_SRS_UWS_CLIENT_01_242: [ It SHOULD do so as soon as practical. ]*/
-                                    /* Codes_SRS_UWS_CLIENT_01_239: [ Close frames sent from client to server must be masked as per Section 5.3. ]*/
-                                    /* Codes_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-                                    close_frame_buffer = uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0);
-                                    if (close_frame_buffer == NULL)
-                                    {
-                                        LogError("Cannot encode the response CLOSE frame");
-
-                                        /* Codes_SRS_UWS_CLIENT_01_288: [ To _Close the WebSocket Connection_, an endpoint closes the underlying TCP connection. ]*/
-                                        /* Codes_SRS_UWS_CLIENT_01_290: [ An endpoint MAY close the connection via any means available when necessary, such as when under attack. ]*/
-                                        uws_client->uws_state = UWS_STATE_CLOSING_UNDERLYING_IO;
-                                        if (xio_close(uws_client->underlying_io, on_underlying_io_close_complete, uws_client) != 0)
-                                        {
-                                            indicate_ws_error(uws_client, WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO);
-                                            uws_client->uws_state = UWS_STATE_CLOSED;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        close_frame_bytes = BUFFER_u_char(close_frame_buffer);
-                                        close_frame_length = BUFFER_length(close_frame_buffer);
-                                        if (xio_send(uws_client->underlying_io, close_frame_bytes, close_frame_length, on_underlying_io_close_sent, uws_client) != 0)
-                                        {
-                                            LogError("Cannot send the response CLOSE frame");
-
-                                            /* Codes_SRS_UWS_CLIENT_01_288: [ To _Close the WebSocket Connection_, an endpoint closes the underlying TCP connection. ]*/
-                                            /* Codes_SRS_UWS_CLIENT_01_290: [ An endpoint MAY close the connection via any means available when necessary, such as when under attack. ]*/
-                                            uws_client->uws_state = UWS_STATE_CLOSING_UNDERLYING_IO;
-                                            if (xio_close(uws_client->underlying_io, on_underlying_io_close_complete, uws_client) != 0)
-                                            {
-                                                indicate_ws_error(uws_client, WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO);
-                                                uws_client->uws_state = UWS_STATE_CLOSED;
-                                            }
-                                        }
-
-                                        BUFFER_delete(close_frame_buffer);
-                                    }
-                                }
-
-                                /* Codes_SRS_UWS_CLIENT_01_460: [ When a CLOSE frame is received the callback `on_ws_peer_closed` passed to `uws_client_open_async` shall be called, while passing to it the argument `on_ws_peer_closed_context`. ]*/
-                                uws_client->on_ws_peer_closed(uws_client->on_ws_peer_closed_context, close_code_ptr, extra_data_ptr, extra_data_length);
-
-                                break;
-                            }
+                            /* Codes_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
+                            consume_received_bytes(uws_client, uws_client->upgrade_response_parser.head_length);
 
-                                /* Codes_SRS_UWS_CLIENT_01_157: [ *  %x9 denotes a ping ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_247: [ The Ping frame contains an opcode of 0x9. ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
-                            case (unsigned char)WS_PING_FRAME:
-                            {
-                                /* Codes_SRS_UWS_CLIENT_01_249: [ Upon receipt of a Ping frame, an endpoint MUST send a Pong frame in response ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_250: [ It SHOULD respond with Pong frame as soon as is practical. ]*/
-                                unsigned char* pong_frame;
-                                size_t pong_frame_length;
-                                BUFFER_HANDLE pong_frame_buffer;
+                            /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
+                            uws_client->uws_state = UWS_STATE_OPEN;
 
-                                uws_client->uws_state = UWS_STATE_ERROR;
+                            /* Codes_SRS_UWS_CLIENT_01_065: [ When the client is to _Establish a WebSocket Connection_ given a set of (/host/, /port/, /resource name/, and /secure/ flag), along with a list of /protocols/ and /extensions/ to be used, and an /origin/ in the case of web browsers, it MUST open a connection, send an opening handshake, and read the server's handshake in response. ]*/
+                            /* Codes_SRS_UWS_CLIENT_01_115: [ If the server's response is validated as provided for above, it is said that _The WebSocket Connection is Established_ and that the WebSocket Connection is in the OPEN state. ]*/
+                            uws_client->on_ws_open_complete(uws_client->on_ws_open_complete_context, WS_OPEN_OK);
 
-                                /* Codes_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-                                pong_frame_buffer = uws_frame_encoder_encode(WS_PONG_FRAME, uws_client->received_bytes + needed_bytes - length, length, true, true, 0);
-                                if (pong_frame_buffer == NULL)
-                                {
-                                    LogError("Encoding of PONG failed.");
-                                }
-                                else
-                                {
-                                    /* Codes_SRS_UWS_CLIENT_01_248: [ A Ping frame MAY include "Application data". ]*/
-                                    pong_frame = BUFFER_u_char(pong_frame_buffer);
-                                    pong_frame_length = BUFFER_length(pong_frame_buffer);
-                                    if (xio_send(uws_client->underlying_io, pong_frame, pong_frame_length, unchecked_on_send_complete, NULL) != 0)
-                                    {
-                                        LogError("Sending CLOSE frame failed.");
-                                    }
+                            consume_received_bytes(uws_client, decode_frames(uws_client, uws_client->received_bytes, uws_client->received_bytes_count));
+                        }
+                    }
+                }
 
-                                    BUFFER_delete(pong_frame_buffer);
-                                }
+                break;
+            }
 
-                                break;
-                            }
-                            /* Codes_SRS_UWS_CLIENT_01_252: [ The Pong frame contains an opcode of 0xA. ]*/
-                            case (unsigned char)WS_PONG_FRAME:
-                                break;
-                            }
+            case UWS_STATE_OPEN:
+            case UWS_STATE_CLOSING_WAITING_FOR_CLOSE:
+                /* Codes_SRS_UWS_CLIENT_01_385: [ If the state of the uws instance is OPEN, the received bytes shall be used for decoding WebSocket frames. ]*/
+                if (uws_client->received_bytes_count == 0)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_538: [ If no bytes are pending from previous calls, the WebSocket frames shall be decoded directly from `buffer`, without copying it. ]*/
+                    size_t consumed_bytes = decode_frames(uws_client, buffer, size);
 
-                            consume_received_bytes(uws_client, needed_bytes);
+                    if ((consumed_bytes < size) &&
+                        ((uws_client->uws_state == UWS_STATE_OPEN) || (uws_client->uws_state == UWS_STATE_CLOSING_WAITING_FOR_CLOSE)))
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_539: [ Only the bytes of an incomplete frame left at the end of `buffer` shall be accumulated for decoding with the bytes received in subsequent calls. ]*/
+                        if (append_received_bytes(uws_client, buffer + consumed_bytes, size - consumed_bytes) != 0)
+                        {
+                            /* Codes_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+                            LogError("Cannot allocate memory for received data");
+                            indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
                         }
                     }
-
-                    break;
                 }
+                else
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_539: [ Only the bytes of an incomplete frame left at the end of `buffer` shall be accumulated for decoding with the bytes received in subsequent calls. ]*/
+                    if (append_received_bytes(uws_client, buffer, size) != 0)
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+                        LogError("Cannot allocate memory for received data");
+                        indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
+                    }
+                    else
+                    {
+                        /* The remainder is moved to the start of the buffer once per call, not once per decoded frame */
+                        consume_received_bytes(uws_client, decode_frames(uws_client, uws_client->received_bytes, uws_client->received_bytes_count));
+                    }
                 }
+
+                break;
             }
         }
     }
@@ -1460,6 +1821,18 @@ int uws_client_open_async(UWS_CLIENT_HANDLE uws_client, ON_WS_OPEN_COMPLETE on_w
             uws_client->uws_state = UWS_STATE_OPENING_UNDERLYING_IO;
 
             uws_client->received_bytes_count = 0;
+            http_response_parser_init(&uws_client->upgrade_response_parser);
+            uws_client->frame_decoder_state = UWS_FRAME_DECODER_STATE_HEADER_AND_LENGTH;
+
+            if (uws_client->uws_deflate != NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_554: [ `uws_client_open_async` shall free the permessage-deflate context of a previous connection by calling `uws_deflate_destroy`, as the extension is negotiated again for each connection. ]*/
+                uws_deflate_destroy(uws_client->uws_deflate);
+                uws_client->uws_deflate = NULL;
+            }
+
+            uws_client->is_receiving_compressed_message = false;
+            uws_client->is_receiving_fragmented_message = false;
 
             uws_client->on_ws_open_complete = on_ws_open_complete;
             uws_client->on_ws_open_complete_context = on_ws_open_complete_context;
@@ -1553,6 +1926,8 @@ int uws_client_close_async(UWS_CLIENT_HANDLE uws_client, ON_WS_CLOSE_COMPLETE on
 
             uws_client->uws_state = UWS_STATE_CLOSING_UNDERLYING_IO;
 
+            flush_coalesced_frames(uws_client);
+
             /* Codes_SRS_UWS_CLIENT_01_031: [ `uws_client_close_async` shall close the connection by calling `xio_close` while passing as argument the IO handle created in `uws_client_create`. ]*/
             /* Codes_SRS_UWS_CLIENT_01_368: [ The callback `on_underlying_io_close` shall be passed as argument to `xio_close`. ]*/
             if (xio_close(uws_client->underlying_io, (on_ws_close_complete == NULL) ? NULL :  on_underlying_io_close_complete, (on_ws_close_complete == NULL) ? NULL : uws_client) != 0)
@@ -1575,6 +1950,9 @@ int uws_client_close_async(UWS_CLIENT_HANDLE uws_client, ON_WS_CLOSE_COMPLETE on
                     complete_send_frame(ws_pending_send, first_pending_send, WS_SEND_FRAME_CANCELLED);
                 }
 
+                /* Codes_SRS_UWS_CLIENT_01_577: [ Coalesced frames that were not yet sent shall be discarded. ]*/
+                discard_coalesced_frames(uws_client);
+
                 /* Codes_SRS_UWS_CLIENT_01_396: [ On success `uws_client_close_async` shall return 0. ]*/
                 result = 0;
             }
@@ -1637,6 +2015,9 @@ int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t clos
                     complete_send_frame(ws_pending_send, first_pending_send, WS_SEND_FRAME_CANCELLED);
                 }
 
+                /* Codes_SRS_UWS_CLIENT_01_577: [ Coalesced frames that were not yet sent shall be discarded. ]*/
+                discard_coalesced_frames(uws_client);
+
                 /* Codes_SRS_UWS_CLIENT_01_466: [ On success `uws_client_close_handshake_async` shall return 0. ]*/
                 result = 0;
             }
@@ -1646,6 +2027,33 @@ int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t clos
     return result;
 }
 
+static WS_SEND_FRAME_RESULT get_ws_send_frame_result(IO_SEND_RESULT send_result)
+{
+    WS_SEND_FRAME_RESULT result;
+
+    switch (send_result)
+    {
+    /* Codes_SRS_UWS_CLIENT_01_436: [ When `on_underlying_io_send_complete` is called with any other error code, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
+    default:
+    case IO_SEND_ERROR:
+        /* Codes_SRS_UWS_CLIENT_01_390: [ When `on_underlying_io_send_complete` is called with `IO_SEND_ERROR` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
+        result = WS_SEND_FRAME_ERROR;
+        break;
+
+    case IO_SEND_OK:
+        /* Codes_SRS_UWS_CLIENT_01_389: [ When `on_underlying_io_send_complete` is called with `IO_SEND_OK` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_OK`. ]*/
+        result = WS_SEND_FRAME_OK;
+        break;
+
+    case IO_SEND_CANCELLED:
+        /* Codes_SRS_UWS_CLIENT_01_391: [ When `on_underlying_io_send_complete` is called with `IO_SEND_CANCELLED` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_CANCELLED`. ]*/
+        result = WS_SEND_FRAME_CANCELLED;
+        break;
+    }
+
+    return result;
+}
+
 static void on_underlying_io_send_complete(void* context, IO_SEND_RESULT send_result)
 {
     if (context == NULL)
@@ -1658,39 +2066,268 @@ static void on_underlying_io_send_complete(void* context, IO_SEND_RESULT send_re
         LIST_ITEM_HANDLE ws_pending_send_list_item = (LIST_ITEM_HANDLE)context;
         WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(ws_pending_send_list_item);
         UWS_CLIENT_HANDLE uws_client = ws_pending_send->uws_client;
-        WS_SEND_FRAME_RESULT ws_send_frame_result;
+        WS_SEND_FRAME_RESULT ws_send_frame_result = get_ws_send_frame_result(send_result);
 
-        switch (send_result)
+        if (complete_send_frame(ws_pending_send, ws_pending_send_list_item, ws_send_frame_result) != 0)
         {
-        /* Codes_SRS_UWS_CLIENT_01_436: [ When `on_underlying_io_send_complete` is called with any other error code, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
-        default:
-        case IO_SEND_ERROR:
-            /* Codes_SRS_UWS_CLIENT_01_390: [ When `on_underlying_io_send_complete` is called with `IO_SEND_ERROR` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
-            ws_send_frame_result = WS_SEND_FRAME_ERROR;
-            break;
+            /* Codes_SRS_UWS_CLIENT_01_433: [ If `singlylinkedlist_remove` fails an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST`. ]*/
+            indicate_ws_error(uws_client, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST);
+        }
+    }
+}
 
-        case IO_SEND_OK:
-            /* Codes_SRS_UWS_CLIENT_01_389: [ When `on_underlying_io_send_complete` is called with `IO_SEND_OK` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_OK`. ]*/
-            ws_send_frame_result = WS_SEND_FRAME_OK;
-            break;
+static bool find_list_node(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    return list_item == (LIST_ITEM_HANDLE)match_context;
+}
 
-        case IO_SEND_CANCELLED:
-            /* Codes_SRS_UWS_CLIENT_01_391: [ When `on_underlying_io_send_complete` is called with `IO_SEND_CANCELLED` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_CANCELLED`. ]*/
-            ws_send_frame_result = WS_SEND_FRAME_CANCELLED;
-            break;
-        }
+static bool find_coalesced_send_frame(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const WS_PENDING_SEND* ws_pending_send = (const WS_PENDING_SEND*)singlylinkedlist_item_get_value(list_item);
+    return ws_pending_send->coalesced_send == (const WS_COALESCED_SEND*)match_context;
+}
 
-        if (complete_send_frame(ws_pending_send, ws_pending_send_list_item, ws_send_frame_result) != 0)
+static void complete_coalesced_send(WS_COALESCED_SEND* coalesced_send, WS_SEND_FRAME_RESULT ws_send_frame_result)
+{
+    UWS_CLIENT_INSTANCE* uws_client = coalesced_send->uws_client;
+    LIST_ITEM_HANDLE pending_send_item;
+
+    /* the list is searched again for every frame, as a callback can queue new frames */
+    while ((pending_send_item = singlylinkedlist_find(uws_client->pending_sends, find_coalesced_send_frame, coalesced_send)) != NULL)
+    {
+        WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(pending_send_item);
+
+        if (complete_send_frame(ws_pending_send, pending_send_item, ws_send_frame_result) != 0)
         {
             /* Codes_SRS_UWS_CLIENT_01_433: [ If `singlylinkedlist_remove` fails an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST`. ]*/
             indicate_ws_error(uws_client, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST);
+            break;
         }
     }
 }
 
-static bool find_list_node(LIST_ITEM_HANDLE list_item, const void* match_context)
+static void on_underlying_io_coalesced_send_complete(void* context, IO_SEND_RESULT send_result)
 {
-    return list_item == (LIST_ITEM_HANDLE)match_context;
+    if (context == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_435: [ When `on_underlying_io_send_complete` is called with a NULL `context`, it shall do nothing. ]*/
+        LogError("on_underlying_io_coalesced_send_complete called with NULL context");
+    }
+    else
+    {
+        WS_COALESCED_SEND* coalesced_send = (WS_COALESCED_SEND*)context;
+
+        /* Codes_SRS_UWS_CLIENT_01_576: [ When the underlying send of coalesced frames completes, every frame it carried shall be removed from the pending sends list and indicated by calling `on_ws_send_frame_complete` with the result mapped as for a single frame. ]*/
+        complete_coalesced_send(coalesced_send, get_ws_send_frame_result(send_result));
+        free(coalesced_send);
+    }
+}
+
+/* Sends the frames coalesced so far with one xio_send. Returns 0, XIO_SEND_WOULD_BLOCK when the frames are kept
+for a later attempt, or another non-zero value when the frames were indicated as failed. */
+static int send_coalesced_frames(UWS_CLIENT_INSTANCE* uws_client)
+{
+    int result;
+    WS_COALESCED_SEND* coalesced_send = uws_client->coalesced_send;
+
+    if (coalesced_send == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        unsigned char* coalesced_bytes = uws_client->coalesced_bytes;
+        size_t coalesced_bytes_count = uws_client->coalesced_bytes_count;
+        size_t coalesced_bytes_size = uws_client->coalesced_bytes_size;
+        uint64_t payload_size = coalesced_send->payload_size;
+        int send_result;
+
+        /* frames queued from a send complete callback invoked inside xio_send start a new coalesced send */
+        uws_client->coalesced_send = NULL;
+        uws_client->coalesced_bytes = NULL;
+        uws_client->coalesced_bytes_count = 0;
+        uws_client->coalesced_bytes_size = 0;
+        uws_client->is_coalesced_send_blocked = false;
+
+        send_result = xio_send(uws_client->underlying_io, coalesced_bytes, coalesced_bytes_count, on_underlying_io_coalesced_send_complete, coalesced_send);
+        if ((send_result == XIO_SEND_WOULD_BLOCK) &&
+            (uws_client->coalesced_send == NULL))
+        {
+            /* Codes_SRS_UWS_CLIENT_01_574: [ If `xio_send` returns `XIO_SEND_WOULD_BLOCK`, the coalesced frames shall be kept and sent by a later call. ]*/
+            free(uws_client->coalesced_bytes);
+            uws_client->coalesced_send = coalesced_send;
+            uws_client->coalesced_bytes = coalesced_bytes;
+            uws_client->coalesced_bytes_count = coalesced_bytes_count;
+            uws_client->coalesced_bytes_size = coalesced_bytes_size;
+            uws_client->is_coalesced_send_blocked = true;
+            result = XIO_SEND_WOULD_BLOCK;
+        }
+        else
+        {
+            /* the buffer is reused for the next coalesced send, xio_send does not keep it */
+            if (uws_client->coalesced_bytes == NULL)
+            {
+                uws_client->coalesced_bytes = coalesced_bytes;
+                uws_client->coalesced_bytes_size = coalesced_bytes_size;
+            }
+            else
+            {
+                free(coalesced_bytes);
+            }
+
+            if (send_result != 0)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_575: [ If `xio_send` fails, every coalesced frame shall be indicated by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
+                LogError("Could not send coalesced frames through the underlying IO");
+                if (uws_client->uws_deflate != NULL)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_558: [ If `xio_send` fails for a compressed frame, the compression context shall be reset by calling `uws_deflate_reset_compressor`, so that later messages do not refer to data the server never received. ]*/
+                    uws_deflate_reset_compressor(uws_client->uws_deflate);
+                }
+
+                /* Codes_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
+                if (singlylinkedlist_find(uws_client->pending_sends, find_coalesced_send_frame, coalesced_send) != NULL)
+                {
+                    // Guards against double free in case the underlying I/O invoked 'on_underlying_io_coalesced_send_complete' within xio_send.
+                    complete_coalesced_send(coalesced_send, WS_SEND_FRAME_ERROR);
+                    free(coalesced_send);
+                }
+
+                result = __FAILURE__;
+            }
+            else
+            {
+                uws_client->payload_bytes_sent += payload_size;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Hands the coalesced frames to the underlying IO ahead of a CLOSE frame or of closing the underlying IO. */
+static void flush_coalesced_frames(UWS_CLIENT_INSTANCE* uws_client)
+{
+    /* Codes_SRS_UWS_CLIENT_01_596: [ Before a CLOSE frame is sent or the underlying IO is closed, the coalesced frames shall be sent by calling `xio_send`. ]*/
+    if (send_coalesced_frames(uws_client) == XIO_SEND_WOULD_BLOCK)
+    {
+        WS_COALESCED_SEND* coalesced_send = uws_client->coalesced_send;
+
+        uws_client->coalesced_send = NULL;
+        uws_client->coalesced_bytes_count = 0;
+        uws_client->is_coalesced_send_blocked = false;
+
+        /* Codes_SRS_UWS_CLIENT_01_597: [ If `xio_send` returns `XIO_SEND_WOULD_BLOCK`, every coalesced frame shall be indicated by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_CANCELLED`, as no data frame can follow the CLOSE frame. ]*/
+        complete_coalesced_send(coalesced_send, WS_SEND_FRAME_CANCELLED);
+        free(coalesced_send);
+    }
+}
+
+/* Appends one masked frame to the coalesced bytes. On failure the frame is not queued and the caller keeps ownership of ws_pending_send. */
+static int coalesce_frame(UWS_CLIENT_INSTANCE* uws_client, WS_PENDING_SEND* ws_pending_send, unsigned char frame_type, const unsigned char* payload, size_t payload_size, bool is_final, unsigned char reserved, size_t size)
+{
+    int result;
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_length;
+
+    /* Codes_SRS_UWS_CLIENT_01_568: [ If the `ws_send_coalescing_limit` option is not 0, `uws_client_send_frame_async` shall not send the frame right away but append it to the bytes coalesced since the last underlying send, encoding its header with `uws_frame_encoder_encode_header` and masking its payload with `uws_frame_encoder_mask`. ]*/
+    if (uws_frame_encoder_encode_header(header, sizeof(header), (WS_FRAME_TYPE)frame_type, payload_size, true, is_final, reserved, &header_length) != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_571: [ If encoding the header, masking the payload or allocating memory for the coalesced frame fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        LogError("Failed encoding WebSocket frame header");
+        result = __FAILURE__;
+    }
+    else if ((uws_client->coalesced_bytes_count > 0) &&
+        /* Codes_SRS_UWS_CLIENT_01_595: [ While the coalesced frames are kept after `xio_send` returned `XIO_SEND_WOULD_BLOCK`, they shall also be sent first. ]*/
+        (uws_client->is_coalesced_send_blocked ||
+        /* the coalesced bytes can already be over the limit when a send that reached it was blocked */
+        (uws_client->coalesced_bytes_count + header_length + payload_size > uws_client->send_coalescing_limit)) &&
+        /* Codes_SRS_UWS_CLIENT_01_569: [ If appending the frame would take the coalesced bytes over the limit, the frames coalesced so far shall be sent first. ]*/
+        (send_coalesced_frames(uws_client) == XIO_SEND_WOULD_BLOCK))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_570: [ If sending them returns `XIO_SEND_WOULD_BLOCK`, `uws_client_send_frame_async` shall not queue the frame and return `XIO_SEND_WOULD_BLOCK`. ]*/
+        result = XIO_SEND_WOULD_BLOCK;
+    }
+    else
+    {
+        size_t needed_size = uws_client->coalesced_bytes_count + header_length + payload_size;
+        bool is_new_coalesced_send = (uws_client->coalesced_send == NULL);
+
+        if (needed_size > uws_client->coalesced_bytes_size)
+        {
+            size_t new_size = (needed_size > uws_client->send_coalescing_limit) ? needed_size : uws_client->send_coalescing_limit;
+            unsigned char* new_bytes = (unsigned char*)realloc(uws_client->coalesced_bytes, new_size);
+            if (new_bytes != NULL)
+            {
+                uws_client->coalesced_bytes = new_bytes;
+                uws_client->coalesced_bytes_size = new_size;
+            }
+        }
+
+        if (needed_size > uws_client->coalesced_bytes_size)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_571: [ If encoding the header, masking the payload or allocating memory for the coalesced frame fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+            LogError("Cannot allocate memory for coalesced frames");
+            result = __FAILURE__;
+        }
+        else if (is_new_coalesced_send &&
+            ((uws_client->coalesced_send = (WS_COALESCED_SEND*)malloc(sizeof(WS_COALESCED_SEND))) == NULL))
+        {
+            LogError("Cannot allocate memory for coalesced send");
+            result = __FAILURE__;
+        }
+        else
+        {
+            unsigned char* frame_bytes = uws_client->coalesced_bytes + uws_client->coalesced_bytes_count;
+
+            if (is_new_coalesced_send)
+            {
+                uws_client->coalesced_send->uws_client = uws_client;
+                uws_client->coalesced_send->payload_size = 0;
+            }
+
+            (void)memcpy(frame_bytes, header, header_length);
+            ws_pending_send->coalesced_send = uws_client->coalesced_send;
+
+            if (uws_frame_encoder_mask(frame_bytes + header_length, payload, payload_size, header + header_length - 4, 0) != 0)
+            {
+                LogError("Failed masking WebSocket frame payload");
+                result = __FAILURE__;
+            }
+            /* Codes_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by calling `singlylinkedlist_add`. ]*/
+            else if (singlylinkedlist_add(uws_client->pending_sends, ws_pending_send) == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_049: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                LogError("Could not allocate memory for pending frames");
+                result = __FAILURE__;
+            }
+            else
+            {
+                uws_client->coalesced_bytes_count = needed_size;
+                uws_client->coalesced_send->payload_size += size;
+
+                if (uws_client->coalesced_bytes_count >= uws_client->send_coalescing_limit)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_572: [ Once the coalesced bytes reach the limit they shall be sent right away. ]*/
+                    /* a failure has already been indicated through on_ws_send_frame_complete, a blocked send is retried by uws_client_dowork */
+                    (void)send_coalesced_frames(uws_client);
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_042: [ On success, `uws_client_send_frame_async` shall return 0. ]*/
+                result = 0;
+            }
+
+            if ((result != 0) &&
+                is_new_coalesced_send)
+            {
+                free(uws_client->coalesced_send);
+                uws_client->coalesced_send = NULL;
+            }
+        }
+    }
+
+    return result;
 }
 
 int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char frame_type, const unsigned char* buffer, size_t size, bool is_final, ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete, void* on_ws_send_frame_complete_context)
@@ -1730,13 +2367,69 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
         else
         {
             BUFFER_HANDLE non_control_frame_buffer;
+            const unsigned char* payload = buffer;
+            size_t payload_size = size;
+            unsigned char reserved = 0;
+            bool is_compressed = false;
+            bool compress_failed = false;
+
+            if ((uws_client->uws_deflate != NULL) &&
+                ((frame_type == (unsigned char)WS_FRAME_TYPE_TEXT) ||
+                (frame_type == (unsigned char)WS_FRAME_TYPE_BINARY) ||
+                (frame_type == (unsigned char)WS_CONTINUATION_FRAME)))
+            {
+                /* Codes_SRS_UWS_CLIENT_01_555: [ If permessage-deflate was negotiated, the payload of data frames shall be compressed by calling `uws_deflate_compress`, passing the `is_final` flag. ]*/
+                if (uws_deflate_compress(uws_client->uws_deflate, buffer, size, is_final, &payload, &payload_size) != 0)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_556: [ If `uws_deflate_compress` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                    LogError("Failed compressing WebSocket frame");
+                    compress_failed = true;
+                }
+                else
+                {
+                    is_compressed = true;
 
+                    /* Codes_SRS_UWS_CLIENT_01_557: [ The RSV1 bit shall be set on the first frame of a compressed message. ]*/
+                    if (frame_type != (unsigned char)WS_CONTINUATION_FRAME)
+                    {
+                        reserved = RESERVED_1;
+                    }
+                }
+            }
+
+            /* Codes_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
+            /* Codes_SRS_UWS_CLIENT_01_050: [ The argument `on_ws_send_frame_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
+            /* Codes_SRS_UWS_CLIENT_01_041: [ - the send complete callback context `on_ws_send_frame_complete_context` ]*/
+            ws_pending_send->on_ws_send_frame_complete = on_ws_send_frame_complete;
+            ws_pending_send->context = on_ws_send_frame_complete_context;
+            ws_pending_send->uws_client = uws_client;
+            ws_pending_send->coalesced_send = NULL;
+
+            if (compress_failed)
+            {
+                free(ws_pending_send);
+                result = __FAILURE__;
+            }
+            else if (uws_client->send_coalescing_limit > 0)
+            {
+                result = coalesce_frame(uws_client, ws_pending_send, frame_type, payload, payload_size, is_final, reserved, size);
+                if (result != 0)
+                {
+                    free(ws_pending_send);
+
+                    if (is_compressed)
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_558: [ If `xio_send` fails for a compressed frame, the compression context shall be reset by calling `uws_deflate_reset_compressor`, so that later messages do not refer to data the server never received. ]*/
+                        uws_deflate_reset_compressor(uws_client->uws_deflate);
+                    }
+                }
+            }
             /* Codes_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling `uws_frame_encoder_encode` and passing to it the `buffer` and `size` argument for payload, the `is_final` flag and setting `is_masked` to true. ]*/
             /* Codes_SRS_UWS_CLIENT_01_270: [ An endpoint MUST encapsulate the /data/ in a WebSocket frame as defined in Section 5.2. ]*/
             /* Codes_SRS_UWS_CLIENT_01_272: [ The opcode (frame-opcode) of the first frame containing the data MUST be set to the appropriate value from Section 5.2 for data that is to be interpreted by the recipient as text or binary data. ]*/
             /* Codes_SRS_UWS_CLIENT_01_274: [ If the data is being sent by the client, the frame(s) MUST be masked as defined in Section 5.3. ]*/
-            non_control_frame_buffer = uws_frame_encoder_encode((WS_FRAME_TYPE)frame_type, buffer, size, true, is_final, 0);
-            if (non_control_frame_buffer == NULL)
+            else if ((non_control_frame_buffer = uws_frame_encoder_encode((WS_FRAME_TYPE)frame_type, payload, payload_size, true, is_final, reserved)) == NULL)
             {
                 /* Codes_SRS_UWS_CLIENT_01_426: [ If `uws_frame_encoder_encode` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
                 LogError("Failed encoding WebSocket frame");
@@ -1754,14 +2447,6 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
                 /* Codes_SRS_UWS_CLIENT_01_429: [ The encoded frame size shall be obtained by calling `BUFFER_length` on the encode buffer. ]*/
                 encoded_frame_length = BUFFER_length(non_control_frame_buffer);
 
-                /* Codes_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
-                /* Codes_SRS_UWS_CLIENT_01_050: [ The argument `on_ws_send_frame_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
-                /* Codes_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
-                /* Codes_SRS_UWS_CLIENT_01_041: [ - the send complete callback context `on_ws_send_frame_complete_context` ]*/
-                ws_pending_send->on_ws_send_frame_complete = on_ws_send_frame_complete;
-                ws_pending_send->context = on_ws_send_frame_complete_context;
-                ws_pending_send->uws_client = uws_client;
-
                 /* Codes_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by calling `singlylinkedlist_add`. ]*/
                 new_pending_send_list_item = singlylinkedlist_add(uws_client->pending_sends, ws_pending_send);
                 if (new_pending_send_list_item == NULL)
@@ -1780,11 +2465,15 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
                     /* Codes_SRS_UWS_CLIENT_01_056: [ - the `send_complete` callback shall be the `on_underlying_io_send_complete` function. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_057: [ - the `send_complete_context` argument shall identify the pending send. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_276: [ The frame(s) that have been formed MUST be transmitted over the underlying network connection. ]*/
-                    if (xio_send(uws_client->underlying_io, encoded_frame, encoded_frame_length, on_underlying_io_send_complete, new_pending_send_list_item) != 0)
+                    int send_result = xio_send(uws_client->underlying_io, encoded_frame, encoded_frame_length, on_underlying_io_send_complete, new_pending_send_list_item);
+                    if (send_result != 0)
                     {
                         /* Codes_SRS_UWS_CLIENT_01_058: [ If `xio_send` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-                        LogError("Could not send bytes through the underlying IO");
-                        
+                        if (send_result != XIO_SEND_WOULD_BLOCK)
+                        {
+                            LogError("Could not send bytes through the underlying IO");
+                        }
+
                         /* Codes_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
                         if (singlylinkedlist_find(uws_client->pending_sends, find_list_node, new_pending_send_list_item) != NULL)
                         {    
@@ -1793,10 +2482,19 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
                             free(ws_pending_send);
                         }
 
-                        result = __FAILURE__;
+                        if (is_compressed)
+                        {
+                            /* Codes_SRS_UWS_CLIENT_01_558: [ If `xio_send` fails for a compressed frame, the compression context shall be reset by calling `uws_deflate_reset_compressor`, so that later messages do not refer to data the server never received. ]*/
+                            uws_deflate_reset_compressor(uws_client->uws_deflate);
+                        }
+
+                        /* Codes_SRS_UWS_CLIENT_01_537: [ If `xio_send` returns `XIO_SEND_WOULD_BLOCK`, `uws_client_send_frame_async` shall de-queue the frame and return `XIO_SEND_WOULD_BLOCK`. ]*/
+                        result = (send_result == XIO_SEND_WOULD_BLOCK) ? XIO_SEND_WOULD_BLOCK : __FAILURE__;
                     }
                     else
                     {
+                        uws_client->payload_bytes_sent += size;
+
                         /* Codes_SRS_UWS_CLIENT_01_042: [ On success, `uws_client_send_frame_async` shall return 0. ]*/
                         result = 0;
                     }
@@ -1822,6 +2520,12 @@ void uws_client_dowork(UWS_CLIENT_HANDLE uws_client)
         /* Codes_SRS_UWS_CLIENT_01_060: [ If the IO is not yet open, `uws_client_dowork` shall do nothing. ]*/
         if (uws_client->uws_state != UWS_STATE_CLOSED)
         {
+            if (uws_client->uws_state == UWS_STATE_OPEN)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_573: [ If frames were coalesced, `uws_client_dowork` shall send all of them with a single `xio_send` call before calling `xio_dowork`. ]*/
+                (void)send_coalesced_frames(uws_client);
+            }
+
             /* Codes_SRS_UWS_CLIENT_01_430: [ `uws_client_dowork` shall call `xio_dowork` with the IO handle argument set to the underlying IO created in `uws_client_create`. ]*/
             xio_dowork(uws_client->underlying_io);
         }
@@ -1858,6 +2562,101 @@ int uws_client_set_option(UWS_CLIENT_HANDLE uws_client, const char* option_name,
                 result = 0;
             }
         }
+        else if (strcmp(OPTION_WS_PERMESSAGE_DEFLATE, option_name) == 0)
+        {
+            const WS_PERMESSAGE_DEFLATE_OPTIONS* permessage_deflate_options = (const WS_PERMESSAGE_DEFLATE_OPTIONS*)value;
+
+            if (uws_client->uws_state != UWS_STATE_CLOSED)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_559: [ If the option name is `ws_permessage_deflate` and the uws instance is not CLOSED, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                LogError("permessage-deflate can only be configured before opening");
+                result = __FAILURE__;
+            }
+            else if ((permessage_deflate_options != NULL) &&
+                (((permessage_deflate_options->client_max_window_bits != 0) && ((permessage_deflate_options->client_max_window_bits < 9) || (permessage_deflate_options->client_max_window_bits > 15))) ||
+                ((permessage_deflate_options->server_max_window_bits != 0) && ((permessage_deflate_options->server_max_window_bits < 8) || (permessage_deflate_options->server_max_window_bits > 15)))))
+            {
+                /* Codes_SRS_UWS_CLIENT_01_560: [ If `client_max_window_bits` is not 0 or 9 to 15, or `server_max_window_bits` is not 0 or 8 to 15, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                LogError("Invalid permessage-deflate window bits: client_max_window_bits=%d, server_max_window_bits=%d",
+                    permessage_deflate_options->client_max_window_bits, permessage_deflate_options->server_max_window_bits);
+                result = __FAILURE__;
+            }
+            else if (permessage_deflate_options == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_561: [ A NULL `value` for `ws_permessage_deflate` shall disable permessage-deflate for subsequent connections. ]*/
+                free(uws_client->permessage_deflate_options);
+                uws_client->permessage_deflate_options = NULL;
+                result = 0;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_562: [ Otherwise `uws_client_set_option` shall copy the `WS_PERMESSAGE_DEFLATE_OPTIONS` pointed to by `value`, and permessage-deflate shall be offered for subsequent connections. ]*/
+                WS_PERMESSAGE_DEFLATE_OPTIONS* options_copy = uws_client->permessage_deflate_options;
+                if ((options_copy == NULL) &&
+                    ((options_copy = (WS_PERMESSAGE_DEFLATE_OPTIONS*)malloc(sizeof(WS_PERMESSAGE_DEFLATE_OPTIONS))) == NULL))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_563: [ If allocating memory for the copy fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                    LogError("Cannot allocate memory for permessage-deflate options");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    *options_copy = *permessage_deflate_options;
+                    uws_client->permessage_deflate_options = options_copy;
+
+                    /* Codes_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
+                    result = 0;
+                }
+            }
+        }
+        else if (strcmp(OPTION_WS_SEND_COALESCING_LIMIT, option_name) == 0)
+        {
+            if (value == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_578: [ If the option name is `ws_send_coalescing_limit` and `value` is NULL, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                LogError("NULL value for ws_send_coalescing_limit");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_579: [ Otherwise the limit shall be set to the `size_t` pointed to by `value`, and setting it to 0 shall send the frames coalesced so far. ]*/
+                uws_client->send_coalescing_limit = *(const size_t*)value;
+                if ((uws_client->send_coalescing_limit == 0) &&
+                    (uws_client->uws_state == UWS_STATE_OPEN))
+                {
+                    (void)send_coalesced_frames(uws_client);
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
+                result = 0;
+            }
+        }
+        else if ((strcmp(OPTION_WS_ON_FRAGMENT_RECEIVED, option_name) == 0) ||
+            (strcmp(OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, option_name) == 0))
+        {
+            if (uws_client->uws_state != UWS_STATE_CLOSED)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_585: [ If the option name is `ws_on_fragment_received` or `ws_on_fragment_received_context` and the uws instance is not CLOSED, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                LogError("The fragment callback can only be set before opening");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (strcmp(OPTION_WS_ON_FRAGMENT_RECEIVED, option_name) == 0)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_586: [ For `ws_on_fragment_received` the `value` shall be stored as the `ON_WS_FRAGMENT_RECEIVED` callback, a NULL `value` restoring whole frame delivery through `on_ws_frame_received`. ]*/
+                    uws_client->on_ws_fragment_received = (ON_WS_FRAGMENT_RECEIVED)value;
+                }
+                else
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_587: [ For `ws_on_fragment_received_context` the `value` shall be stored as the context passed to the fragment callback. ]*/
+                    uws_client->on_ws_fragment_received_context = (void*)value;
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
+                result = 0;
+            }
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_441: [ Otherwise all options shall be passed as they are to the underlying IO by calling `xio_setoption`. ]*/
@@ -1898,6 +2697,40 @@ static void* uws_client_clone_option(const char* name, const void* value)
             /* Codes_SRS_UWS_CLIENT_01_507: [ `uws_client_clone_option` called with `name` being `uWSClientOptions` shall return the same value. ]*/
             result = (void*)value;
         }
+        else if (strcmp(name, OPTION_WS_PERMESSAGE_DEFLATE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_564: [ `uws_client_clone_option` called with `name` being `ws_permessage_deflate` shall return a newly allocated copy of the `WS_PERMESSAGE_DEFLATE_OPTIONS` value. ]*/
+            result = malloc(sizeof(WS_PERMESSAGE_DEFLATE_OPTIONS));
+            if (result == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_565: [ If allocating memory for the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+                LogError("Cannot allocate memory for permessage-deflate options");
+            }
+            else
+            {
+                (void)memcpy(result, value, sizeof(WS_PERMESSAGE_DEFLATE_OPTIONS));
+            }
+        }
+        else if (strcmp(name, OPTION_WS_SEND_COALESCING_LIMIT) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_580: [ `uws_client_clone_option` called with `name` being `ws_send_coalescing_limit` shall return a newly allocated copy of the `size_t` value. ]*/
+            result = malloc(sizeof(size_t));
+            if (result == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_581: [ If allocating memory for the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+                LogError("Cannot allocate memory for the coalescing limit");
+            }
+            else
+            {
+                *(size_t*)result = *(const size_t*)value;
+            }
+        }
+        else if ((strcmp(name, OPTION_WS_ON_FRAGMENT_RECEIVED) == 0) ||
+            (strcmp(name, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT) == 0))
+        {
+            /* Codes_SRS_UWS_CLIENT_01_599: [ `uws_client_clone_option` called with `name` being `ws_on_fragment_received` or `ws_on_fragment_received_context` shall return the same value. ]*/
+            result = (void*)value;
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_512: [ `uws_client_clone_option` called with any other option name than `uWSClientOptions` shall return NULL. ]*/
@@ -1926,6 +2759,18 @@ static void uws_client_destroy_option(const char* name, const void* value)
             /* Codes_SRS_UWS_CLIENT_01_508: [ `uws_client_destroy_option` called with the option `name` being `uWSClientOptions` shall destroy the value by calling `OptionHandler_Destroy`. ]*/
             OptionHandler_Destroy((OPTIONHANDLER_HANDLE)value);
         }
+        else if ((strcmp(name, OPTION_WS_PERMESSAGE_DEFLATE) == 0) ||
+            (strcmp(name, OPTION_WS_SEND_COALESCING_LIMIT) == 0))
+        {
+            /* Codes_SRS_UWS_CLIENT_01_566: [ `uws_client_destroy_option` called with the option `name` being `ws_permessage_deflate` shall free the value. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_582: [ `uws_client_destroy_option` called with the option `name` being `ws_send_coalescing_limit` shall free the value. ]*/
+            free((void*)value);
+        }
+        else if ((strcmp(name, OPTION_WS_ON_FRAGMENT_RECEIVED) == 0) ||
+            (strcmp(name, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT) == 0))
+        {
+            /* Codes_SRS_UWS_CLIENT_01_600: [ `uws_client_destroy_option` called with the option `name` being `ws_on_fragment_received` or `ws_on_fragment_received_context` shall do nothing. ]*/
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_513: [ If `uws_client_destroy_option` is called with any other `name` it shall do nothing. ]*/
@@ -1976,6 +2821,42 @@ OPTIONHANDLER_HANDLE uws_client_retrieve_options(UWS_CLIENT_HANDLE uws_client)
                     OptionHandler_Destroy(result);
                     result = NULL;
                 }
+                /* Codes_SRS_UWS_CLIENT_01_567: [ If permessage-deflate options were set, `uws_client_retrieve_options` shall also add the `ws_permessage_deflate` option with the current options by calling `OptionHandler_AddOption`. ]*/
+                else if ((uws_client->permessage_deflate_options != NULL) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_PERMESSAGE_DEFLATE, uws_client->permessage_deflate_options) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+                /* Codes_SRS_UWS_CLIENT_01_583: [ If the coalescing limit is not 0, `uws_client_retrieve_options` shall also add the `ws_send_coalescing_limit` option by calling `OptionHandler_AddOption`. ]*/
+                else if ((uws_client->send_coalescing_limit != 0) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_SEND_COALESCING_LIMIT, &uws_client->send_coalescing_limit) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+                else if (uws_client->on_ws_fragment_received != NULL)
+                {
+#pragma warning(push)
+#pragma warning(disable:4152)
+                    void* on_ws_fragment_received = uws_client->on_ws_fragment_received;
+#pragma warning(pop)
+
+                    /* Codes_SRS_UWS_CLIENT_01_598: [ If the fragment callback was set, `uws_client_retrieve_options` shall also add the `ws_on_fragment_received` option and, when not NULL, the `ws_on_fragment_received_context` option by calling `OptionHandler_AddOption`. ]*/
+                    if ((OptionHandler_AddOption(result, OPTION_WS_ON_FRAGMENT_RECEIVED, on_ws_fragment_received) != OPTIONHANDLER_OK) ||
+                        ((uws_client->on_ws_fragment_received_context != NULL) &&
+                        (OptionHandler_AddOption(result, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, uws_client->on_ws_fragment_received_context) != OPTIONHANDLER_OK)))
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+                        LogError("OptionHandler_AddOption failed");
+                        OptionHandler_Destroy(result);
+                        result = NULL;
+                    }
+                }
             }
         }
        
@@ -1983,3 +2864,34 @@ OPTIONHANDLER_HANDLE uws_client_retrieve_options(UWS_CLIENT_HANDLE uws_client)
 
     return result;
 }
+
+int uws_client_get_statistics(UWS_CLIENT_HANDLE uws_client, XIO_STATISTICS* statistics)
+{
+    int result;
+
+    if ((uws_client == NULL) ||
+        (statistics == NULL))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_532: [ If any of the arguments `uws_client` or `statistics` is NULL, `uws_client_get_statistics` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_client=%p, statistics=%p", uws_client, statistics);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_533: [ `uws_client_get_statistics` shall obtain the statistics of the underlying IO by calling `xio_get_statistics`. ]*/
+        if (xio_get_statistics(uws_client->underlying_io, statistics) != 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_534: [ If `xio_get_statistics` fails, all the counters shall be reported as 0. ]*/
+            (void)memset(statistics, 0, sizeof(XIO_STATISTICS));
+        }
+
+        /* Codes_SRS_UWS_CLIENT_01_535: [ `bytes_sent` and `bytes_received` shall be set to the number of payload bytes of the data frames sent with `uws_client_send_frame_async` and indicated through `on_ws_frame_received`. ]*/
+        statistics->bytes_sent = uws_client->payload_bytes_sent;
+        statistics->bytes_received = uws_client->payload_bytes_received;
+
+        /* Codes_SRS_UWS_CLIENT_01_536: [ On success, `uws_client_get_statistics` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
@@ -0,0 +1,709 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/uws_deflate.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#ifdef USE_WS_DEFLATE
+#include "zlib.h"
+#endif
+
+static const char PERMESSAGE_DEFLATE[] = "permessage-deflate";
+static const char CLIENT_NO_CONTEXT_TAKEOVER[] = "client_no_context_takeover";
+static const char SERVER_NO_CONTEXT_TAKEOVER[] = "server_no_context_takeover";
+static const char CLIENT_MAX_WINDOW_BITS[] = "client_max_window_bits";
+static const char SERVER_MAX_WINDOW_BITS[] = "server_max_window_bits";
+
+#define DEFAULT_WINDOW_BITS     15
+#define MIN_OUTPUT_BUFFER_SIZE  256
+/* a decompression buffer grown above this by a large message is freed before the next message */
+#define MAX_KEPT_OUTPUT_BUFFER_SIZE (64 * 1024)
+
+#ifdef USE_WS_DEFLATE
+/* the octets that a sync flush appends and that are removed from / added back to every message */
+static const unsigned char DEFLATE_TAIL[] = { 0x00, 0x00, 0xFF, 0xFF };
+
+typedef struct UWS_DEFLATE_INSTANCE_TAG
+{
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+    z_stream deflate_stream;
+    z_stream inflate_stream;
+    unsigned char* compressed;
+    size_t compressed_size;
+    unsigned char* decompressed;
+    size_t decompressed_size;
+    size_t message_decompressed_size;
+} UWS_DEFLATE_INSTANCE;
+#endif
+
+static bool is_valid_window_bits(int window_bits, int min_window_bits)
+{
+    return (window_bits == 0) || ((window_bits >= min_window_bits) && (window_bits <= 15));
+}
+
+int uws_deflate_format_offer(const WS_PERMESSAGE_DEFLATE_OPTIONS* options, char* buffer, size_t buffer_size)
+{
+    int result;
+
+    if ((options == NULL) ||
+        (buffer == NULL))
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_001: [ If `options` or `buffer` is NULL, `uws_deflate_format_offer` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: options=%p, buffer=%p", options, buffer);
+        result = __FAILURE__;
+    }
+    else if ((!is_valid_window_bits(options->client_max_window_bits, 9)) ||
+        (!is_valid_window_bits(options->server_max_window_bits, 8)))
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_002: [ If `client_max_window_bits` is not 0 or 9 to 15, or `server_max_window_bits` is not 0 or 8 to 15, `uws_deflate_format_offer` shall fail and return a non-zero value. ]*/
+        LogError("Invalid window bits: client_max_window_bits=%d, server_max_window_bits=%d", options->client_max_window_bits, options->server_max_window_bits);
+        result = __FAILURE__;
+    }
+    else
+    {
+#ifdef USE_WS_DEFLATE
+        char client_window_bits[8] = "";
+        char server_window_bits[32] = "";
+        int length;
+
+        if (options->client_max_window_bits != 0)
+        {
+            (void)sprintf(client_window_bits, "=%d", options->client_max_window_bits);
+        }
+
+        if (options->server_max_window_bits != 0)
+        {
+            (void)sprintf(server_window_bits, "; %s=%d", SERVER_MAX_WINDOW_BITS, options->server_max_window_bits);
+        }
+
+        /* Codes_SRS_UWS_DEFLATE_01_003: [ `uws_deflate_format_offer` shall write into `buffer` a permessage-deflate extension offer that always carries `client_max_window_bits` (with a value only if `client_max_window_bits` is not 0) and carries `server_max_window_bits`, `client_no_context_takeover` and `server_no_context_takeover` when requested in `options`. ]*/
+        length = snprintf(buffer, buffer_size, "%s; %s%s%s%s%s",
+            PERMESSAGE_DEFLATE,
+            CLIENT_MAX_WINDOW_BITS, client_window_bits,
+            server_window_bits,
+            options->client_no_context_takeover ? "; client_no_context_takeover" : "",
+            options->server_no_context_takeover ? "; server_no_context_takeover" : "");
+        if ((length < 0) ||
+            ((size_t)length >= buffer_size))
+        {
+            /* Codes_SRS_UWS_DEFLATE_01_004: [ If the offer does not fit in `buffer_size` bytes, `uws_deflate_format_offer` shall fail and return a non-zero value. ]*/
+            LogError("Buffer too small for the permessage-deflate offer");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_DEFLATE_01_005: [ On success `uws_deflate_format_offer` shall return 0. ]*/
+            result = 0;
+        }
+#else
+        /* Codes_SRS_UWS_DEFLATE_01_006: [ If the library was built without zlib (`USE_WS_DEFLATE` not defined), `uws_deflate_format_offer` shall fail and return a non-zero value. ]*/
+        (void)buffer_size;
+        LogError("permessage-deflate support was not built in, build with use_ws_deflate");
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
+
+static bool is_token_char(char c)
+{
+    return (c > ' ') && (c < 127) && (strchr("()<>@,;:\\\"/[]?={}", c) == NULL);
+}
+
+static void skip_spaces(const char** position, const char* end)
+{
+    while ((*position < end) && ((**position == ' ') || (**position == '\t')))
+    {
+        (*position)++;
+    }
+}
+
+static size_t read_token(const char** position, const char* end)
+{
+    const char* start = *position;
+
+    while ((*position < end) && is_token_char(**position))
+    {
+        (*position)++;
+    }
+
+    return (size_t)(*position - start);
+}
+
+static bool is_token(const char* token, size_t token_length, const char* expected)
+{
+    return (strlen(expected) == token_length) && (memcmp(token, expected, token_length) == 0);
+}
+
+/* parses the decimal value of a window bits parameter, which may be quoted */
+static int parse_window_bits(const char* value, size_t value_length, int* window_bits)
+{
+    int result;
+
+    if ((value_length >= 2) &&
+        (value[0] == '"') &&
+        (value[value_length - 1] == '"'))
+    {
+        value++;
+        value_length -= 2;
+    }
+
+    if ((value_length == 1) &&
+        (value[0] >= '8') && (value[0] <= '9'))
+    {
+        *window_bits = value[0] - '0';
+        result = 0;
+    }
+    else if ((value_length == 2) &&
+        (value[0] == '1') &&
+        (value[1] >= '0') && (value[1] <= '5'))
+    {
+        *window_bits = 10 + value[1] - '0';
+        result = 0;
+    }
+    else
+    {
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+int uws_deflate_parse_response(const WS_PERMESSAGE_DEFLATE_OPTIONS* offered_options, const char* extensions, size_t extensions_length, WS_PERMESSAGE_DEFLATE_OPTIONS* negotiated_options, bool* is_accepted)
+{
+    int result;
+
+    if ((offered_options == NULL) ||
+        ((extensions == NULL) && (extensions_length > 0)) ||
+        (negotiated_options == NULL) ||
+        (is_accepted == NULL))
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_007: [ If `offered_options`, `negotiated_options` or `is_accepted` is NULL, or `extensions` is NULL while `extensions_length` is not 0, `uws_deflate_parse_response` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: offered_options=%p, extensions=%p, extensions_length=%u, negotiated_options=%p, is_accepted=%p",
+            offered_options, extensions, (unsigned int)extensions_length, negotiated_options, is_accepted);
+        result = __FAILURE__;
+    }
+    else
+    {
+        const char* position = extensions;
+        const char* end = extensions + extensions_length;
+        bool has_client_max_window_bits = false;
+        bool has_server_max_window_bits = false;
+
+        /* Codes_SRS_UWS_DEFLATE_01_008: [ If `extensions` is empty the offer is declined: `is_accepted` shall be set to false and `uws_deflate_parse_response` shall return 0. ]*/
+        *is_accepted = false;
+        (void)memset(negotiated_options, 0, sizeof(WS_PERMESSAGE_DEFLATE_OPTIONS));
+        result = 0;
+
+        skip_spaces(&position, end);
+        while ((result == 0) && (position < end))
+        {
+            const char* name = position;
+            size_t name_length = read_token(&position, end);
+
+            if ((name_length == 0) ||
+                (!is_token(name, name_length, PERMESSAGE_DEFLATE)) ||
+                (*is_accepted))
+            {
+                /* Codes_SRS_UWS_DEFLATE_01_009: [ If `extensions` contains any extension other than one permessage-deflate, `uws_deflate_parse_response` shall fail and return a non-zero value. ]*/
+                LogError("Unexpected extension in the upgrade response: %.*s", (int)(end - name), name);
+                result = __FAILURE__;
+                break;
+            }
+
+            *is_accepted = true;
+
+            skip_spaces(&position, end);
+            while ((result == 0) && (position < end) && (*position == ';'))
+            {
+                const char* parameter;
+                size_t parameter_length;
+                const char* value = NULL;
+                size_t value_length = 0;
+
+                position++;
+                skip_spaces(&position, end);
+                parameter = position;
+                parameter_length = read_token(&position, end);
+                skip_spaces(&position, end);
+
+                if ((position < end) && (*position == '='))
+                {
+                    position++;
+                    skip_spaces(&position, end);
+                    value = position;
+                    if ((position < end) && (*position == '"'))
+                    {
+                        position++;
+                        while ((position < end) && (*position != '"'))
+                        {
+                            position++;
+                        }
+                        if (position < end)
+                        {
+                            position++;
+                        }
+                    }
+                    else
+                    {
+                        (void)read_token(&position, end);
+                    }
+                    value_length = (size_t)(position - value);
+                    skip_spaces(&position, end);
+                }
+
+                if (is_token(parameter, parameter_length, SERVER_NO_CONTEXT_TAKEOVER) &&
+                    (value == NULL) &&
+                    (!negotiated_options->server_no_context_takeover))
+                {
+                    /* Codes_SRS_UWS_DEFLATE_01_010: [ A `server_no_context_takeover` parameter shall set `server_no_context_takeover` in `negotiated_options`. ]*/
+                    negotiated_options->server_no_context_takeover = true;
+                }
+                else if (is_token(parameter, parameter_length, CLIENT_NO_CONTEXT_TAKEOVER) &&
+                    (value == NULL) &&
+                    (!negotiated_options->client_no_context_takeover))
+                {
+                    /* Codes_SRS_UWS_DEFLATE_01_011: [ A `client_no_context_takeover` parameter shall set `client_no_context_takeover` in `negotiated_options`. ]*/
+                    negotiated_options->client_no_context_takeover = true;
+                }
+                else if (is_token(parameter, parameter_length, SERVER_MAX_WINDOW_BITS) &&
+                    (value != NULL) &&
+                    (!has_server_max_window_bits) &&
+                    (parse_window_bits(value, value_length, &negotiated_options->server_max_window_bits) == 0) &&
+                    ((offered_options->server_max_window_bits == 0) || (negotiated_options->server_max_window_bits <= offered_options->server_max_window_bits)))
+                {
+                    /* Codes_SRS_UWS_DEFLATE_01_012: [ A `server_max_window_bits` parameter with a value from 8 to 15, not above the offered value, shall be stored in `negotiated_options`. ]*/
+                    has_server_max_window_bits = true;
+                }
+                else if (is_token(parameter, parameter_length, CLIENT_MAX_WINDOW_BITS) &&
+                    (value != NULL) &&
+                    (!has_client_max_window_bits) &&
+                    (parse_window_bits(value, value_length, &negotiated_options->client_max_window_bits) == 0) &&
+                    (negotiated_options->client_max_window_bits >= 9) &&
+                    ((offered_options->client_max_window_bits == 0) || (negotiated_options->client_max_window_bits <= offered_options->client_max_window_bits)))
+                {
+                    /* Codes_SRS_UWS_DEFLATE_01_013: [ A `client_max_window_bits` parameter with a value from 9 to 15, not above the offered value, shall be stored in `negotiated_options`. ]*/
+                    /* zlib cannot produce raw deflate data with a 256 byte window, so 8 is refused */
+                    has_client_max_window_bits = true;
+                }
+                else
+                {
+                    /* Codes_SRS_UWS_DEFLATE_01_014: [ If any parameter is unknown, repeated, has an invalid value or is not allowed by the offer, `uws_deflate_parse_response` shall fail and return a non-zero value. ]*/
+                    LogError("Bad permessage-deflate parameter in the upgrade response: %.*s", (int)parameter_length, parameter);
+                    result = __FAILURE__;
+                }
+            }
+
+            if (result == 0)
+            {
+                if ((position < end) && (*position == ','))
+                {
+                    position++;
+                    skip_spaces(&position, end);
+                }
+                else if (position < end)
+                {
+                    LogError("Cannot parse the extensions in the upgrade response");
+                    result = __FAILURE__;
+                }
+            }
+        }
+
+        if (result == 0)
+        {
+            if ((*is_accepted) &&
+                (offered_options->server_max_window_bits != 0) &&
+                (!has_server_max_window_bits))
+            {
+                /* Codes_SRS_UWS_DEFLATE_01_015: [ If `server_max_window_bits` was offered and the accepted extension does not carry it, `uws_deflate_parse_response` shall fail and return a non-zero value. ]*/
+                LogError("server_max_window_bits was requested but not accepted");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_DEFLATE_01_016: [ Window bits that are not present in the response shall be set to the offered value, or to 15 if none was offered. ]*/
+                if (!has_client_max_window_bits)
+                {
+                    negotiated_options->client_max_window_bits = (offered_options->client_max_window_bits != 0) ? offered_options->client_max_window_bits : DEFAULT_WINDOW_BITS;
+                }
+
+                if (!has_server_max_window_bits)
+                {
+                    negotiated_options->server_max_window_bits = DEFAULT_WINDOW_BITS;
+                }
+
+                /* Codes_SRS_UWS_DEFLATE_01_017: [ A `client_no_context_takeover` that was offered shall be kept in `negotiated_options` even if the server does not echo it. ]*/
+                negotiated_options->client_no_context_takeover = negotiated_options->client_no_context_takeover || offered_options->client_no_context_takeover;
+
+                /* Codes_SRS_UWS_DEFLATE_01_041: [ `max_decompressed_message_size` is not negotiated and shall be copied from `offered_options` to `negotiated_options`. ]*/
+                negotiated_options->max_decompressed_message_size = offered_options->max_decompressed_message_size;
+            }
+        }
+
+        if (result != 0)
+        {
+            *is_accepted = false;
+        }
+    }
+
+    return result;
+}
+
+#ifdef USE_WS_DEFLATE
+/* makes sure that at least MIN_OUTPUT_BUFFER_SIZE bytes are free after used_size, growing geometrically */
+static int ensure_output_space(unsigned char** buffer, size_t* buffer_size, size_t used_size)
+{
+    int result;
+
+    if (*buffer_size - used_size >= MIN_OUTPUT_BUFFER_SIZE)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_size = (*buffer_size < MIN_OUTPUT_BUFFER_SIZE) ? (MIN_OUTPUT_BUFFER_SIZE * 4) : (*buffer_size * 2);
+        unsigned char* new_buffer;
+
+        if (new_size <= *buffer_size)
+        {
+            LogError("Output buffer size overflow");
+            result = __FAILURE__;
+        }
+        else if ((new_buffer = (unsigned char*)realloc(*buffer, new_size)) == NULL)
+        {
+            LogError("Cannot grow output buffer to %u bytes", (unsigned int)new_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            *buffer = new_buffer;
+            *buffer_size = new_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+#endif
+
+UWS_DEFLATE_HANDLE uws_deflate_create(const WS_PERMESSAGE_DEFLATE_OPTIONS* negotiated_options)
+{
+    UWS_DEFLATE_HANDLE result;
+
+    if (negotiated_options == NULL)
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_018: [ If `negotiated_options` is NULL, `uws_deflate_create` shall fail and return NULL. ]*/
+        LogError("NULL negotiated_options");
+        result = NULL;
+    }
+#ifdef USE_WS_DEFLATE
+    else if ((negotiated_options->client_max_window_bits < 9) ||
+        (negotiated_options->client_max_window_bits > 15))
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_019: [ If `client_max_window_bits` in `negotiated_options` is not between 9 and 15, `uws_deflate_create` shall fail and return NULL. ]*/
+        LogError("Invalid client_max_window_bits: %d", negotiated_options->client_max_window_bits);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_020: [ `uws_deflate_create` shall allocate a new instance holding a copy of `negotiated_options`. ]*/
+        result = (UWS_DEFLATE_HANDLE)malloc(sizeof(UWS_DEFLATE_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_UWS_DEFLATE_01_021: [ If any allocation or zlib initialization fails, `uws_deflate_create` shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for permessage-deflate instance");
+        }
+        else
+        {
+            (void)memset(result, 0, sizeof(UWS_DEFLATE_INSTANCE));
+            result->negotiated_options = *negotiated_options;
+
+            /* Codes_SRS_UWS_DEFLATE_01_022: [ `uws_deflate_create` shall initialize a raw deflate stream with `deflateInit2` using a window of `client_max_window_bits`. ]*/
+            if (deflateInit2(&result->deflate_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -negotiated_options->client_max_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                /* Codes_SRS_UWS_DEFLATE_01_021: [ If any allocation or zlib initialization fails, `uws_deflate_create` shall fail and return NULL. ]*/
+                LogError("deflateInit2 failed");
+                free(result);
+                result = NULL;
+            }
+            /* Codes_SRS_UWS_DEFLATE_01_023: [ `uws_deflate_create` shall initialize a raw inflate stream with `inflateInit2` using a 15 bit window, which can decode data produced with any smaller window. ]*/
+            else if (inflateInit2(&result->inflate_stream, -DEFAULT_WINDOW_BITS) != Z_OK)
+            {
+                /* Codes_SRS_UWS_DEFLATE_01_021: [ If any allocation or zlib initialization fails, `uws_deflate_create` shall fail and return NULL. ]*/
+                LogError("inflateInit2 failed");
+                (void)deflateEnd(&result->deflate_stream);
+                free(result);
+                result = NULL;
+            }
+        }
+    }
+#else
+    else
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_024: [ If the library was built without zlib (`USE_WS_DEFLATE` not defined), `uws_deflate_create` shall fail and return NULL. ]*/
+        LogError("permessage-deflate support was not built in, build with use_ws_deflate");
+        result = NULL;
+    }
+#endif
+
+    return result;
+}
+
+void uws_deflate_destroy(UWS_DEFLATE_HANDLE uws_deflate)
+{
+    if (uws_deflate == NULL)
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_025: [ If `uws_deflate` is NULL, `uws_deflate_destroy` shall do nothing. ]*/
+        LogError("NULL uws_deflate");
+    }
+    else
+    {
+#ifdef USE_WS_DEFLATE
+        /* Codes_SRS_UWS_DEFLATE_01_026: [ `uws_deflate_destroy` shall end both zlib streams and free all memory held by the instance. ]*/
+        (void)deflateEnd(&uws_deflate->deflate_stream);
+        (void)inflateEnd(&uws_deflate->inflate_stream);
+        free(uws_deflate->compressed);
+        free(uws_deflate->decompressed);
+        free(uws_deflate);
+#endif
+    }
+}
+
+int uws_deflate_compress(UWS_DEFLATE_HANDLE uws_deflate, const unsigned char* payload, size_t size, bool is_final, const unsigned char** compressed, size_t* compressed_size)
+{
+    int result;
+
+    if ((uws_deflate == NULL) ||
+        ((payload == NULL) && (size > 0)) ||
+        (compressed == NULL) ||
+        (compressed_size == NULL))
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_027: [ If `uws_deflate`, `compressed` or `compressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_deflate_compress` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_deflate=%p, payload=%p, size=%u, compressed=%p, compressed_size=%p",
+            uws_deflate, payload, (unsigned int)size, compressed, compressed_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+#ifdef USE_WS_DEFLATE
+        z_stream* stream = &uws_deflate->deflate_stream;
+        size_t used_size = 0;
+        int zlib_result = Z_OK;
+
+        /* Codes_SRS_UWS_DEFLATE_01_028: [ `uws_deflate_compress` shall compress `payload` with `deflate` and `Z_SYNC_FLUSH` into a buffer owned by the instance, which is reused by subsequent calls. ]*/
+        stream->next_in = (Bytef*)payload;
+        stream->avail_in = (uInt)size;
+        result = 0;
+
+        do
+        {
+            if (ensure_output_space(&uws_deflate->compressed, &uws_deflate->compressed_size, used_size) != 0)
+            {
+                /* Codes_SRS_UWS_DEFLATE_01_029: [ If growing the output buffer or `deflate` fails, `uws_deflate_compress` shall fail and return a non-zero value. ]*/
+                result = __FAILURE__;
+            }
+            else
+            {
+                stream->next_out = uws_deflate->compressed + used_size;
+                stream->avail_out = (uInt)(uws_deflate->compressed_size - used_size);
+                zlib_result = deflate(stream, Z_SYNC_FLUSH);
+                used_size = uws_deflate->compressed_size - stream->avail_out;
+                if ((zlib_result != Z_OK) && (zlib_result != Z_BUF_ERROR))
+                {
+                    /* Codes_SRS_UWS_DEFLATE_01_029: [ If growing the output buffer or `deflate` fails, `uws_deflate_compress` shall fail and return a non-zero value. ]*/
+                    LogError("deflate failed: %d", zlib_result);
+                    result = __FAILURE__;
+                }
+            }
+        } while ((result == 0) && (stream->avail_out == 0));
+
+        if (result == 0)
+        {
+            if (is_final)
+            {
+                /* Codes_SRS_UWS_DEFLATE_01_030: [ When `is_final` is true, the 0x00 0x00 0xFF 0xFF tail of the sync flush shall be removed from the output. ]*/
+                if ((used_size >= sizeof(DEFLATE_TAIL)) &&
+                    (memcmp(uws_deflate->compressed + used_size - sizeof(DEFLATE_TAIL), DEFLATE_TAIL, sizeof(DEFLATE_TAIL)) == 0))
+                {
+                    used_size -= sizeof(DEFLATE_TAIL);
+                }
+
+                if (uws_deflate->negotiated_options.client_no_context_takeover)
+                {
+                    /* Codes_SRS_UWS_DEFLATE_01_031: [ When `is_final` is true and `client_no_context_takeover` was negotiated, the deflate stream shall be reset with `deflateReset`. ]*/
+                    (void)deflateReset(stream);
+                }
+            }
+
+            /* Codes_SRS_UWS_DEFLATE_01_032: [ On success `uws_deflate_compress` shall set `compressed` and `compressed_size` to the compressed bytes and return 0. ]*/
+            *compressed = uws_deflate->compressed;
+            *compressed_size = used_size;
+        }
+#else
+        (void)is_final;
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
+
+void uws_deflate_reset_compressor(UWS_DEFLATE_HANDLE uws_deflate)
+{
+    if (uws_deflate == NULL)
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_039: [ If `uws_deflate` is NULL, `uws_deflate_reset_compressor` shall do nothing. ]*/
+        LogError("NULL uws_deflate");
+    }
+    else
+    {
+#ifdef USE_WS_DEFLATE
+        /* Codes_SRS_UWS_DEFLATE_01_040: [ `uws_deflate_reset_compressor` shall drop the compression history by calling `deflateReset`. ]*/
+        (void)deflateReset(&uws_deflate->deflate_stream);
+#endif
+    }
+}
+
+#ifdef USE_WS_DEFLATE
+static int inflate_bytes(UWS_DEFLATE_INSTANCE* uws_deflate, const unsigned char* bytes, size_t size, size_t* used_size)
+{
+    z_stream* stream = &uws_deflate->inflate_stream;
+    size_t max_message_size = uws_deflate->negotiated_options.max_decompressed_message_size;
+    int result = 0;
+
+    if (max_message_size == 0)
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_046: [ If `max_decompressed_message_size` is 0, `UWS_DEFLATE_DEFAULT_MAX_DECOMPRESSED_MESSAGE_SIZE` shall be used instead. ]*/
+        max_message_size = UWS_DEFLATE_DEFAULT_MAX_DECOMPRESSED_MESSAGE_SIZE;
+    }
+
+    stream->next_in = (Bytef*)bytes;
+    stream->avail_in = (uInt)size;
+    stream->avail_out = 0;
+
+    /* Codes_SRS_UWS_DEFLATE_01_045: [ `inflate` shall be called until all of `payload` is consumed and it leaves room in the output buffer, so that no decompressed byte is held back by zlib. ]*/
+    while ((result == 0) && ((stream->avail_in > 0) || (stream->avail_out == 0)))
+    {
+        if (ensure_output_space(&uws_deflate->decompressed, &uws_deflate->decompressed_size, *used_size) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            int zlib_result;
+            size_t available_size = uws_deflate->decompressed_size - *used_size;
+
+            /* inflating one byte past the limit is enough to know that the message is too big */
+            size_t remaining_size = max_message_size - (uws_deflate->message_decompressed_size + *used_size);
+            if (available_size > remaining_size)
+            {
+                available_size = remaining_size + 1;
+            }
+
+            stream->next_out = uws_deflate->decompressed + *used_size;
+            stream->avail_out = (uInt)available_size;
+            zlib_result = inflate(stream, Z_SYNC_FLUSH);
+            *used_size += available_size - stream->avail_out;
+            if ((zlib_result != Z_OK) &&
+                (zlib_result != Z_BUF_ERROR))
+            {
+                LogError("inflate failed: %d", zlib_result);
+                result = __FAILURE__;
+            }
+            else if (uws_deflate->message_decompressed_size + *used_size > max_message_size)
+            {
+                LogError("Decompressed message exceeds %u bytes", (unsigned int)max_message_size);
+                result = UWS_DEFLATE_MESSAGE_TOO_BIG;
+            }
+        }
+    }
+
+    return result;
+}
+#endif
+
+int uws_deflate_decompress(UWS_DEFLATE_HANDLE uws_deflate, const unsigned char* payload, size_t size, bool is_final, const unsigned char** decompressed, size_t* decompressed_size)
+{
+    int result;
+
+    if ((uws_deflate == NULL) ||
+        ((payload == NULL) && (size > 0)) ||
+        (decompressed == NULL) ||
+        (decompressed_size == NULL))
+    {
+        /* Codes_SRS_UWS_DEFLATE_01_033: [ If `uws_deflate`, `decompressed` or `decompressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_deflate_decompress` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_deflate=%p, payload=%p, size=%u, decompressed=%p, decompressed_size=%p",
+            uws_deflate, payload, (unsigned int)size, decompressed, decompressed_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+#ifdef USE_WS_DEFLATE
+        size_t used_size = 0;
+        int inflate_result;
+
+        if ((uws_deflate->message_decompressed_size == 0) &&
+            (uws_deflate->decompressed_size > MAX_KEPT_OUTPUT_BUFFER_SIZE))
+        {
+            /* Codes_SRS_UWS_DEFLATE_01_044: [ When a new message starts and the buffer holding the decompressed bytes is larger than 64 KB, it shall be freed, so that one large message does not keep its memory for the rest of the connection. ]*/
+            free(uws_deflate->decompressed);
+            uws_deflate->decompressed = NULL;
+            uws_deflate->decompressed_size = 0;
+        }
+
+        /* Codes_SRS_UWS_DEFLATE_01_034: [ `uws_deflate_decompress` shall decompress `payload` with `inflate` and `Z_SYNC_FLUSH` into a buffer owned by the instance, which is reused by subsequent calls. ]*/
+        /* Codes_SRS_UWS_DEFLATE_01_035: [ When `is_final` is true, the 0x00 0x00 0xFF 0xFF tail shall be inflated after `payload`. ]*/
+        inflate_result = inflate_bytes(uws_deflate, payload, size, &used_size);
+        if ((inflate_result == 0) && is_final)
+        {
+            inflate_result = inflate_bytes(uws_deflate, DEFLATE_TAIL, sizeof(DEFLATE_TAIL), &used_size);
+        }
+
+        if (inflate_result == UWS_DEFLATE_MESSAGE_TOO_BIG)
+        {
+            /* Codes_SRS_UWS_DEFLATE_01_042: [ If the bytes decompressed for the current message, across all the calls made for it, exceed `max_decompressed_message_size`, `uws_deflate_decompress` shall fail and return `UWS_DEFLATE_MESSAGE_TOO_BIG`. ]*/
+            /* Codes_SRS_UWS_DEFLATE_01_043: [ In that case the buffer holding the decompressed bytes shall be freed and the inflate stream shall be reset with `inflateReset`. ]*/
+            free(uws_deflate->decompressed);
+            uws_deflate->decompressed = NULL;
+            uws_deflate->decompressed_size = 0;
+            uws_deflate->message_decompressed_size = 0;
+            (void)inflateReset(&uws_deflate->inflate_stream);
+            result = UWS_DEFLATE_MESSAGE_TOO_BIG;
+        }
+        else if (inflate_result != 0)
+        {
+            /* Codes_SRS_UWS_DEFLATE_01_036: [ If growing the output buffer or `inflate` fails, `uws_deflate_decompress` shall fail and return a non-zero value. ]*/
+            result = __FAILURE__;
+        }
+        else
+        {
+            uws_deflate->message_decompressed_size = is_final ? 0 : (uws_deflate->message_decompressed_size + used_size);
+
+            if (is_final &&
+                uws_deflate->negotiated_options.server_no_context_takeover)
+            {
+                /* Codes_SRS_UWS_DEFLATE_01_037: [ When `is_final` is true and `server_no_context_takeover` was negotiated, the inflate stream shall be reset with `inflateReset`. ]*/
+                (void)inflateReset(&uws_deflate->inflate_stream);
+            }
+
+            /* Codes_SRS_UWS_DEFLATE_01_038: [ On success `uws_deflate_decompress` shall set `decompressed` and `decompressed_size` to the decompressed bytes and return 0. ]*/
+            *decompressed = uws_deflate->decompressed;
+            *decompressed_size = used_size;
+            result = 0;
+        }
+#else
+        (void)is_final;
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
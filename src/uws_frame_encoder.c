@@ -5,12 +5,326 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/gb_rand.h"
 #include "azure_c_shared_utility/uws_frame_encoder.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/uniqueid.h"
+#include "azure_c_shared_utility/optimize_size.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define UWS_FRAME_ENCODER_SSE2
+#define UWS_FRAME_ENCODER_AVX2
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define UWS_FRAME_ENCODER_SSE2
+#define UWS_FRAME_ENCODER_AVX2
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+/* payloads shorter than this are masked with the word-wise loop only, the vector setup is not worth it */
+#define VECTOR_MASK_MIN_LENGTH 64
+
+typedef void(*MASK_FUNCTION)(unsigned char* destination, const unsigned char* source, size_t length, const unsigned char* rotated_key);
+
+/* rotated_key always holds 32 bytes, with rotated_key[i] being the key byte that applies to destination[i] */
+static size_t mask_words(unsigned char* destination, const unsigned char* source, size_t length, const unsigned char* rotated_key)
+{
+    uint64_t key_word;
+    size_t i;
+
+    (void)memcpy(&key_word, rotated_key, sizeof(key_word));
+
+    for (i = 0; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+    {
+        uint64_t data_word;
+        (void)memcpy(&data_word, source + i, sizeof(data_word));
+        data_word ^= key_word;
+        (void)memcpy(destination + i, &data_word, sizeof(data_word));
+    }
+
+    return i;
+}
+
+#ifdef UWS_FRAME_ENCODER_SSE2
+static void mask_sse2(unsigned char* destination, const unsigned char* source, size_t length, const unsigned char* rotated_key)
+{
+    __m128i key_vector = _mm_loadu_si128((const __m128i*)rotated_key);
+    size_t i;
+
+    for (i = 0; i + 16 <= length; i += 16)
+    {
+        __m128i data_vector = _mm_loadu_si128((const __m128i*)(source + i));
+        _mm_storeu_si128((__m128i*)(destination + i), _mm_xor_si128(data_vector, key_vector));
+    }
+
+    i += mask_words(destination + i, source + i, length - i, rotated_key);
+    for (; i < length; i++)
+    {
+        destination[i] = source[i] ^ rotated_key[i % 4];
+    }
+}
+#endif
+
+#ifdef UWS_FRAME_ENCODER_AVX2
+#if defined(__GNUC__)
+__attribute__((target("avx2")))
+#endif
+static void mask_avx2(unsigned char* destination, const unsigned char* source, size_t length, const unsigned char* rotated_key)
+{
+    __m256i key_vector = _mm256_loadu_si256((const __m256i*)rotated_key);
+    size_t i;
+
+    for (i = 0; i + 32 <= length; i += 32)
+    {
+        __m256i data_vector = _mm256_loadu_si256((const __m256i*)(source + i));
+        _mm256_storeu_si256((__m256i*)(destination + i), _mm256_xor_si256(data_vector, key_vector));
+    }
+
+    i += mask_words(destination + i, source + i, length - i, rotated_key);
+    for (; i < length; i++)
+    {
+        destination[i] = source[i] ^ rotated_key[i % 4];
+    }
+}
+
+static int is_avx2_supported(void)
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? 1 : 0;
+#else
+    int result;
+    int cpu_info[4];
+
+    __cpuid(cpu_info, 0);
+    if (cpu_info[0] < 7)
+    {
+        result = 0;
+    }
+    else
+    {
+        __cpuid(cpu_info, 1);
+        /* AVX and OSXSAVE are needed, and the OS has to save the YMM state */
+        if (((cpu_info[2] & (1 << 27)) == 0) ||
+            ((cpu_info[2] & (1 << 28)) == 0) ||
+            ((_xgetbv(0) & 0x06) != 0x06))
+        {
+            result = 0;
+        }
+        else
+        {
+            __cpuidex(cpu_info, 7, 0);
+            result = ((cpu_info[1] & (1 << 5)) != 0) ? 1 : 0;
+        }
+    }
+
+    return result;
+#endif
+}
+#endif
+
+static MASK_FUNCTION get_vector_mask_function(void)
+{
+    /* the detection result is the same no matter which thread computes it, so a racy cache is fine */
+    static volatile int mask_function_index = -1;
+    MASK_FUNCTION result;
+
+    if (mask_function_index < 0)
+    {
+        int index = 0;
+#ifdef UWS_FRAME_ENCODER_SSE2
+        index = 1;
+#endif
+#ifdef UWS_FRAME_ENCODER_AVX2
+        if (is_avx2_supported())
+        {
+            index = 2;
+        }
+#endif
+        mask_function_index = index;
+    }
+
+    switch (mask_function_index)
+    {
+    default:
+        result = NULL;
+        break;
+#ifdef UWS_FRAME_ENCODER_SSE2
+    case 1:
+        result = mask_sse2;
+        break;
+#endif
+#ifdef UWS_FRAME_ENCODER_AVX2
+    case 2:
+        result = mask_avx2;
+        break;
+#endif
+    }
+
+    return result;
+}
+
+int uws_frame_encoder_mask(unsigned char* destination, const unsigned char* source, size_t length, const unsigned char* masking_key, size_t key_offset)
+{
+    int result;
+
+    if ((length > 0) &&
+        ((destination == NULL) || (source == NULL) || (masking_key == NULL)))
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_056: [ If `length` is greater than 0 and any of `destination`, `source` or `masking_key` is NULL, `uws_frame_encoder_mask` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: destination=%p, source=%p, masking_key=%p, length=%u",
+            destination, source, masking_key, (unsigned int)length);
+        result = __FAILURE__;
+    }
+    else
+    {
+        unsigned char rotated_key[32];
+        MASK_FUNCTION vector_mask_function;
+        size_t i;
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_058: [ The key byte applied to octet i of `source` shall be `masking_key[(key_offset + i) % 4]`, so that a payload can be (un)masked in several calls. ]*/
+        for (i = 0; i < sizeof(rotated_key); i++)
+        {
+            rotated_key[i] = masking_key[(key_offset + i) % 4];
+        }
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_059: [ `uws_frame_encoder_mask` shall XOR the data several bytes at a time (using SSE2 or AVX2 instructions when the CPU supports them, selected at runtime). ]*/
+        if ((length >= VECTOR_MASK_MIN_LENGTH) &&
+            ((vector_mask_function = get_vector_mask_function()) != NULL))
+        {
+            vector_mask_function(destination, source, length, rotated_key);
+        }
+        else
+        {
+            i = mask_words(destination, source, length, rotated_key);
+            for (; i < length; i++)
+            {
+                destination[i] = source[i] ^ rotated_key[i % 4];
+            }
+        }
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_055: [ `uws_frame_encoder_mask` shall (un)mask `length` bytes from `source` into `destination` using the 4 byte `masking_key`, as described in RFC6455 section 5.3. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_057: [ `destination` and `source` shall be allowed to be the same buffer (in place masking). ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_060: [ On success `uws_frame_encoder_mask` shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+static size_t get_header_length(size_t length, bool is_masked)
+{
+    size_t result = 2;
+
+    if (length > 65535)
+    {
+        result += 8;
+    }
+    else if (length > 125)
+    {
+        result += 2;
+    }
+
+    if (is_masked)
+    {
+        result += 4;
+    }
+
+    return result;
+}
+
+static int write_header(unsigned char* buffer, size_t header_length, WS_FRAME_TYPE opcode, size_t length, bool is_masked, bool is_final, unsigned char reserved)
+{
+    int result;
+
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_007: [ *  %x0 denotes a continuation frame ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_008: [ *  %x1 denotes a text frame ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_009: [ *  %x2 denotes a binary frame ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_010: [ *  %x3-7 are reserved for further non-control frames ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_011: [ *  %x8 denotes a connection close ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_012: [ *  %x9 denotes a ping ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_013: [ *  %xA denotes a pong ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_014: [ *  %xB-F are reserved for further control frames ]*/
+    buffer[0] = (unsigned char)opcode;
+
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_002: [ Indicates that this is the final fragment in a message. ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_003: [ The first fragment MAY also be the final fragment. ]*/
+    if (is_final)
+    {
+        buffer[0] |= 0x80;
+    }
+
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_004: [ MUST be 0 unless an extension is negotiated that defines meanings for non-zero values. ]*/
+    buffer[0] |= reserved << 4;
+
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_022: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_018: [ The length of the "Payload data", in bytes: ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_023: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_042: [ The payload length, indicated in the framing as frame-payload-length, does NOT include the length of the masking key. ]*/
+    if (length > 65535)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_020: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
+        buffer[1] = 127;
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_021: [ Multibyte length quantities are expressed in network byte order. ]*/
+        buffer[2] = (unsigned char)((uint64_t)length >> 56) & 0xFF;
+        buffer[3] = (unsigned char)((uint64_t)length >> 48) & 0xFF;
+        buffer[4] = (unsigned char)((uint64_t)length >> 40) & 0xFF;
+        buffer[5] = (unsigned char)((uint64_t)length >> 32) & 0xFF;
+        buffer[6] = (unsigned char)((uint64_t)length >> 24) & 0xFF;
+        buffer[7] = (unsigned char)((uint64_t)length >> 16) & 0xFF;
+        buffer[8] = (unsigned char)((uint64_t)length >> 8) & 0xFF;
+        buffer[9] = (unsigned char)(length & 0xFF);
+    }
+    else if (length > 125)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_019: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
+        buffer[1] = 126;
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_021: [ Multibyte length quantities are expressed in network byte order. ]*/
+        buffer[2] = (unsigned char)(length >> 8);
+        buffer[3] = (unsigned char)(length & 0xFF);
+    }
+    else
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_043: [ if 0-125, that is the payload length. ]*/
+        buffer[1] = (unsigned char)length;
+    }
+
+    if (is_masked)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_015: [ Defines whether the "Payload data" is masked. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_033: [ A masked frame MUST have the field frame-masked set to 1, as defined in Section 5.2. ]*/
+        buffer[1] |= 0x80;
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_069: [ In order to obtain a 32 bit value for masking, `gb_rand_bytes` shall be called to fill the 4 masking key bytes. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_016: [ If set to 1, a masking key is present in masking-key, and this is used to unmask the "Payload data" as per Section 5.3. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_026: [ This field is present if the mask bit is set to 1 and is absent if the mask bit is set to 0. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_034: [ The masking key is contained completely within the frame, as defined in Section 5.2 as frame-masking-key. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_036: [ The masking key is a 32-bit value chosen at random by the client. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_037: [ When preparing a masked frame, the client MUST pick a fresh masking key from the set of allowed 32-bit values. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_038: [ The masking key needs to be unpredictable; thus, the masking key MUST be derived from a strong source of entropy, and the masking key for a given frame MUST NOT make it simple for a server/proxy to predict the masking key for a subsequent frame. ]*/
+        if (gb_rand_bytes(buffer + header_length - 4, 4) != 0)
+        {
+            LogError("Cannot obtain masking key");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
 
 BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char* payload, size_t length, bool is_masked, bool is_final, unsigned char reserved)
 {
@@ -37,9 +351,6 @@ BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char
     }
     else
     {
-        size_t needed_bytes = 2;
-        size_t header_bytes;
-
         /* Codes_SRS_UWS_FRAME_ENCODER_01_044: [ On success `uws_frame_encoder_encode` shall return a non-NULL handle to the result buffer. ]*/
         /* Codes_SRS_UWS_FRAME_ENCODER_01_048: [ The newly created buffer shall be created by calling `BUFFER_new`. ]*/
         result = BUFFER_new();
@@ -51,22 +362,8 @@ BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char
         else
         {
             /* Codes_SRS_UWS_FRAME_ENCODER_01_001: [ `uws_frame_encoder_encode` shall encode the information given in `opcode`, `payload`, `length`, `is_masked`, `is_final` and `reserved` according to the RFC6455 into a new buffer.]*/
-            if (length > 65535)
-            {
-                needed_bytes += 8;
-            }
-            else if (length > 125)
-            {
-                needed_bytes += 2;
-            }
-
-            if (is_masked)
-            {
-                needed_bytes += 4;
-            }
-
-            header_bytes = needed_bytes;
-            needed_bytes += length;
+            size_t header_bytes = get_header_length(length, is_masked);
+            size_t needed_bytes = header_bytes + length;
 
             /* Codes_SRS_UWS_FRAME_ENCODER_01_046: [ The result buffer shall be resized accordingly using `BUFFER_enlarge`. ]*/
             if (BUFFER_enlarge(result, needed_bytes) != 0)
@@ -89,93 +386,23 @@ BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char
                 }
                 else
                 {
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_007: [ *  %x0 denotes a continuation frame ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_008: [ *  %x1 denotes a text frame ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_009: [ *  %x2 denotes a binary frame ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_010: [ *  %x3-7 are reserved for further non-control frames ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_011: [ *  %x8 denotes a connection close ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_012: [ *  %x9 denotes a ping ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_013: [ *  %xA denotes a pong ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_014: [ *  %xB-F are reserved for further control frames ]*/
-                    buffer[0] = (unsigned char)opcode;
-
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_002: [ Indicates that this is the final fragment in a message. ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_003: [ The first fragment MAY also be the final fragment. ]*/
-                    if (is_final)
-                    {
-                        buffer[0] |= 0x80;
-                    }
-
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_004: [ MUST be 0 unless an extension is negotiated that defines meanings for non-zero values. ]*/
-                    buffer[0] |= reserved << 4;
-
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_022: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_018: [ The length of the "Payload data", in bytes: ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_023: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_042: [ The payload length, indicated in the framing as frame-payload-length, does NOT include the length of the masking key. ]*/
-                    if (length > 65535)
-                    {
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_020: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
-                        buffer[1] = 127;
-
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_021: [ Multibyte length quantities are expressed in network byte order. ]*/
-                        buffer[2] = (unsigned char)((uint64_t)length >> 56) & 0xFF;
-                        buffer[3] = (unsigned char)((uint64_t)length >> 48) & 0xFF;
-                        buffer[4] = (unsigned char)((uint64_t)length >> 40) & 0xFF;
-                        buffer[5] = (unsigned char)((uint64_t)length >> 32) & 0xFF;
-                        buffer[6] = (unsigned char)((uint64_t)length >> 24) & 0xFF;
-                        buffer[7] = (unsigned char)((uint64_t)length >> 16) & 0xFF;
-                        buffer[8] = (unsigned char)((uint64_t)length >> 8) & 0xFF;
-                        buffer[9] = (unsigned char)(length & 0xFF);
-                    }
-                    else if (length > 125)
-                    {
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_019: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
-                        buffer[1] = 126;
-
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_021: [ Multibyte length quantities are expressed in network byte order. ]*/
-                        buffer[2] = (unsigned char)(length >> 8);
-                        buffer[3] = (unsigned char)(length & 0xFF);
-                    }
-                    else
+                    if (write_header(buffer, header_bytes, opcode, length, is_masked, is_final, reserved) != 0)
                     {
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_043: [ if 0-125, that is the payload length. ]*/
-                        buffer[1] = (unsigned char)length;
+                        /* Codes_SRS_UWS_FRAME_ENCODER_01_070: [ If `gb_rand_bytes` fails then `uws_frame_encoder_encode` shall fail and return NULL. ]*/
+                        LogError("Cannot encode frame header");
+                        BUFFER_delete(result);
+                        result = NULL;
                     }
-
-                    if (is_masked)
-                    {
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_015: [ Defines whether the "Payload data" is masked. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_033: [ A masked frame MUST have the field frame-masked set to 1, as defined in Section 5.2. ]*/
-                        buffer[1] |= 0x80;
-
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_053: [ In order to obtain a 32 bit value for masking, `gb_rand` shall be used 4 times (for each byte). ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_016: [ If set to 1, a masking key is present in masking-key, and this is used to unmask the "Payload data" as per Section 5.3. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_026: [ This field is present if the mask bit is set to 1 and is absent if the mask bit is set to 0. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_034: [ The masking key is contained completely within the frame, as defined in Section 5.2 as frame-masking-key. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_036: [ The masking key is a 32-bit value chosen at random by the client. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_037: [ When preparing a masked frame, the client MUST pick a fresh masking key from the set of allowed 32-bit values. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_038: [ The masking key needs to be unpredictable; thus, the masking key MUST be derived from a strong source of entropy, and the masking key for a given frame MUST NOT make it simple for a server/proxy to predict the masking key for a subsequent frame. ]*/
-                        buffer[header_bytes - 4] = (unsigned char)gb_rand();
-                        buffer[header_bytes - 3] = (unsigned char)gb_rand();
-                        buffer[header_bytes - 2] = (unsigned char)gb_rand();
-                        buffer[header_bytes - 1] = (unsigned char)gb_rand();
-                    }
-
-                    if (length > 0)
+                    else if (length > 0)
                     {
                         if (is_masked)
                         {
-                            size_t i;
-
                             /* Codes_SRS_UWS_FRAME_ENCODER_01_035: [ It is used to mask the "Payload data" defined in the same section as frame-payload-data, which includes "Extension data" and "Application data". ]*/
                             /* Codes_SRS_UWS_FRAME_ENCODER_01_039: [ To convert masked data into unmasked data, or vice versa, the following algorithm is applied. ]*/
                             /* Codes_SRS_UWS_FRAME_ENCODER_01_040: [ The same algorithm applies regardless of the direction of the translation, e.g., the same steps are applied to mask the data as to unmask the data. ]*/
-                            for (i = 0; i < length; i++)
-                            {
-                                /* Codes_SRS_UWS_FRAME_ENCODER_01_041: [ Octet i of the transformed data ("transformed-octet-i") is the XOR of octet i of the original data ("original-octet-i") with octet at index i modulo 4 of the masking key ("masking-key-octet-j"): ]*/
-                                buffer[header_bytes + i] = ((unsigned char*)payload)[i] ^ buffer[header_bytes - 4 + (i % 4)];
-                            }
+                            /* Codes_SRS_UWS_FRAME_ENCODER_01_041: [ Octet i of the transformed data ("transformed-octet-i") is the XOR of octet i of the original data ("original-octet-i") with octet at index i modulo 4 of the masking key ("masking-key-octet-j"): ]*/
+                            /* Codes_SRS_UWS_FRAME_ENCODER_01_061: [ `uws_frame_encoder_encode` shall mask the payload by calling `uws_frame_encoder_mask`. ]*/
+                            (void)uws_frame_encoder_mask(buffer + header_bytes, payload, length, buffer + header_bytes - 4, 0);
                         }
                         else
                         {
@@ -189,3 +416,57 @@ BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char
 
     return result;
 }
+
+int uws_frame_encoder_encode_header(unsigned char* header, size_t header_size, WS_FRAME_TYPE opcode, size_t length, bool is_masked, bool is_final, unsigned char reserved, size_t* header_length)
+{
+    int result;
+
+    if ((header == NULL) ||
+        (header_length == NULL))
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_063: [ If `header` or `header_length` is NULL, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: header=%p, header_length=%p", header, header_length);
+        result = __FAILURE__;
+    }
+    else if (reserved > 7)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_064: [ If `reserved` has any bits set except the lowest 3 then `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+        LogError("Bad reserved value: 0x%02x", reserved);
+        result = __FAILURE__;
+    }
+    else if (opcode > 0x0F)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_065: [ If `opcode` is greater than 0x0F, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+        LogError("Invalid opcode: 0x%02x", opcode);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t needed_bytes = get_header_length(length, is_masked);
+        if (header_size < needed_bytes)
+        {
+            /* Codes_SRS_UWS_FRAME_ENCODER_01_066: [ If `header_size` is smaller than the number of bytes needed for the header, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+            LogError("Header buffer too small: %u bytes, %u needed", (unsigned int)header_size, (unsigned int)needed_bytes);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_FRAME_ENCODER_01_062: [ `uws_frame_encoder_encode_header` shall encode only the frame header (at most `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes) for a payload of `length` bytes into `header`, following the same rules as `uws_frame_encoder_encode`. ]*/
+            /* Codes_SRS_UWS_FRAME_ENCODER_01_067: [ When `is_masked` is true, the masking key shall be placed in the last 4 bytes of the header, so that the caller can mask the payload with `uws_frame_encoder_mask`. ]*/
+            if (write_header(header, needed_bytes, opcode, length, is_masked, is_final, reserved) != 0)
+            {
+                /* Codes_SRS_UWS_FRAME_ENCODER_01_071: [ If `gb_rand_bytes` fails then `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+                LogError("Cannot encode frame header");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_FRAME_ENCODER_01_068: [ On success `uws_frame_encoder_encode_header` shall set `header_length` to the number of header bytes written and return 0. ]*/
+                *header_length = needed_bytes;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
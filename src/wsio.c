@@ -201,6 +201,8 @@ static int internal_close(WSIO_INSTANCE* wsio_instance, ON_IO_CLOSE_COMPLETE on_
     return result;
 }
 
+static void on_underlying_ws_fragment_received(void* context, unsigned char frame_type, const unsigned char* buffer, size_t size, bool is_first, bool is_final);
+
 CONCRETE_IO_HANDLE wsio_create(void* io_create_parameters)
 {
     /* Codes_SRS_WSIO_01_066: [ `io_create_parameters` shall be used as a `WSIO_CONFIG*` . ]*/
@@ -269,6 +271,17 @@ CONCRETE_IO_HANDLE wsio_create(void* io_create_parameters)
                     free(result);
                     result = NULL;
                 }
+                /* Codes_SRS_WSIO_01_192: [ `wsio_create` shall have the uws instance hand out received payload as it arrives by calling `uws_client_set_option` with `ws_on_fragment_received` set to a fragment handler and `ws_on_fragment_received_context` set to the new wsio instance. ]*/
+                else if ((uws_client_set_option(result->uws, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)on_underlying_ws_fragment_received) != 0) ||
+                    (uws_client_set_option(result->uws, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, result) != 0))
+                {
+                    /* Codes_SRS_WSIO_01_193: [ If setting either option fails then `wsio_create` shall fail and return NULL. ]*/
+                    LogError("Cannot set the fragment callback on the uws instance.");
+                    singlylinkedlist_destroy(result->pending_io_list);
+                    uws_client_destroy(result->uws);
+                    free(result);
+                    result = NULL;
+                }
                 else
                 {
                     result->io_state = IO_STATE_NOT_OPEN;
@@ -406,6 +419,15 @@ static void on_underlying_ws_frame_received(void* context, unsigned char frame_t
     }
 }
 
+static void on_underlying_ws_fragment_received(void* context, unsigned char frame_type, const unsigned char* buffer, size_t size, bool is_first, bool is_final)
+{
+    (void)is_first;
+    (void)is_final;
+
+    /* Codes_SRS_WSIO_01_194: [ When the fragment handler is called, the piece of payload shall be processed exactly as a received frame by `on_underlying_ws_frame_received`, as wsio exposes a byte stream without message boundaries. ]*/
+    on_underlying_ws_frame_received(context, frame_type, buffer, size);
+}
+
 static void on_underlying_ws_peer_closed(void* context, uint16_t* close_code, const unsigned char* extra_data, size_t extra_data_length)
 {
     /* Codes_SRS_WSIO_01_168: [ The `close_code`, `extra_data` and `extra_data_length` arguments shall be ignored. ]*/
@@ -603,7 +625,8 @@ int wsio_send(CONCRETE_IO_HANDLE ws_io, const void* buffer, size_t size, ON_SEND
                     /* Codes_SRS_WSIO_01_095: [ `wsio_send` shall call `uws_client_send_frame_async`, passing the `buffer` and `size` arguments as they are: ]*/
                     /* Codes_SRS_WSIO_01_097: [ The `is_final` argument shall be set to true. ]*/
                     /* Codes_SRS_WSIO_01_096: [ The frame type used shall be `WS_FRAME_TYPE_BINARY`. ]*/
-                    if (uws_client_send_frame_async(wsio_instance->uws, WS_FRAME_TYPE_BINARY, (const unsigned char*)buffer, size, true, on_underlying_ws_send_frame_complete, new_item) != 0)
+                    int send_result = uws_client_send_frame_async(wsio_instance->uws, WS_FRAME_TYPE_BINARY, (const unsigned char*)buffer, size, true, on_underlying_ws_send_frame_complete, new_item);
+                    if (send_result != 0)
                     {
                         if (singlylinkedlist_remove(wsio_instance->pending_io_list, new_item) != 0)
                         {
@@ -611,7 +634,9 @@ int wsio_send(CONCRETE_IO_HANDLE ws_io, const void* buffer, size_t size, ON_SEND
                         }
 
                         free(pending_socket_io);
-                        result = __FAILURE__;
+
+                        /* Codes_SRS_WSIO_01_191: [ If `uws_client_send_frame_async` returns `XIO_SEND_WOULD_BLOCK`, `wsio_send` shall remove the pending IO and return `XIO_SEND_WOULD_BLOCK`. ]*/
+                        result = (send_result == XIO_SEND_WOULD_BLOCK) ? XIO_SEND_WOULD_BLOCK : __FAILURE__;
                     }
                     else
                     {
@@ -804,6 +829,38 @@ OPTIONHANDLER_HANDLE wsio_retrieveoptions(CONCRETE_IO_HANDLE handle)
     return result;
 }
 
+int wsio_get_statistics(CONCRETE_IO_HANDLE ws_io, XIO_STATISTICS* statistics)
+{
+    int result;
+
+    if ((ws_io == NULL) ||
+        (statistics == NULL))
+    {
+        /* Codes_SRS_WSIO_01_187: [ If any of the arguments `ws_io` or `statistics` is NULL, `wsio_get_statistics` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: ws_io=%p, statistics=%p", ws_io, statistics);
+        result = __FAILURE__;
+    }
+    else
+    {
+        WSIO_INSTANCE* wsio_instance = (WSIO_INSTANCE*)ws_io;
+
+        /* Codes_SRS_WSIO_01_188: [ `wsio_get_statistics` shall obtain the statistics by calling `uws_client_get_statistics`. ]*/
+        if (uws_client_get_statistics(wsio_instance->uws, statistics) != 0)
+        {
+            /* Codes_SRS_WSIO_01_189: [ If `uws_client_get_statistics` fails, `wsio_get_statistics` shall fail and return a non-zero value. ]*/
+            LogError("uws_client_get_statistics failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_WSIO_01_190: [ On success, `wsio_get_statistics` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 static const IO_INTERFACE_DESCRIPTION ws_io_interface_description =
 {
     wsio_retrieveoptions,
@@ -813,7 +870,9 @@ static const IO_INTERFACE_DESCRIPTION ws_io_interface_description =
     wsio_close,
     wsio_send,
     wsio_dowork,
-    wsio_setoption
+    wsio_setoption,
+    NULL,
+    wsio_get_statistics
 };
 
 const IO_INTERFACE_DESCRIPTION* wsio_get_interface_description(void)
@@ -1,15 +1,38 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/x509_openssl.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
 #include "openssl/bio.h"
 #include "openssl/rsa.h"
 #include "openssl/x509.h"
 #include "openssl/pem.h"
 #include "openssl/err.h"
 
+/* a PEM string interned by x509_openssl_pem_acquire, with the objects parsed from it on first use */
+typedef struct PEM_CACHE_ENTRY_TAG
+{
+    char* pem;
+    size_t pem_length;
+    size_t hash;
+    size_t ref_count;
+    bool is_certificates_parsed;
+    X509** certificates;
+    size_t certificate_count;
+    bool is_private_key_parsed;
+    EVP_PKEY* private_key;
+    struct PEM_CACHE_ENTRY_TAG* next;
+} PEM_CACHE_ENTRY;
+
+static LOCK_HANDLE pem_cache_lock = NULL;
+static PEM_CACHE_ENTRY* pem_cache = NULL;
+
 void log_ERR_get_error(const char* message)
 {
     char buf[128];
@@ -30,14 +53,366 @@ void log_ERR_get_error(const char* message)
     }
 }
 
+static bool lock_pem_cache(void)
+{
+    bool result;
+
+    if ((pem_cache_lock != NULL) && (Lock(pem_cache_lock) != LOCK_OK))
+    {
+        LogError("Failed acquiring the PEM cache lock.");
+        result = false;
+    }
+    else
+    {
+        result = true;
+    }
+
+    return result;
+}
+
+static void unlock_pem_cache(void)
+{
+    if (pem_cache_lock != NULL)
+    {
+        (void)Unlock(pem_cache_lock);
+    }
+}
+
+/* FNV-1a */
+static size_t get_pem_hash(const char* pem, size_t pem_length)
+{
+    size_t result = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < pem_length; i++)
+    {
+        result = (result ^ (unsigned char)pem[i]) * 16777619u;
+    }
+
+    return result;
+}
+
+/* must be called with the cache lock held */
+static PEM_CACHE_ENTRY* find_pem_cache_entry(const char* pem)
+{
+    PEM_CACHE_ENTRY* result;
+
+    for (result = pem_cache; result != NULL; result = result->next)
+    {
+        if (result->pem == pem)
+        {
+            break;
+        }
+    }
+
+    if ((result == NULL) && (pem_cache != NULL))
+    {
+        size_t pem_length = strlen(pem);
+        size_t hash = get_pem_hash(pem, pem_length);
+
+        for (result = pem_cache; result != NULL; result = result->next)
+        {
+            if ((result->hash == hash) &&
+                (result->pem_length == pem_length) &&
+                (memcmp(result->pem, pem, pem_length) == 0))
+            {
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void destroy_pem_cache_entry(PEM_CACHE_ENTRY* entry)
+{
+    size_t i;
+
+    for (i = 0; i < entry->certificate_count; i++)
+    {
+        X509_free(entry->certificates[i]);
+    }
+
+    free(entry->certificates);
+
+    if (entry->private_key != NULL)
+    {
+        EVP_PKEY_free(entry->private_key);
+    }
+
+    free(entry->pem);
+    free(entry);
+}
+
+/* must be called with the cache lock held */
+static void release_pem_cache_entry_locked(PEM_CACHE_ENTRY* entry)
+{
+    entry->ref_count--;
+
+    if (entry->ref_count == 0)
+    {
+        PEM_CACHE_ENTRY** entry_link;
+
+        for (entry_link = &pem_cache; *entry_link != NULL; entry_link = &(*entry_link)->next)
+        {
+            if (*entry_link == entry)
+            {
+                *entry_link = entry->next;
+                break;
+            }
+        }
+
+        destroy_pem_cache_entry(entry);
+    }
+}
+
+/* returns NULL when pem was never interned, in which case the caller parses it directly */
+static PEM_CACHE_ENTRY* reference_pem_cache_entry(const char* pem)
+{
+    PEM_CACHE_ENTRY* result;
+
+    if (!lock_pem_cache())
+    {
+        result = NULL;
+    }
+    else
+    {
+        if ((result = find_pem_cache_entry(pem)) != NULL)
+        {
+            result->ref_count++;
+        }
+
+        unlock_pem_cache();
+    }
+
+    return result;
+}
+
+static void release_pem_cache_entry(PEM_CACHE_ENTRY* entry)
+{
+    if (lock_pem_cache())
+    {
+        release_pem_cache_entry_locked(entry);
+        unlock_pem_cache();
+    }
+}
+
+static void add_ref_certificate(X509* certificate)
+{
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || defined(LIBRESSL_VERSION_NUMBER)
+    (void)CRYPTO_add(&certificate->references, 1, CRYPTO_LOCK_X509);
+#else
+    (void)X509_up_ref(certificate);
+#endif
+}
+
+/* must be called with the cache lock held, a failed parse is remembered and not retried */
+static void parse_pem_cache_certificates(PEM_CACHE_ENTRY* entry)
+{
+    if (!entry->is_certificates_parsed)
+    {
+        BIO* bio_cert = BIO_new_mem_buf(entry->pem, (int)entry->pem_length);
+
+        entry->is_certificates_parsed = true;
+
+        if (bio_cert == NULL)
+        {
+            log_ERR_get_error("cannot create BIO");
+        }
+        else
+        {
+            X509* certificate = PEM_read_bio_X509_AUX(bio_cert, NULL, NULL, NULL);
+
+            while (certificate != NULL)
+            {
+                X509** new_certificates = (X509**)realloc(entry->certificates, (entry->certificate_count + 1) * sizeof(X509*));
+                if (new_certificates == NULL)
+                {
+                    LogError("Failed allocating the parsed certificates.");
+                    X509_free(certificate);
+                    break;
+                }
+                else
+                {
+                    entry->certificates = new_certificates;
+                    entry->certificates[entry->certificate_count++] = certificate;
+                    certificate = PEM_read_bio_X509(bio_cert, NULL, NULL, NULL);
+                }
+            }
+
+            // The read loop usually ends on EOF.
+            ERR_clear_error();
+            BIO_free(bio_cert);
+        }
+    }
+}
+
+/* must be called with the cache lock held, a failed parse is remembered and not retried */
+static void parse_pem_cache_private_key(PEM_CACHE_ENTRY* entry)
+{
+    if (!entry->is_private_key_parsed)
+    {
+        BIO* bio_key = BIO_new_mem_buf(entry->pem, (int)entry->pem_length);
+
+        entry->is_private_key_parsed = true;
+
+        if (bio_key == NULL)
+        {
+            log_ERR_get_error("cannot create BIO");
+        }
+        else
+        {
+            if ((entry->private_key = PEM_read_bio_PrivateKey(bio_key, NULL, NULL, NULL)) == NULL)
+            {
+                log_ERR_get_error("Failed PEM_read_bio_PrivateKey");
+            }
+
+            BIO_free(bio_key);
+        }
+    }
+}
+
+static void clear_extra_chain_certs(SSL_CTX* ssl_ctx)
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
+    SSL_CTX_clear_extra_chain_certs(ssl_ctx);
+#else 
+    if (ssl_ctx->extra_certs != NULL)
+    {
+        sk_X509_pop_free(ssl_ctx->extra_certs, X509_free); 
+        ssl_ctx->extra_certs = NULL; 
+    }
+#endif 
+}
+
+static int use_cached_certificate_chain(SSL_CTX* ssl_ctx, PEM_CACHE_ENTRY* entry)
+{
+    int result;
+
+    if (!lock_pem_cache())
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        parse_pem_cache_certificates(entry);
+
+        if (entry->certificate_count == 0)
+        {
+            LogError("no certificate could be parsed");
+            result = __FAILURE__;
+        }
+        else if (SSL_CTX_use_certificate(ssl_ctx, entry->certificates[0]) != 1)
+        {
+            log_ERR_get_error("Failure SSL_CTX_use_certificate");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t i;
+
+            result = 0;
+            clear_extra_chain_certs(ssl_ctx);
+
+            for (i = 1; i < entry->certificate_count; i++)
+            {
+                /* the SSL context takes ownership of the chain certificates */
+                add_ref_certificate(entry->certificates[i]);
+                if (SSL_CTX_add_extra_chain_cert(ssl_ctx, entry->certificates[i]) != 1)
+                {
+                    X509_free(entry->certificates[i]);
+                    log_ERR_get_error("Failure SSL_CTX_add_extra_chain_cert");
+                    result = __FAILURE__;
+                    break;
+                }
+            }
+        }
+
+        unlock_pem_cache();
+    }
+
+    return result;
+}
+
+static int use_cached_private_key(SSL_CTX* ssl_ctx, PEM_CACHE_ENTRY* entry)
+{
+    int result;
+
+    if (!lock_pem_cache())
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        parse_pem_cache_private_key(entry);
+
+        if (entry->private_key == NULL)
+        {
+            LogError("no private key could be parsed");
+            result = __FAILURE__;
+        }
+        else if (SSL_CTX_use_PrivateKey(ssl_ctx, entry->private_key) != 1)
+        {
+            log_ERR_get_error("Failed SSL_CTX_use_PrivateKey");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        unlock_pem_cache();
+    }
+
+    return result;
+}
+
+static int add_cached_certificates(X509_STORE* cert_store, PEM_CACHE_ENTRY* entry)
+{
+    int result;
+
+    if (!lock_pem_cache())
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        parse_pem_cache_certificates(entry);
+
+        result = 0;
+        for (i = 0; i < entry->certificate_count; i++)
+        {
+            /* X509_STORE_add_cert takes its own reference */
+            if (!X509_STORE_add_cert(cert_store, entry->certificates[i]) &&
+                (ERR_GET_REASON(ERR_peek_error()) != X509_R_CERT_ALREADY_IN_HASH_TABLE))
+            {
+                log_ERR_get_error("failure in X509_STORE_add_cert");
+                result = __FAILURE__;
+                break;
+            }
+        }
+
+        unlock_pem_cache();
+    }
+
+    return result;
+}
+
 static int load_certificate_chain(SSL_CTX* ssl_ctx, const char* ecc_cert)
 {
     int result;
     BIO* bio_cert;
     X509* x509_value;
+    PEM_CACHE_ENTRY* cache_entry;
 
-    bio_cert = BIO_new_mem_buf((char*)ecc_cert, -1);
-    if (bio_cert == NULL)
+    if ((cache_entry = reference_pem_cache_entry(ecc_cert)) != NULL)
+    {
+        result = use_cached_certificate_chain(ssl_ctx, cache_entry);
+        release_pem_cache_entry(cache_entry);
+    }
+    else if ((bio_cert = BIO_new_mem_buf((char*)ecc_cert, -1)) == NULL)
     {
         log_ERR_get_error("cannot create BIO");
         result = __FAILURE__;
@@ -67,15 +442,7 @@ static int load_certificate_chain(SSL_CTX* ssl_ctx, const char* ecc_cert)
                 // certificates.
                 
                 /* Codes_SRS_X509_OPENSSL_07_006: [ If successful x509_openssl_add_ecc_credentials shall to import each certificate in the cert chain. ] */
-#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
-                SSL_CTX_clear_extra_chain_certs(ssl_ctx);
-#else 
-                if (ssl_ctx->extra_certs != NULL)
-                {
-                    sk_X509_pop_free(ssl_ctx->extra_certs, X509_free); 
-                    ssl_ctx->extra_certs = NULL; 
-                }
-#endif 
+                clear_extra_chain_certs(ssl_ctx);
                 while ((ca_chain = PEM_read_bio_X509(bio_cert, NULL, NULL, NULL)) != NULL)
                 {
                     if (SSL_CTX_add_extra_chain_cert(ssl_ctx, ca_chain) != 1)
@@ -113,9 +480,16 @@ static int load_alias_key_cert(SSL_CTX* ssl_ctx, const char* ecc_alias_key)
     int result;
     BIO* bio_certificate;
     EVP_PKEY* pkey = NULL;
+    PEM_CACHE_ENTRY* cache_entry;
+
+    if ((cache_entry = reference_pem_cache_entry(ecc_alias_key)) != NULL)
+    {
+        /* Codes_SRS_X509_OPENSSL_07_008: [ If the key was interned by x509_openssl_pem_acquire, x509_openssl_add_ecc_credentials shall use the EVP_PKEY parsed on first use instead of parsing the key again. ] */
+        result = use_cached_private_key(ssl_ctx, cache_entry);
+        release_pem_cache_entry(cache_entry);
+    }
     /* Codes_SRS_X509_OPENSSL_07_002: [ x509_openssl_add_ecc_credentials shall get the memory BIO method function. ] */
-    bio_certificate = BIO_new_mem_buf((char*)ecc_alias_key, -1); 
-    if (bio_certificate == NULL)
+    else if ((bio_certificate = BIO_new_mem_buf((char*)ecc_alias_key, -1)) == NULL)
     {
         log_ERR_get_error("Failed BIO_new_mem_buf");
         result = __FAILURE__;
@@ -154,9 +528,16 @@ static int load_private_key_RSA(SSL_CTX* ssl_ctx, const char* x509privatekey)
 {
     int result;
     BIO *bio_privatekey;
+    PEM_CACHE_ENTRY* cache_entry;
+
+    if ((cache_entry = reference_pem_cache_entry(x509privatekey)) != NULL)
+    {
+        /*Codes_SRS_X509_OPENSSL_02_021: [ If the private key was interned by x509_openssl_pem_acquire, x509_openssl_add_credentials shall use the EVP_PKEY parsed on first use instead of parsing the key again. ]*/
+        result = use_cached_private_key(ssl_ctx, cache_entry);
+        release_pem_cache_entry(cache_entry);
+    }
     /*Codes_SRS_X509_OPENSSL_02_004: [ x509_openssl_add_credentials shall use BIO_new_mem_buf to create a memory BIO from the x509 privatekey. ]*/
-    bio_privatekey = BIO_new_mem_buf((char*)x509privatekey, -1); /*taking off the const from the pointer is needed on older versions of OPENSSL*/
-    if (bio_privatekey == NULL)
+    else if ((bio_privatekey = BIO_new_mem_buf((char*)x509privatekey, -1)) == NULL) /*taking off the const from the pointer is needed on older versions of OPENSSL*/
     {
         /*Codes_SRS_X509_OPENSSL_02_009: [ Otherwise x509_openssl_add_credentials shall fail and return a non-zero number. ]*/
         log_ERR_get_error("cannot create BIO *bio_privatekey;");
@@ -277,12 +658,20 @@ int x509_openssl_add_certificates(SSL_CTX* ssl_ctx, const char* certificates)
     else
     {
         X509_STORE* cert_store = SSL_CTX_get_cert_store(ssl_ctx);
+        PEM_CACHE_ENTRY* cache_entry;
+
         if (cert_store == NULL)
         {
             /*Codes_SRS_X509_OPENSSL_02_018: [ In case of any failure x509_openssl_add_certificates shall fail and return a non-zero value. ]*/
             log_ERR_get_error("failure in SSL_CTX_get_cert_store.");
             result = __FAILURE__;
         }
+        else if ((cache_entry = reference_pem_cache_entry(certificates)) != NULL)
+        {
+            /*Codes_SRS_X509_OPENSSL_02_020: [ If certificates was interned by x509_openssl_pem_acquire, x509_openssl_add_certificates shall add the certificates parsed on first use instead of parsing them again. ]*/
+            result = add_cached_certificates(cert_store, cache_entry);
+            release_pem_cache_entry(cache_entry);
+        }
         else
         {
             /*Codes_SRS_X509_OPENSSL_02_012: [ x509_openssl_add_certificates shall get the memory BIO method function by calling BIO_s_mem. ]*/
@@ -368,3 +757,125 @@ int x509_openssl_add_certificates(SSL_CTX* ssl_ctx, const char* certificates)
 
 }
 
+
+int x509_openssl_init(void)
+{
+    int result;
+
+    /*Codes_SRS_X509_OPENSSL_02_022: [ x509_openssl_init shall create the lock that guards the PEM cache. ]*/
+    if ((pem_cache_lock == NULL) &&
+        ((pem_cache_lock = Lock_Init()) == NULL))
+    {
+        /*Codes_SRS_X509_OPENSSL_02_023: [ If creating the lock fails, x509_openssl_init shall fail and return a non-zero value. ]*/
+        LogError("Failed creating the PEM cache lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+void x509_openssl_deinit(void)
+{
+    /*Codes_SRS_X509_OPENSSL_02_024: [ x509_openssl_deinit shall destroy the PEM cache lock. Entries still referenced stay valid until released. ]*/
+    if (pem_cache_lock != NULL)
+    {
+        (void)Lock_Deinit(pem_cache_lock);
+        pem_cache_lock = NULL;
+    }
+}
+
+const char* x509_openssl_pem_acquire(const char* pem)
+{
+    const char* result;
+
+    if (pem == NULL)
+    {
+        /*Codes_SRS_X509_OPENSSL_02_025: [ If pem is NULL then x509_openssl_pem_acquire shall fail and return NULL. ]*/
+        LogError("invalid argument const char* pem=NULL");
+        result = NULL;
+    }
+    else if (!lock_pem_cache())
+    {
+        result = NULL;
+    }
+    else
+    {
+        PEM_CACHE_ENTRY* entry = find_pem_cache_entry(pem);
+
+        if (entry != NULL)
+        {
+            /*Codes_SRS_X509_OPENSSL_02_026: [ If a string with the same content is already interned, x509_openssl_pem_acquire shall add a reference to it and return it. ]*/
+            entry->ref_count++;
+            result = entry->pem;
+        }
+        /*Codes_SRS_X509_OPENSSL_02_027: [ Otherwise x509_openssl_pem_acquire shall intern a copy of pem, keyed by a hash of its content, with a reference count of 1 and return the copy. ]*/
+        else if ((entry = (PEM_CACHE_ENTRY*)malloc(sizeof(PEM_CACHE_ENTRY))) == NULL)
+        {
+            /*Codes_SRS_X509_OPENSSL_02_028: [ If any failure occurs, x509_openssl_pem_acquire shall return NULL. ]*/
+            LogError("Failed allocating the PEM cache entry.");
+            result = NULL;
+        }
+        else
+        {
+            (void)memset(entry, 0, sizeof(PEM_CACHE_ENTRY));
+            entry->pem_length = strlen(pem);
+
+            if ((entry->pem = (char*)malloc(entry->pem_length + 1)) == NULL)
+            {
+                /*Codes_SRS_X509_OPENSSL_02_028: [ If any failure occurs, x509_openssl_pem_acquire shall return NULL. ]*/
+                LogError("Failed allocating the PEM copy.");
+                free(entry);
+                result = NULL;
+            }
+            else
+            {
+                (void)memcpy(entry->pem, pem, entry->pem_length + 1);
+                entry->hash = get_pem_hash(pem, entry->pem_length);
+                entry->ref_count = 1;
+                entry->next = pem_cache;
+                pem_cache = entry;
+                result = entry->pem;
+            }
+        }
+
+        unlock_pem_cache();
+    }
+
+    return result;
+}
+
+void x509_openssl_pem_release(const char* pem)
+{
+    if (pem == NULL)
+    {
+        /*Codes_SRS_X509_OPENSSL_02_029: [ If pem is NULL then x509_openssl_pem_release shall return. ]*/
+    }
+    else if (lock_pem_cache())
+    {
+        PEM_CACHE_ENTRY* entry;
+
+        for (entry = pem_cache; entry != NULL; entry = entry->next)
+        {
+            if (entry->pem == pem)
+            {
+                break;
+            }
+        }
+
+        if (entry == NULL)
+        {
+            LogError("pem=%p was not returned by x509_openssl_pem_acquire", pem);
+        }
+        else
+        {
+            /*Codes_SRS_X509_OPENSSL_02_030: [ x509_openssl_pem_release shall drop a reference, and free the string and the objects parsed from it when the last reference is released. ]*/
+            release_pem_cache_entry_locked(entry);
+        }
+
+        unlock_pem_cache();
+    }
+}
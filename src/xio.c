@@ -21,7 +21,7 @@ XIO_HANDLE xio_create(const IO_INTERFACE_DESCRIPTION* io_interface_description,
     XIO_INSTANCE* xio_instance;
     /* Codes_SRS_XIO_01_003: [If the argument io_interface_description is NULL, xio_create shall return NULL.] */
     if ((io_interface_description == NULL) ||
-        /* Codes_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+        /* Codes_SRS_XIO_01_004: [If any io_interface_description member other than the optional concrete_io_send_constbuffer and concrete_io_get_statistics is NULL, xio_create shall return NULL.] */
         (io_interface_description->concrete_io_retrieveoptions == NULL) ||
         (io_interface_description->concrete_io_create == NULL) ||
         (io_interface_description->concrete_io_destroy == NULL) ||
@@ -148,12 +148,45 @@ int xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE o
         /* Codes_SRS_XIO_01_009: [On success, xio_send shall return 0.] */
         /* Codes_SRS_XIO_01_015: [If the underlying concrete_io_send fails, xio_send shall return a non-zero value.] */
         /* Codes_SRS_XIO_01_027: [xio_send shall pass to the concrete_io_send function the on_send_complete and callback_context arguments.] */
+        /* Codes_SRS_XIO_01_038: [If concrete_io_send returns XIO_SEND_WOULD_BLOCK, xio_send shall return XIO_SEND_WOULD_BLOCK.] */
         result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, buffer, size, on_send_complete, callback_context);
     }
 
     return result;
 }
 
+int xio_send_constbuffer(XIO_HANDLE xio, CONSTBUFFER_HANDLE buffer, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    /* Codes_SRS_XIO_01_028: [If xio or buffer is NULL, xio_send_constbuffer shall return a non-zero value.] */
+    if ((xio == NULL) ||
+        (buffer == NULL))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        if (xio_instance->io_interface_description->concrete_io_send_constbuffer != NULL)
+        {
+            /* Codes_SRS_XIO_01_029: [If the concrete IO implements concrete_io_send_constbuffer, xio_send_constbuffer shall call it, passing down the buffer, on_send_complete and callback_context arguments.] */
+            /* Codes_SRS_XIO_01_031: [On success, xio_send_constbuffer shall return 0.] */
+            /* Codes_SRS_XIO_01_032: [If the underlying send fails, xio_send_constbuffer shall return a non-zero value.] */
+            result = xio_instance->io_interface_description->concrete_io_send_constbuffer(xio_instance->concrete_xio_handle, buffer, on_send_complete, callback_context);
+        }
+        else
+        {
+            /* Codes_SRS_XIO_01_030: [Otherwise xio_send_constbuffer shall obtain the buffer content by calling CONSTBUFFER_GetContent and pass it to concrete_io_send.] */
+            const CONSTBUFFER* content = CONSTBUFFER_GetContent(buffer);
+            result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, content->buffer, content->size, on_send_complete, callback_context);
+        }
+    }
+
+    return result;
+}
+
 void xio_dowork(XIO_HANDLE xio)
 {
     /* Codes_SRS_XIO_01_018: [When the handle argument is NULL, xio_dowork shall do nothing.] */
@@ -301,3 +334,35 @@ OPTIONHANDLER_HANDLE xio_retrieveoptions(XIO_HANDLE xio)
     return result;
 }
 
+int xio_get_statistics(XIO_HANDLE xio, XIO_STATISTICS* statistics)
+{
+    int result;
+
+    /* Codes_SRS_XIO_01_033: [If xio or statistics is NULL, xio_get_statistics shall fail and return a non-zero value.] */
+    if ((xio == NULL) ||
+        (statistics == NULL))
+    {
+        LogError("invalid argument detected: XIO_HANDLE xio=%p, XIO_STATISTICS* statistics=%p", xio, statistics);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        /* Codes_SRS_XIO_01_034: [If the concrete IO does not implement concrete_io_get_statistics, xio_get_statistics shall fail and return a non-zero value.] */
+        if (xio_instance->io_interface_description->concrete_io_get_statistics == NULL)
+        {
+            LogError("the concrete IO does not keep statistics");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_01_035: [Otherwise xio_get_statistics shall call concrete_io_get_statistics, passing down the statistics argument.] */
+            /* Codes_SRS_XIO_01_036: [On success, xio_get_statistics shall return 0.] */
+            /* Codes_SRS_XIO_01_037: [If concrete_io_get_statistics fails, xio_get_statistics shall return a non-zero value.] */
+            result = xio_instance->io_interface_description->concrete_io_get_statistics(xio_instance->concrete_xio_handle, statistics);
+        }
+    }
+
+    return result;
+}
@@ -594,6 +594,97 @@ BEGIN_TEST_SUITE(constbuffer_unittests)
         ///cleanup
     }
 
+    /*Tests_SRS_CONSTBUFFER_01_001: [If source is NULL and size is different than 0 then CONSTBUFFER_CreateWithMoveMemory shall fail and return NULL.]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateWithMoveMemory_with_invalid_args_fails)
+    {
+        ///arrange
+
+        ///act
+        CONSTBUFFER_HANDLE handle = CONSTBUFFER_CreateWithMoveMemory(NULL, 1);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_CONSTBUFFER_01_002: [Otherwise, CONSTBUFFER_CreateWithMoveMemory shall take ownership of the memory area pointed to by source, without copying it.]*/
+    /*Tests_SRS_CONSTBUFFER_01_003: [Otherwise CONSTBUFFER_CreateWithMoveMemory shall return a non-NULL handle.]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateWithMoveMemory_succeeds)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE handle;
+        const CONSTBUFFER* content;
+        unsigned char* source = (unsigned char*)malloc(BUFFER1_length);
+        (void)memcpy(source, BUFFER1_u_char, BUFFER1_length);
+        umock_c_reset_all_calls();
+
+        /*this is the handle*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        handle = CONSTBUFFER_CreateWithMoveMemory(source, BUFFER1_length);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(handle);
+        content = CONSTBUFFER_GetContent(handle);
+        ASSERT_ARE_EQUAL(size_t, BUFFER1_length, content->size);
+        /*testing that it is a pointer assignment and not a copy*/
+        ASSERT_ARE_EQUAL(void_ptr, source, content->buffer);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CONSTBUFFER_Destroy(handle);
+    }
+
+    /*Tests_SRS_CONSTBUFFER_01_005: [If any error occurs, CONSTBUFFER_CreateWithMoveMemory shall fail and return NULL.]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateWithMoveMemory_fails_when_malloc_fails)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE handle;
+        unsigned char* source = (unsigned char*)malloc(BUFFER1_length);
+        umock_c_reset_all_calls();
+
+        whenShallmalloc_fail = 1;
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        handle = CONSTBUFFER_CreateWithMoveMemory(source, BUFFER1_length);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        free(source);
+    }
+
+    /*Tests_SRS_CONSTBUFFER_01_004: [The non-NULL handle returned by CONSTBUFFER_CreateWithMoveMemory shall have its ref count set to "1".]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateWithMoveMemory_is_ref_counted_1)
+    {
+        ///arrange
+        unsigned char* source = (unsigned char*)malloc(BUFFER1_length);
+        CONSTBUFFER_HANDLE handle = CONSTBUFFER_CreateWithMoveMemory(source, BUFFER1_length);
+        umock_c_reset_all_calls();
+
+        /*this is the content*/
+        STRICT_EXPECTED_CALL(gballoc_free(source));
+        /*this is the handle*/
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        CONSTBUFFER_Destroy(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+    }
+
     /*Tests_SRS_CONSTBUFFER_02_015: [If constbufferHandle is NULL then CONSTBUFFER_Destroy shall do nothing.]*/
     TEST_FUNCTION(CONSTBUFFER_Destroy_with_NULL_argument_does_nothing)
     {
@@ -0,0 +1,478 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// getaddrinfo_a is a GNU extension
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "dns_async.h"
+
+/**
+ * The gballoc.h will replace the malloc, free, and realloc by the my_gballoc functions, in this case,
+ *    if you define these mock functions after include the gballoc.h, you will create an infinity recursion,
+ *    so, places the my_gballoc functions before the #include "azure_c_shared_utility/gballoc.h"
+ */
+void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "socket_async_os.h"
+#include "azure_c_shared_utility/gballoc.h"
+
+MOCKABLE_FUNCTION(, int, getaddrinfo_a, int, mode, struct gaicb**, list, int, ent, struct sigevent*, sig);
+MOCKABLE_FUNCTION(, int, gai_error, struct gaicb*, req);
+MOCKABLE_FUNCTION(, int, gai_cancel, struct gaicb*, req);
+MOCKABLE_FUNCTION(, int, gai_suspend, const struct gaicb* const*, list, int, ent, const struct timespec*, timeout);
+
+#undef ENABLE_MOCKS
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
+#include "umock_c_negative_tests.h"
+#include "azure_c_shared_utility/macro_utils.h"
+
+#define FAKE_GOOD_IP_ADDR 444
+
+static struct sockaddr_in fake_good_addr;
+static struct addrinfo fake_addrinfo;
+static struct sockaddr_in6 fake_good_addr6;
+static struct addrinfo fake_addrinfo6;
+
+// The request handed to getaddrinfo_a and the state the resolver thread would report for it
+static struct gaicb* g_request;
+static int g_lookup_state;
+static int g_cancel_result;
+static size_t g_freeaddrinfo_count;
+static struct addrinfo* g_freed_addrinfo;
+
+void freeaddrinfo(struct addrinfo* ai)
+{
+    g_freeaddrinfo_count++;
+    g_freed_addrinfo = ai;
+}
+
+// An IPv6 address followed by an IPv4 one, as returned for a dual-stack host
+static void complete_lookup(int lookup_result)
+{
+    g_lookup_state = lookup_result;
+    if (lookup_result == 0)
+    {
+        fake_good_addr.sin_family = AF_INET;
+        fake_good_addr.sin_addr.s_addr = FAKE_GOOD_IP_ADDR;
+        fake_addrinfo.ai_next = NULL;
+        fake_addrinfo.ai_family = AF_INET;
+        fake_addrinfo.ai_addr = (struct sockaddr*)&fake_good_addr;
+        fake_addrinfo.ai_addrlen = sizeof(fake_good_addr);
+
+        fake_good_addr6.sin6_family = AF_INET6;
+        fake_good_addr6.sin6_addr.s6_addr[15] = 1;
+        fake_addrinfo6.ai_next = &fake_addrinfo;
+        fake_addrinfo6.ai_family = AF_INET6;
+        fake_addrinfo6.ai_addr = (struct sockaddr*)&fake_good_addr6;
+        fake_addrinfo6.ai_addrlen = sizeof(fake_good_addr6);
+
+        g_request->ar_result = &fake_addrinfo6;
+    }
+}
+
+static int my_getaddrinfo_a(int mode, struct gaicb** list, int ent, struct sigevent* sig)
+{
+    (void)mode;
+    (void)ent;
+    (void)sig;
+    g_request = list[0];
+    g_lookup_state = EAI_INPROGRESS;
+    return 0;
+}
+
+static int my_gai_error(struct gaicb* req)
+{
+    (void)req;
+    return g_lookup_state;
+}
+
+static int my_gai_cancel(struct gaicb* req)
+{
+    (void)req;
+    if (g_cancel_result == EAI_CANCELED)
+    {
+        g_lookup_state = EAI_CANCELED;
+    }
+    else if (g_cancel_result == EAI_ALLDONE)
+    {
+        complete_lookup(0);
+    }
+    return g_cancel_result;
+}
+
+// The lookup that could not be cancelled finishes while the caller waits for it
+static int my_gai_suspend(const struct gaicb* const* list, int ent, const struct timespec* timeout)
+{
+    (void)list;
+    (void)ent;
+    (void)timeout;
+    complete_lookup(0);
+    return 0;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static DNS_ASYNC_HANDLE create_started_lookup(bool dual_stack)
+{
+    DNS_ASYNC_OPTIONS options;
+    DNS_ASYNC_HANDLE result;
+    options.dual_stack = dual_stack;
+    result = dns_async_create("fake.com", &options);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_FALSE(dns_async_is_lookup_complete(result));
+    umock_c_reset_all_calls();
+    return result;
+}
+
+BEGIN_TEST_SUITE(dns_async_getaddrinfo_a_ut)
+
+    TEST_SUITE_INITIALIZE(a)
+    {
+        int result;
+        TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+        g_testByTest = TEST_MUTEX_CREATE();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+
+        (void)umock_c_init(on_umock_c_error);
+
+        result = umocktypes_charptr_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+        result = umocktypes_bool_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+        result = umocktypes_stdint_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+
+        REGISTER_UMOCK_ALIAS_TYPE(struct gaicb**, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(struct gaicb*, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(struct sigevent*, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(const struct gaicb* const*, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(const struct timespec*, void*);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+        REGISTER_GLOBAL_MOCK_HOOK(getaddrinfo_a, my_getaddrinfo_a);
+        REGISTER_GLOBAL_MOCK_HOOK(gai_error, my_gai_error);
+        REGISTER_GLOBAL_MOCK_HOOK(gai_cancel, my_gai_cancel);
+        REGISTER_GLOBAL_MOCK_HOOK(gai_suspend, my_gai_suspend);
+    }
+
+    TEST_SUITE_CLEANUP(TestClassCleanup)
+    {
+        umock_c_deinit();
+
+        TEST_MUTEX_DESTROY(g_testByTest);
+        TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    }
+
+    TEST_FUNCTION_INITIALIZE(initialize)
+    {
+        if (TEST_MUTEX_ACQUIRE(g_testByTest))
+        {
+            ASSERT_FAIL("Could not acquire test serialization mutex.");
+        }
+
+        umock_c_reset_all_calls();
+
+        g_request = NULL;
+        g_lookup_state = EAI_INPROGRESS;
+        g_cancel_result = EAI_CANCELED;
+        g_freeaddrinfo_count = 0;
+        g_freed_addrinfo = NULL;
+    }
+
+    TEST_FUNCTION_CLEANUP(cleans)
+    {
+        TEST_MUTEX_RELEASE(g_testByTest);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_030: [ The first call to dns_async_is_lookup_complete shall start the lookup by calling getaddrinfo_a in GAI_NOWAIT mode and return false. ]*/
+    /* Tests_SRS_DNS_ASYNC_01_001: [ If options is NULL or options->dual_stack is false, only IPv4 addresses shall be looked up. ]*/
+    TEST_FUNCTION(dns_async__first_is_complete_starts_getaddrinfo_a__succeeds)
+    {
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(getaddrinfo_a(GAI_NOWAIT, IGNORED_PTR_ARG, 1, NULL));
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_FALSE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_NOT_NULL(g_request);
+        ASSERT_ARE_EQUAL(char_ptr, "fake.com", g_request->ar_name);
+        ASSERT_ARE_EQUAL(int, AF_INET, g_request->ar_request->ai_family);
+        ASSERT_ARE_EQUAL(int, SOCK_STREAM, g_request->ar_request->ai_socktype);
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_002: [ If options->dual_stack is true, both IPv4 and IPv6 addresses shall be looked up. ]*/
+    TEST_FUNCTION(dns_async__dual_stack_lookup_asks_for_any_family__succeeds)
+    {
+        ///arrange
+        DNS_ASYNC_OPTIONS options;
+        DNS_ASYNC_HANDLE dns;
+        options.dual_stack = true;
+        dns = dns_async_create("fake.com", &options);
+
+        ///act
+        (void)dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(g_request);
+        ASSERT_ARE_EQUAL(int, AF_UNSPEC, g_request->ar_request->ai_family);
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_031: [ If getaddrinfo_a fails, dns_async_is_lookup_complete shall return true and the lookup shall be considered failed. ]*/
+    TEST_FUNCTION(dns_async__getaddrinfo_a_fails__fails)
+    {
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(getaddrinfo_a(GAI_NOWAIT, IGNORED_PTR_ARG, 1, NULL)).SetReturn(EAI_AGAIN);
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_TRUE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 0, dns_async_get_address_count(dns));
+        ASSERT_ARE_EQUAL(uint32_t, 0, dns_async_get_ipv4(dns));
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_032: [ The following calls shall return false as long as gai_error returns EAI_INPROGRESS. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_023: [ If the DNS lookup process is not yet complete, dns_async_is_create_complete shall return false. ]*/
+    TEST_FUNCTION(dns_async__is_complete_while_in_progress_polls_gai_error__succeeds)
+    {
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = create_started_lookup(false);
+        STRICT_EXPECTED_CALL(gai_error(g_request));
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_FALSE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 0, dns_async_get_address_count(dns));
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_033: [ Once gai_error returns 0 the addresses shall be extracted from the result, which shall then be freed with freeaddrinfo. ]*/
+    /* Tests_SRS_DNS_ASYNC_01_004: [ The addresses shall alternate between address families, starting with the family of the first address returned by the resolver. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_022: [ If the DNS lookup process has completed, dns_async_is_create_complete shall return true. ]*/
+    TEST_FUNCTION(dns_async__is_complete_after_the_lookup_succeeded_returns_the_addresses__succeeds)
+    {
+        ///arrange
+        bool result;
+        size_t address_length = 0;
+        DNS_ASYNC_HANDLE dns = create_started_lookup(true);
+        complete_lookup(0);
+        STRICT_EXPECTED_CALL(gai_error(g_request));
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_TRUE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 1, g_freeaddrinfo_count);
+        ASSERT_ARE_EQUAL(void_ptr, &fake_addrinfo6, g_freed_addrinfo);
+        ASSERT_ARE_EQUAL(size_t, 2, dns_async_get_address_count(dns));
+        ASSERT_ARE_EQUAL(int, AF_INET6, dns_async_get_address(dns, 0, &address_length)->sa_family);
+        ASSERT_ARE_EQUAL(size_t, sizeof(struct sockaddr_in6), address_length);
+        ASSERT_ARE_EQUAL(int, AF_INET, dns_async_get_address(dns, 1, &address_length)->sa_family);
+        ASSERT_ARE_EQUAL(size_t, sizeof(struct sockaddr_in), address_length);
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, dns_async_get_ipv4(dns));
+
+        ///cleanup
+        umock_c_reset_all_calls();
+        dns_async_destroy(dns);
+        ASSERT_ARE_EQUAL(size_t, 1, g_freeaddrinfo_count);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_024: [ If dns_async_is_create_complete has previously returned true, dns_async_is_create_complete shall do nothing and return true. ]*/
+    TEST_FUNCTION(dns_async__is_complete_repeated_call_after_completion__succeeds)
+    {
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = create_started_lookup(false);
+        complete_lookup(0);
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns));
+        umock_c_reset_all_calls();
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_TRUE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_034: [ Once gai_error returns any other value the lookup shall be considered failed. ]*/
+    TEST_FUNCTION(dns_async__is_complete_after_the_lookup_failed__fails)
+    {
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = create_started_lookup(false);
+        complete_lookup(EAI_NONAME);
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_TRUE(result);
+        ASSERT_ARE_EQUAL(size_t, 0, g_freeaddrinfo_count);
+        ASSERT_ARE_EQUAL(size_t, 0, dns_async_get_address_count(dns));
+        ASSERT_ARE_EQUAL(uint32_t, 0, dns_async_get_ipv4(dns));
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_035: [ When built with DNS_ASYNC_USE_GETADDRINFO_A, a lookup still running shall be cancelled with gai_cancel. If it cannot be cancelled, dns_async_destroy shall wait for it with gai_suspend and free its result before deleting the DNS_ASYNC_HANDLE. ]*/
+    TEST_FUNCTION(dns_async__destroy_while_in_progress_cancels_the_lookup__succeeds)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns = create_started_lookup(false);
+        struct gaicb* request = g_request;
+        STRICT_EXPECTED_CALL(gai_cancel(request));
+        STRICT_EXPECTED_CALL(gai_error(request));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        dns_async_destroy(dns);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 0, g_freeaddrinfo_count);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_035: [ When built with DNS_ASYNC_USE_GETADDRINFO_A, a lookup still running shall be cancelled with gai_cancel. If it cannot be cancelled, dns_async_destroy shall wait for it with gai_suspend and free its result before deleting the DNS_ASYNC_HANDLE. ]*/
+    TEST_FUNCTION(dns_async__destroy_while_in_progress_waits_for_a_lookup_that_cannot_be_cancelled__succeeds)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns = create_started_lookup(false);
+        struct gaicb* request = g_request;
+        g_cancel_result = EAI_NOTCANCELED;
+        STRICT_EXPECTED_CALL(gai_cancel(request));
+        STRICT_EXPECTED_CALL(gai_error(request));
+        STRICT_EXPECTED_CALL(gai_suspend(IGNORED_PTR_ARG, 1, NULL));
+        STRICT_EXPECTED_CALL(gai_error(request));
+        STRICT_EXPECTED_CALL(gai_error(request));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        dns_async_destroy(dns);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 1, g_freeaddrinfo_count);
+        ASSERT_ARE_EQUAL(void_ptr, &fake_addrinfo6, g_freed_addrinfo);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_035: [ When built with DNS_ASYNC_USE_GETADDRINFO_A, a lookup still running shall be cancelled with gai_cancel. If it cannot be cancelled, dns_async_destroy shall wait for it with gai_suspend and free its result before deleting the DNS_ASYNC_HANDLE. ]*/
+    TEST_FUNCTION(dns_async__destroy_frees_the_result_of_a_lookup_that_completed_before_the_cancel__succeeds)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns = create_started_lookup(false);
+        g_cancel_result = EAI_ALLDONE;
+
+        ///act
+        dns_async_destroy(dns);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 1, g_freeaddrinfo_count);
+        ASSERT_ARE_EQUAL(void_ptr, &fake_addrinfo6, g_freed_addrinfo);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_051: [ dns_async_destroy shall delete all acquired resources and delete the DNS_ASYNC_HANDLE. ]*/
+    TEST_FUNCTION(dns_async__destroy_after_completion_does_not_cancel__succeeds)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns = create_started_lookup(false);
+        complete_lookup(0);
+        ASSERT_IS_TRUE(dns_async_is_lookup_complete(dns));
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        dns_async_destroy(dns);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 1, g_freeaddrinfo_count);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_30_051: [ dns_async_destroy shall delete all acquired resources and delete the DNS_ASYNC_HANDLE. ]*/
+    TEST_FUNCTION(dns_async__destroy_before_the_lookup_started_does_not_cancel__succeeds)
+    {
+        ///arrange
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        dns_async_destroy(dns);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+END_TEST_SUITE(dns_async_getaddrinfo_a_ut)
@@ -80,11 +80,35 @@ int my_getaddrinfo(const char *node, const char *service, const struct addrinfo
     fake_addrinfo.ai_next = NULL;
     fake_addrinfo.ai_family = AF_INET;
     fake_addrinfo.ai_addr = (struct sockaddr*)(&fake_good_addr);
+    fake_addrinfo.ai_addrlen = sizeof(fake_good_addr);
+    ((struct sockaddr_in *) fake_addrinfo.ai_addr)->sin_family = AF_INET;
     ((struct sockaddr_in *) fake_addrinfo.ai_addr)->sin_addr.s_addr = FAKE_GOOD_IP_ADDR;
     *res = &fake_addrinfo;
     return 0;
 }
 
+struct sockaddr_in6 fake_good_addr6[2];
+struct addrinfo fake_addrinfo6[2];
+
+// Two IPv6 addresses followed by the IPv4 one, as returned for a dual-stack host
+int my_getaddrinfo_dual_stack(const char *node, const char *service, const struct addrinfo *hints, struct addrinfo **res)
+{
+    size_t i;
+    (void)my_getaddrinfo(node, service, hints, res);
+    for (i = 0; i < 2; i++)
+    {
+        fake_good_addr6[i].sin6_family = AF_INET6;
+        fake_good_addr6[i].sin6_addr.s6_addr[15] = (unsigned char)(i + 1);
+        fake_addrinfo6[i].ai_family = AF_INET6;
+        fake_addrinfo6[i].ai_addr = (struct sockaddr*)(&fake_good_addr6[i]);
+        fake_addrinfo6[i].ai_addrlen = sizeof(fake_good_addr6[i]);
+    }
+    fake_addrinfo6[0].ai_next = &fake_addrinfo6[1];
+    fake_addrinfo6[1].ai_next = &fake_addrinfo;
+    *res = &fake_addrinfo6[0];
+    return 0;
+}
+
 /**
  * Include the test tools.
  */
@@ -296,6 +320,92 @@ BEGIN_TEST_SUITE(dns_async_ut)
         dns_async_destroy(dns);
     }
 
+    /* Tests_SRS_DNS_ASYNC_01_001: [ If options is NULL or options->dual_stack is false, only IPv4 addresses shall be looked up. ]*/
+    /* Tests_SRS_DNS_ASYNC_01_012: [ Otherwise dns_async_get_address_count shall return the number of addresses found, at most DNS_ASYNC_MAX_ADDRESSES. ]*/
+    /* Tests_SRS_DNS_ASYNC_01_022: [ Otherwise dns_async_get_address shall return the address at position index and set address_length to its length. ]*/
+    TEST_FUNCTION(dns_async__get_address__succeeds)
+    {
+        ///arrange
+        bool result;
+        size_t count;
+        size_t address_length = 0;
+        const struct sockaddr* address;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        result = dns_async_is_lookup_complete(dns);
+        ASSERT_IS_TRUE_WITH_MSG(result, "Unexpected non-completion");
+
+        ///act
+        count = dns_async_get_address_count(dns);
+        address = dns_async_get_address(dns, 0, &address_length);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 1, count);
+        ASSERT_IS_NOT_NULL(address);
+        ASSERT_ARE_EQUAL(size_t, sizeof(struct sockaddr_in), address_length);
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, ((const struct sockaddr_in*)address)->sin_addr.s_addr);
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_002: [ If options->dual_stack is true, both IPv4 and IPv6 addresses shall be looked up. ]*/
+    /* Tests_SRS_DNS_ASYNC_01_004: [ The addresses shall alternate between address families, starting with the family of the first address returned by the resolver. ]*/
+    TEST_FUNCTION(dns_async__dual_stack_addresses_are_interleaved__succeeds)
+    {
+        ///arrange
+        bool result;
+        size_t address_length = 0;
+        DNS_ASYNC_OPTIONS options;
+        DNS_ASYNC_HANDLE dns;
+        options.dual_stack = true;
+        dns = dns_async_create("fake.com", &options);
+        umock_c_reset_all_calls();
+        REGISTER_GLOBAL_MOCK_HOOK(getaddrinfo, my_getaddrinfo_dual_stack);
+        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        result = dns_async_is_lookup_complete(dns);
+        REGISTER_GLOBAL_MOCK_HOOK(getaddrinfo, my_getaddrinfo);
+        ASSERT_IS_TRUE_WITH_MSG(result, "Unexpected non-completion");
+
+        ///act
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 3, dns_async_get_address_count(dns));
+        ASSERT_ARE_EQUAL(int, AF_INET6, dns_async_get_address(dns, 0, &address_length)->sa_family);
+        ASSERT_ARE_EQUAL(int, AF_INET, dns_async_get_address(dns, 1, &address_length)->sa_family);
+        ASSERT_ARE_EQUAL(int, AF_INET6, dns_async_get_address(dns, 2, &address_length)->sa_family);
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, dns_async_get_ipv4(dns));
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_010: [ If the dns parameter is NULL, dns_async_get_address_count shall log an error and return 0. ]*/
+    /* Tests_SRS_DNS_ASYNC_01_011: [ If dns_async_is_lookup_complete has not yet returned true, dns_async_get_address_count shall log an error and return 0. ]*/
+    /* Tests_SRS_DNS_ASYNC_01_020: [ If the dns or address_length parameter is NULL, dns_async_get_address shall log an error and return NULL. ]*/
+    /* Tests_SRS_DNS_ASYNC_01_021: [ If the lookup is not complete or index is not lower than the address count, dns_async_get_address shall log an error and return NULL. ]*/
+    TEST_FUNCTION(dns_async__get_address_parameter_validation__fails)
+    {
+        ///arrange
+        size_t address_length = 0;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+
+        ///act
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, dns_async_get_address_count(NULL));
+        ASSERT_ARE_EQUAL(size_t, 0, dns_async_get_address_count(dns));
+        ASSERT_IS_NULL(dns_async_get_address(NULL, 0, &address_length));
+        ASSERT_IS_NULL(dns_async_get_address(dns, 0, NULL));
+        ASSERT_IS_NULL(dns_async_get_address(dns, 0, &address_length));
+
+        (void)dns_async_is_lookup_complete(dns);
+        ASSERT_IS_NULL(dns_async_get_address(dns, 1, &address_length));
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
     /* Tests_SRS_DNS_ASYNC_30_020: [ If the dns parameter is NULL, dns_async_is_create_complete shall log an error and return false. ]*/
     TEST_FUNCTION(dns_async__is_complete_parameter_validation__fails)
     {
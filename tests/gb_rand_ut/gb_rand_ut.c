@@ -0,0 +1,579 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// needed for syscall
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+// getrandom and open are reached through the variadic syscall and open below
+MOCKABLE_FUNCTION(, long, mock_getrandom, void*, buf, size_t, buflen, unsigned int, flags);
+MOCKABLE_FUNCTION(, int, mock_open, const char*, pathname, int, flags);
+MOCKABLE_FUNCTION(, ssize_t, read, int, fd, void*, buf, size_t, count);
+MOCKABLE_FUNCTION(, int, close, int, fd);
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gb_rand.h"
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
+#include "umock_c_negative_tests.h"
+#include "azure_c_shared_utility/macro_utils.h"
+
+#define TEST_BLOCK_SIZE     256
+#define TEST_SMALL_SIZE     16
+#define TEST_LARGE_SIZE     1000
+#define TEST_FD             0x42
+
+long syscall(long number, ...)
+{
+    long result;
+    va_list args;
+
+    va_start(args, number);
+    if (number == SYS_getrandom)
+    {
+        void* buf = va_arg(args, void*);
+        size_t buflen = va_arg(args, size_t);
+        unsigned int flags = va_arg(args, unsigned int);
+        result = mock_getrandom(buf, buflen, flags);
+    }
+    else
+    {
+        errno = ENOSYS;
+        result = -1;
+    }
+    va_end(args);
+
+    return result;
+}
+
+int open(const char* pathname, int flags, ...)
+{
+    return mock_open(pathname, flags);
+}
+
+// Every byte handed out by the fakes is the next value of this counter
+static unsigned char g_next_random_byte;
+static size_t g_getrandom_call_count;
+static size_t g_getrandom_max_bytes;
+static size_t g_getrandom_fail_count;
+static int g_getrandom_errno;
+static size_t g_read_max_bytes;
+static int g_read_errno;
+
+static void fill_random(unsigned char* buffer, size_t size)
+{
+    size_t i;
+    for (i = 0; i < size; i++)
+    {
+        buffer[i] = g_next_random_byte++;
+    }
+}
+
+static long my_mock_getrandom(void* buf, size_t buflen, unsigned int flags)
+{
+    long result;
+    (void)flags;
+
+    g_getrandom_call_count++;
+    if (g_getrandom_fail_count > 0)
+    {
+        g_getrandom_fail_count--;
+        errno = g_getrandom_errno;
+        result = -1;
+    }
+    else
+    {
+        size_t size = (buflen < g_getrandom_max_bytes) ? buflen : g_getrandom_max_bytes;
+        fill_random((unsigned char*)buf, size);
+        result = (long)size;
+    }
+
+    return result;
+}
+
+static int my_mock_open(const char* pathname, int flags)
+{
+    (void)pathname;
+    (void)flags;
+    return TEST_FD;
+}
+
+static ssize_t my_read(int fd, void* buf, size_t count)
+{
+    ssize_t result;
+    (void)fd;
+
+    if (g_read_errno != 0)
+    {
+        errno = g_read_errno;
+        result = -1;
+    }
+    else
+    {
+        size_t size = (count < g_read_max_bytes) ? count : g_read_max_bytes;
+        fill_random((unsigned char*)buf, size);
+        result = (ssize_t)size;
+    }
+
+    return result;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+// The block is per thread: each test body runs on a new thread, so it starts with an empty block.
+// The asserts stay on the test thread.
+#define TEST_MAX_CALLS      20
+
+typedef struct TEST_CALL_TAG
+{
+    size_t size;
+    int result;
+    unsigned char output[TEST_LARGE_SIZE];
+} TEST_CALL;
+
+static TEST_CALL g_calls[TEST_MAX_CALLS];
+static size_t g_call_count;
+static size_t g_parent_refill_count;
+static int g_child_status;
+
+static void call_gb_rand_bytes(size_t size)
+{
+    TEST_CALL* call = &g_calls[g_call_count++];
+    call->size = size;
+    call->result = gb_rand_bytes(call->output, size);
+}
+
+static void* run_calls(void* arg)
+{
+    const size_t* sizes = (const size_t*)arg;
+    size_t i;
+
+    for (i = 0; sizes[i] != 0; i++)
+    {
+        call_gb_rand_bytes(sizes[i]);
+    }
+
+    return NULL;
+}
+
+// sizes ends with 0
+static void run_on_new_thread(const size_t* sizes)
+{
+    pthread_t thread;
+    ASSERT_ARE_EQUAL(int, 0, pthread_create(&thread, NULL, run_calls, (void*)sizes));
+    ASSERT_ARE_EQUAL(int, 0, pthread_join(thread, NULL));
+}
+
+static void* fill_block_and_fork(void* arg)
+{
+    pid_t child;
+    (void)arg;
+
+    call_gb_rand_bytes(TEST_SMALL_SIZE);
+
+    child = fork();
+    if (child == 0)
+    {
+        // the child must get its bytes from a refill, not from the block it inherited
+        size_t getrandom_call_count = g_getrandom_call_count;
+        unsigned char output[TEST_SMALL_SIZE];
+        int result = gb_rand_bytes(output, sizeof(output));
+        _exit(((result == 0) && (g_getrandom_call_count == getrandom_call_count + 1)) ? 0 : 1);
+    }
+    else if (child > 0)
+    {
+        size_t getrandom_call_count = g_getrandom_call_count;
+        call_gb_rand_bytes(TEST_SMALL_SIZE);
+        g_parent_refill_count = g_getrandom_call_count - getrandom_call_count;
+
+        if (waitpid(child, &g_child_status, 0) != child)
+        {
+            g_child_status = -1;
+        }
+    }
+    else
+    {
+        g_child_status = -1;
+    }
+
+    return NULL;
+}
+
+BEGIN_TEST_SUITE(gb_rand_ut)
+
+    TEST_SUITE_INITIALIZE(a)
+    {
+        int result;
+        TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+        g_testByTest = TEST_MUTEX_CREATE();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+
+        (void)umock_c_init(on_umock_c_error);
+
+        result = umocktypes_charptr_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+        result = umocktypes_bool_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+        result = umocktypes_stdint_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+
+        REGISTER_UMOCK_ALIAS_TYPE(ssize_t, long);
+
+        REGISTER_GLOBAL_MOCK_HOOK(mock_getrandom, my_mock_getrandom);
+        REGISTER_GLOBAL_MOCK_HOOK(mock_open, my_mock_open);
+        REGISTER_GLOBAL_MOCK_HOOK(read, my_read);
+        REGISTER_GLOBAL_MOCK_RETURN(close, 0);
+    }
+
+    TEST_SUITE_CLEANUP(TestClassCleanup)
+    {
+        umock_c_deinit();
+
+        TEST_MUTEX_DESTROY(g_testByTest);
+        TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    }
+
+    TEST_FUNCTION_INITIALIZE(initialize)
+    {
+        if (TEST_MUTEX_ACQUIRE(g_testByTest))
+        {
+            ASSERT_FAIL("Could not acquire test serialization mutex.");
+        }
+
+        umock_c_reset_all_calls();
+
+        (void)memset(g_calls, 0, sizeof(g_calls));
+        g_call_count = 0;
+        g_next_random_byte = 0;
+        g_getrandom_call_count = 0;
+        g_getrandom_max_bytes = SIZE_MAX;
+        g_getrandom_fail_count = 0;
+        g_getrandom_errno = ENOSYS;
+        g_read_max_bytes = SIZE_MAX;
+        g_read_errno = 0;
+        g_parent_refill_count = 0;
+        g_child_status = -1;
+    }
+
+    TEST_FUNCTION_CLEANUP(cleans)
+    {
+        TEST_MUTEX_RELEASE(g_testByTest);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_with_NULL_buffer_fails)
+    {
+        ///act
+        int result = gb_rand_bytes(NULL, TEST_SMALL_SIZE);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_fills_the_block_from_getrandom)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_SMALL_SIZE, 0 };
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, g_calls[0].result);
+        ASSERT_ARE_EQUAL(int, 0, (int)g_calls[0].output[0]);
+        ASSERT_ARE_EQUAL(int, TEST_SMALL_SIZE - 1, (int)g_calls[0].output[TEST_SMALL_SIZE - 1]);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_serves_from_the_block_until_it_is_used_up)
+    {
+        ///arrange
+        size_t sizes[TEST_BLOCK_SIZE / TEST_SMALL_SIZE + 2];
+        size_t i;
+
+        for (i = 0; i < TEST_BLOCK_SIZE / TEST_SMALL_SIZE + 1; i++)
+        {
+            sizes[i] = TEST_SMALL_SIZE;
+        }
+        sizes[i] = 0;
+
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        for (i = 0; i < TEST_BLOCK_SIZE / TEST_SMALL_SIZE; i++)
+        {
+            ASSERT_ARE_EQUAL(int, 0, g_calls[i].result);
+            ASSERT_ARE_EQUAL(int, (int)(i * TEST_SMALL_SIZE), (int)g_calls[i].output[0]);
+        }
+        ASSERT_ARE_EQUAL(int, 0, g_calls[i].result);
+        ASSERT_ARE_EQUAL(int, 0, (int)g_calls[i].output[0]);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_refills_when_the_rest_of_the_block_is_too_small)
+    {
+        ///arrange
+        size_t sizes[] = { 60, 60, 60, 60, 20, 0 };
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, g_calls[4].result);
+        ASSERT_ARE_EQUAL(int, 0, (int)g_calls[4].output[0]);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_large_request_does_not_go_through_the_block)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_LARGE_SIZE, TEST_SMALL_SIZE, 0 };
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_LARGE_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, g_calls[0].result);
+        ASSERT_ARE_EQUAL(int, 0, (int)g_calls[0].output[0]);
+        ASSERT_ARE_EQUAL(int, (TEST_LARGE_SIZE - 1) % 256, (int)g_calls[0].output[TEST_LARGE_SIZE - 1]);
+        ASSERT_ARE_EQUAL(int, 0, g_calls[1].result);
+        ASSERT_ARE_EQUAL(int, TEST_LARGE_SIZE % 256, (int)g_calls[1].output[0]);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_large_request_continues_short_getrandom_reads)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_LARGE_SIZE, 0 };
+        g_getrandom_max_bytes = 256;
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_LARGE_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_LARGE_SIZE - 256, 0));
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_LARGE_SIZE - 512, 0));
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_LARGE_SIZE - 768, 0));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, g_calls[0].result);
+        ASSERT_ARE_EQUAL(int, (TEST_LARGE_SIZE - 1) % 256, (int)g_calls[0].output[TEST_LARGE_SIZE - 1]);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_retries_an_interrupted_getrandom)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_SMALL_SIZE, 0 };
+        g_getrandom_fail_count = 1;
+        g_getrandom_errno = EINTR;
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, g_calls[0].result);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_falls_back_to_dev_urandom_when_getrandom_fails)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_SMALL_SIZE, TEST_SMALL_SIZE, 0 };
+        g_getrandom_fail_count = 1;
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_open("/dev/urandom", O_RDONLY));
+        STRICT_EXPECTED_CALL(read(TEST_FD, IGNORED_PTR_ARG, TEST_BLOCK_SIZE));
+        STRICT_EXPECTED_CALL(close(TEST_FD));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, g_calls[0].result);
+        ASSERT_ARE_EQUAL(int, 0, (int)g_calls[0].output[0]);
+        ASSERT_ARE_EQUAL(int, 0, g_calls[1].result);
+        ASSERT_ARE_EQUAL(int, TEST_SMALL_SIZE, (int)g_calls[1].output[0]);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_reads_the_rest_from_dev_urandom_after_a_partial_getrandom)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_SMALL_SIZE, 0 };
+        g_getrandom_max_bytes = 100;
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0))
+            .SetReturn(100);
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE - 100, 0))
+            .SetReturn(-1);
+        STRICT_EXPECTED_CALL(mock_open("/dev/urandom", O_RDONLY));
+        STRICT_EXPECTED_CALL(read(TEST_FD, IGNORED_PTR_ARG, TEST_BLOCK_SIZE - 100));
+        STRICT_EXPECTED_CALL(close(TEST_FD));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, g_calls[0].result);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_continues_short_dev_urandom_reads)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_SMALL_SIZE, 0 };
+        g_getrandom_fail_count = 1;
+        g_read_max_bytes = 100;
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_open("/dev/urandom", O_RDONLY));
+        STRICT_EXPECTED_CALL(read(TEST_FD, IGNORED_PTR_ARG, TEST_BLOCK_SIZE));
+        STRICT_EXPECTED_CALL(read(TEST_FD, IGNORED_PTR_ARG, TEST_BLOCK_SIZE - 100));
+        STRICT_EXPECTED_CALL(read(TEST_FD, IGNORED_PTR_ARG, TEST_BLOCK_SIZE - 200));
+        STRICT_EXPECTED_CALL(close(TEST_FD));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, g_calls[0].result);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_fails_when_dev_urandom_cannot_be_opened)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_SMALL_SIZE, 0 };
+        g_getrandom_fail_count = 1;
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_open("/dev/urandom", O_RDONLY))
+            .SetReturn(-1);
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_NOT_EQUAL(int, 0, g_calls[0].result);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_fails_and_closes_when_reading_dev_urandom_fails)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_SMALL_SIZE, 0 };
+        g_getrandom_fail_count = 1;
+        g_read_errno = EIO;
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_open("/dev/urandom", O_RDONLY));
+        STRICT_EXPECTED_CALL(read(TEST_FD, IGNORED_PTR_ARG, TEST_BLOCK_SIZE));
+        STRICT_EXPECTED_CALL(close(TEST_FD));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_NOT_EQUAL(int, 0, g_calls[0].result);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_fails_and_closes_at_the_end_of_dev_urandom)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_SMALL_SIZE, 0 };
+        g_getrandom_fail_count = 1;
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_open("/dev/urandom", O_RDONLY));
+        STRICT_EXPECTED_CALL(read(TEST_FD, IGNORED_PTR_ARG, TEST_BLOCK_SIZE))
+            .SetReturn(0);
+        STRICT_EXPECTED_CALL(close(TEST_FD));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_NOT_EQUAL(int, 0, g_calls[0].result);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_retries_the_refill_after_a_failed_one)
+    {
+        ///arrange
+        size_t sizes[] = { TEST_SMALL_SIZE, TEST_SMALL_SIZE, 0 };
+        g_getrandom_fail_count = 1;
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+        STRICT_EXPECTED_CALL(mock_open("/dev/urandom", O_RDONLY))
+            .SetReturn(-1);
+        STRICT_EXPECTED_CALL(mock_getrandom(IGNORED_PTR_ARG, TEST_BLOCK_SIZE, 0));
+
+        ///act
+        run_on_new_thread(sizes);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_NOT_EQUAL(int, 0, g_calls[0].result);
+        ASSERT_ARE_EQUAL(int, 0, g_calls[1].result);
+        ASSERT_ARE_EQUAL(int, 0, (int)g_calls[1].output[0]);
+    }
+
+    TEST_FUNCTION(gb_rand_bytes_in_a_forked_child_does_not_reuse_the_parent_block)
+    {
+        ///arrange
+        pthread_t thread;
+
+        ///act
+        ASSERT_ARE_EQUAL(int, 0, pthread_create(&thread, NULL, fill_block_and_fork, NULL));
+        ASSERT_ARE_EQUAL(int, 0, pthread_join(thread, NULL));
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, g_calls[0].result);
+        ASSERT_ARE_EQUAL(int, 0, g_calls[1].result);
+        ASSERT_ARE_EQUAL(int, TEST_SMALL_SIZE, (int)g_calls[1].output[0]);
+        ASSERT_ARE_EQUAL(size_t, 0, g_parent_refill_count);
+        ASSERT_IS_TRUE(WIFEXITED(g_child_status));
+        ASSERT_ARE_EQUAL(int, 0, WEXITSTATUS(g_child_status));
+    }
+
+END_TEST_SUITE(gb_rand_ut)
@@ -4,9 +4,11 @@
 #ifdef __cplusplus
 #include <cstdlib>
 #include <cstddef>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #endif
 #include "testrunnerswitcher.h"
 #include "umock_c.h"
@@ -334,6 +336,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_STATISTICS*, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SOCKETIO_CONFIG*, const SOCKETIO_CONFIG*);
     REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
@@ -1358,6 +1361,35 @@ TEST_FUNCTION(when_xio_send_fails_http_proxy_io_send_also_fails)
     http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
 }
 
+/* Tests_SRS_HTTP_PROXY_IO_01_101: [ If `xio_send` returns `XIO_SEND_WOULD_BLOCK`, `http_proxy_io_send` shall return `XIO_SEND_WOULD_BLOCK`. ]*/
+TEST_FUNCTION(when_xio_send_would_block_http_proxy_io_send_returns_XIO_SEND_WOULD_BLOCK)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    int result;
+    unsigned char test_buffer[] = { 0x42 };
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    (void)http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_io_open_complete_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_buffer), NULL, (void*)0x4247))
+        .ValidateArgumentBuffer(2, test_buffer, sizeof(test_buffer))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_send(http_io, test_buffer, sizeof(test_buffer), NULL, (void*)0x4247);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, XIO_SEND_WOULD_BLOCK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
 /* http_proxy_io_dowork */
 
 /* Tests_SRS_HTTP_PROXY_IO_01_037: [ `http_proxy_io_dowork` shall call `xio_dowork` on the underlying IO created in `http_proxy_io_create`. ]*/
@@ -2592,6 +2624,39 @@ TEST_FUNCTION(three_extra_byte_get_indicated_as_received)
     http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
 }
 
+/* Tests_SRS_HTTP_PROXY_IO_01_102: [ The buffered bytes shall be parsed by calling `http_response_parser_parse`, so that only the bytes received since the previous call are scanned for the double new-line. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_072: [ Any bytes that are extra (not consumed by the CONNECT response), shall be indicated as received by calling the `on_bytes_received` callback and passing the `on_bytes_received_context` as context argument. ]*/
+TEST_FUNCTION(a_reply_split_across_the_double_new_line_indicates_OPEN_OK_and_the_extra_bytes)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    static const char connect_response_part_1[] = "HTTP/1.1 200 OK\r\nProxy-Agent: x\r";
+    static const char connect_response_part_2[] = "\n\r";
+    static const char connect_response_part_3[] = "\nAB";
+    static const unsigned char expected_bytes[] = { 'A', 'B' };
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&http_proxy_io_config_with_username);
+    (void)http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response_part_1, sizeof(connect_response_part_1) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response_part_2, sizeof(connect_response_part_2) - 1);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
+    STRICT_EXPECTED_CALL(test_on_bytes_received((void*)0x4243, IGNORED_PTR_ARG, sizeof(expected_bytes)))
+        .ValidateArgumentBuffer(2, expected_bytes, sizeof(expected_bytes));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response_part_3, sizeof(connect_response_part_3) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
 /* Tests_SRS_HTTP_PROXY_IO_01_074: [ If `on_underlying_io_bytes_received` is called while OPEN, all bytes shall be indicated as received by calling the `on_bytes_received` callback and passing the `on_bytes_received_context` as context argument. ]*/
 TEST_FUNCTION(bytes_indicated_as_received_in_OPEN_get_bubbled_up)
 {
@@ -2908,4 +2973,110 @@ TEST_FUNCTION(when_on_underlying_io_error_is_called_while_waiting_for_underlying
     http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
 }
 
+/* http_proxy_io_get_statistics */
+
+/* Tests_SRS_HTTP_PROXY_IO_01_096: [ If any of the arguments `http_proxy_io` or `statistics` is NULL, `http_proxy_io_get_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(http_proxy_io_get_statistics_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_get_statistics(NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_096: [ If any of the arguments `http_proxy_io` or `statistics` is NULL, `http_proxy_io_get_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(http_proxy_io_get_statistics_with_NULL_statistics_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE http_io;
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_get_statistics(http_io, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_097: [ `http_proxy_io_get_statistics` shall obtain the statistics of the underlying IO by calling `xio_get_statistics`. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_099: [ `bytes_sent` and `bytes_received` shall only count the bytes tunneled after the CONNECT request completed. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_100: [ On success, `http_proxy_io_get_statistics` shall return 0. ]*/
+TEST_FUNCTION(http_proxy_io_get_statistics_does_not_count_the_CONNECT_exchange)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+    XIO_STATISTICS underlying_statistics;
+    CONCRETE_IO_HANDLE http_io;
+    unsigned char send_payload[] = { 0x42, 0x43 };
+
+    (void)memset(&underlying_statistics, 0, sizeof(underlying_statistics));
+    underlying_statistics.bytes_sent = 1000;
+    underlying_statistics.would_block_count = 3;
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    (void)http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_io_open_complete_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    (void)http_proxy_io_get_interface_description()->concrete_io_send(http_io, send_payload, sizeof(send_payload), test_on_send_complete, (void*)0x4245);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_get_statistics(TEST_IO_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_statistics(&underlying_statistics, sizeof(underlying_statistics));
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_get_statistics(http_io, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(statistics.bytes_sent == sizeof(send_payload));
+    ASSERT_IS_TRUE(statistics.bytes_received == 0);
+    ASSERT_IS_TRUE(statistics.would_block_count == 3);
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_098: [ If `xio_get_statistics` fails, all the counters shall be reported as 0. ]*/
+TEST_FUNCTION(when_xio_get_statistics_fails_http_proxy_io_get_statistics_reports_zero_counters)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+    CONCRETE_IO_HANDLE http_io;
+
+    (void)memset(&statistics, 0xFF, sizeof(statistics));
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_get_statistics(TEST_IO_HANDLE, &statistics))
+        .SetReturn(1);
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_get_statistics(http_io, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(statistics.bytes_sent == 0);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.queued_bytes);
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
 END_TEST_SUITE(http_proxy_io_unittests)
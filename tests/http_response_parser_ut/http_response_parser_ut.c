@@ -0,0 +1,366 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "azure_c_shared_utility/http_response_parser.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+static const char test_response[] = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nsec-websocket-extensions:  permessage-deflate \t\r\n\r\nAB";
+
+static int parse_status_line(const char* line, int* status_code)
+{
+    return http_response_parser_parse_status_line(line, strlen(line), status_code);
+}
+
+static HTTP_RESPONSE_PARSER_RESULT parse_all(HTTP_RESPONSE_PARSER* parser, const char* response)
+{
+    http_response_parser_init(parser);
+    return http_response_parser_parse(parser, (const unsigned char*)response, strlen(response));
+}
+
+BEGIN_TEST_SUITE(http_response_parser_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* http_response_parser_parse */
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_002: [ `http_response_parser_init` shall reset `parser` so that it starts parsing a new response from the first byte of the buffer. ]*/
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_008: [ The first line shall be parsed as the status line by calling `http_response_parser_parse_status_line`. ]*/
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_010: [ When the empty line ending the head is found, `head_length` shall be set to the number of bytes of the head including that line and `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_COMPLETE`. ]*/
+TEST_FUNCTION(http_response_parser_parse_with_a_whole_response_completes)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    HTTP_RESPONSE_PARSER_RESULT result;
+
+    // act
+    result = parse_all(&parser, test_response);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_COMPLETE, (int)result);
+    ASSERT_ARE_EQUAL(int, 101, parser.status_code);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_response) - 3, parser.head_length);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_006: [ `buffer` shall hold all the bytes of the response received so far, and only the bytes after the ones scanned by previous calls shall be scanned. ]*/
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_007: [ If no complete CRLF terminated line is left in `buffer`, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_NEED_MORE_BYTES`. ]*/
+TEST_FUNCTION(http_response_parser_parse_with_1_more_byte_each_time_completes_only_at_the_end_of_the_head)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    size_t head_length = sizeof(test_response) - 3;
+    size_t i;
+
+    http_response_parser_init(&parser);
+
+    for (i = 1; i < head_length; i++)
+    {
+        // act
+        HTTP_RESPONSE_PARSER_RESULT result = http_response_parser_parse(&parser, (const unsigned char*)test_response, i);
+
+        // assert
+        ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_NEED_MORE_BYTES, (int)result);
+        ASSERT_ARE_EQUAL(size_t, i, parser.scanned_bytes);
+    }
+
+    ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_COMPLETE, (int)http_response_parser_parse(&parser, (const unsigned char*)test_response, head_length));
+    ASSERT_ARE_EQUAL(int, 101, parser.status_code);
+    ASSERT_ARE_EQUAL(size_t, head_length, parser.head_length);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_004: [ Once the end of the head was found, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_COMPLETE` without looking at `buffer`. ]*/
+TEST_FUNCTION(http_response_parser_parse_after_complete_returns_complete)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    HTTP_RESPONSE_PARSER_RESULT result;
+    (void)parse_all(&parser, test_response);
+
+    // act
+    result = http_response_parser_parse(&parser, NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_COMPLETE, (int)result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_response) - 3, parser.head_length);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_007: [ If no complete CRLF terminated line is left in `buffer`, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_NEED_MORE_BYTES`. ]*/
+TEST_FUNCTION(http_response_parser_parse_does_not_end_lines_at_a_bare_line_feed)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    HTTP_RESPONSE_PARSER_RESULT result;
+
+    // act
+    result = parse_all(&parser, "HTTP/1.1 200 OK\r\nX: a\n\nb\r\n");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_NEED_MORE_BYTES, (int)result);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_003: [ If `parser` is NULL, or `buffer` is NULL while `size` is not 0, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_ERROR`. ]*/
+TEST_FUNCTION(http_response_parser_parse_with_NULL_parser_fails)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER_RESULT result;
+
+    // act
+    result = http_response_parser_parse(NULL, (const unsigned char*)test_response, sizeof(test_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_ERROR, (int)result);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_003: [ If `parser` is NULL, or `buffer` is NULL while `size` is not 0, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_ERROR`. ]*/
+TEST_FUNCTION(http_response_parser_parse_with_NULL_buffer_and_non_zero_size_fails)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    HTTP_RESPONSE_PARSER_RESULT result;
+    http_response_parser_init(&parser);
+
+    // act
+    result = http_response_parser_parse(&parser, NULL, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_ERROR, (int)result);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_005: [ If `size` is smaller than the number of bytes already scanned, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_ERROR`. ]*/
+TEST_FUNCTION(http_response_parser_parse_with_a_shrunk_buffer_fails)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    HTTP_RESPONSE_PARSER_RESULT result;
+    http_response_parser_init(&parser);
+    (void)http_response_parser_parse(&parser, (const unsigned char*)test_response, 10);
+
+    // act
+    result = http_response_parser_parse(&parser, (const unsigned char*)test_response, 9);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_ERROR, (int)result);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_009: [ If the status line cannot be parsed, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_ERROR`. ]*/
+TEST_FUNCTION(http_response_parser_parse_with_an_empty_response_fails)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    HTTP_RESPONSE_PARSER_RESULT result;
+
+    // act
+    result = parse_all(&parser, "\r\n\r\n");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_ERROR, (int)result);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_009: [ If the status line cannot be parsed, `http_response_parser_parse` shall return `HTTP_RESPONSE_PARSER_ERROR`. ]*/
+TEST_FUNCTION(http_response_parser_parse_fails_as_soon_as_a_bad_status_line_is_complete)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    HTTP_RESPONSE_PARSER_RESULT result;
+
+    // act
+    result = parse_all(&parser, "HYTP/1.1 200\r\n");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)HTTP_RESPONSE_PARSER_ERROR, (int)result);
+}
+
+/* http_response_parser_parse_status_line */
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_014: [ The status code shall be read from the decimal digits that follow the spaces. ]*/
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_016: [ On success `http_response_parser_parse_status_line` shall set `status_code` and return 0. ]*/
+TEST_FUNCTION(http_response_parser_parse_status_line_with_a_reason_phrase_succeeds)
+{
+    // arrange
+    int status_code = 0;
+    int result;
+
+    // act
+    result = parse_status_line("HTTP/111.222 433 555", &status_code);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 433, status_code);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_013: [ The version shall be skipped up to and including its dot, then up to the space that follows it. ]*/
+TEST_FUNCTION(http_response_parser_parse_status_line_with_2_spaces_before_the_status_code_succeeds)
+{
+    // arrange
+    int status_code = 0;
+    int result;
+
+    // act
+    result = parse_status_line("HTTP/1.1  101", &status_code);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 101, status_code);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_016: [ On success `http_response_parser_parse_status_line` shall set `status_code` and return 0. ]*/
+TEST_FUNCTION(http_response_parser_parse_status_line_does_not_look_past_line_length)
+{
+    // arrange
+    int status_code = 0;
+    int result;
+
+    // act
+    result = http_response_parser_parse_status_line("HTTP/1.1 2049", 11, &status_code);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 20, status_code);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_011: [ If `line` or `status_code` is NULL, `http_response_parser_parse_status_line` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(http_response_parser_parse_status_line_with_NULL_arguments_fails)
+{
+    // arrange
+    int status_code;
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, http_response_parser_parse_status_line(NULL, 0, &status_code));
+    ASSERT_ARE_NOT_EQUAL(int, 0, http_response_parser_parse_status_line("HTTP/1.1 200", 12, NULL));
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_012: [ If `line` does not start with `HTTP/`, `http_response_parser_parse_status_line` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_015: [ If the dot, the space or the status code digits are missing, or the status code has more than 9 digits, `http_response_parser_parse_status_line` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(http_response_parser_parse_status_line_with_bad_lines_fails)
+{
+    static const char* bad_lines[] = { "", "H", "HTTPS/1.1 200", "HYTP/1.1 200", "HTTP/1.", "HTTP/1.1", "HTTP/1.1 ", "HTTP/111222 433", "HTTP/1.1 OK", "HTTP/1.1 1234567890" };
+    size_t i;
+
+    for (i = 0; i < sizeof(bad_lines) / sizeof(bad_lines[0]); i++)
+    {
+        // arrange
+        int status_code;
+
+        // act
+        int result = parse_status_line(bad_lines[i], &status_code);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, bad_lines[i]);
+    }
+}
+
+/* http_response_parser_get_header */
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_019: [ The header lines of the head shall be looked up for the first one whose name matches `header_name`, compared case insensitive, and is followed by a colon. ]*/
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_020: [ On success `value` shall point to the header value in `buffer` without leading whitespace, `value_length` shall exclude trailing whitespace and `http_response_parser_get_header` shall return true. ]*/
+TEST_FUNCTION(http_response_parser_get_header_finds_a_header_case_insensitive)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    const char* value = NULL;
+    size_t value_length = 0;
+    bool result;
+    (void)parse_all(&parser, test_response);
+
+    // act
+    result = http_response_parser_get_header(&parser, (const unsigned char*)test_response, "Sec-WebSocket-Extensions", &value, &value_length);
+
+    // assert
+    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(size_t, strlen("permessage-deflate"), value_length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(value, "permessage-deflate", value_length));
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_019: [ The header lines of the head shall be looked up for the first one whose name matches `header_name`, compared case insensitive, and is followed by a colon. ]*/
+TEST_FUNCTION(http_response_parser_get_header_does_not_match_a_longer_header_name)
+{
+    // arrange
+    static const char response[] = "HTTP/1.1 101 Switching Protocols\r\nUpgradeX: a\r\n\r\nUpgrade: b\r\n";
+    HTTP_RESPONSE_PARSER parser;
+    const char* value;
+    size_t value_length;
+    bool result;
+    (void)parse_all(&parser, response);
+
+    // act
+    result = http_response_parser_get_header(&parser, (const unsigned char*)response, "Upgrade", &value, &value_length);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_018: [ If the head was not completely parsed yet, `http_response_parser_get_header` shall return false. ]*/
+TEST_FUNCTION(http_response_parser_get_header_before_the_head_is_complete_fails)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    const char* value;
+    size_t value_length;
+    bool result;
+    http_response_parser_init(&parser);
+    (void)http_response_parser_parse(&parser, (const unsigned char*)test_response, 60);
+
+    // act
+    result = http_response_parser_get_header(&parser, (const unsigned char*)test_response, "Upgrade", &value, &value_length);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+}
+
+/* Tests_SRS_HTTP_RESPONSE_PARSER_01_017: [ If any argument is NULL, `http_response_parser_get_header` shall return false. ]*/
+TEST_FUNCTION(http_response_parser_get_header_with_NULL_arguments_fails)
+{
+    // arrange
+    HTTP_RESPONSE_PARSER parser;
+    const char* value;
+    size_t value_length;
+    (void)parse_all(&parser, test_response);
+
+    // act
+    // assert
+    ASSERT_IS_FALSE(http_response_parser_get_header(NULL, (const unsigned char*)test_response, "Upgrade", &value, &value_length));
+    ASSERT_IS_FALSE(http_response_parser_get_header(&parser, NULL, "Upgrade", &value, &value_length));
+    ASSERT_IS_FALSE(http_response_parser_get_header(&parser, (const unsigned char*)test_response, NULL, &value, &value_length));
+    ASSERT_IS_FALSE(http_response_parser_get_header(&parser, (const unsigned char*)test_response, "Upgrade", NULL, &value_length));
+    ASSERT_IS_FALSE(http_response_parser_get_header(&parser, (const unsigned char*)test_response, "Upgrade", &value, NULL));
+}
+
+END_TEST_SUITE(http_response_parser_ut)
@@ -0,0 +1,550 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include <sys/epoll.h>
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umock_c_negative_tests.h"
+#include "azure_c_shared_utility/macro_utils.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, int, epoll_create1, int, flags);
+    MOCKABLE_FUNCTION(, int, epoll_ctl, int, epfd, int, op, int, fd, struct epoll_event*, event);
+    MOCKABLE_FUNCTION(, int, epoll_wait, int, epfd, struct epoll_event*, events, int, maxevents, int, timeout);
+    MOCKABLE_FUNCTION(, int, close, int, fd);
+#ifdef __cplusplus
+}
+#endif
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/socket_reactor.h"
+
+#define TEST_EPOLL_FD           42
+#define TEST_SOCKET             43
+#define TEST_OTHER_SOCKET       44
+static LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4242;
+
+static void* g_registered_ptrs[2];
+static size_t g_registered_count;
+static void* g_ready_ptr;
+static uint32_t g_ready_events;
+static uint32_t g_modified_events;
+
+static int my_epoll_ctl(int epfd, int op, int fd, struct epoll_event* event)
+{
+    (void)epfd;
+    (void)fd;
+    if (op == EPOLL_CTL_ADD && g_registered_count < 2)
+    {
+        g_registered_ptrs[g_registered_count++] = event->data.ptr;
+    }
+    else if (op == EPOLL_CTL_MOD)
+    {
+        g_modified_events = event->events;
+    }
+    return 0;
+}
+
+static int my_epoll_wait(int epfd, struct epoll_event* events, int maxevents, int timeout)
+{
+    int result;
+    (void)epfd;
+    (void)maxevents;
+    (void)timeout;
+    if (g_ready_ptr == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        events[0].events = g_ready_events;
+        events[0].data.ptr = g_ready_ptr;
+        result = 1;
+    }
+    return result;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+BEGIN_TEST_SUITE(socket_reactor_epoll_ut)
+
+    TEST_SUITE_INITIALIZE(a)
+    {
+        int result;
+        TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+        g_testByTest = TEST_MUTEX_CREATE();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+
+        (void)umock_c_init(on_umock_c_error);
+
+        result = umocktypes_charptr_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+        result = umocktypes_bool_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+
+        REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+        REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+        REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+        REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+        REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+        REGISTER_GLOBAL_MOCK_RETURN(epoll_create1, TEST_EPOLL_FD);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(epoll_create1, -1);
+        REGISTER_GLOBAL_MOCK_HOOK(epoll_ctl, my_epoll_ctl);
+        REGISTER_GLOBAL_MOCK_HOOK(epoll_wait, my_epoll_wait);
+        REGISTER_GLOBAL_MOCK_RETURN(close, 0);
+    }
+
+    TEST_SUITE_CLEANUP(TestClassCleanup)
+    {
+        umock_c_deinit();
+
+        TEST_MUTEX_DESTROY(g_testByTest);
+        TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    }
+
+    TEST_FUNCTION_INITIALIZE(initialize)
+    {
+        if (TEST_MUTEX_ACQUIRE(g_testByTest))
+        {
+            ASSERT_FAIL("Could not acquire test serialization mutex.");
+        }
+
+        g_registered_count = 0;
+        g_ready_ptr = NULL;
+        g_ready_events = EPOLLIN;
+        g_modified_events = 0;
+        umock_c_reset_all_calls();
+    }
+
+    TEST_FUNCTION_CLEANUP(cleans)
+    {
+        TEST_MUTEX_RELEASE(g_testByTest);
+    }
+
+    TEST_FUNCTION(socket_reactor_init_creates_the_lock_and_the_epoll_instance)
+    {
+        ///arrange
+        int result;
+        STRICT_EXPECTED_CALL(Lock_Init());
+        STRICT_EXPECTED_CALL(epoll_create1(EPOLL_CLOEXEC));
+
+        ///act
+        result = socket_reactor_init();
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_init_fails_when_epoll_create1_fails)
+    {
+        ///arrange
+        int result;
+        STRICT_EXPECTED_CALL(Lock_Init());
+        STRICT_EXPECTED_CALL(epoll_create1(EPOLL_CLOEXEC)).SetReturn(-1);
+        STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_init();
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(socket_reactor_deinit_closes_the_epoll_instance)
+    {
+        ///arrange
+        (void)socket_reactor_init();
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(close(TEST_EPOLL_FD));
+        STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+        ///act
+        socket_reactor_deinit();
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(socket_reactor_register_returns_NULL_when_the_reactor_is_not_running)
+    {
+        ///act
+        SOCKET_REACTOR_ENTRY_HANDLE entry = socket_reactor_register(TEST_SOCKET);
+
+        ///assert
+        ASSERT_IS_NULL(entry);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(socket_reactor_register_adds_the_socket_to_the_epoll_instance)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        (void)socket_reactor_init();
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(epoll_ctl(TEST_EPOLL_FD, EPOLL_CTL_ADD, TEST_SOCKET, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        entry = socket_reactor_register(TEST_SOCKET);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(entry);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_unregister_removes_the_socket_from_the_epoll_instance)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(epoll_ctl(TEST_EPOLL_FD, EPOLL_CTL_DEL, TEST_SOCKET, NULL));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(entry));
+
+        ///act
+        socket_reactor_unregister(entry);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_is_readable_returns_true_for_a_new_entry_without_polling)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        bool result;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_is_readable(entry);
+
+        ///assert
+        ASSERT_IS_TRUE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_is_readable_polls_once_per_round_and_reports_only_ready_sockets)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry1;
+        SOCKET_REACTOR_ENTRY_HANDLE entry2;
+        bool result1;
+        bool result2;
+        (void)socket_reactor_init();
+        entry1 = socket_reactor_register(TEST_SOCKET);
+        entry2 = socket_reactor_register(TEST_OTHER_SOCKET);
+        (void)socket_reactor_is_readable(entry1);
+        (void)socket_reactor_is_readable(entry2);
+        g_ready_ptr = g_registered_ptrs[1];
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(epoll_wait(TEST_EPOLL_FD, IGNORED_PTR_ARG, IGNORED_NUM_ARG, 0));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result1 = socket_reactor_is_readable(entry1);
+        result2 = socket_reactor_is_readable(entry2);
+
+        ///assert
+        ASSERT_IS_FALSE(result1);
+        ASSERT_IS_TRUE(result2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry1);
+        socket_reactor_unregister(entry2);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_is_readable_returns_true_when_epoll_wait_fails)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        bool result;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        (void)socket_reactor_is_readable(entry);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(epoll_wait(TEST_EPOLL_FD, IGNORED_PTR_ARG, IGNORED_NUM_ARG, 0)).SetReturn(-1);
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_is_readable(entry);
+
+        ///assert
+        ASSERT_IS_TRUE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_set_write_interest_adds_EPOLLOUT_to_the_watched_events)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        int result;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(epoll_ctl(TEST_EPOLL_FD, EPOLL_CTL_MOD, TEST_SOCKET, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_set_write_interest(entry, true);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(int, (int)(EPOLLIN | EPOLLRDHUP | EPOLLOUT), (int)g_modified_events);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_set_write_interest_removes_EPOLLOUT_from_the_watched_events)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        int result;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        (void)socket_reactor_set_write_interest(entry, true);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(epoll_ctl(TEST_EPOLL_FD, EPOLL_CTL_MOD, TEST_SOCKET, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_set_write_interest(entry, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(int, (int)(EPOLLIN | EPOLLRDHUP), (int)g_modified_events);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_set_write_interest_does_not_call_epoll_ctl_when_the_interest_does_not_change)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        int result;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_set_write_interest(entry, false);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_set_write_interest_fails_when_epoll_ctl_fails)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        int result;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(epoll_ctl(TEST_EPOLL_FD, EPOLL_CTL_MOD, TEST_SOCKET, IGNORED_PTR_ARG)).SetReturn(-1);
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_set_write_interest(entry, true);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_is_writable_returns_true_when_the_entry_is_not_watched_for_writability)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        bool result;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        (void)socket_reactor_is_readable(entry);
+        (void)socket_reactor_is_readable(entry);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_is_writable(entry);
+
+        ///assert
+        ASSERT_IS_TRUE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_is_writable_returns_false_when_the_poll_did_not_report_EPOLLOUT)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        bool readable;
+        bool result;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        (void)socket_reactor_is_readable(entry);
+        (void)socket_reactor_set_write_interest(entry, true);
+        g_ready_ptr = g_registered_ptrs[0];
+        g_ready_events = EPOLLIN;
+        readable = socket_reactor_is_readable(entry);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_is_writable(entry);
+
+        ///assert
+        ASSERT_IS_TRUE(readable);
+        ASSERT_IS_FALSE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+    TEST_FUNCTION(socket_reactor_is_writable_returns_true_when_the_poll_reported_EPOLLOUT)
+    {
+        ///arrange
+        SOCKET_REACTOR_ENTRY_HANDLE entry;
+        bool readable;
+        bool result;
+        (void)socket_reactor_init();
+        entry = socket_reactor_register(TEST_SOCKET);
+        (void)socket_reactor_is_readable(entry);
+        (void)socket_reactor_set_write_interest(entry, true);
+        g_ready_ptr = g_registered_ptrs[0];
+        g_ready_events = EPOLLOUT;
+        readable = socket_reactor_is_readable(entry);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        ///act
+        result = socket_reactor_is_writable(entry);
+
+        ///assert
+        ASSERT_IS_FALSE(readable);
+        ASSERT_IS_TRUE(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        socket_reactor_unregister(entry);
+        socket_reactor_deinit();
+    }
+
+END_TEST_SUITE(socket_reactor_epoll_ut)
@@ -2,665 +2,2151 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #endif
 
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
 #include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
+#include "umock_c_negative_tests.h"
+
+static size_t currentrealloc_call;
+static size_t whenShallrealloc_fail;
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    void* result;
+    currentrealloc_call++;
+    if ((whenShallrealloc_fail > 0) &&
+        (currentrealloc_call == whenShallrealloc_fail))
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = realloc(ptr, size);
+    }
+    return result;
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/constbuffer.h"
+#include "dns_async.h"
+#include "socket_async.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, int, socket, int, af, int, type, int, protocol);
+    MOCKABLE_FUNCTION(, int, connect, int, sockfd, const struct sockaddr*, addr, socklen_t, addrlen);
+    MOCKABLE_FUNCTION(, int, setsockopt, int, sockfd, int, level, int, optname, const void*, optval, socklen_t, optlen);
+    MOCKABLE_FUNCTION(, int, getsockopt, int, sockfd, int, level, int, optname, void*, optval, socklen_t*, optlen);
+    MOCKABLE_FUNCTION(, ssize_t, sendmsg, int, sockfd, const struct msghdr*, msg, int, flags);
+    MOCKABLE_FUNCTION(, ssize_t, recv, int, sockfd, void*, buf, size_t, len, int, flags);
+    MOCKABLE_FUNCTION(, int, shutdown, int, sockfd, int, how);
+    MOCKABLE_FUNCTION(, int, close, int, sockfd);
+#ifdef __cplusplus
+}
+#endif
+
+/* a minimal list, the pending IOs are the only thing socketio keeps in it */
+static const void** list_items = NULL;
+static size_t list_item_count = 0;
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
+{
+    const void** items = (const void**)realloc((void*)list_items, (list_item_count + 1) * sizeof(item));
+    (void)list;
+    if (items != NULL)
+    {
+        list_items = items;
+        list_items[list_item_count++] = item;
+    }
+    return (LIST_ITEM_HANDLE)list_item_count;
+}
+
+static int my_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
+{
+    size_t index = (size_t)item - 1;
+    (void)list;
+    (void)memmove((void*)&list_items[index], &list_items[index + 1], sizeof(const void*) * (list_item_count - index - 1));
+    list_item_count--;
+    if (list_item_count == 0)
+    {
+        free((void*)list_items);
+        list_items = NULL;
+    }
+    return 0;
+}
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list)
+{
+    (void)list;
+    return (list_item_count > 0) ? (LIST_ITEM_HANDLE)1 : NULL;
+}
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_get_next_item(LIST_ITEM_HANDLE item_handle)
+{
+    return ((size_t)item_handle < list_item_count) ? (LIST_ITEM_HANDLE)((size_t)item_handle + 1) : NULL;
+}
+
+static const void* my_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle)
+{
+    return list_items[(size_t)item_handle - 1];
+}
+
+#include "azure_c_shared_utility/gballoc.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+// Not mocked, the socket is always switched to non-blocking the same way
+int fcntl(int fd, int cmd, ...) { (void)fd; (void)cmd; return 0; }
+
+TEST_DEFINE_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT_VALUES);
+
+#define TEST_HOSTNAME               "test_host"
+#define TEST_PORT                   443
+#define TEST_FIRST_SOCKET           0x4242
+#define TEST_MAX_SOCKETS            8
+#define TEST_CONNECT_TIMEOUT_MS     10000
+#define TEST_ATTEMPT_DELAY_MS       250
+
+/* same batch size as socketio_berkeley.c */
+#ifdef IOV_MAX
+#define TEST_MAX_IOV                IOV_MAX
+#else
+#define TEST_MAX_IOV                16
+#endif
+
+static const SINGLYLINKEDLIST_HANDLE TEST_SINGLYLINKEDLIST_HANDLE = (SINGLYLINKEDLIST_HANDLE)0x4301;
+static const TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4302;
+static const DNS_ASYNC_HANDLE TEST_DNS_ASYNC_HANDLE = (DNS_ASYNC_HANDLE)0x4303;
+static const CONSTBUFFER_HANDLE TEST_CONSTBUFFER_HANDLE = (CONSTBUFFER_HANDLE)0x4304;
+static const OPTIONHANDLER_HANDLE TEST_OPTIONHANDLER_HANDLE = (OPTIONHANDLER_HANDLE)0x4305;
+
+static const unsigned char test_constbuffer_bytes[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08 };
+static CONSTBUFFER test_constbuffer_content = { test_constbuffer_bytes, sizeof(test_constbuffer_bytes) };
+
+/* the tick counter only moves when a test says so */
+static tickcounter_ms_t g_current_ms;
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_current_ms;
+    return 0;
+}
+
+/* the resolved addresses handed out by the dns_async mock */
+static struct sockaddr_in test_ipv4_address;
+static struct sockaddr_in6 test_ipv6_address;
+static const struct sockaddr* g_addresses[DNS_ASYNC_MAX_ADDRESSES];
+static size_t g_address_lengths[DNS_ASYNC_MAX_ADDRESSES];
+static size_t g_address_count;
+static bool g_is_lookup_complete;
+
+static bool my_dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns)
+{
+    (void)dns;
+    return g_is_lookup_complete;
+}
+
+static size_t my_dns_async_get_address_count(DNS_ASYNC_HANDLE dns)
+{
+    (void)dns;
+    return g_address_count;
+}
+
+static const struct sockaddr* my_dns_async_get_address(DNS_ASYNC_HANDLE dns, size_t index, size_t* address_length)
+{
+    (void)dns;
+    *address_length = g_address_lengths[index];
+    return g_addresses[index];
+}
+
+static void add_ipv4_address(void)
+{
+    g_addresses[g_address_count] = (const struct sockaddr*)&test_ipv4_address;
+    g_address_lengths[g_address_count] = sizeof(test_ipv4_address);
+    g_address_count++;
+}
+
+static void add_ipv6_address(void)
+{
+    g_addresses[g_address_count] = (const struct sockaddr*)&test_ipv6_address;
+    g_address_lengths[g_address_count] = sizeof(test_ipv6_address);
+    g_address_count++;
+}
+
+/* every socket the module creates gets the next number, its connect state is set by the tests */
+static int g_socket_count;
+static int g_socket_families[TEST_MAX_SOCKETS];
+static bool g_is_connect_complete[TEST_MAX_SOCKETS];
+static int g_connect_error[TEST_MAX_SOCKETS];
+static bool g_is_closed[TEST_MAX_SOCKETS];
+
+static int my_socket(int af, int type, int protocol)
+{
+    (void)type;
+    (void)protocol;
+    g_socket_families[g_socket_count] = af;
+    return TEST_FIRST_SOCKET + g_socket_count++;
+}
+
+static int my_socket_async_is_create_complete(SOCKET_ASYNC_HANDLE sock, bool* is_complete)
+{
+    *is_complete = g_is_connect_complete[sock - TEST_FIRST_SOCKET];
+    return 0;
+}
+
+static int my_getsockopt(int sockfd, int level, int optname, void* optval, socklen_t* optlen)
+{
+    (void)level;
+    (void)optname;
+    (void)optlen;
+    *(int*)optval = g_connect_error[sockfd - TEST_FIRST_SOCKET];
+    return 0;
+}
+
+#define TEST_MAX_SETSOCKOPT_CALLS 8
+static size_t g_setsockopt_call_count;
+static int g_setsockopt_levels[TEST_MAX_SETSOCKOPT_CALLS];
+static int g_setsockopt_optnames[TEST_MAX_SETSOCKOPT_CALLS];
+static int g_setsockopt_values[TEST_MAX_SETSOCKOPT_CALLS];
+static int g_setsockopt_result;
+
+static int my_setsockopt(int sockfd, int level, int optname, const void* optval, socklen_t optlen)
+{
+    (void)sockfd;
+    (void)optlen;
+    if (g_setsockopt_call_count < TEST_MAX_SETSOCKOPT_CALLS)
+    {
+        g_setsockopt_levels[g_setsockopt_call_count] = level;
+        g_setsockopt_optnames[g_setsockopt_call_count] = optname;
+        g_setsockopt_values[g_setsockopt_call_count] = *(const int*)optval;
+    }
+    g_setsockopt_call_count++;
+    return g_setsockopt_result;
+}
+
+static int my_close(int sockfd)
+{
+    if ((sockfd >= TEST_FIRST_SOCKET) && (sockfd < TEST_FIRST_SOCKET + TEST_MAX_SOCKETS))
+    {
+        g_is_closed[sockfd - TEST_FIRST_SOCKET] = true;
+    }
+    return 0;
+}
+
+/* sendmsg accepts at most g_sendmsg_max_bytes per call, or fails with g_sendmsg_errno when that is not 0 */
+static size_t g_sendmsg_max_bytes;
+static int g_sendmsg_errno;
+static size_t g_sendmsg_call_count;
+static size_t g_sendmsg_iov_counts[16];
+static unsigned char g_sent_bytes[256];
+static size_t g_sent_byte_count;
+
+static ssize_t my_sendmsg(int sockfd, const struct msghdr* msg, int flags)
+{
+    ssize_t result;
+    (void)sockfd;
+    (void)flags;
+
+    if (g_sendmsg_call_count < sizeof(g_sendmsg_iov_counts) / sizeof(g_sendmsg_iov_counts[0]))
+    {
+        g_sendmsg_iov_counts[g_sendmsg_call_count] = (size_t)msg->msg_iovlen;
+    }
+    g_sendmsg_call_count++;
+
+    if (g_sendmsg_errno != 0)
+    {
+        errno = g_sendmsg_errno;
+        result = -1;
+    }
+    else
+    {
+        size_t sent = 0;
+        size_t i;
+
+        for (i = 0; (i < (size_t)msg->msg_iovlen) && (sent < g_sendmsg_max_bytes); i++)
+        {
+            size_t chunk = msg->msg_iov[i].iov_len;
+            if (chunk > g_sendmsg_max_bytes - sent)
+            {
+                chunk = g_sendmsg_max_bytes - sent;
+            }
+            if (g_sent_byte_count + chunk <= sizeof(g_sent_bytes))
+            {
+                (void)memcpy(g_sent_bytes + g_sent_byte_count, msg->msg_iov[i].iov_base, chunk);
+                g_sent_byte_count += chunk;
+            }
+            sent += chunk;
+        }
+
+        result = (ssize_t)sent;
+    }
+
+    return result;
+}
+
+/* recv hands out the sizes in g_recv_sizes one call at a time, then reports EAGAIN */
+static ssize_t g_recv_sizes[16];
+static size_t g_recv_size_count;
+static size_t g_recv_call_count;
+static size_t g_recv_buffer_sizes[16];
+
+static ssize_t my_recv(int sockfd, void* buf, size_t len, int flags)
+{
+    ssize_t result;
+    (void)sockfd;
+    (void)flags;
+
+    if (g_recv_call_count < sizeof(g_recv_buffer_sizes) / sizeof(g_recv_buffer_sizes[0]))
+    {
+        g_recv_buffer_sizes[g_recv_call_count] = len;
+    }
+
+    if (g_recv_call_count < g_recv_size_count)
+    {
+        result = g_recv_sizes[g_recv_call_count];
+        if ((result > 0) && ((size_t)result <= len))
+        {
+            (void)memset(buf, 0x42, (size_t)result);
+        }
+    }
+    else
+    {
+        errno = EAGAIN;
+        result = -1;
+    }
+
+    g_recv_call_count++;
+    return result;
+}
+
+static void set_recv_sizes(const ssize_t* sizes, size_t count)
+{
+    (void)memcpy(g_recv_sizes, sizes, count * sizeof(ssize_t));
+    g_recv_size_count = count;
+    g_recv_call_count = 0;
+}
+
+/* callbacks given to socketio */
+static size_t g_open_complete_count;
+static IO_OPEN_RESULT g_open_result;
+static size_t g_io_error_count;
+static size_t g_bytes_received_count;
+static size_t g_bytes_received_total;
+static size_t g_send_complete_count;
+static IO_SEND_RESULT g_send_results[16];
+
+static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    g_open_complete_count++;
+    g_open_result = open_result;
+}
+
+static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    (void)buffer;
+    g_bytes_received_count++;
+    g_bytes_received_total += size;
+}
+
+static void test_on_io_error(void* context)
+{
+    (void)context;
+    g_io_error_count++;
+}
+
+static void test_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    if (g_send_complete_count < sizeof(g_send_results) / sizeof(g_send_results[0]))
+    {
+        g_send_results[g_send_complete_count] = send_result;
+    }
+    g_send_complete_count++;
+}
+
+static void test_on_io_writable(void* context)
+{
+    (void)context;
+}
+
+static const unsigned char test_send_bytes[] = { 0x11, 0x12, 0x13, 0x14, 0x21, 0x22, 0x23, 0x24, 0x31, 0x32, 0x33, 0x34 };
+
+/* the first send would block, so it and the ones after it end up in the pending IO list */
+static void queue_sends(CONCRETE_IO_HANDLE socket_io, size_t count, size_t size)
+{
+    size_t i;
+
+    g_sendmsg_errno = EAGAIN;
+    for (i = 0; i < count; i++)
+    {
+        int result = socketio_send(socket_io, test_send_bytes + ((i * size) % sizeof(test_send_bytes)), size, test_on_send_complete, NULL);
+        ASSERT_ARE_EQUAL(int, 0, result);
+    }
+    g_sendmsg_errno = 0;
+    g_sendmsg_call_count = 0;
+    g_sent_byte_count = 0;
+}
+
+static CONCRETE_IO_HANDLE create_socketio(void)
+{
+    SOCKETIO_CONFIG config = { TEST_HOSTNAME, TEST_PORT, NULL };
+    CONCRETE_IO_HANDLE result = socketio_create(&config);
+    ASSERT_IS_NOT_NULL(result);
+    return result;
+}
+
+static void open_socketio_async(CONCRETE_IO_HANDLE socket_io)
+{
+    int result = socketio_open(socket_io, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+    ASSERT_ARE_EQUAL(int, 0, result);
+}
+
+/* returns an instance connected to a single IPv4 address, through the whole asynchronous open */
+static CONCRETE_IO_HANDLE create_open_socketio(void)
+{
+    CONCRETE_IO_HANDLE result = create_socketio();
+    open_socketio_async(result);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(result);
+    g_is_connect_complete[0] = true;
+    socketio_dowork(result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_open_result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+BEGIN_TEST_SUITE(socketio_berkeley_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+    size_t type_size;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    (void)umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // Unnatural type_size variable exists to avoid "conditional expression is constant" warning
+    type_size = sizeof(ssize_t);
+    if (type_size == sizeof(int32_t))
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(ssize_t, int32_t);
+    }
+    else
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(ssize_t, int64_t);
+    }
+
+    type_size = sizeof(socklen_t);
+    if (type_size == sizeof(uint32_t))
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(socklen_t, uint32_t);
+    }
+    else
+    {
+        REGISTER_UMOCK_ALIAS_TYPE(socklen_t, uint64_t);
+    }
+
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(DNS_ASYNC_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SOCKET_ASYNC_HANDLE, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_create, TEST_SINGLYLINKEDLIST_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, my_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, my_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, my_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_next_item, my_singlylinkedlist_get_next_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, my_singlylinkedlist_item_get_value);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_RETURN(dns_async_create, TEST_DNS_ASYNC_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(dns_async_is_lookup_complete, my_dns_async_is_lookup_complete);
+    REGISTER_GLOBAL_MOCK_HOOK(dns_async_get_address_count, my_dns_async_get_address_count);
+    REGISTER_GLOBAL_MOCK_HOOK(dns_async_get_address, my_dns_async_get_address);
+    REGISTER_GLOBAL_MOCK_HOOK(socket, my_socket);
+    REGISTER_GLOBAL_MOCK_RETURN(connect, 0);
+    REGISTER_GLOBAL_MOCK_HOOK(setsockopt, my_setsockopt);
+    REGISTER_GLOBAL_MOCK_HOOK(getsockopt, my_getsockopt);
+    REGISTER_GLOBAL_MOCK_HOOK(socket_async_is_create_complete, my_socket_async_is_create_complete);
+    REGISTER_GLOBAL_MOCK_HOOK(sendmsg, my_sendmsg);
+    REGISTER_GLOBAL_MOCK_HOOK(recv, my_recv);
+    REGISTER_GLOBAL_MOCK_HOOK(close, my_close);
+    REGISTER_GLOBAL_MOCK_RETURN(CONSTBUFFER_GetContent, &test_constbuffer_content);
+    REGISTER_GLOBAL_MOCK_RETURN(CONSTBUFFER_Clone, TEST_CONSTBUFFER_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_Create, TEST_OPTIONHANDLER_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_AddOption, OPTIONHANDLER_OK);
+
+    test_ipv4_address.sin_family = AF_INET;
+    test_ipv4_address.sin_addr.s_addr = htonl(0x7F000001);
+    test_ipv6_address.sin6_family = AF_INET6;
+    test_ipv6_address.sin6_addr.s6_addr[15] = 1;
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+
+    currentrealloc_call = 0;
+    whenShallrealloc_fail = 0;
+    g_current_ms = 1000;
+    g_address_count = 0;
+    g_is_lookup_complete = false;
+    g_socket_count = 0;
+    (void)memset(g_socket_families, 0, sizeof(g_socket_families));
+    (void)memset(g_is_connect_complete, 0, sizeof(g_is_connect_complete));
+    (void)memset(g_connect_error, 0, sizeof(g_connect_error));
+    (void)memset(g_is_closed, 0, sizeof(g_is_closed));
+    g_setsockopt_call_count = 0;
+    g_setsockopt_result = 0;
+    g_sendmsg_max_bytes = SIZE_MAX;
+    g_sendmsg_errno = 0;
+    g_sendmsg_call_count = 0;
+    g_sent_byte_count = 0;
+    g_recv_size_count = 0;
+    g_recv_call_count = 0;
+    g_open_complete_count = 0;
+    g_open_result = IO_OPEN_ERROR;
+    g_io_error_count = 0;
+    g_bytes_received_count = 0;
+    g_bytes_received_total = 0;
+    g_send_complete_count = 0;
+    test_constbuffer_content.buffer = test_constbuffer_bytes;
+    test_constbuffer_content.size = sizeof(test_constbuffer_bytes);
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    ASSERT_ARE_EQUAL(size_t, 0, list_item_count);
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* socketio_create */
+
+TEST_FUNCTION(socketio_create_with_NULL_config_fails)
+{
+    // act
+    CONCRETE_IO_HANDLE result = socketio_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(socketio_create_creates_the_pending_io_list_and_copies_the_hostname)
+{
+    // arrange
+    SOCKETIO_CONFIG config = { TEST_HOSTNAME, TEST_PORT, NULL };
+    CONCRETE_IO_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(TEST_HOSTNAME)));
+
+    // act
+    result = socketio_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(result);
+}
+
+/* socketio_open */
+
+TEST_FUNCTION(socketio_open_starts_the_DNS_lookup_and_does_not_report_the_open_yet)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(dns_async_create(TEST_HOSTNAME, IGNORED_PTR_ARG));
+
+    // act
+    result = socketio_open(socket_io, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_tickcounter_create_fails_socketio_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+
+    // act
+    result = socketio_open(socket_io, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_open_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_dns_async_create_fails_socketio_open_fails_and_releases_the_tick_counter)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(dns_async_create(TEST_HOSTNAME, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+
+    // act
+    result = socketio_open(socket_io, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_open_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(socketio_open_twice_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    int result;
+    open_socketio_async(socket_io);
+
+    // act
+    result = socketio_open(socket_io, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+/* socketio_dowork while opening */
+
+TEST_FUNCTION(socketio_dowork_while_the_DNS_lookup_is_pending_does_not_complete_the_open)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    g_current_ms += TEST_CONNECT_TIMEOUT_MS - 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(dns_async_is_lookup_complete(TEST_DNS_ASYNC_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_the_DNS_lookup_does_not_finish_within_the_connect_timeout_the_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    g_current_ms += TEST_CONNECT_TIMEOUT_MS;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(dns_async_is_lookup_complete(TEST_DNS_ASYNC_HANDLE));
+    STRICT_EXPECTED_CALL(dns_async_destroy(TEST_DNS_ASYNC_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_open_result);
+    ASSERT_ARE_EQUAL(int, 0, g_socket_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_the_DNS_lookup_returns_no_address_the_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    g_is_lookup_complete = true;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_open_result);
+    ASSERT_ARE_EQUAL(int, 0, g_socket_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_the_DNS_lookup_completes_a_non_blocking_connect_to_the_first_address_is_started)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(dns_async_is_lookup_complete(TEST_DNS_ASYNC_HANDLE));
+    STRICT_EXPECTED_CALL(dns_async_get_address_count(TEST_DNS_ASYNC_HANDLE));
+    STRICT_EXPECTED_CALL(dns_async_get_address(TEST_DNS_ASYNC_HANDLE, 0, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(socket(AF_INET, SOCK_STREAM, 0));
+    STRICT_EXPECTED_CALL(connect(TEST_FIRST_SOCKET, IGNORED_PTR_ARG, sizeof(struct sockaddr_in)));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_the_connect_completes_the_open_succeeds)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_is_connect_complete[0] = true;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(socket_async_is_create_complete(TEST_FIRST_SOCKET, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(getsockopt(TEST_FIRST_SOCKET, SOL_SOCKET, SO_ERROR, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(dns_async_destroy(TEST_DNS_ASYNC_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(recv(TEST_FIRST_SOCKET, IGNORED_PTR_ARG, IGNORED_NUM_ARG, 0));
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_open_result);
+    ASSERT_IS_FALSE(g_is_closed[0]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_the_only_connect_attempt_fails_the_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_is_connect_complete[0] = true;
+    g_connect_error[0] = ECONNREFUSED;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_open_result);
+    ASSERT_IS_TRUE(g_is_closed[0]);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_the_connect_does_not_complete_within_the_connect_timeout_the_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_current_ms += TEST_CONNECT_TIMEOUT_MS;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_open_result);
+    ASSERT_IS_TRUE(g_is_closed[0]);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(the_time_spent_in_the_DNS_lookup_counts_against_the_connect_timeout)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    g_current_ms += TEST_CONNECT_TIMEOUT_MS - 1;
+    socketio_dowork(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_current_ms += 1;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_open_result);
+    ASSERT_IS_TRUE(g_is_closed[0]);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+/* socketio_dowork connection racing */
+
+TEST_FUNCTION(with_several_addresses_only_the_first_connect_attempt_is_started_right_away)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv6_address();
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 1, g_socket_count);
+    ASSERT_ARE_EQUAL(int, AF_INET6, g_socket_families[0]);
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(the_next_connect_attempt_is_not_started_before_the_connection_attempt_delay)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv6_address();
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_current_ms += TEST_ATTEMPT_DELAY_MS - 1;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 1, g_socket_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_the_first_connect_attempt_is_still_pending_after_the_connection_attempt_delay_the_next_address_is_tried)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv6_address();
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_current_ms += TEST_ATTEMPT_DELAY_MS;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 2, g_socket_count);
+    ASSERT_ARE_EQUAL(int, AF_INET, g_socket_families[1]);
+    ASSERT_IS_FALSE(g_is_closed[0]);
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
+    ASSERT_IS_TRUE(g_is_closed[0]);
+    ASSERT_IS_TRUE(g_is_closed[1]);
+}
+
+TEST_FUNCTION(when_the_later_connect_attempt_completes_first_it_wins_and_the_earlier_one_is_closed)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv6_address();
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_current_ms += TEST_ATTEMPT_DELAY_MS;
+    socketio_dowork(socket_io);
+    g_is_connect_complete[1] = true;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(socket_async_is_create_complete(TEST_FIRST_SOCKET, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(socket_async_is_create_complete(TEST_FIRST_SOCKET + 1, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(getsockopt(TEST_FIRST_SOCKET + 1, SOL_SOCKET, SO_ERROR, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(close(TEST_FIRST_SOCKET));
+    STRICT_EXPECTED_CALL(dns_async_destroy(TEST_DNS_ASYNC_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(recv(TEST_FIRST_SOCKET + 1, IGNORED_PTR_ARG, IGNORED_NUM_ARG, 0));
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_open_result);
+    ASSERT_IS_TRUE(g_is_closed[0]);
+    ASSERT_IS_FALSE(g_is_closed[1]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
+
+TEST_FUNCTION(when_the_first_connect_attempt_completes_the_later_one_is_closed)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv6_address();
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_current_ms += TEST_ATTEMPT_DELAY_MS;
+    socketio_dowork(socket_io);
+    g_is_connect_complete[0] = true;
 
-#define ENABLE_MOCKS
+    // act
+    socketio_dowork(socket_io);
 
-#include "azure_c_shared_utility/singlylinkedlist.h"
-#include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/optionhandler.h"
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_open_result);
+    ASSERT_IS_FALSE(g_is_closed[0]);
+    ASSERT_IS_TRUE(g_is_closed[1]);
 
-#undef ENABLE_MOCKS
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-#include "azure_c_shared_utility/socketio.h"
+TEST_FUNCTION(when_a_connect_attempt_fails_the_next_address_is_tried_without_waiting_for_the_connection_attempt_delay)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv6_address();
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_is_connect_complete[0] = true;
+    g_connect_error[0] = ENETUNREACH;
 
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <netdb.h>
+    // act
+    socketio_dowork(socket_io);
 
-TEST_MUTEX_HANDLE test_serialize_mutex;
+    // assert
+    ASSERT_IS_TRUE(g_is_closed[0]);
+    ASSERT_ARE_EQUAL(int, 2, g_socket_count);
+    ASSERT_ARE_EQUAL(int, AF_INET, g_socket_families[1]);
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
 
-BEGIN_TEST_SUITE(socketio_berkeley_unittests)
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-#if 0
+TEST_FUNCTION(when_all_connect_attempts_fail_the_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv6_address();
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
+    g_current_ms += TEST_ATTEMPT_DELAY_MS;
+    socketio_dowork(socket_io);
+    g_is_connect_complete[0] = true;
+    g_connect_error[0] = ENETUNREACH;
+    g_is_connect_complete[1] = true;
+    g_connect_error[1] = ECONNREFUSED;
 
-// SOCKETIO_SETOPTION TESTS WERE WORKING BEFORE SWITCH TO umock_c...need to finish the conversion
+    // act
+    socketio_dowork(socket_io);
 
-// socketio_setoption tests
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_open_result);
+    ASSERT_IS_TRUE(g_is_closed[0]);
+    ASSERT_IS_TRUE(g_is_closed[1]);
 
-static CONCRETE_IO_HANDLE setup_socket()
-{
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-    int result = socketio_open(ioHandle, test_on_io_open_complete, &callbackContext,
-        test_on_bytes_received, &callbackContext, test_on_io_error, &callbackContext);
-    ASSERT_ARE_EQUAL(int, 0, result);
-    return ioHandle;
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-static void verify_mocks_and_destroy_socket(CONCRETE_IO_HANDLE ioHandle)
+/* socketio_destroy */
+
+TEST_FUNCTION(socketio_destroy_while_the_DNS_lookup_is_pending_reports_the_open_as_cancelled)
 {
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(dns_async_destroy(TEST_DNS_ASYNC_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(socket_io));
+
+    // act
+    socketio_destroy(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_CANCELLED, g_open_result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    socketio_destroy(ioHandle);
 }
 
-TEST_FUNCTION(socketio_setoption_fails_when_handle_is_null)
+TEST_FUNCTION(socketio_destroy_while_connecting_closes_the_connect_socket_and_reports_the_open_as_cancelled)
 {
     // arrange
-    int irrelevant = 1;
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
 
     // act
-    int result = socketio_setoption(NULL, "tcp_keepalive", &irrelevant);
+    socketio_destroy(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_CANCELLED, g_open_result);
+    ASSERT_IS_TRUE(g_is_closed[0]);
 }
 
-TEST_FUNCTION(socketio_setoption_fails_when_option_name_is_null)
+TEST_FUNCTION(socketio_destroy_after_the_open_completed_does_not_report_the_open_again)
 {
     // arrange
-    int irrelevant = 1;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
 
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
+    // act
+    socketio_destroy(socket_io);
 
-    umock_c_reset_all_calls();
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_IS_TRUE(g_is_closed[0]);
+}
+
+/* socketio_close */
+
+TEST_FUNCTION(socketio_close_while_opening_reports_the_open_as_cancelled)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    int result;
+    open_socketio_async(socket_io);
 
     // act
-    int result = socketio_setoption(ioHandle, NULL, &irrelevant);
+    result = socketio_close(socket_io, NULL, NULL);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_CANCELLED, g_open_result);
+
+    // cleanup
+    socketio_destroy(socket_io);
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
 }
 
-TEST_FUNCTION(socketio_setoption_fails_when_value_is_null)
+/* socketio_send_constbuffer */
+
+TEST_FUNCTION(socketio_send_constbuffer_with_NULL_buffer_fails)
 {
     // arrange
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
-
-    umock_c_reset_all_calls();
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
 
     // act
-    int result = socketio_setoption(ioHandle, "tcp_keepalive", NULL);
+    int result = socketio_send_constbuffer(socket_io, NULL, test_on_send_complete, NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_setoption_fails_when_it_receives_an_unsupported_option)
+TEST_FUNCTION(socketio_send_constbuffer_with_an_empty_buffer_fails)
 {
     // arrange
-    int irrelevant = 1;
-
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int result;
+    test_constbuffer_content.size = 0;
 
-    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE));
 
     // act
-    int result = socketio_setoption(ioHandle, "unsupported_option_name", &irrelevant);
+    result = socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_setoption_passes_tcp_keepalive_to_setsockopt)
+TEST_FUNCTION(socketio_send_constbuffer_that_is_sent_right_away_takes_no_reference)
 {
     // arrange
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
-
-    umock_c_reset_all_calls();
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int result;
 
-    int onoff = -42;
-
-    STRICT_EXPECTED_CALL(setsockopt(*(int*)ioHandle, SOL_SOCKET, SO_KEEPALIVE,
-        &onoff, sizeof(int)));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(sendmsg(TEST_FIRST_SOCKET, IGNORED_PTR_ARG, 0));
 
     // act
-    int result = socketio_setoption(ioHandle, "tcp_keepalive", &onoff);
+    result = socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_send_results[0]);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_constbuffer_bytes), g_sent_byte_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_setoption_passes_tcp_keepalive_time_to_setsockopt)
+TEST_FUNCTION(socketio_send_constbuffer_that_would_block_queues_a_reference_instead_of_a_copy)
 {
     // arrange
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
-
-    umock_c_reset_all_calls();
-
-    int time = 3;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int result;
+    g_sendmsg_errno = EAGAIN;
 
-    STRICT_EXPECTED_CALL(setsockopt(*(int*)ioHandle, SOL_TCP, TCP_KEEPIDLE,
-        &time, sizeof(int)));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(sendmsg(TEST_FIRST_SOCKET, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_Clone(TEST_CONSTBUFFER_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
 
     // act
-    int result = socketio_setoption(ioHandle, "tcp_keepalive_time", &time);
+    result = socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(size_t, 0, g_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 1, list_item_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_setoption_passes_tcp_keepalive_interval_to_setsockopt)
+TEST_FUNCTION(when_CONSTBUFFER_Clone_fails_socketio_send_constbuffer_fails)
 {
     // arrange
-    CONCRETE_IO_HANDLE ioHandle = setup_socket();
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int result;
+    g_sendmsg_errno = EAGAIN;
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(sendmsg(TEST_FIRST_SOCKET, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_Clone(TEST_CONSTBUFFER_HANDLE))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
-    umock_c_reset_all_calls();
+    // act
+    result = socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, list_item_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    int interval = 15;
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    STRICT_EXPECTED_CALL(setsockopt(*(int*)ioHandle, SOL_TCP, TCP_KEEPINTVL,
-        &interval, sizeof(int)));
+TEST_FUNCTION(socketio_send_constbuffer_partially_sent_queues_the_rest_of_the_caller_bytes)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int result;
+    g_sendmsg_max_bytes = 3;
 
     // act
-    int result = socketio_setoption(ioHandle, "tcp_keepalive_interval", &interval);
+    result = socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL);
+    g_sendmsg_max_bytes = SIZE_MAX;
+    socketio_dowork(socket_io);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
-    verify_mocks_and_destroy_socket(ioHandle);
+    ASSERT_ARE_EQUAL(size_t, 2, g_sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_constbuffer_bytes), g_sent_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_sent_bytes, test_constbuffer_bytes, sizeof(test_constbuffer_bytes)));
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_send_results[0]);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-#endif
+TEST_FUNCTION(when_a_queued_constbuffer_is_sent_its_reference_is_released)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    g_sendmsg_errno = EAGAIN;
+    (void)socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL);
+    g_sendmsg_errno = 0;
+    umock_c_reset_all_calls();
 
-/* Seems like the below tests require a full blown rewrite */
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_next_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(sendmsg(TEST_FIRST_SOCKET, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_Destroy(TEST_CONSTBUFFER_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(recv(TEST_FIRST_SOCKET, IGNORED_PTR_ARG, IGNORED_NUM_ARG, 0));
 
-#if 0
+    // act
+    socketio_dowork(socket_io);
 
-TEST_SUITE_INITIALIZE(suite_init)
-{
-    test_serialize_mutex = MicroMockCreateMutex();
-    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_send_results[0]);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_sent_bytes, test_constbuffer_bytes, sizeof(test_constbuffer_bytes)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_SUITE_CLEANUP(suite_cleanup)
+TEST_FUNCTION(socketio_destroy_releases_the_reference_of_a_constbuffer_still_queued)
 {
-    MicroMockDestroyMutex(test_serialize_mutex);
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    g_sendmsg_errno = EAGAIN;
+    (void)socketio_send_constbuffer(socket_io, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(close(TEST_FIRST_SOCKET));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_Destroy(TEST_CONSTBUFFER_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(socket_io));
+
+    // act
+    socketio_destroy(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_send_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-TEST_FUNCTION_INITIALIZE(method_init)
+/* socketio_dowork with pending IOs */
+
+TEST_FUNCTION(socketio_dowork_flushes_all_pending_IOs_with_a_single_sendmsg)
 {
-    if (!MicroMockAcquireMutex(test_serialize_mutex))
-    {
-        ASSERT_FAIL("Could not acquire test serialization mutex.");
-    }
-    list_head_count = 0;
-    list_add_called = false;
-    g_addrinfo_call_fail = false;
-    //g_socket_send_size_value = -1;
-    g_socket_recv_size_value = -1;
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    queue_sends(socket_io, 3, 4);
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, 3, g_sendmsg_iov_counts[0]);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_send_bytes), g_sent_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_sent_bytes, test_send_bytes, sizeof(test_send_bytes)));
+    ASSERT_ARE_EQUAL(size_t, 3, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_send_results[0]);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_send_results[1]);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_send_results[2]);
+    ASSERT_ARE_EQUAL(size_t, 0, list_item_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION_CLEANUP(method_cleanup)
+TEST_FUNCTION(a_partial_write_ending_inside_an_IO_completes_the_IOs_before_it_and_resumes_inside_it)
 {
-    if (!MicroMockReleaseMutex(test_serialize_mutex))
-    {
-        ASSERT_FAIL("Could not release test serialization mutex.");
-    }
+    // arrange
+    XIO_STATISTICS queued_statistics;
+    XIO_STATISTICS statistics;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    queue_sends(socket_io, 3, 4);
+    g_sendmsg_max_bytes = 6;
+    ASSERT_ARE_EQUAL(int, 0, socketio_get_statistics(socket_io, &queued_statistics));
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 2, list_item_count);
+    ASSERT_ARE_EQUAL(int, 0, socketio_get_statistics(socket_io, &statistics));
+    ASSERT_ARE_EQUAL(uint64_t, queued_statistics.would_block_count + 1, statistics.would_block_count);
+
+    // act
+    g_sendmsg_max_bytes = SIZE_MAX;
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, 3, g_sendmsg_iov_counts[0]);
+    ASSERT_ARE_EQUAL(size_t, 2, g_sendmsg_iov_counts[1]);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_send_bytes), g_sent_byte_count);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_sent_bytes, test_send_bytes, sizeof(test_send_bytes)));
+    ASSERT_ARE_EQUAL(size_t, 3, g_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 0, list_item_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-static void OnBytesReceived(void* context, const unsigned char* buffer, size_t size)
+TEST_FUNCTION(a_partial_write_ending_on_an_IO_boundary_leaves_the_next_IO_untouched)
 {
-    (void)context;
-    (void)buffer;
-    (void)size;
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    queue_sends(socket_io, 3, 4);
+    g_sendmsg_max_bytes = 8;
+
+    // act
+    socketio_dowork(socket_io);
+    g_sendmsg_max_bytes = SIZE_MAX;
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_sendmsg_iov_counts[1]);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_sent_bytes, test_send_bytes, sizeof(test_send_bytes)));
+    ASSERT_ARE_EQUAL(size_t, 3, g_send_complete_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-static void PrintLogFunction(unsigned int options, char* format, ...)
+TEST_FUNCTION(socketio_dowork_sends_at_most_IOV_MAX_pending_IOs_per_sendmsg)
 {
-    (void)options;
-    (void)format;
+    // arrange
+    XIO_STATISTICS queued_statistics;
+    XIO_STATISTICS statistics;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    queue_sends(socket_io, TEST_MAX_IOV + 1, 1);
+    ASSERT_ARE_EQUAL(int, 0, socketio_get_statistics(socket_io, &queued_statistics));
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, TEST_MAX_IOV, g_sendmsg_iov_counts[0]);
+    ASSERT_ARE_EQUAL(size_t, TEST_MAX_IOV, g_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 1, list_item_count);
+    ASSERT_ARE_EQUAL(int, 0, socketio_get_statistics(socket_io, &statistics));
+    ASSERT_ARE_EQUAL(uint64_t, queued_statistics.would_block_count + 0, statistics.would_block_count);
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_sendmsg_iov_counts[1]);
+    ASSERT_ARE_EQUAL(size_t, TEST_MAX_IOV + 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 0, list_item_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-static void OnSendComplete(void* context, IO_SEND_RESULT send_result)
+TEST_FUNCTION(when_sendmsg_would_block_the_pending_IOs_stay_queued_and_are_sent_by_the_next_dowork)
 {
-    (void)context;
-    (void)send_result;
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    XIO_STATISTICS statistics;
+    queue_sends(socket_io, 2, 4);
+    g_sendmsg_errno = EAGAIN;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 2, list_item_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_io_error_count);
+    ASSERT_ARE_EQUAL(int, 0, socketio_get_statistics(socket_io, &statistics));
+    ASSERT_ARE_EQUAL(size_t, 8, statistics.queued_bytes);
+
+    // act
+    g_sendmsg_errno = 0;
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_sendmsg_call_count);
+    ASSERT_ARE_EQUAL(size_t, 2, g_sendmsg_iov_counts[1]);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_sent_bytes, test_send_bytes, 8));
+    ASSERT_ARE_EQUAL(size_t, 2, g_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 0, list_item_count);
+    ASSERT_ARE_EQUAL(int, 0, socketio_get_statistics(socket_io, &statistics));
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.queued_bytes);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-/* socketio_win32_create */
-TEST_FUNCTION(socketio_create_io_create_parameters_NULL_fails)
+TEST_FUNCTION(when_sendmsg_fails_for_pending_IOs_an_error_is_indicated)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    queue_sends(socket_io, 2, 4);
+    g_sendmsg_errno = ECONNRESET;
 
     // act
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(NULL, PrintLogFunction);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_IS_NULL(ioHandle);
+    ASSERT_ARE_EQUAL(size_t, 1, g_io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 1, list_item_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_create_list_create_fails)
+/* socketio_dowork receive buffer */
+
+TEST_FUNCTION(without_adaptive_receive_buffer_every_recv_uses_the_default_size)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    const ssize_t recv_sizes[] = { RECEIVE_BYTES_VALUE, RECEIVE_BYTES_VALUE, 10 };
+    set_recv_sizes(recv_sizes, sizeof(recv_sizes) / sizeof(recv_sizes[0]));
 
-    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_create()).SetReturn((SINGLYLINKEDLIST_HANDLE)NULL);
-    EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 4, g_recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[0]);
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[1]);
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[2]);
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[3]);
+    ASSERT_ARE_EQUAL(size_t, 3, g_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, (2 * RECEIVE_BYTES_VALUE) + 10, g_bytes_received_total);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+TEST_FUNCTION(with_adaptive_receive_buffer_a_full_recv_doubles_the_next_one)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    bool adaptive = true;
+    const ssize_t recv_sizes[] = { RECEIVE_BYTES_VALUE, 2 * RECEIVE_BYTES_VALUE, 4 * RECEIVE_BYTES_VALUE, 10 };
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_ADAPTIVE_RECEIVE_BUFFER, &adaptive));
+    set_recv_sizes(recv_sizes, sizeof(recv_sizes) / sizeof(recv_sizes[0]));
 
     // act
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_IS_NULL(ioHandle);
+    ASSERT_ARE_EQUAL(size_t, 5, g_recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[0]);
+    ASSERT_ARE_EQUAL(size_t, 2 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[1]);
+    ASSERT_ARE_EQUAL(size_t, 4 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[2]);
+    ASSERT_ARE_EQUAL(size_t, 8 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[3]);
+    ASSERT_ARE_EQUAL(size_t, 8 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[4]);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_create_succeeds)
+TEST_FUNCTION(with_adaptive_receive_buffer_a_recv_that_is_not_full_does_not_grow_the_buffer)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    bool adaptive = true;
+    const ssize_t recv_sizes[] = { RECEIVE_BYTES_VALUE - 1, RECEIVE_BYTES_VALUE - 1 };
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_ADAPTIVE_RECEIVE_BUFFER, &adaptive));
+    set_recv_sizes(recv_sizes, sizeof(recv_sizes) / sizeof(recv_sizes[0]));
+
+    // act
+    socketio_dowork(socket_io);
 
-    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_create());
-    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 3, g_recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[1]);
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[2]);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+TEST_FUNCTION(with_adaptive_receive_buffer_the_growth_stops_at_receive_buffer_size)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    bool adaptive = true;
+    size_t receive_buffer_size = 3 * RECEIVE_BYTES_VALUE;
+    const ssize_t recv_sizes[] = { RECEIVE_BYTES_VALUE, 2 * RECEIVE_BYTES_VALUE, 3 * RECEIVE_BYTES_VALUE };
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_ADAPTIVE_RECEIVE_BUFFER, &adaptive));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_RECEIVE_BUFFER_SIZE, &receive_buffer_size));
+    set_recv_sizes(recv_sizes, sizeof(recv_sizes) / sizeof(recv_sizes[0]));
 
     // act
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_IS_NOT_NULL(ioHandle);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 4, g_recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, 2 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[1]);
+    ASSERT_ARE_EQUAL(size_t, 3 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[2]);
+    ASSERT_ARE_EQUAL(size_t, 3 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[3]);
 
-    socketio_destroy(ioHandle);
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-// socketio_win32_destroy 
-TEST_FUNCTION(socketio_destroy_socket_io_NULL_succeeds)
+TEST_FUNCTION(with_adaptive_receive_buffer_each_idle_dowork_halves_the_buffer_down_to_the_default_size)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    bool adaptive = true;
+    const ssize_t recv_sizes[] = { RECEIVE_BYTES_VALUE, 2 * RECEIVE_BYTES_VALUE, 4 * RECEIVE_BYTES_VALUE, 10 };
+    size_t i;
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_ADAPTIVE_RECEIVE_BUFFER, &adaptive));
+    set_recv_sizes(recv_sizes, sizeof(recv_sizes) / sizeof(recv_sizes[0]));
+    socketio_dowork(socket_io);
+
+    for (i = 8; i >= 1; i /= 2)
+    {
+        // act
+        set_recv_sizes(recv_sizes, 0);
+        socketio_dowork(socket_io);
+
+        // assert
+        ASSERT_ARE_EQUAL(size_t, 1, g_recv_call_count);
+        ASSERT_ARE_EQUAL(size_t, i * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[0]);
+    }
 
     // act
-    socketio_destroy(NULL);
+    set_recv_sizes(recv_sizes, 0);
+    socketio_dowork(socket_io);
 
     // assert
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[0]);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_destroy_socket_succeeds)
+TEST_FUNCTION(with_adaptive_receive_buffer_a_dowork_that_received_data_does_not_shrink_the_buffer)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    bool adaptive = true;
+    const ssize_t grow_sizes[] = { RECEIVE_BYTES_VALUE, 10 };
+    const ssize_t small_sizes[] = { 10 };
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_ADAPTIVE_RECEIVE_BUFFER, &adaptive));
+    set_recv_sizes(grow_sizes, sizeof(grow_sizes) / sizeof(grow_sizes[0]));
+    socketio_dowork(socket_io);
+    set_recv_sizes(small_sizes, sizeof(small_sizes) / sizeof(small_sizes[0]));
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // act
+    socketio_dowork(socket_io);
+    set_recv_sizes(small_sizes, 0);
+    socketio_dowork(socket_io);
 
-    mocks.ResetAllCalls();
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[0]);
 
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG))
-        .ExpectedAtLeastTimes(2);
-    EXPECTED_CALL(mocks, singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, singlylinkedlist_destroy(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, gballoc_free(IGNORED_PTR_ARG));
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    list_head_count = 1;
+TEST_FUNCTION(when_growing_the_receive_buffer_fails_the_current_buffer_keeps_being_used)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    bool adaptive = true;
+    const ssize_t recv_sizes[] = { RECEIVE_BYTES_VALUE, RECEIVE_BYTES_VALUE, 10 };
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_ADAPTIVE_RECEIVE_BUFFER, &adaptive));
+    set_recv_sizes(recv_sizes, sizeof(recv_sizes) / sizeof(recv_sizes[0]));
+    whenShallrealloc_fail = currentrealloc_call + 1;
 
     // act
-    socketio_destroy(ioHandle);
+    socketio_dowork(socket_io);
 
     // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 4, g_recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[1]);
+    ASSERT_ARE_EQUAL(size_t, 2 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[2]);
+    ASSERT_ARE_EQUAL(size_t, (2 * RECEIVE_BYTES_VALUE) + 10, g_bytes_received_total);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_open_socket_io_NULL_fails)
+TEST_FUNCTION(when_allocating_the_receive_buffer_fails_an_error_is_indicated_and_nothing_is_received)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    size_t receive_buffer_size = 2 * RECEIVE_BYTES_VALUE;
+    const ssize_t recv_sizes[] = { 10 };
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_RECEIVE_BUFFER_SIZE, &receive_buffer_size));
+    set_recv_sizes(recv_sizes, sizeof(recv_sizes) / sizeof(recv_sizes[0]));
+    whenShallrealloc_fail = currentrealloc_call + 1;
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+    // act
+    socketio_dowork(socket_io);
 
-    mocks.ResetAllCalls();
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_recv_call_count);
 
     // act
-    int result = socketio_open(NULL, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, g_recv_call_count);
+    ASSERT_ARE_EQUAL(size_t, 2 * RECEIVE_BYTES_VALUE, g_recv_buffer_sizes[0]);
+    ASSERT_ARE_EQUAL(size_t, 10, g_bytes_received_total);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_open_socket_fails)
+TEST_FUNCTION(socketio_setoption_with_receive_buffer_size_out_of_range_fails)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    size_t too_small = 0;
+    size_t too_large = RECEIVE_BYTES_MAX_VALUE + 1;
+
+    // act
+    int result_too_small = socketio_setoption(socket_io, OPTION_RECEIVE_BUFFER_SIZE, &too_small);
+    int result_too_large = socketio_setoption(socket_io, OPTION_RECEIVE_BUFFER_SIZE, &too_large);
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_too_small);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_too_large);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    mocks.ResetAllCalls();
+/* socket tuning options */
 
-    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG))
-        .SetReturn(-1);
+TEST_FUNCTION(socketio_setoption_tcp_nodelay_before_open_is_stored_and_applied_to_the_connecting_socket)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    int value = 1;
+    int result;
 
     // act
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    result = socketio_setoption(socket_io, "tcp_nodelay", &value);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_setsockopt_call_count);
+
+    // act
+    open_socketio_async(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    socketio_dowork(socket_io);
 
-    socketio_destroy(ioHandle);
+    // assert
+    ASSERT_ARE_EQUAL(int, 1, g_socket_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_setsockopt_call_count);
+    ASSERT_ARE_EQUAL(int, IPPROTO_TCP, g_setsockopt_levels[0]);
+    ASSERT_ARE_EQUAL(int, TCP_NODELAY, g_setsockopt_optnames[0]);
+    ASSERT_ARE_EQUAL(int, 1, g_setsockopt_values[0]);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
+TEST_FUNCTION(socketio_setoption_tuning_option_set_to_0_before_open_is_applied_to_the_connecting_socket)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    int value = 0;
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "so_sndbuf", &value));
+    open_socketio_async(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+
+    // act
+    socketio_dowork(socket_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_setsockopt_call_count);
+    ASSERT_ARE_EQUAL(int, SOL_SOCKET, g_setsockopt_levels[0]);
+    ASSERT_ARE_EQUAL(int, SO_SNDBUF, g_setsockopt_optnames[0]);
+    ASSERT_ARE_EQUAL(int, 0, g_setsockopt_values[0]);
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-TEST_FUNCTION(socketio_open_getaddrinfo_fails)
+TEST_FUNCTION(socketio_without_tuning_options_no_socket_option_is_set_on_connect)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    open_socketio_async(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+
+    // act
+    socketio_dowork(socket_io);
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // assert
+    ASSERT_ARE_EQUAL(int, 1, g_socket_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_setsockopt_call_count);
 
-    mocks.ResetAllCalls();
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    g_addrinfo_call_fail = true;
-    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
+TEST_FUNCTION(socketio_when_applying_a_tuning_option_on_connect_fails_the_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    int value = 65536;
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "so_rcvbuf", &value));
+    open_socketio_async(socket_io);
+    add_ipv4_address();
+    g_is_lookup_complete = true;
+    g_setsockopt_result = -1;
 
     // act
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_open_result);
+    ASSERT_IS_TRUE(g_is_closed[0]);
 
-    socketio_destroy(ioHandle);
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_open_connect_fails)
+TEST_FUNCTION(socketio_setoption_tuning_option_when_open_is_applied_immediately)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int value = 1;
+    int result;
+
+    // act
+    result = socketio_setoption(socket_io, "tcp_nodelay", &value);
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_setsockopt_call_count);
+    ASSERT_ARE_EQUAL(int, IPPROTO_TCP, g_setsockopt_levels[0]);
+    ASSERT_ARE_EQUAL(int, TCP_NODELAY, g_setsockopt_optnames[0]);
+    ASSERT_ARE_EQUAL(int, 1, g_setsockopt_values[0]);
 
-    mocks.ResetAllCalls();
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, connect(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(-1);
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, freeaddrinfo(IGNORED_PTR_ARG));
+TEST_FUNCTION(socketio_setoption_tuning_option_with_a_negative_value_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int value = -1;
+    int result;
 
     // act
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    result = socketio_setoption(socket_io, "so_sndbuf", &value);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(size_t, 0, g_setsockopt_call_count);
 
-    socketio_destroy(ioHandle);
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_open_ioctlsocket_fails)
+TEST_FUNCTION(socketio_setoption_tuning_option_when_setsockopt_fails_the_option_stays_unset)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    const IO_INTERFACE_DESCRIPTION* interface_description = socketio_get_interface_description();
+    int value = 1;
+    int result;
+    OPTIONHANDLER_HANDLE options;
+    g_setsockopt_result = -1;
 
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    // act
+    result = socketio_setoption(socket_io, "tcp_nodelay", &value);
 
-    mocks.ResetAllCalls();
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
 
-    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(mocks, getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, connect(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    //EXPECTED_CALL(mocks, fcntl(IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG))
-    //    .SetReturn(-1);
-    EXPECTED_CALL(mocks, freeaddrinfo(IGNORED_PTR_ARG));
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
+    // arrange
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     // act
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    options = interface_description->concrete_io_retrieveoptions(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    mocks.AssertActualAndExpectedCalls();
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, options);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    socketio_destroy(ioHandle);
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-//TEST_FUNCTION(socketio_open_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-//    EXPECTED_CALL(mocks, getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, connect(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-//    EXPECTED_CALL(mocks, freeaddrinfo(IGNORED_PTR_ARG));
-//
-//    // act
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//
-//    // assert
-//    ASSERT_ARE_EQUAL(int, 0, result);
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
-
-TEST_FUNCTION(socketio_close_socket_io_NULL_fails)
+TEST_FUNCTION(socketio_retrieveoptions_returns_the_tuning_options_that_were_set)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    const IO_INTERFACE_DESCRIPTION* interface_description = socketio_get_interface_description();
+    int nodelay = 0;
+    int sndbuf = 16384;
+    OPTIONHANDLER_HANDLE options;
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "tcp_nodelay", &nodelay));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "so_sndbuf", &sndbuf));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "tcp_nodelay", IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(3, &nodelay, sizeof(nodelay));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "so_sndbuf", IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(3, &sndbuf, sizeof(sndbuf));
 
     // act
-    int result = socketio_close(NULL);
+    options = interface_description->concrete_io_retrieveoptions(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, options);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_close_Succeeds)
+#ifdef TCP_QUICKACK
+TEST_FUNCTION(socketio_dowork_with_tcp_quickack_rearms_it_after_a_read)
 {
     // arrange
-    socketio_mocks mocks;
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int value = 1;
+    const ssize_t recv_sizes[] = { 10 };
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "tcp_quickack", &value));
+    set_recv_sizes(recv_sizes, sizeof(recv_sizes) / sizeof(recv_sizes[0]));
+    g_setsockopt_call_count = 0;
+
+    // act
+    socketio_dowork(socket_io);
 
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_setsockopt_call_count);
+    ASSERT_ARE_EQUAL(int, IPPROTO_TCP, g_setsockopt_levels[0]);
+    ASSERT_ARE_EQUAL(int, TCP_QUICKACK, g_setsockopt_optnames[0]);
+    ASSERT_ARE_EQUAL(int, 1, g_setsockopt_values[0]);
 
-    mocks.ResetAllCalls();
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
-    EXPECTED_CALL(mocks, close(IGNORED_NUM_ARG));
+TEST_FUNCTION(socketio_dowork_with_tcp_quickack_does_not_rearm_it_when_nothing_was_read)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int value = 1;
+    const ssize_t recv_sizes[] = { 10 };
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "tcp_quickack", &value));
+    set_recv_sizes(recv_sizes, 0);
+    g_setsockopt_call_count = 0;
 
     // act
-    result = socketio_close(ioHandle);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_setsockopt_call_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_send_socket_io_fails)
+TEST_FUNCTION(socketio_dowork_with_tcp_quickack_set_to_0_does_not_rearm_it)
 {
     // arrange
-    socketio_mocks mocks;
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int value = 0;
+    const ssize_t recv_sizes[] = { 10 };
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, "tcp_quickack", &value));
+    set_recv_sizes(recv_sizes, sizeof(recv_sizes) / sizeof(recv_sizes[0]));
+    g_setsockopt_call_count = 0;
 
     // act
-    int result = socketio_send(NULL, (const void*)TEST_BUFFER_VALUE, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
+    socketio_dowork(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_setsockopt_call_count);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
+#endif
 
-TEST_FUNCTION(socketio_send_buffer_NULL_fails)
+TEST_FUNCTION(socketio_retrieveoptions_does_not_return_the_on_io_writable_callback)
 {
     // arrange
-    socketio_mocks mocks;
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    CONCRETE_IO_HANDLE socket_io = create_socketio();
+    const IO_INTERFACE_DESCRIPTION* interface_description = socketio_get_interface_description();
+    OPTIONHANDLER_HANDLE options;
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_ON_IO_WRITABLE, (const void*)test_on_io_writable));
+    ASSERT_ARE_EQUAL(int, 0, socketio_setoption(socket_io, OPTION_ON_IO_WRITABLE_CONTEXT, (void*)0x4242));
+    umock_c_reset_all_calls();
 
-    mocks.ResetAllCalls();
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     // act
-    result = socketio_send(ioHandle, NULL, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
+    options = interface_description->concrete_io_retrieveoptions(socket_io);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, options);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-TEST_FUNCTION(socketio_send_size_zero_fails)
+/* socketio_setoption */
+
+TEST_FUNCTION(socketio_setoption_with_NULL_handle_fails)
 {
     // arrange
-    socketio_mocks mocks;
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
+    int value = 1;
+
+    // act
+    int result = socketio_setoption(NULL, "tcp_keepalive", &value);
 
-    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    mocks.ResetAllCalls();
+TEST_FUNCTION(socketio_setoption_with_an_unknown_option_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int value = 1;
 
     // act
-    result = socketio_send(ioHandle, (const void*)TEST_BUFFER_VALUE, 0, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
+    int result = socketio_setoption(socket_io, "unsupported_option_name", &value);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    socketio_destroy(socket_io);
 }
 
-// TBD:  To be implemented when fcntl is mocked
-//TEST_FUNCTION(socketio_send_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, send(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-//
-//    // act
-//    result = socketio_send(ioHandle, (const void*)TEST_BUFFER_VALUE, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
-//
-//    // assert
-//    ASSERT_ARE_EQUAL(int, 0, result);
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
-
-// TBD:  To be implemented when fcntl is mocked
-//TEST_FUNCTION(socketio_send_returns_1_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//    ASSERT_ARE_EQUAL(int, 0, result);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, send(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG)).SetReturn(1);
-//    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
-//    EXPECTED_CALL(mocks, gballoc_malloc(IGNORED_NUM_ARG));
-//    EXPECTED_CALL(mocks, singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-//
-//    // act
-//    result = socketio_send(ioHandle, (const void*)TEST_BUFFER_VALUE, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
-//
-//    // assert
-//    ASSERT_ARE_EQUAL(int, 0, result);
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
-
-TEST_FUNCTION(socketio_dowork_socket_io_NULL_fails)
-{
-    // arrange
-    socketio_mocks mocks;
-
-    // act
-    socketio_dowork(NULL);
-
-    // assert
-}
-
-// TBD:  To be implemented when fcntl is mocked
-//TEST_FUNCTION(socketio_dowork_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, recv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-//
-//    // act
-//    socketio_dowork(ioHandle);
-//
-//    // assert
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
-
-// TBD:  To be implemented when fcntl is mocked
-//TEST_FUNCTION(socketio_dowork_recv_bytes_succeeds)
-//{
-//    // arrange
-//    socketio_mocks mocks;
-//    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-//    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig, PrintLogFunction);
-//
-//    int result = socketio_open(ioHandle, OnBytesReceived, OnIoStateChanged, &callbackContext);
-//
-//    mocks.ResetAllCalls();
-//
-//    EXPECTED_CALL(mocks, singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-//    EXPECTED_CALL(mocks, recv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG))
-//        .CopyOutArgumentBuffer(2, "t", 1)
-//        .SetReturn(1);
-//    EXPECTED_CALL(mocks, recv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
-//
-//    // act
-//    socketio_dowork(ioHandle);
-//
-//    // assert
-//    mocks.AssertActualAndExpectedCalls();
-//
-//    socketio_destroy(ioHandle);
-//}
+TEST_FUNCTION(socketio_setoption_passes_tcp_keepalive_to_setsockopt)
+{
+    // arrange
+    CONCRETE_IO_HANDLE socket_io = create_open_socketio();
+    int value = 1;
+    int result;
 
-#endif
+    STRICT_EXPECTED_CALL(setsockopt(TEST_FIRST_SOCKET, SOL_SOCKET, SO_KEEPALIVE, &value, sizeof(int)));
 
-END_TEST_SUITE(socketio_berkeley_unittests)
+    // act
+    result = socketio_setoption(socket_io, "tcp_keepalive", &value);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(socket_io);
+}
 
+END_TEST_SUITE(socketio_berkeley_unittests)
@@ -0,0 +1,498 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+
+/* the underlying IO is mocked, the TLS peer is a real OpenSSL server connected through memory BIOs */
+#include "openssl/ssl.h"
+#include "openssl/x509.h"
+#include "openssl/evp.h"
+#include "openssl/ec.h"
+#include "openssl/objects.h"
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umock_c_negative_tests.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void* real_malloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void* real_realloc(void* ptr, size_t size)
+    {
+        return realloc(ptr, size);
+    }
+
+    void real_free(void* ptr)
+    {
+        free(ptr);
+    }
+
+    int real_mallocAndStrcpy_s(char** destination, const char* source);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/x509_openssl.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/tlsio_openssl.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+#define TEST_UNDERLYING_IO_INTERFACE        (const IO_INTERFACE_DESCRIPTION*)0x4242
+#define TEST_UNDERLYING_IO                  (XIO_HANDLE)0x4243
+#define TEST_LOCK_HANDLE                    (LOCK_HANDLE)0x4244
+#define TEST_CONDITION_HANDLE               (COND_HANDLE)0x4245
+
+static const unsigned char test_plaintext[] = { 'h', 'e', 'l', 'l', 'o' };
+
+/* the underlying IO */
+static ON_IO_OPEN_COMPLETE g_on_io_open_complete;
+static void* g_on_io_open_complete_context;
+static ON_BYTES_RECEIVED g_on_bytes_received;
+static void* g_on_bytes_received_context;
+static int g_xio_send_result;
+static size_t g_xio_send_call_count;
+
+/* the TLS server on the other end */
+static SSL_CTX* g_server_ssl_context;
+static SSL* g_server_ssl;
+static BIO* g_server_input;
+static BIO* g_server_output;
+static unsigned char g_server_plaintext[256];
+static size_t g_server_plaintext_size;
+
+/* the tlsio callbacks */
+static size_t g_open_complete_count;
+static IO_OPEN_RESULT g_open_result;
+static size_t g_send_complete_count;
+static IO_SEND_RESULT g_send_result;
+static size_t g_io_writable_count;
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)xio;
+    (void)on_io_error;
+    (void)on_io_error_context;
+    g_on_io_open_complete = on_io_open_complete;
+    g_on_io_open_complete_context = on_io_open_complete_context;
+    g_on_bytes_received = on_bytes_received;
+    g_on_bytes_received_context = on_bytes_received_context;
+    return 0;
+}
+
+/* like socketio, bytes are either all taken (and completed right away) or refused with XIO_SEND_WOULD_BLOCK */
+static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    (void)xio;
+
+    g_xio_send_call_count++;
+
+    if (g_xio_send_result != 0)
+    {
+        result = g_xio_send_result;
+    }
+    else
+    {
+        (void)BIO_write(g_server_input, buffer, (int)size);
+        if (on_send_complete != NULL)
+        {
+            on_send_complete(callback_context, IO_SEND_OK);
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+static int my_xio_get_statistics(XIO_HANDLE xio, XIO_STATISTICS* statistics)
+{
+    (void)xio;
+    (void)memset(statistics, 0, sizeof(XIO_STATISTICS));
+    return 0;
+}
+
+static int test_validation_callback(X509_STORE_CTX* store_context, void* data)
+{
+    (void)store_context;
+    (void)data;
+    return 1;
+}
+
+static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    g_open_complete_count++;
+    g_open_result = open_result;
+}
+
+static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    (void)buffer;
+    (void)size;
+}
+
+static void test_on_io_error(void* context)
+{
+    (void)context;
+}
+
+static void test_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    g_send_complete_count++;
+    g_send_result = send_result;
+}
+
+static void test_on_io_writable(void* context)
+{
+    (void)context;
+    g_io_writable_count++;
+}
+
+static EVP_PKEY* create_server_key(void)
+{
+    EVP_PKEY* result = NULL;
+    EVP_PKEY_CTX* key_context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+    ASSERT_IS_NOT_NULL(key_context);
+    ASSERT_ARE_EQUAL(int, 1, EVP_PKEY_keygen_init(key_context));
+    ASSERT_ARE_EQUAL(int, 1, EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_context, NID_X9_62_prime256v1));
+    ASSERT_ARE_EQUAL(int, 1, EVP_PKEY_keygen(key_context, &result));
+    EVP_PKEY_CTX_free(key_context);
+    return result;
+}
+
+static X509* create_server_certificate(EVP_PKEY* key)
+{
+    X509* result = X509_new();
+    X509_NAME* name;
+    ASSERT_IS_NOT_NULL(result);
+
+    (void)X509_set_version(result, 2);
+    (void)ASN1_INTEGER_set(X509_get_serialNumber(result), 1);
+    (void)X509_gmtime_adj(X509_get_notBefore(result), 0);
+    (void)X509_gmtime_adj(X509_get_notAfter(result), 3600);
+    (void)X509_set_pubkey(result, key);
+    name = X509_get_subject_name(result);
+    (void)X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+    (void)X509_set_issuer_name(result, name);
+    ASSERT_ARE_NOT_EQUAL(int, 0, X509_sign(result, key, EVP_sha256()));
+
+    return result;
+}
+
+static void create_server(void)
+{
+    EVP_PKEY* key = create_server_key();
+    X509* certificate = create_server_certificate(key);
+
+    g_server_ssl_context = SSL_CTX_new(TLS_server_method());
+    ASSERT_IS_NOT_NULL(g_server_ssl_context);
+    ASSERT_ARE_EQUAL(int, 1, SSL_CTX_use_certificate(g_server_ssl_context, certificate));
+    ASSERT_ARE_EQUAL(int, 1, SSL_CTX_use_PrivateKey(g_server_ssl_context, key));
+    X509_free(certificate);
+    EVP_PKEY_free(key);
+
+    g_server_ssl = SSL_new(g_server_ssl_context);
+    ASSERT_IS_NOT_NULL(g_server_ssl);
+    g_server_input = BIO_new(BIO_s_mem());
+    g_server_output = BIO_new(BIO_s_mem());
+    SSL_set_bio(g_server_ssl, g_server_input, g_server_output);
+    SSL_set_accept_state(g_server_ssl);
+    g_server_plaintext_size = 0;
+}
+
+static void destroy_server(void)
+{
+    SSL_free(g_server_ssl);
+    SSL_CTX_free(g_server_ssl_context);
+    g_server_ssl = NULL;
+    g_server_ssl_context = NULL;
+}
+
+/* lets the server process what the tlsio sent and hands the server's answer to the tlsio */
+static void pump_server(void)
+{
+    unsigned char buffer[4096];
+    int size;
+
+    if (!SSL_is_init_finished(g_server_ssl))
+    {
+        (void)SSL_do_handshake(g_server_ssl);
+    }
+
+    if (SSL_is_init_finished(g_server_ssl))
+    {
+        while ((size = SSL_read(g_server_ssl, g_server_plaintext + g_server_plaintext_size, (int)(sizeof(g_server_plaintext) - g_server_plaintext_size))) > 0)
+        {
+            g_server_plaintext_size += (size_t)size;
+        }
+    }
+
+    while ((size = BIO_read(g_server_output, buffer, sizeof(buffer))) > 0)
+    {
+        g_on_bytes_received(g_on_bytes_received_context, buffer, (size_t)size);
+    }
+}
+
+static CONCRETE_IO_HANDLE create_open_tlsio(void)
+{
+    TLSIO_CONFIG config;
+    CONCRETE_IO_HANDLE result;
+    int tls_version = 12;
+    size_t i;
+
+    create_server();
+
+    (void)memset(&config, 0, sizeof(config));
+    config.hostname = "localhost";
+    config.port = 443;
+    config.underlying_io_interface = TEST_UNDERLYING_IO_INTERFACE;
+    config.underlying_io_parameters = NULL;
+
+    result = tlsio_openssl_create(&config);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_setoption(result, OPTION_TLS_VERSION, &tls_version));
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_setoption(result, "tls_validation_callback", (const void*)test_validation_callback));
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_setoption(result, OPTION_ON_IO_WRITABLE, (const void*)test_on_io_writable));
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_open(result, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL));
+
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    for (i = 0; (i < 10) && (g_open_complete_count == 0); i++)
+    {
+        pump_server();
+    }
+
+    /* the server reads the client's last handshake flight */
+    pump_server();
+
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(int, (int)IO_OPEN_OK, (int)g_open_result);
+
+    g_xio_send_call_count = 0;
+    umock_c_reset_all_calls();
+
+    return result;
+}
+
+static void destroy_tlsio(CONCRETE_IO_HANDLE tls_io)
+{
+    g_xio_send_result = 0;
+    (void)tlsio_openssl_close(tls_io, NULL, NULL);
+    tlsio_openssl_destroy(tls_io);
+    destroy_server();
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(tlsio_openssl_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, real_mallocAndStrcpy_s);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_send, my_xio_send);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_get_statistics, my_xio_get_statistics);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_UNDERLYING_IO);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_CONDITION_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(x509_openssl_init, 0);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_STATISTICS*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+
+    result = tlsio_openssl_init();
+    ASSERT_ARE_EQUAL(int, 0, result);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    tlsio_openssl_deinit();
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    g_xio_send_result = 0;
+    g_xio_send_call_count = 0;
+    g_open_complete_count = 0;
+    g_open_result = IO_OPEN_ERROR;
+    g_send_complete_count = 0;
+    g_send_result = IO_SEND_ERROR;
+    g_io_writable_count = 0;
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* tlsio_openssl_send */
+
+TEST_FUNCTION(tlsio_openssl_send_hands_the_record_to_the_underlying_io)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    int result;
+
+    // act
+    result = tlsio_openssl_send(tls_io, test_plaintext, sizeof(test_plaintext), test_on_send_complete, NULL);
+    pump_server();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(int, (int)IO_SEND_OK, (int)g_send_result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_plaintext), g_server_plaintext_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_server_plaintext, test_plaintext, sizeof(test_plaintext)));
+
+    // cleanup
+    destroy_tlsio(tls_io);
+}
+
+TEST_FUNCTION(when_the_underlying_io_would_block_tlsio_openssl_send_returns_XIO_SEND_WOULD_BLOCK)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    int result;
+    g_xio_send_result = XIO_SEND_WOULD_BLOCK;
+
+    // act
+    result = tlsio_openssl_send(tls_io, test_plaintext, sizeof(test_plaintext), test_on_send_complete, NULL);
+    pump_server();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, XIO_SEND_WOULD_BLOCK, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_xio_send_call_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_server_plaintext_size);
+
+    // cleanup
+    destroy_tlsio(tls_io);
+}
+
+TEST_FUNCTION(a_send_refused_with_XIO_SEND_WOULD_BLOCK_is_sent_once_when_the_caller_sends_the_same_bytes_again)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    unsigned char retried_plaintext[sizeof(test_plaintext)];
+    int result;
+    g_xio_send_result = XIO_SEND_WOULD_BLOCK;
+    (void)tlsio_openssl_send(tls_io, test_plaintext, sizeof(test_plaintext), test_on_send_complete, NULL);
+    g_xio_send_result = 0;
+    (void)memcpy(retried_plaintext, test_plaintext, sizeof(test_plaintext));
+
+    // act
+    result = tlsio_openssl_send(tls_io, retried_plaintext, sizeof(retried_plaintext), test_on_send_complete, NULL);
+    pump_server();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(int, (int)IO_SEND_OK, (int)g_send_result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_plaintext), g_server_plaintext_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_server_plaintext, test_plaintext, sizeof(test_plaintext)));
+
+    // cleanup
+    destroy_tlsio(tls_io);
+}
+
+TEST_FUNCTION(after_the_underlying_io_would_block_tlsio_openssl_dowork_indicates_the_io_is_writable_once_it_drained)
+{
+    // arrange
+    CONCRETE_IO_HANDLE tls_io = create_open_tlsio();
+    g_xio_send_result = XIO_SEND_WOULD_BLOCK;
+    (void)tlsio_openssl_send(tls_io, test_plaintext, sizeof(test_plaintext), test_on_send_complete, NULL);
+    g_xio_send_result = 0;
+
+    // act
+    tlsio_openssl_dowork(tls_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_io_writable_count);
+
+    // cleanup
+    destroy_tlsio(tls_io);
+}
+
+END_TEST_SUITE(tlsio_openssl_ut)
@@ -5,11 +5,13 @@
 #include <cstdlib>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #endif
 
 #include "testrunnerswitcher.h"
@@ -58,6 +60,7 @@ Tests_SRS_UWS_CLIENT_01_211: [ One implication of this is that in absence of ext
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/uws_frame_encoder.h"
+#include "azure_c_shared_utility/uws_deflate.h"
 #include "azure_c_shared_utility/gb_rand.h"
 #include "azure_c_shared_utility/base64.h"
 
@@ -78,6 +81,7 @@ static const XIO_HANDLE TEST_IO_HANDLE = (XIO_HANDLE)0x4244;
 static const OPTIONHANDLER_HANDLE TEST_IO_OPTIONHANDLER_HANDLE = (OPTIONHANDLER_HANDLE)0x4446;
 static const OPTIONHANDLER_HANDLE TEST_OPTIONHANDLER_HANDLE = (OPTIONHANDLER_HANDLE)0x4447;
 static const STRING_HANDLE BASE64_ENCODED_STRING = (STRING_HANDLE)0x4447;
+static const UWS_DEFLATE_HANDLE TEST_UWS_DEFLATE_HANDLE = (UWS_DEFLATE_HANDLE)0x4448;
 
 static size_t currentmalloc_call;
 static size_t whenShallmalloc_fail;
@@ -330,6 +334,8 @@ MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_open_complete, void*, context, WS_OPE
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_frame_received, void*, context, unsigned char, frame_type, const unsigned char*, buffer, size_t, size)
 MOCK_FUNCTION_END()
+MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_fragment_received, void*, context, unsigned char, frame_type, const unsigned char*, buffer, size_t, size, bool, is_first, bool, is_final)
+MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_peer_closed, void*, context, uint16_t*, close_code, const unsigned char*, extra_data, size_t, extra_data_length)
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_error, void*, context, WS_ERROR, error_code);
@@ -478,6 +484,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, real_BUFFER_length);
     REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_encode, my_uws_frame_encoder_encode);
     REGISTER_GLOBAL_MOCK_RETURN(STRING_c_str, "test_str");
+    REGISTER_GLOBAL_MOCK_RETURN(uws_deflate_create, TEST_UWS_DEFLATE_HANDLE);
     REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
     REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
     REGISTER_TYPE(WS_OPEN_RESULT, WS_OPEN_RESULT);
@@ -501,10 +508,18 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_FRAME_DECODED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_STATISTICS*, void*);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(UWS_DEFLATE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const WS_PERMESSAGE_DEFLATE_OPTIONS*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(WS_PERMESSAGE_DEFLATE_OPTIONS*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(bool*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const unsigned char**, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(size_t*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(unsigned char*, void*);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -3752,6 +3767,40 @@ TEST_FUNCTION(when_all_but_1_bytes_are_received_from_the_response_no_open_comple
     }
 }
 
+/* Tests_SRS_UWS_CLIENT_01_593: [ The accumulated bytes shall be parsed by calling `http_response_parser_parse`, so that only the bytes received since the previous call are scanned for the end of the response head. ]*/
+/* Tests_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
+TEST_FUNCTION(when_the_response_is_received_in_chunks_split_inside_the_double_new_line_the_open_complete_is_indicated)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response_part_1[] = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r";
+    const char test_upgrade_response_part_2[] = "\n\r";
+    const char test_upgrade_response_part_3[] = "\n";
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response_part_1, sizeof(test_upgrade_response_part_1) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response_part_2, sizeof(test_upgrade_response_part_2) - 1);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response_part_3, sizeof(test_upgrade_response_part_3) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 /* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames by passing them to `uws_frame_decoder_decode`. ]*/
 TEST_FUNCTION(when_1_extra_byte_is_received_the_open_complete_is_properly_indicated_and_the_extra_byte_is_saved_for_decoding_frames)
 {
@@ -3813,7 +3862,6 @@ TEST_FUNCTION(when_a_1_byte_binary_frame_is_received_it_shall_be_indicated_to_th
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
 
@@ -3850,7 +3898,6 @@ TEST_FUNCTION(when_a_1_byte_text_frame_is_received_it_shall_be_indicated_to_the_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
 
@@ -3884,7 +3931,6 @@ TEST_FUNCTION(when_a_0_bytes_binary_frame_is_received_it_shall_be_indicated_to_t
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_buffer();
 
@@ -3918,7 +3964,6 @@ TEST_FUNCTION(when_a_0_bytes_text_frame_is_received_it_shall_be_indicated_to_the
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_buffer();
 
@@ -3959,7 +4004,6 @@ TEST_FUNCTION(when_a_125_bytes_binary_frame_is_received_it_shall_be_indicated_to
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 125))
         .ValidateArgumentBuffer(3, &test_frame[2], 125);
 
@@ -3998,7 +4042,6 @@ TEST_FUNCTION(when_a_126_bytes_binary_frame_is_received_it_shall_be_indicated_to
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 126))
         .ValidateArgumentBuffer(3, &test_frame[4], 126);
 
@@ -4037,7 +4080,6 @@ TEST_FUNCTION(when_a_127_bytes_binary_frame_is_received_it_shall_be_indicated_to
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 127))
         .ValidateArgumentBuffer(3, &test_frame[4], 127);
 
@@ -4080,7 +4122,6 @@ TEST_FUNCTION(when_a_65535_bytes_binary_frame_is_received_it_shall_be_indicated_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65535))
         .ValidateArgumentBuffer(3, &test_frame[4], 65535);
 
@@ -4130,7 +4171,6 @@ TEST_FUNCTION(when_a_65536_bytes_binary_frame_is_received_it_shall_be_indicated_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65536))
         .ValidateArgumentBuffer(3, &test_frame[10], 65536);
 
@@ -4180,7 +4220,6 @@ TEST_FUNCTION(when_a_65537_bytes_binary_frame_is_received_it_shall_be_indicated_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65537))
         .ValidateArgumentBuffer(3, &test_frame[10], 65537);
 
@@ -4214,7 +4253,6 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_16_bit_length_an_error
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4252,7 +4290,6 @@ TEST_FUNCTION(when_a_125_byte_binary_frame_is_received_with_16_bit_length_an_err
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4284,7 +4321,6 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_64_bit_length_an_error
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4332,7 +4368,6 @@ TEST_FUNCTION(when_a_65535_byte_binary_frame_is_received_with_64_bit_length_an_e
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4365,7 +4400,6 @@ TEST_FUNCTION(check_for_16_bit_length_too_low_is_done_as_soon_as_length_is_recei
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4397,7 +4431,6 @@ TEST_FUNCTION(check_for_64_bit_length_too_low_is_done_as_soon_as_length_is_recei
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4445,7 +4478,6 @@ TEST_FUNCTION(when_the_highest_bit_is_set_in_a_64_bit_length_frame_an_error_is_i
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4466,7 +4498,7 @@ TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x00 };
+    unsigned char test_frame[102] = { 0x82, 0x7D };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4477,6 +4509,7 @@ TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
+    /* the incomplete frame does not fit in the bytes left over from the upgrade response */
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_NOT_ENOUGH_MEMORY));
@@ -4491,6 +4524,119 @@ TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error
     uws_client_destroy(uws_client);
 }
 
+/* Tests_SRS_UWS_CLIENT_01_538: [ If no bytes are pending from previous calls, the WebSocket frames shall be decoded directly from `buffer`, without copying it. ]*/
+TEST_FUNCTION(when_several_complete_frames_are_received_in_one_call_they_are_indicated_without_allocating_memory)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frames[] = { 0x82, 0x01, 0x42, 0x81, 0x01, 'a', 0x82, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, &test_frames[2], 1));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, &test_frames[5], 1));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
+        .IgnoreArgument_buffer();
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_539: [ Only the bytes of an incomplete frame left at the end of `buffer` shall be accumulated for decoding with the bytes received in subsequent calls. ]*/
+TEST_FUNCTION(when_a_frame_is_received_in_2_calls_it_is_indicated_after_the_second_call)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frames[] = { 0x82, 0x01, 0x42, 0x82, 0x02, 0x43, 0x44 };
+    const unsigned char expected_payload[] = { 0x43, 0x44 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, &test_frames[2], 1));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(expected_payload)))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, 5);
+    g_on_bytes_received(g_on_bytes_received_context, test_frames + 5, sizeof(test_frames) - 5);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_540: [ The memory used for accumulating received bytes shall be grown geometrically and kept across calls, so that it is not reallocated for every received chunk. ]*/
+TEST_FUNCTION(when_a_large_frame_is_received_in_many_calls_memory_is_not_reallocated_for_each_call)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char* test_frame = (unsigned char*)malloc(65536 + 10);
+    size_t i;
+
+    test_frame[0] = 0x82;
+    test_frame[1] = 0x7F;
+    test_frame[2] = 0x00;
+    test_frame[3] = 0x00;
+    test_frame[4] = 0x00;
+    test_frame[5] = 0x00;
+    test_frame[6] = 0x00;
+    test_frame[7] = 0x01;
+    test_frame[8] = 0x00;
+    test_frame[9] = 0x00;
+    for (i = 0; i < 65536; i++)
+    {
+        test_frame[10 + i] = (unsigned char)i;
+    }
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+    currentrealloc_call = 0;
+
+    // act
+    for (i = 0; i + 64 < 65536 + 10; i += 64)
+    {
+        g_on_bytes_received(g_on_bytes_received_context, test_frame + i, 64);
+    }
+    g_on_bytes_received(g_on_bytes_received_context, test_frame + i, 65536 + 10 - i);
+
+    // assert
+    ASSERT_IS_TRUE(currentrealloc_call < 20);
+
+    // cleanup
+    free(test_frame);
+    uws_client_destroy(uws_client);
+}
+
 /* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
 TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_byte_with_a_separate_call_decoding_frame_succeeds)
 {
@@ -4513,7 +4659,6 @@ TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)upgrade_response_frame, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_buffer();
 
@@ -4673,7 +4818,6 @@ TEST_FUNCTION(when_a_masked_frame_is_received_an_error_is_indicated_and_connecti
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .CaptureReturn(&buffer_handle);
@@ -4725,7 +4869,6 @@ TEST_FUNCTION(when_a_masked_frame_is_received_and_encoding_the_close_frame_fails
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .SetReturn(NULL);
@@ -4765,7 +4908,6 @@ TEST_FUNCTION(when_a_masked_frame_is_received_and_sending_the_encoded_CLOSE_fram
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .CaptureReturn(&buffer_handle);
@@ -4823,7 +4965,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_the_code_is_reported_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -4876,7 +5017,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_without_a_close_code_while_in_open_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -4927,7 +5067,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_extra_bytes_the_bytes_are_pass
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 2))
         .ValidateArgumentBuffer(1, &close_frame[4], 2);
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
@@ -4977,7 +5116,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_a_malformed_UTF8_text_the_conn
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(1, &close_frame[4], 1)
         .SetReturn(false);
@@ -5018,7 +5156,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_encoding_the_outg
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -5060,7 +5197,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_sending_the_outgo
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -5502,6 +5638,68 @@ TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
     uws_client_destroy(uws_client);
 }
 
+/* Tests_SRS_UWS_CLIENT_01_537: [ If `xio_send` returns `XIO_SEND_WOULD_BLOCK`, `uws_client_send_frame_async` shall de-queue the frame and return `XIO_SEND_WOULD_BLOCK`. ]*/
+TEST_FUNCTION(when_xio_send_would_block_uws_client_send_frame_async_returns_XIO_SEND_WOULD_BLOCK)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+    LIST_ITEM_HANDLE new_item_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&buffer_handle);
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .CaptureReturn(&new_item_handle);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)0x1234);
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .ValidateArgumentValue_item_handle(&new_item_handle);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, XIO_SEND_WOULD_BLOCK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 /* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
 TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails_message_removed_by_xio_send)
 {
@@ -6380,7 +6578,6 @@ TEST_FUNCTION(when_a_PING_frame_was_received_a_PONG_frame_is_sent)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, IGNORED_PTR_ARG, 0, true, true, 0))
         .IgnoreArgument_payload()
         .CaptureReturn(&buffer_handle);
@@ -6431,7 +6628,6 @@ TEST_FUNCTION(when_a_PING_frame_was_received_with_some_payload_a_PONG_frame_is_s
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, pong_frame_payload, sizeof(pong_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, pong_frame_payload, sizeof(pong_frame_payload))
         .CaptureReturn(&buffer_handle);
@@ -6477,7 +6673,6 @@ TEST_FUNCTION(when_a_PING_frame_is_received_after_a_close_frame_no_pong_is_sent)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -7006,7 +7201,6 @@ TEST_FUNCTION(underlying_io_close_after_a_send_close_frame_failed_puts_the_uws_i
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7058,7 +7252,6 @@ TEST_FUNCTION(underlying_io_close_due_to_CLOSE_frame_being_received_doe_not_trig
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7101,7 +7294,6 @@ TEST_FUNCTION(underlying_io_close_complete_with_NULL_context_does_nothing)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7189,4 +7381,1898 @@ TEST_FUNCTION(when_close_complete_is_called_and_the_user_callback_is_NULL_no_cal
     uws_client_destroy(uws_client);
 }
 
+/* uws_client_get_statistics */
+
+/* Tests_SRS_UWS_CLIENT_01_532: [ If any of the arguments `uws_client` or `statistics` is NULL, `uws_client_get_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_get_statistics_with_NULL_uws_client_fails)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+
+    // act
+    result = uws_client_get_statistics(NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_532: [ If any of the arguments `uws_client` or `statistics` is NULL, `uws_client_get_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_get_statistics_with_NULL_statistics_fails)
+{
+    // arrange
+    int result;
+    UWS_CLIENT_HANDLE uws_client;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_get_statistics(uws_client, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_533: [ `uws_client_get_statistics` shall obtain the statistics of the underlying IO by calling `xio_get_statistics`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_535: [ `bytes_sent` and `bytes_received` shall be set to the number of payload bytes of the data frames sent with `uws_client_send_frame_async` and indicated through `on_ws_frame_received`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_536: [ On success, `uws_client_get_statistics` shall return 0. ]*/
+TEST_FUNCTION(uws_client_get_statistics_reports_the_underlying_io_counters_and_the_payload_bytes)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+    XIO_STATISTICS underlying_statistics;
+    UWS_CLIENT_HANDLE uws_client;
+
+    (void)memset(&underlying_statistics, 0, sizeof(underlying_statistics));
+    underlying_statistics.bytes_sent = 100;
+    underlying_statistics.bytes_received = 200;
+    underlying_statistics.queued_bytes = 42;
+    underlying_statistics.queued_send_count = 2;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_get_statistics(TEST_IO_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_statistics(&underlying_statistics, sizeof(underlying_statistics));
+
+    // act
+    result = uws_client_get_statistics(uws_client, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 42, statistics.queued_bytes);
+    ASSERT_ARE_EQUAL(size_t, 2, statistics.queued_send_count);
+    ASSERT_IS_TRUE(statistics.bytes_sent == 0);
+    ASSERT_IS_TRUE(statistics.bytes_received == 0);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_534: [ If `xio_get_statistics` fails, all the counters shall be reported as 0. ]*/
+TEST_FUNCTION(when_xio_get_statistics_fails_uws_client_get_statistics_reports_zero_counters)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+    UWS_CLIENT_HANDLE uws_client;
+
+    (void)memset(&statistics, 0xFF, sizeof(statistics));
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_get_statistics(TEST_IO_HANDLE, &statistics))
+        .SetReturn(1);
+
+    // act
+    result = uws_client_get_statistics(uws_client, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.queued_bytes);
+    ASSERT_IS_TRUE(statistics.would_block_count == 0);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* permessage-deflate */
+
+static UWS_CLIENT_HANDLE create_uws_client_with_permessage_deflate(void)
+{
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { false, false, 0, 0 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+
+    return uws_client;
+}
+
+static UWS_CLIENT_HANDLE open_uws_client_with_permessage_deflate(void)
+{
+    UWS_CLIENT_HANDLE uws_client = create_uws_client_with_permessage_deflate();
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: permessage-deflate\r\n\r\n";
+    bool is_accepted = true;
+
+    STRICT_EXPECTED_CALL(uws_deflate_parse_response(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_is_accepted(&is_accepted, sizeof(is_accepted));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    return uws_client;
+}
+
+/* Tests_SRS_UWS_CLIENT_01_562: [ Otherwise `uws_client_set_option` shall copy the `WS_PERMESSAGE_DEFLATE_OPTIONS` pointed to by `value`, and permessage-deflate shall be offered for subsequent connections. ]*/
+/* Tests_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_permessage_deflate_copies_the_options)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { true, false, 10, 0 };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &options);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_563: [ If allocating memory for the copy fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_memory_for_the_permessage_deflate_options_fails_uws_client_set_option_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { false, false, 0, 0 };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &options);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_560: [ If `client_max_window_bits` is not 0 or 9 to 15, or `server_max_window_bits` is not 0 or 8 to 15, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_invalid_permessage_deflate_window_bits_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS client_8_options = { false, false, 8, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS server_16_options = { false, false, 0, 16 };
+    int result_1;
+    int result_2;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result_1 = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &client_8_options);
+    result_2 = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &server_16_options);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_559: [ If the option name is `ws_permessage_deflate` and the uws instance is not CLOSED, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_permessage_deflate_while_opening_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { false, false, 0, 0 };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &options);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_543: [ If permessage-deflate was enabled with `uws_client_set_option`, the upgrade request shall carry a `Sec-WebSocket-Extensions` header with the offer obtained by calling `uws_deflate_format_offer`. ]*/
+TEST_FUNCTION(on_underlying_io_open_complete_with_permessage_deflate_enabled_sends_the_extension_offer)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { false, false, 0, 0 };
+    size_t i;
+    const char test_offer[] = "permessage-deflate; client_max_window_bits";
+    const char expected_upgrade_request[] = "GET /aaa HTTP/1.1\r\n"
+        "Host: test_host:444\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: ZWRuYW1vZGU6bm9jYXBlcyE=\r\n"
+        "Sec-WebSocket-Protocol: test_protocol\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n"
+        "\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    for (i = 0; i < 16; i++)
+    {
+        EXPECTED_CALL(gb_rand());
+    }
+
+    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 16));
+    STRICT_EXPECTED_CALL(STRING_c_str(BASE64_ENCODED_STRING)).SetReturn("ZWRuYW1vZGU6bm9jYXBlcyE=");
+    STRICT_EXPECTED_CALL(uws_deflate_format_offer(IGNORED_PTR_ARG, IGNORED_PTR_ARG, UWS_DEFLATE_MAX_OFFER_SIZE))
+        .CopyOutArgumentBuffer_buffer(test_offer, sizeof(test_offer));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(expected_upgrade_request) - 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, expected_upgrade_request, sizeof(expected_upgrade_request) - 1)
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(BASE64_ENCODED_STRING));
+
+    // act
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_544: [ If `uws_deflate_format_offer` fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST`. ]*/
+TEST_FUNCTION(when_formatting_the_extension_offer_fails_the_error_WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { false, false, 0, 0 };
+    size_t i;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    for (i = 0; i < 16; i++)
+    {
+        EXPECTED_CALL(gb_rand());
+    }
+
+    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 16));
+    STRICT_EXPECTED_CALL(STRING_c_str(BASE64_ENCODED_STRING));
+    STRICT_EXPECTED_CALL(uws_deflate_format_offer(IGNORED_PTR_ARG, IGNORED_PTR_ARG, UWS_DEFLATE_MAX_OFFER_SIZE))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST));
+    STRICT_EXPECTED_CALL(STRING_delete(BASE64_ENCODED_STRING));
+
+    // act
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_545: [ If permessage-deflate was offered, the `Sec-WebSocket-Extensions` header of the upgrade response (compared case insensitive, an absent header meaning no extensions were accepted) shall be parsed by calling `uws_deflate_parse_response`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_548: [ If the server accepted permessage-deflate, a compression context shall be created by calling `uws_deflate_create` with the negotiated options. ]*/
+TEST_FUNCTION(an_upgrade_response_accepting_permessage_deflate_creates_the_compression_context)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nsec-websocket-extensions:  permessage-deflate; client_max_window_bits=10 \r\n\r\n";
+    const char expected_extensions[] = "permessage-deflate; client_max_window_bits=10";
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 10, 15 };
+    bool is_accepted = true;
+
+    uws_client = create_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_parse_response(IGNORED_PTR_ARG, IGNORED_PTR_ARG, sizeof(expected_extensions) - 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, expected_extensions, sizeof(expected_extensions) - 1)
+        .CopyOutArgumentBuffer_negotiated_options(&negotiated_options, sizeof(negotiated_options))
+        .CopyOutArgumentBuffer_is_accepted(&is_accepted, sizeof(is_accepted));
+    STRICT_EXPECTED_CALL(uws_deflate_create(IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(1, &negotiated_options, sizeof(negotiated_options));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_547: [ If the server did not accept permessage-deflate, frames shall be exchanged uncompressed. ]*/
+TEST_FUNCTION(an_upgrade_response_without_extensions_opens_without_compression)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+
+    uws_client = create_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_parse_response(IGNORED_PTR_ARG, NULL, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_546: [ If `uws_deflate_parse_response` fails, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+TEST_FUNCTION(when_parsing_the_extensions_in_the_upgrade_response_fails_the_error_WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: x-webkit-deflate-frame\r\n\r\n";
+
+    uws_client = create_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_parse_response(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_549: [ If `uws_deflate_create` fails, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+TEST_FUNCTION(when_creating_the_compression_context_fails_the_error_WS_OPEN_ERROR_NOT_ENOUGH_MEMORY_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: permessage-deflate\r\n\r\n";
+    bool is_accepted = true;
+
+    uws_client = create_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_parse_response(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_is_accepted(&is_accepted, sizeof(is_accepted));
+    STRICT_EXPECTED_CALL(uws_deflate_create(IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_550: [ The payload of a data frame that has RSV1 set, and of the continuation frames that follow it, shall be decompressed by calling `uws_deflate_decompress`, passing whether the frame is the final frame of the message. ]*/
+/* Tests_SRS_UWS_CLIENT_01_552: [ The decompressed bytes shall be indicated as a frame of the message type. ]*/
+TEST_FUNCTION(a_compressed_text_message_in_2_frames_is_decompressed_and_indicated_as_text)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frames[] = { 0x41, 0x02, 0xF2, 0x48, 0x80, 0x03, 0xCD, 0xC9, 0x07 };
+    const unsigned char first_decompressed[] = { 'H' };
+    const unsigned char second_decompressed[] = { 'e', 'l', 'l', 'o' };
+    const unsigned char* first_decompressed_ptr = first_decompressed;
+    const unsigned char* second_decompressed_ptr = second_decompressed;
+    size_t first_decompressed_size = sizeof(first_decompressed);
+    size_t second_decompressed_size = sizeof(second_decompressed);
+
+    uws_client = open_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_deflate_decompress(TEST_UWS_DEFLATE_HANDLE, IGNORED_PTR_ARG, 2, false, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, test_frames + 2, 2)
+        .CopyOutArgumentBuffer_decompressed(&first_decompressed_ptr, sizeof(first_decompressed_ptr))
+        .CopyOutArgumentBuffer_decompressed_size(&first_decompressed_size, sizeof(first_decompressed_size));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, sizeof(first_decompressed)))
+        .ValidateArgumentBuffer(3, first_decompressed, sizeof(first_decompressed));
+    STRICT_EXPECTED_CALL(uws_deflate_decompress(TEST_UWS_DEFLATE_HANDLE, IGNORED_PTR_ARG, 3, true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, test_frames + 6, 3)
+        .CopyOutArgumentBuffer_decompressed(&second_decompressed_ptr, sizeof(second_decompressed_ptr))
+        .CopyOutArgumentBuffer_decompressed_size(&second_decompressed_size, sizeof(second_decompressed_size));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, sizeof(second_decompressed)))
+        .ValidateArgumentBuffer(3, second_decompressed, sizeof(second_decompressed));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_551: [ If `uws_deflate_decompress` fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1007 shall be sent. ]*/
+TEST_FUNCTION(when_decompressing_a_frame_fails_an_error_is_indicated_and_a_close_frame_with_1007_is_sent)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frame[] = { 0xC2, 0x01, 0x42 };
+    const unsigned char close_frame_payload[] = { 0x03, 0xEF };
+
+    uws_client = open_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_deflate_decompress(TEST_UWS_DEFLATE_HANDLE, IGNORED_PTR_ARG, 1, true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_594: [ If `uws_deflate_decompress` returns `UWS_DEFLATE_MESSAGE_TOO_BIG`, the CLOSE frame shall be sent with status code 1009 instead. ]*/
+TEST_FUNCTION(when_a_frame_decompresses_to_a_too_big_message_an_error_is_indicated_and_a_close_frame_with_1009_is_sent)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frame[] = { 0xC2, 0x01, 0x42 };
+    const unsigned char close_frame_payload[] = { 0x03, 0xF1 };
+
+    uws_client = open_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_deflate_decompress(TEST_UWS_DEFLATE_HANDLE, IGNORED_PTR_ARG, 1, true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(UWS_DEFLATE_MESSAGE_TOO_BIG);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_553: [ If a frame with RSV1 set is received while permessage-deflate was not negotiated, or RSV1 is set on a control frame or a continuation frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+TEST_FUNCTION(a_frame_with_RSV1_set_when_permessage_deflate_was_not_negotiated_indicates_an_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame[] = { 0xC2, 0x01, 0x42 };
+    const unsigned char close_frame_payload[] = { 0x03, 0xEA };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_553: [ If a frame with RSV1 set is received while permessage-deflate was not negotiated, or RSV1 is set on a control frame or a continuation frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+TEST_FUNCTION(a_control_frame_with_RSV1_set_indicates_an_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frame[] = { 0xC9, 0x00 };
+
+    uws_client = open_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, 2, true, true, 0));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_555: [ If permessage-deflate was negotiated, the payload of data frames shall be compressed by calling `uws_deflate_compress`, passing the `is_final` flag. ]*/
+/* Tests_SRS_UWS_CLIENT_01_557: [ The RSV1 bit shall be set on the first frame of a compressed message. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_permessage_deflate_sends_the_compressed_payload_with_RSV1)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 'H', 'e', 'l', 'l', 'o' };
+    const unsigned char compressed[] = { 0xF2, 0x48, 0xCD, 0xC9, 0xC9, 0x07, 0x00 };
+    const unsigned char* compressed_ptr = compressed;
+    size_t compressed_size = sizeof(compressed);
+    int result;
+
+    uws_client = open_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_compress(TEST_UWS_DEFLATE_HANDLE, test_payload, sizeof(test_payload), true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_compressed(&compressed_ptr, sizeof(compressed_ptr))
+        .CopyOutArgumentBuffer_compressed_size(&compressed_size, sizeof(compressed_size));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_TEXT_FRAME, compressed, sizeof(compressed), true, true, RESERVED_1));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_TEXT, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_556: [ If `uws_deflate_compress` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_compressing_the_payload_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    uws_client = open_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_compress(TEST_UWS_DEFLATE_HANDLE, test_payload, sizeof(test_payload), true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_558: [ If `xio_send` fails for a compressed frame, the compression context shall be reset by calling `uws_deflate_reset_compressor`, so that later messages do not refer to data the server never received. ]*/
+TEST_FUNCTION(when_sending_a_compressed_frame_would_block_the_compressor_is_reset)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    const unsigned char compressed[] = { 0x72, 0x02, 0x00 };
+    const unsigned char* compressed_ptr = compressed;
+    size_t compressed_size = sizeof(compressed);
+    int result;
+
+    uws_client = open_uws_client_with_permessage_deflate();
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_compress(TEST_UWS_DEFLATE_HANDLE, test_payload, sizeof(test_payload), true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_compressed(&compressed_ptr, sizeof(compressed_ptr))
+        .CopyOutArgumentBuffer_compressed_size(&compressed_size, sizeof(compressed_size));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, compressed, sizeof(compressed), true, true, RESERVED_1));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)0x1234);
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_reset_compressor(TEST_UWS_DEFLATE_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, XIO_SEND_WOULD_BLOCK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_542: [ `uws_client_destroy` shall free the permessage-deflate options set with `uws_client_set_option`. ]*/
+TEST_FUNCTION(uws_client_destroy_frees_the_permessage_deflate_options)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { false, false, 0, 0 };
+
+    uws_client = uws_client_create("test_host", 444, "aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &options);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    uws_client_destroy(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_564: [ `uws_client_clone_option` called with `name` being `ws_permessage_deflate` shall return a newly allocated copy of the `WS_PERMESSAGE_DEFLATE_OPTIONS` value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_566: [ `uws_client_destroy_option` called with the option `name` being `ws_permessage_deflate` shall free the value. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_permessage_deflate_copies_the_options)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { true, true, 12, 11 };
+    void* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = g_clone_option(OPTION_WS_PERMESSAGE_DEFLATE, &options);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(result, &options, sizeof(options)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_destroy_option(OPTION_WS_PERMESSAGE_DEFLATE, result);
+    uws_client_destroy(uws_client);
+}
+
+/* uws_client send coalescing */
+
+static UWS_CLIENT_HANDLE open_uws_client_with_send_coalescing(size_t send_coalescing_limit)
+{
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_SEND_COALESCING_LIMIT, &send_coalescing_limit);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    return uws_client;
+}
+
+/* Tests_SRS_UWS_CLIENT_01_568: [ If the `ws_send_coalescing_limit` option is not 0, `uws_client_send_frame_async` shall not send the frame right away but append it to the bytes coalesced since the last underlying send, encoding its header with `uws_frame_encoder_encode_header` and masking its payload with `uws_frame_encoder_mask`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_042: [ On success, `uws_client_send_frame_async` shall return 0. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_send_coalescing_does_not_send_the_frame)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 1024));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_571: [ If encoding the header, masking the payload or allocating memory for the coalesced frame fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_encoding_the_header_fails_uws_client_send_frame_async_with_send_coalescing_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_571: [ If encoding the header, masking the payload or allocating memory for the coalesced frame fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_masking_the_payload_fails_uws_client_send_frame_async_with_send_coalescing_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 1024));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, 0))
+        .SetReturn(1);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_573: [ If frames were coalesced, `uws_client_dowork` shall send all of them with a single `xio_send` call before calling `xio_dowork`. ]*/
+TEST_FUNCTION(uws_client_dowork_sends_the_coalesced_frames_with_one_xio_send)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2 * (header_length + sizeof(test_payload)), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_572: [ Once the coalesced bytes reach the limit they shall be sent right away. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_sends_the_coalesced_frames_when_the_limit_is_reached)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(7);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 7));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, 7, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_569: [ If appending the frame would take the coalesced bytes over the limit, the frames coalesced so far shall be sent first. ]*/
+/* Tests_SRS_UWS_CLIENT_01_570: [ If sending them returns `XIO_SEND_WOULD_BLOCK`, `uws_client_send_frame_async` shall not queue the frame and return `XIO_SEND_WOULD_BLOCK`. ]*/
+TEST_FUNCTION(when_sending_the_coalesced_frames_would_block_uws_client_send_frame_async_returns_XIO_SEND_WOULD_BLOCK)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42, 0x43 };
+    size_t header_length = 6;
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(10);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, 8, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, XIO_SEND_WOULD_BLOCK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_574: [ If `xio_send` returns `XIO_SEND_WOULD_BLOCK`, the coalesced frames shall be kept and sent by a later call. ]*/
+TEST_FUNCTION(when_xio_send_would_block_uws_client_dowork_sends_the_coalesced_frames_again)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, header_length + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_569: [ If appending the frame would take the coalesced bytes over the limit, the frames coalesced so far shall be sent first. ]*/
+/* Tests_SRS_UWS_CLIENT_01_570: [ If sending them returns `XIO_SEND_WOULD_BLOCK`, `uws_client_send_frame_async` shall not queue the frame and return `XIO_SEND_WOULD_BLOCK`. ]*/
+TEST_FUNCTION(when_blocked_coalesced_frames_are_over_the_limit_uws_client_send_frame_async_returns_XIO_SEND_WOULD_BLOCK)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(5);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, header_length + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, XIO_SEND_WOULD_BLOCK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_595: [ While the coalesced frames are kept after `xio_send` returned `XIO_SEND_WOULD_BLOCK`, they shall also be sent first. ]*/
+/* Tests_SRS_UWS_CLIENT_01_570: [ If sending them returns `XIO_SEND_WOULD_BLOCK`, `uws_client_send_frame_async` shall not queue the frame and return `XIO_SEND_WOULD_BLOCK`. ]*/
+TEST_FUNCTION(while_coalesced_frames_are_blocked_uws_client_send_frame_async_returns_XIO_SEND_WOULD_BLOCK)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, header_length + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, XIO_SEND_WOULD_BLOCK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_575: [ If `xio_send` fails, every coalesced frame shall be indicated by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
+TEST_FUNCTION(when_xio_send_fails_uws_client_dowork_indicates_the_coalesced_frames_as_failed)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value((LIST_ITEM_HANDLE)1));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, (LIST_ITEM_HANDLE)1));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_ERROR));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value((LIST_ITEM_HANDLE)1));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, (LIST_ITEM_HANDLE)1));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4249, WS_SEND_FRAME_ERROR));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_576: [ When the underlying send of coalesced frames completes, every frame it carried shall be removed from the pending sends list and indicated by calling `on_ws_send_frame_complete` with the result mapped as for a single frame. ]*/
+/* Tests_SRS_UWS_CLIENT_01_389: [ When `on_underlying_io_send_complete` is called with `IO_SEND_OK` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_OK`. ]*/
+TEST_FUNCTION(when_the_coalesced_send_completes_each_frame_is_indicated_as_sent)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value((LIST_ITEM_HANDLE)1));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, (LIST_ITEM_HANDLE)1));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_OK));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value((LIST_ITEM_HANDLE)1));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, (LIST_ITEM_HANDLE)1));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4249, WS_SEND_FRAME_OK));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_596: [ Before a CLOSE frame is sent or the underlying IO is closed, the coalesced frames shall be sent by calling `xio_send`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_036: [ For each pending send frame the send complete callback shall be called with `UWS_SEND_FRAME_CANCELLED`. ]*/
+TEST_FUNCTION(uws_client_close_async_sends_the_coalesced_frames_before_closing_the_underlying_io)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, header_length + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+
+    // act
+    (void)uws_client_close_async(uws_client, test_on_ws_close_complete, (void*)0x4301);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_596: [ Before a CLOSE frame is sent or the underlying IO is closed, the coalesced frames shall be sent by calling `xio_send`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_465: [ `uws_client_close_handshake_async` shall initiate the close handshake by sending a close frame to the peer. ]*/
+TEST_FUNCTION(uws_client_close_handshake_async_sends_the_coalesced_frames_before_the_close_frame)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+    unsigned char close_frame_payload[] = { 0x03, 0xE8 };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xE8 };
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, header_length + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), IGNORED_PTR_ARG, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+
+    // act
+    result = uws_client_close_handshake_async(uws_client, 1000, "", test_on_ws_close_complete, (void*)0x4445);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_597: [ If `xio_send` returns `XIO_SEND_WOULD_BLOCK`, every coalesced frame shall be indicated by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_CANCELLED`, as no data frame can follow the CLOSE frame. ]*/
+TEST_FUNCTION(when_sending_the_coalesced_frames_would_block_uws_client_close_handshake_async_cancels_them_and_sends_the_close_frame)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+    unsigned char close_frame_payload[] = { 0x03, 0xE8 };
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, header_length + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn((LIST_ITEM_HANDLE)1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+
+    // act
+    result = uws_client_close_handshake_async(uws_client, 1000, "", test_on_ws_close_complete, (void*)0x4445);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_596: [ Before a CLOSE frame is sent or the underlying IO is closed, the coalesced frames shall be sent by calling `xio_send`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_241: [ If an endpoint receives a Close frame and did not previously send a Close frame, the endpoint MUST send a Close frame in response. ]*/
+TEST_FUNCTION(when_a_CLOSE_frame_is_received_the_coalesced_frames_are_sent_before_the_response_close_frame)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+    unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xE8 };
+    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, header_length + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .SetReturn(sent_close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .SetReturn(sizeof(sent_close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, NULL, 0));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_578: [ If the option name is `ws_send_coalescing_limit` and `value` is NULL, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_NULL_ws_send_coalescing_limit_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_SEND_COALESCING_LIMIT, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_579: [ Otherwise the limit shall be set to the `size_t` pointed to by `value`, and setting it to 0 shall send the frames coalesced so far. ]*/
+/* Tests_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_client_set_option_with_a_0_ws_send_coalescing_limit_sends_the_coalesced_frames)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    size_t header_length = 6;
+    size_t send_coalescing_limit = 0;
+    int result;
+
+    uws_client = open_uws_client_with_send_coalescing(1024);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, IGNORED_NUM_ARG, WS_BINARY_FRAME, IGNORED_NUM_ARG, true, true, 0, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_header_length(&header_length, sizeof(header_length));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, header_length + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_SEND_COALESCING_LIMIT, &send_coalescing_limit);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_583: [ If the coalescing limit is not 0, `uws_client_retrieve_options` shall also add the `ws_send_coalescing_limit` option by calling `OptionHandler_AddOption`. ]*/
+TEST_FUNCTION(uws_client_retrieve_options_adds_the_ws_send_coalescing_limit)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    size_t send_coalescing_limit = 4096;
+    OPTIONHANDLER_HANDLE result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_SEND_COALESCING_LIMIT, &send_coalescing_limit);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_WS_SEND_COALESCING_LIMIT, IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_580: [ `uws_client_clone_option` called with `name` being `ws_send_coalescing_limit` shall return a newly allocated copy of the `size_t` value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_582: [ `uws_client_destroy_option` called with the option `name` being `ws_send_coalescing_limit` shall free the value. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_send_coalescing_limit_copies_the_value)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    size_t send_coalescing_limit = 4096;
+    void* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = g_clone_option(OPTION_WS_SEND_COALESCING_LIMIT, &send_coalescing_limit);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, send_coalescing_limit, *(size_t*)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_destroy_option(OPTION_WS_SEND_COALESCING_LIMIT, result);
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_581: [ If allocating memory for the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_uws_client_clone_option_with_ws_send_coalescing_limit_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    size_t send_coalescing_limit = 4096;
+    void* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = g_clone_option(OPTION_WS_SEND_COALESCING_LIMIT, &send_coalescing_limit);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_598: [ If the fragment callback was set, `uws_client_retrieve_options` shall also add the `ws_on_fragment_received` option and, when not NULL, the `ws_on_fragment_received_context` option by calling `OptionHandler_AddOption`. ]*/
+TEST_FUNCTION(uws_client_retrieve_options_adds_the_fragment_callback_and_its_context)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received);
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, (void*)0x4250);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, (void*)0x4250));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_598: [ If the fragment callback was set, `uws_client_retrieve_options` shall also add the `ws_on_fragment_received` option and, when not NULL, the `ws_on_fragment_received_context` option by calling `OptionHandler_AddOption`. ]*/
+TEST_FUNCTION(uws_client_retrieve_options_with_a_NULL_fragment_context_adds_only_the_fragment_callback)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_adding_the_fragment_callback_option_fails_uws_client_retrieve_options_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received))
+        .SetReturn(OPTIONHANDLER_ERROR);
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_OPTIONHANDLER_HANDLE));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_599: [ `uws_client_clone_option` called with `name` being `ws_on_fragment_received` or `ws_on_fragment_received_context` shall return the same value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_600: [ `uws_client_destroy_option` called with the option `name` being `ws_on_fragment_received` or `ws_on_fragment_received_context` shall do nothing. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_the_fragment_options_returns_the_same_values)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    void* callback_result;
+    void* context_result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    // act
+    callback_result = g_clone_option(OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received);
+    context_result = g_clone_option(OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, (void*)0x4250);
+    g_destroy_option(OPTION_WS_ON_FRAGMENT_RECEIVED, callback_result);
+    g_destroy_option(OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, context_result);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, (void*)test_on_ws_fragment_received, callback_result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4250, context_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* uws_client fragment streaming */
+
+static UWS_CLIENT_HANDLE open_uws_client_with_fragment_callback(void)
+{
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received);
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, (void*)0x4250);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    return uws_client;
+}
+
+static UWS_CLIENT_HANDLE open_uws_client_with_permessage_deflate_and_fragment_callback(void)
+{
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { false, false, 0, 0 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSec-WebSocket-Extensions: permessage-deflate\r\n\r\n";
+    bool is_accepted = true;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_PERMESSAGE_DEFLATE, &options);
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received);
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, (void*)0x4250);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+
+    STRICT_EXPECTED_CALL(uws_deflate_parse_response(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_is_accepted(&is_accepted, sizeof(is_accepted));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    return uws_client;
+}
+
+/* Tests_SRS_UWS_CLIENT_01_586: [ For `ws_on_fragment_received` the `value` shall be stored as the `ON_WS_FRAGMENT_RECEIVED` callback, a NULL `value` restoring whole frame delivery through `on_ws_frame_received`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_587: [ For `ws_on_fragment_received_context` the `value` shall be stored as the context passed to the fragment callback. ]*/
+/* Tests_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_on_fragment_received_succeeds)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result_callback;
+    int result_context;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result_callback = uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received);
+    result_context = uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result_callback);
+    ASSERT_ARE_EQUAL(int, 0, result_context);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_585: [ If the option name is `ws_on_fragment_received` or `ws_on_fragment_received_context` and the uws instance is not CLOSED, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_on_fragment_received_when_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = open_uws_client_with_fragment_callback();
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_585: [ If the option name is `ws_on_fragment_received` or `ws_on_fragment_received_context` and the uws instance is not CLOSED, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_on_fragment_received_context_when_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = open_uws_client_with_fragment_callback();
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, (void*)0x4251);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_586: [ For `ws_on_fragment_received` the `value` shall be stored as the `ON_WS_FRAGMENT_RECEIVED` callback, a NULL `value` restoring whole frame delivery through `on_ws_frame_received`. ]*/
+TEST_FUNCTION(when_the_fragment_callback_is_reset_to_NULL_whole_frames_are_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame[] = { 0x82, 0x01, 0x42 };
+    const unsigned char expected_payload[] = { 0x42 };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED, (const void*)test_on_ws_fragment_received);
+    (void)uws_client_set_option(uws_client, OPTION_WS_ON_FRAGMENT_RECEIVED, NULL);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_588: [ When a fragment callback is set, the payload of a received text, binary or continuation frame shall be indicated as soon as its bytes are received, without waiting for the complete frame. ]*/
+/* Tests_SRS_UWS_CLIENT_01_590: [ Each piece shall be indicated by calling the fragment callback with its context, the message type, the piece bytes and size, `is_first` set only for the first piece of a message and `is_final` set only for the last piece of the final frame of a message. ]*/
+TEST_FUNCTION(when_a_fragment_callback_is_set_a_partially_received_binary_frame_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frame[] = { 0x82, 0x03, 0x42, 0x43 };
+    const unsigned char expected_payload[] = { 0x42, 0x43 };
+
+    uws_client = open_uws_client_with_fragment_callback();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4250, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(expected_payload), true, false))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_588: [ When a fragment callback is set, the payload of a received text, binary or continuation frame shall be indicated as soon as its bytes are received, without waiting for the complete frame. ]*/
+/* Tests_SRS_UWS_CLIENT_01_589: [ The header and the payload bytes indicated shall be consumed, so that no more than a frame header is ever buffered for such frames. ]*/
+/* Tests_SRS_UWS_CLIENT_01_590: [ Each piece shall be indicated by calling the fragment callback with its context, the message type, the piece bytes and size, `is_first` set only for the first piece of a message and `is_final` set only for the last piece of the final frame of a message. ]*/
+TEST_FUNCTION(when_a_fragment_callback_is_set_the_rest_of_a_partially_received_frame_is_indicated_as_it_arrives)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frame_start[] = { 0x82, 0x03, 0x42, 0x43 };
+    const unsigned char test_frame_end[] = { 0x44 };
+
+    uws_client = open_uws_client_with_fragment_callback();
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_start, sizeof(test_frame_start));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4250, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(test_frame_end), false, true))
+        .ValidateArgumentBuffer(3, test_frame_end, sizeof(test_frame_end));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_end, sizeof(test_frame_end));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_589: [ The header and the payload bytes indicated shall be consumed, so that no more than a frame header is ever buffered for such frames. ]*/
+TEST_FUNCTION(when_a_fragment_callback_is_set_a_frame_header_without_payload_bytes_is_kept_until_payload_arrives)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frame_header[] = { 0x81, 0x01 };
+    const unsigned char test_frame_payload[] = { 'a' };
+
+    uws_client = open_uws_client_with_fragment_callback();
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_header, sizeof(test_frame_header));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4250, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, sizeof(test_frame_payload), true, true))
+        .ValidateArgumentBuffer(3, test_frame_payload, sizeof(test_frame_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_payload, sizeof(test_frame_payload));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_590: [ Each piece shall be indicated by calling the fragment callback with its context, the message type, the piece bytes and size, `is_first` set only for the first piece of a message and `is_final` set only for the last piece of the final frame of a message. ]*/
+TEST_FUNCTION(when_a_fragment_callback_is_set_a_fragmented_text_message_is_indicated_with_the_message_type)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frames[] = { 0x01, 0x01, 'a', 0x00, 0x01, 'b', 0x80, 0x01, 'c' };
+
+    uws_client = open_uws_client_with_fragment_callback();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4250, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1, true, false))
+        .ValidateArgumentBuffer(3, test_frames + 2, 1);
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4250, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1, false, false))
+        .ValidateArgumentBuffer(3, test_frames + 5, 1);
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4250, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1, false, true))
+        .ValidateArgumentBuffer(3, test_frames + 8, 1);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_590: [ Each piece shall be indicated by calling the fragment callback with its context, the message type, the piece bytes and size, `is_first` set only for the first piece of a message and `is_final` set only for the last piece of the final frame of a message. ]*/
+TEST_FUNCTION(when_a_fragment_callback_is_set_a_0_bytes_binary_frame_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frame[] = { 0x82, 0x00 };
+
+    uws_client = open_uws_client_with_fragment_callback();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4250, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0, true, true));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_591: [ If a continuation frame is received while no fragmented message is in progress, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+TEST_FUNCTION(when_a_fragment_callback_is_set_a_continuation_frame_without_a_message_indicates_an_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frame[] = { 0x80, 0x01, 0x42 };
+    const unsigned char close_frame_payload[] = { 0x03, 0xEA };
+
+    uws_client = open_uws_client_with_fragment_callback();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_592: [ Payload pieces of a permessage-deflate compressed message shall be decompressed by calling `uws_deflate_decompress` as they arrive, passing `true` as `is_final` only for the last piece of the final frame. ]*/
+TEST_FUNCTION(when_a_fragment_callback_is_set_a_partially_received_compressed_frame_is_decompressed_as_it_arrives)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_frame[] = { 0xC1, 0x03, 0x42, 0x43 };
+    const unsigned char decompressed_payload[] = { 'a', 'b', 'c' };
+    const unsigned char* decompressed_ptr = decompressed_payload;
+    size_t decompressed_size = sizeof(decompressed_payload);
+
+    uws_client = open_uws_client_with_permessage_deflate_and_fragment_callback();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_deflate_decompress(TEST_UWS_DEFLATE_HANDLE, IGNORED_PTR_ARG, 2, false, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, test_frame + 2, 2)
+        .CopyOutArgumentBuffer_decompressed(&decompressed_ptr, sizeof(decompressed_ptr))
+        .CopyOutArgumentBuffer_decompressed_size(&decompressed_size, sizeof(decompressed_size));
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4250, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, sizeof(decompressed_payload), true, false))
+        .ValidateArgumentBuffer(3, decompressed_payload, sizeof(decompressed_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 END_TEST_SUITE(uws_client_ut)
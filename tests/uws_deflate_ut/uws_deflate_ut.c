@@ -0,0 +1,752 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "azure_c_shared_utility/uws_deflate.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+/* "Hello" compressed, as in RFC 7692 section 7.2.3.1 */
+static const unsigned char compressed_hello[] = { 0xF2, 0x48, 0xCD, 0xC9, 0xC9, 0x07, 0x00 };
+
+static int parse_response(const WS_PERMESSAGE_DEFLATE_OPTIONS* offered_options, const char* extensions, WS_PERMESSAGE_DEFLATE_OPTIONS* negotiated_options, bool* is_accepted)
+{
+    return uws_deflate_parse_response(offered_options, extensions, strlen(extensions), negotiated_options, is_accepted);
+}
+
+BEGIN_TEST_SUITE(uws_deflate_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* uws_deflate_format_offer */
+
+/* Tests_SRS_UWS_DEFLATE_01_003: [ `uws_deflate_format_offer` shall write into `buffer` a permessage-deflate extension offer that always carries `client_max_window_bits` (with a value only if `client_max_window_bits` is not 0) and carries `server_max_window_bits`, `client_no_context_takeover` and `server_no_context_takeover` when requested in `options`. ]*/
+/* Tests_SRS_UWS_DEFLATE_01_005: [ On success `uws_deflate_format_offer` shall return 0. ]*/
+TEST_FUNCTION(uws_deflate_format_offer_with_default_options_offers_client_max_window_bits_without_value)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { false, false, 0, 0 };
+    char offer[UWS_DEFLATE_MAX_OFFER_SIZE];
+    int result;
+
+    // act
+    result = uws_deflate_format_offer(&options, offer, sizeof(offer));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "permessage-deflate; client_max_window_bits", offer);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_003: [ `uws_deflate_format_offer` shall write into `buffer` a permessage-deflate extension offer that always carries `client_max_window_bits` (with a value only if `client_max_window_bits` is not 0) and carries `server_max_window_bits`, `client_no_context_takeover` and `server_no_context_takeover` when requested in `options`. ]*/
+TEST_FUNCTION(uws_deflate_format_offer_with_all_options_offers_all_parameters)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { true, true, 12, 10 };
+    char offer[UWS_DEFLATE_MAX_OFFER_SIZE];
+    int result;
+
+    // act
+    result = uws_deflate_format_offer(&options, offer, sizeof(offer));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "permessage-deflate; client_max_window_bits=12; server_max_window_bits=10; client_no_context_takeover; server_no_context_takeover", offer);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_001: [ If `options` or `buffer` is NULL, `uws_deflate_format_offer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_format_offer_with_NULL_options_fails)
+{
+    // arrange
+    char offer[UWS_DEFLATE_MAX_OFFER_SIZE];
+    int result;
+
+    // act
+    result = uws_deflate_format_offer(NULL, offer, sizeof(offer));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_002: [ If `client_max_window_bits` is not 0 or 9 to 15, or `server_max_window_bits` is not 0 or 8 to 15, `uws_deflate_format_offer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_format_offer_with_client_max_window_bits_8_fails)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { false, false, 8, 0 };
+    char offer[UWS_DEFLATE_MAX_OFFER_SIZE];
+    int result;
+
+    // act
+    result = uws_deflate_format_offer(&options, offer, sizeof(offer));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_004: [ If the offer does not fit in `buffer_size` bytes, `uws_deflate_format_offer` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_format_offer_with_a_too_small_buffer_fails)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS options = { true, true, 15, 15 };
+    char offer[20];
+    int result;
+
+    // act
+    result = uws_deflate_format_offer(&options, offer, sizeof(offer));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* uws_deflate_parse_response */
+
+/* Tests_SRS_UWS_DEFLATE_01_008: [ If `extensions` is empty the offer is declined: `is_accepted` shall be set to false and `uws_deflate_parse_response` shall return 0. ]*/
+TEST_FUNCTION(uws_deflate_parse_response_with_no_extensions_declines_the_offer)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS offered_options = { false, false, 0, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+    bool is_accepted = true;
+    int result;
+
+    // act
+    result = uws_deflate_parse_response(&offered_options, NULL, 0, &negotiated_options, &is_accepted);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(is_accepted);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_007: [ If `offered_options`, `negotiated_options` or `is_accepted` is NULL, or `extensions` is NULL while `extensions_length` is not 0, `uws_deflate_parse_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_parse_response_with_NULL_extensions_and_non_zero_length_fails)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS offered_options = { false, false, 0, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+    bool is_accepted;
+    int result;
+
+    // act
+    result = uws_deflate_parse_response(&offered_options, NULL, 1, &negotiated_options, &is_accepted);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_016: [ Window bits that are not present in the response shall be set to the offered value, or to 15 if none was offered. ]*/
+TEST_FUNCTION(uws_deflate_parse_response_without_parameters_uses_15_bit_windows)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS offered_options = { false, false, 0, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+    bool is_accepted;
+    int result;
+
+    // act
+    result = parse_response(&offered_options, "permessage-deflate", &negotiated_options, &is_accepted);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(is_accepted);
+    ASSERT_ARE_EQUAL(int, 15, negotiated_options.client_max_window_bits);
+    ASSERT_ARE_EQUAL(int, 15, negotiated_options.server_max_window_bits);
+    ASSERT_IS_FALSE(negotiated_options.client_no_context_takeover);
+    ASSERT_IS_FALSE(negotiated_options.server_no_context_takeover);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_010: [ A `server_no_context_takeover` parameter shall set `server_no_context_takeover` in `negotiated_options`. ]*/
+/* Tests_SRS_UWS_DEFLATE_01_012: [ A `server_max_window_bits` parameter with a value from 8 to 15, not above the offered value, shall be stored in `negotiated_options`. ]*/
+/* Tests_SRS_UWS_DEFLATE_01_013: [ A `client_max_window_bits` parameter with a value from 9 to 15, not above the offered value, shall be stored in `negotiated_options`. ]*/
+/* Tests_SRS_UWS_DEFLATE_01_017: [ A `client_no_context_takeover` that was offered shall be kept in `negotiated_options` even if the server does not echo it. ]*/
+TEST_FUNCTION(uws_deflate_parse_response_stores_the_accepted_parameters)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS offered_options = { true, false, 12, 10 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+    bool is_accepted;
+    int result;
+
+    // act
+    result = parse_response(&offered_options, "permessage-deflate; server_max_window_bits=\"9\";client_max_window_bits=11 ; server_no_context_takeover", &negotiated_options, &is_accepted);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(is_accepted);
+    ASSERT_ARE_EQUAL(int, 11, negotiated_options.client_max_window_bits);
+    ASSERT_ARE_EQUAL(int, 9, negotiated_options.server_max_window_bits);
+    ASSERT_IS_TRUE(negotiated_options.client_no_context_takeover);
+    ASSERT_IS_TRUE(negotiated_options.server_no_context_takeover);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_041: [ `max_decompressed_message_size` is not negotiated and shall be copied from `offered_options` to `negotiated_options`. ]*/
+TEST_FUNCTION(uws_deflate_parse_response_copies_the_max_decompressed_message_size)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS offered_options = { false, false, 15, 15, 4096 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+    bool is_accepted;
+    int result;
+
+    // act
+    result = parse_response(&offered_options, "permessage-deflate; server_max_window_bits=15", &negotiated_options, &is_accepted);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(is_accepted);
+    ASSERT_ARE_EQUAL(size_t, 4096, negotiated_options.max_decompressed_message_size);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_009: [ If `extensions` contains any extension other than one permessage-deflate, `uws_deflate_parse_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_parse_response_with_another_extension_fails)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS offered_options = { false, false, 0, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+    bool is_accepted;
+    int result_1;
+    int result_2;
+
+    // act
+    result_1 = parse_response(&offered_options, "x-webkit-deflate-frame", &negotiated_options, &is_accepted);
+    result_2 = parse_response(&offered_options, "permessage-deflate, permessage-deflate", &negotiated_options, &is_accepted);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_2);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_014: [ If any parameter is unknown, repeated, has an invalid value or is not allowed by the offer, `uws_deflate_parse_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_parse_response_with_invalid_parameters_fails)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS offered_options = { false, false, 12, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+    bool is_accepted;
+    const char* invalid_responses[] =
+    {
+        "permessage-deflate; foo",
+        "permessage-deflate; server_no_context_takeover; server_no_context_takeover",
+        "permessage-deflate; client_max_window_bits=8",
+        "permessage-deflate; client_max_window_bits=13",
+        "permessage-deflate; server_max_window_bits=16",
+        "permessage-deflate; server_max_window_bits=9 junk"
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof(invalid_responses) / sizeof(invalid_responses[0]); i++)
+    {
+        // act
+        int result = parse_response(&offered_options, invalid_responses[i], &negotiated_options, &is_accepted);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, invalid_responses[i]);
+        ASSERT_IS_FALSE(is_accepted);
+    }
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_015: [ If `server_max_window_bits` was offered and the accepted extension does not carry it, `uws_deflate_parse_response` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_parse_response_without_the_offered_server_max_window_bits_fails)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS offered_options = { false, false, 0, 10 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options;
+    bool is_accepted;
+    int result;
+
+    // act
+    result = parse_response(&offered_options, "permessage-deflate", &negotiated_options, &is_accepted);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* uws_deflate_create */
+
+/* Tests_SRS_UWS_DEFLATE_01_018: [ If `negotiated_options` is NULL, `uws_deflate_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(uws_deflate_create_with_NULL_options_fails)
+{
+    // arrange
+    UWS_DEFLATE_HANDLE result;
+
+    // act
+    result = uws_deflate_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_019: [ If `client_max_window_bits` in `negotiated_options` is not between 9 and 15, `uws_deflate_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(uws_deflate_create_with_client_max_window_bits_8_fails)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 8, 15 };
+    UWS_DEFLATE_HANDLE result;
+
+    // act
+    result = uws_deflate_create(&negotiated_options);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_020: [ `uws_deflate_create` shall allocate a new instance holding a copy of `negotiated_options`. ]*/
+/* Tests_SRS_UWS_DEFLATE_01_026: [ `uws_deflate_destroy` shall end both zlib streams and free all memory held by the instance. ]*/
+TEST_FUNCTION(uws_deflate_create_succeeds)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15 };
+    UWS_DEFLATE_HANDLE result;
+
+    // act
+    result = uws_deflate_create(&negotiated_options);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+
+    // cleanup
+    uws_deflate_destroy(result);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_025: [ If `uws_deflate` is NULL, `uws_deflate_destroy` shall do nothing. ]*/
+TEST_FUNCTION(uws_deflate_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    uws_deflate_destroy(NULL);
+
+    // assert
+    // no explicit assert
+}
+
+/* uws_deflate_decompress */
+
+/* Tests_SRS_UWS_DEFLATE_01_034: [ `uws_deflate_decompress` shall decompress `payload` with `inflate` and `Z_SYNC_FLUSH` into a buffer owned by the instance, which is reused by subsequent calls. ]*/
+/* Tests_SRS_UWS_DEFLATE_01_035: [ When `is_final` is true, the 0x00 0x00 0xFF 0xFF tail shall be inflated after `payload`. ]*/
+/* Tests_SRS_UWS_DEFLATE_01_038: [ On success `uws_deflate_decompress` shall set `decompressed` and `decompressed_size` to the decompressed bytes and return 0. ]*/
+TEST_FUNCTION(uws_deflate_decompress_decompresses_the_rfc_7692_example)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15 };
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    // act
+    result = uws_deflate_decompress(uws_deflate, compressed_hello, sizeof(compressed_hello), true, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 5, decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(decompressed, "Hello", 5));
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_036: [ If growing the output buffer or `inflate` fails, `uws_deflate_decompress` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_decompress_with_invalid_data_fails)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15 };
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    const unsigned char invalid_payload[] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    // act
+    result = uws_deflate_decompress(uws_deflate, invalid_payload, sizeof(invalid_payload), true, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_045: [ `inflate` shall be called until all of `payload` is consumed and it leaves room in the output buffer, so that no decompressed byte is held back by zlib. ]*/
+TEST_FUNCTION(uws_deflate_decompress_returns_the_bytes_zlib_holds_when_the_output_buffer_filled_up_with_the_input)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS compressor_options = { false, false, 15, 15, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15, 0 };
+    UWS_DEFLATE_HANDLE compressor = uws_deflate_create(&compressor_options);
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    unsigned char payload[4100];
+    const unsigned char* compressed;
+    size_t compressed_size;
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    /* without the sync flush tail the last input byte is consumed while 4 KB of output are still pending */
+    (void)memset(payload, 'a', sizeof(payload));
+    (void)uws_deflate_compress(compressor, payload, sizeof(payload), true, &compressed, &compressed_size);
+
+    // act
+    result = uws_deflate_decompress(uws_deflate, compressed, compressed_size, false, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(payload), decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(decompressed, payload, sizeof(payload)));
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+    uws_deflate_destroy(compressor);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_033: [ If `uws_deflate`, `decompressed` or `decompressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_deflate_decompress` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_decompress_with_NULL_handle_fails)
+{
+    // arrange
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    // act
+    result = uws_deflate_decompress(NULL, compressed_hello, sizeof(compressed_hello), true, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_042: [ If the bytes decompressed for the current message, across all the calls made for it, exceed `max_decompressed_message_size`, `uws_deflate_decompress` shall fail and return `UWS_DEFLATE_MESSAGE_TOO_BIG`. ]*/
+TEST_FUNCTION(uws_deflate_decompress_of_a_message_above_the_max_size_fails_with_UWS_DEFLATE_MESSAGE_TOO_BIG)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS compressor_options = { false, false, 15, 15, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15, 3999 };
+    UWS_DEFLATE_HANDLE compressor = uws_deflate_create(&compressor_options);
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    unsigned char payload[4000];
+    const unsigned char* compressed;
+    size_t compressed_size;
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    (void)memset(payload, 'a', sizeof(payload));
+    (void)uws_deflate_compress(compressor, payload, sizeof(payload), true, &compressed, &compressed_size);
+
+    // act
+    result = uws_deflate_decompress(uws_deflate, compressed, compressed_size, true, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, UWS_DEFLATE_MESSAGE_TOO_BIG, result);
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+    uws_deflate_destroy(compressor);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_042: [ If the bytes decompressed for the current message, across all the calls made for it, exceed `max_decompressed_message_size`, `uws_deflate_decompress` shall fail and return `UWS_DEFLATE_MESSAGE_TOO_BIG`. ]*/
+TEST_FUNCTION(uws_deflate_decompress_of_a_message_of_exactly_the_max_size_succeeds)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS compressor_options = { false, false, 15, 15, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15, 4000 };
+    UWS_DEFLATE_HANDLE compressor = uws_deflate_create(&compressor_options);
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    unsigned char payload[4000];
+    const unsigned char* compressed;
+    size_t compressed_size;
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    (void)memset(payload, 'a', sizeof(payload));
+    (void)uws_deflate_compress(compressor, payload, sizeof(payload), true, &compressed, &compressed_size);
+
+    // act
+    result = uws_deflate_decompress(uws_deflate, compressed, compressed_size, true, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(payload), decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(decompressed, payload, sizeof(payload)));
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+    uws_deflate_destroy(compressor);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_042: [ If the bytes decompressed for the current message, across all the calls made for it, exceed `max_decompressed_message_size`, `uws_deflate_decompress` shall fail and return `UWS_DEFLATE_MESSAGE_TOO_BIG`. ]*/
+TEST_FUNCTION(uws_deflate_decompress_counts_the_max_size_across_the_fragments_of_a_message)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS compressor_options = { false, false, 15, 15, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15, 3000 };
+    UWS_DEFLATE_HANDLE compressor = uws_deflate_create(&compressor_options);
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    unsigned char payload[2000];
+    const unsigned char* compressed;
+    size_t compressed_size;
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    (void)memset(payload, 'a', sizeof(payload));
+    (void)uws_deflate_compress(compressor, payload, sizeof(payload), false, &compressed, &compressed_size);
+    ASSERT_ARE_EQUAL(int, 0, uws_deflate_decompress(uws_deflate, compressed, compressed_size, false, &decompressed, &decompressed_size));
+    ASSERT_ARE_EQUAL(size_t, sizeof(payload), decompressed_size);
+    (void)uws_deflate_compress(compressor, payload, sizeof(payload), true, &compressed, &compressed_size);
+
+    // act
+    result = uws_deflate_decompress(uws_deflate, compressed, compressed_size, true, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, UWS_DEFLATE_MESSAGE_TOO_BIG, result);
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+    uws_deflate_destroy(compressor);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_046: [ If `max_decompressed_message_size` is 0, `UWS_DEFLATE_DEFAULT_MAX_DECOMPRESSED_MESSAGE_SIZE` shall be used instead. ]*/
+TEST_FUNCTION(uws_deflate_decompress_with_max_size_0_fails_a_message_above_the_default_max_size)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS compressor_options = { false, false, 15, 15, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15, 0 };
+    UWS_DEFLATE_HANDLE compressor = uws_deflate_create(&compressor_options);
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    size_t payload_size = UWS_DEFLATE_DEFAULT_MAX_DECOMPRESSED_MESSAGE_SIZE + 1;
+    unsigned char* payload = (unsigned char*)malloc(payload_size);
+    const unsigned char* compressed;
+    size_t compressed_size;
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    ASSERT_IS_NOT_NULL(payload);
+    (void)memset(payload, 'a', payload_size);
+    (void)uws_deflate_compress(compressor, payload, payload_size, true, &compressed, &compressed_size);
+
+    // act
+    result = uws_deflate_decompress(uws_deflate, compressed, compressed_size, true, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, UWS_DEFLATE_MESSAGE_TOO_BIG, result);
+
+    // cleanup
+    free(payload);
+    uws_deflate_destroy(uws_deflate);
+    uws_deflate_destroy(compressor);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_043: [ In that case the buffer holding the decompressed bytes shall be freed and the inflate stream shall be reset with `inflateReset`. ]*/
+TEST_FUNCTION(uws_deflate_decompress_after_a_too_big_message_decompresses_the_next_message)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS compressor_options = { false, false, 15, 15, 0 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15, 3999 };
+    UWS_DEFLATE_HANDLE compressor = uws_deflate_create(&compressor_options);
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    unsigned char payload[4000];
+    const unsigned char* compressed;
+    size_t compressed_size;
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    (void)memset(payload, 'a', sizeof(payload));
+    (void)uws_deflate_compress(compressor, payload, sizeof(payload), true, &compressed, &compressed_size);
+    ASSERT_ARE_EQUAL(int, UWS_DEFLATE_MESSAGE_TOO_BIG, uws_deflate_decompress(uws_deflate, compressed, compressed_size, true, &decompressed, &decompressed_size));
+
+    // act
+    result = uws_deflate_decompress(uws_deflate, compressed_hello, sizeof(compressed_hello), true, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 5, decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(decompressed, "Hello", 5));
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+    uws_deflate_destroy(compressor);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_044: [ When a new message starts and the buffer holding the decompressed bytes is larger than 64 KB, it shall be freed, so that one large message does not keep its memory for the rest of the connection. ]*/
+TEST_FUNCTION(uws_deflate_decompress_after_a_large_message_decompresses_the_next_message)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15, 0 };
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    unsigned char* payload = (unsigned char*)malloc(100000);
+    unsigned char* compressed_copy = (unsigned char*)malloc(100000);
+    const unsigned char* compressed;
+    size_t compressed_size;
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    int result;
+
+    ASSERT_IS_NOT_NULL(payload);
+    ASSERT_IS_NOT_NULL(compressed_copy);
+    (void)memset(payload, 'a', 100000);
+    (void)uws_deflate_compress(uws_deflate, payload, 100000, true, &compressed, &compressed_size);
+    (void)memcpy(compressed_copy, compressed, compressed_size);
+    ASSERT_ARE_EQUAL(int, 0, uws_deflate_decompress(uws_deflate, compressed_copy, compressed_size, true, &decompressed, &decompressed_size));
+    ASSERT_ARE_EQUAL(size_t, 100000, decompressed_size);
+
+    // act
+    result = uws_deflate_decompress(uws_deflate, compressed_hello, sizeof(compressed_hello), true, &decompressed, &decompressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 5, decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(decompressed, "Hello", 5));
+
+    // cleanup
+    free(compressed_copy);
+    free(payload);
+    uws_deflate_destroy(uws_deflate);
+}
+
+/* uws_deflate_compress */
+
+/* Tests_SRS_UWS_DEFLATE_01_028: [ `uws_deflate_compress` shall compress `payload` with `deflate` and `Z_SYNC_FLUSH` into a buffer owned by the instance, which is reused by subsequent calls. ]*/
+/* Tests_SRS_UWS_DEFLATE_01_030: [ When `is_final` is true, the 0x00 0x00 0xFF 0xFF tail of the sync flush shall be removed from the output. ]*/
+/* Tests_SRS_UWS_DEFLATE_01_032: [ On success `uws_deflate_compress` shall set `compressed` and `compressed_size` to the compressed bytes and return 0. ]*/
+TEST_FUNCTION(uws_deflate_compress_output_is_decompressed_to_the_original_payload)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 10, 15 };
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    unsigned char payload[4000];
+    unsigned char compressed_copy[4000];
+    const unsigned char* compressed;
+    size_t compressed_size;
+    const unsigned char* decompressed;
+    size_t decompressed_size;
+    size_t i;
+    int result;
+
+    for (i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (unsigned char)('a' + ((i * 7) % 26));
+    }
+
+    // act
+    result = uws_deflate_compress(uws_deflate, payload, sizeof(payload), true, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(compressed_size < sizeof(payload));
+    ASSERT_IS_TRUE((compressed_size < 4) || (memcmp(compressed + compressed_size - 4, "\x00\x00\xFF\xFF", 4) != 0));
+    (void)memcpy(compressed_copy, compressed, compressed_size);
+    ASSERT_ARE_EQUAL(int, 0, uws_deflate_decompress(uws_deflate, compressed_copy, compressed_size, true, &decompressed, &decompressed_size));
+    ASSERT_ARE_EQUAL(size_t, sizeof(payload), decompressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(decompressed, payload, sizeof(payload)));
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_031: [ When `is_final` is true and `client_no_context_takeover` was negotiated, the deflate stream shall be reset with `deflateReset`. ]*/
+TEST_FUNCTION(uws_deflate_compress_with_client_no_context_takeover_compresses_each_message_alone)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { true, false, 15, 15 };
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    const unsigned char* compressed;
+    size_t compressed_size;
+    int result;
+
+    (void)uws_deflate_compress(uws_deflate, (const unsigned char*)"Hello", 5, true, &compressed, &compressed_size);
+
+    // act
+    result = uws_deflate_compress(uws_deflate, (const unsigned char*)"Hello", 5, true, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(compressed_hello), compressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(compressed, compressed_hello, sizeof(compressed_hello)));
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_040: [ `uws_deflate_reset_compressor` shall drop the compression history by calling `deflateReset`. ]*/
+TEST_FUNCTION(uws_deflate_reset_compressor_drops_the_compression_history)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15 };
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    const unsigned char* compressed;
+    size_t compressed_size;
+    int result;
+
+    (void)uws_deflate_compress(uws_deflate, (const unsigned char*)"Hello", 5, true, &compressed, &compressed_size);
+
+    // act
+    uws_deflate_reset_compressor(uws_deflate);
+    result = uws_deflate_compress(uws_deflate, (const unsigned char*)"Hello", 5, true, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(compressed_hello), compressed_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(compressed, compressed_hello, sizeof(compressed_hello)));
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+}
+
+/* Tests_SRS_UWS_DEFLATE_01_027: [ If `uws_deflate`, `compressed` or `compressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_deflate_compress` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_deflate_compress_with_NULL_payload_and_non_zero_size_fails)
+{
+    // arrange
+    WS_PERMESSAGE_DEFLATE_OPTIONS negotiated_options = { false, false, 15, 15 };
+    UWS_DEFLATE_HANDLE uws_deflate = uws_deflate_create(&negotiated_options);
+    const unsigned char* compressed;
+    size_t compressed_size;
+    int result;
+
+    // act
+    result = uws_deflate_compress(uws_deflate, NULL, 1, true, &compressed, &compressed_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_deflate_destroy(uws_deflate);
+}
+
+END_TEST_SUITE(uws_deflate_ut)
@@ -884,13 +884,14 @@ TEST_FUNCTION(uws_frame_encoder_encodes_a_reserved_control_frame_F)
 }
 
 /* Tests_SRS_UWS_FRAME_ENCODER_01_015: [ Defines whether the "Payload data" is masked. ]*/
-/* Tests_SRS_UWS_FRAME_ENCODER_01_053: [ In order to obtain a 32 bit value for masking, `gb_rand` shall be used 4 times (for each byte). ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_069: [ In order to obtain a 32 bit value for masking, `gb_rand_bytes` shall be called to fill the 4 masking key bytes. ]*/
 /* Tests_SRS_UWS_FRAME_ENCODER_01_016: [ If set to 1, a masking key is present in masking-key, and this is used to unmask the "Payload data" as per Section 5.3. ]*/
 /* Tests_SRS_UWS_FRAME_ENCODER_01_026: [ This field is present if the mask bit is set to 1 and is absent if the mask bit is set to 0. ]*/
 /* Tests_SRS_UWS_FRAME_ENCODER_01_042: [ The payload length, indicated in the framing as frame-payload-length, does NOT include the length of the masking key. ]*/
 TEST_FUNCTION(uws_frame_encoder_encode_encodes_a_masked_zero_length_binary_frame)
 {
     // arrange
+    unsigned char masking_key[] = { 0xFF, 0xFF, 0xFF, 0xFF };
     BUFFER_HANDLE result;
     BUFFER_HANDLE newly_created_buffer;
     unsigned char expected_bytes[] = { 0x82, 0x80, 0xFF, 0xFF, 0xFF, 0xFF };
@@ -901,14 +902,8 @@ TEST_FUNCTION(uws_frame_encoder_encode_encodes_a_masked_zero_length_binary_frame
         .ValidateArgumentValue_handle(&newly_created_buffer);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&newly_created_buffer);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
 
     // act
     result = uws_frame_encoder_encode(WS_BINARY_FRAME, NULL, 0, true, true, 0);
@@ -925,13 +920,14 @@ TEST_FUNCTION(uws_frame_encoder_encode_encodes_a_masked_zero_length_binary_frame
 }
 
 /* Tests_SRS_UWS_FRAME_ENCODER_01_015: [ Defines whether the "Payload data" is masked. ]*/
-/* Tests_SRS_UWS_FRAME_ENCODER_01_053: [ In order to obtain a 32 bit value for masking, `gb_rand` shall be used 4 times (for each byte). ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_069: [ In order to obtain a 32 bit value for masking, `gb_rand_bytes` shall be called to fill the 4 masking key bytes. ]*/
 /* Tests_SRS_UWS_FRAME_ENCODER_01_016: [ If set to 1, a masking key is present in masking-key, and this is used to unmask the "Payload data" as per Section 5.3. ]*/
 /* Tests_SRS_UWS_FRAME_ENCODER_01_026: [ This field is present if the mask bit is set to 1 and is absent if the mask bit is set to 0. ]*/
 /* Tests_SRS_UWS_FRAME_ENCODER_01_042: [ The payload length, indicated in the framing as frame-payload-length, does NOT include the length of the masking key. ]*/
 TEST_FUNCTION(uws_frame_encoder_encode_encodes_a_masked_zero_length_binary_frame_different_mask)
 {
     // arrange
+    unsigned char masking_key[] = { 0x42, 0x43, 0x44, 0x45 };
     BUFFER_HANDLE result;
     BUFFER_HANDLE newly_created_buffer;
     unsigned char expected_bytes[] = { 0x82, 0x80, 0x42, 0x43, 0x44, 0x45 };
@@ -942,14 +938,8 @@ TEST_FUNCTION(uws_frame_encoder_encode_encodes_a_masked_zero_length_binary_frame
         .ValidateArgumentValue_handle(&newly_created_buffer);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&newly_created_buffer);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x42);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x43);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x44);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x45);
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
 
     // act
     result = uws_frame_encoder_encode(WS_BINARY_FRAME, NULL, 0, true, true, 0);
@@ -1202,6 +1192,7 @@ TEST_FUNCTION(uws_frame_encoder_encode_encodes_a_65536_byte_long_binary_frame)
 TEST_FUNCTION(uws_frame_encoder_encode_masks_a_1_byte_frame_with_0_as_mask)
 {
     // arrange
+    unsigned char masking_key[] = { 0x00, 0x00, 0x00, 0x00 };
     BUFFER_HANDLE result;
     BUFFER_HANDLE newly_created_buffer;
     unsigned char payload[] = { 0x42 };
@@ -1213,14 +1204,8 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_1_byte_frame_with_0_as_mask)
         .ValidateArgumentValue_handle(&newly_created_buffer);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&newly_created_buffer);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x00);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x00);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x00);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x00);
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
 
     // act
     result = uws_frame_encoder_encode(WS_BINARY_FRAME, payload, sizeof(payload), true, true, 0);
@@ -1248,6 +1233,7 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_1_byte_frame_with_0_as_mask)
 TEST_FUNCTION(uws_frame_encoder_encode_masks_a_1_byte_frame_with_0xFF_as_mask)
 {
     // arrange
+    unsigned char masking_key[] = { 0xFF, 0x00, 0x00, 0x00 };
     BUFFER_HANDLE result;
     BUFFER_HANDLE newly_created_buffer;
     unsigned char payload[] = { 0x42 };
@@ -1259,14 +1245,8 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_1_byte_frame_with_0xFF_as_mask)
         .ValidateArgumentValue_handle(&newly_created_buffer);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&newly_created_buffer);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x00);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x00);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x00);
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
 
     // act
     result = uws_frame_encoder_encode(WS_BINARY_FRAME, payload, sizeof(payload), true, true, 0);
@@ -1294,6 +1274,7 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_1_byte_frame_with_0xFF_as_mask)
 TEST_FUNCTION(uws_frame_encoder_encode_masks_a_4_byte_frame_with_0xFF_as_mask)
 {
     // arrange
+    unsigned char masking_key[] = { 0xFF, 0xFF, 0xFF, 0xFF };
     BUFFER_HANDLE result;
     BUFFER_HANDLE newly_created_buffer;
     unsigned char payload[] = { 0x42, 0x43, 0x44, 0x45 };
@@ -1305,14 +1286,8 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_4_byte_frame_with_0xFF_as_mask)
         .ValidateArgumentValue_handle(&newly_created_buffer);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&newly_created_buffer);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
 
     // act
     result = uws_frame_encoder_encode(WS_BINARY_FRAME, payload, sizeof(payload), true, true, 0);
@@ -1340,6 +1315,7 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_4_byte_frame_with_0xFF_as_mask)
 TEST_FUNCTION(uws_frame_encoder_encode_masks_a_5_byte_frame_with_0xFF_as_mask)
 {
     // arrange
+    unsigned char masking_key[] = { 0xFF, 0xFF, 0xFF, 0xFF };
     BUFFER_HANDLE result;
     BUFFER_HANDLE newly_created_buffer;
     unsigned char payload[] = { 0x42, 0x43, 0x44, 0x45, 0x01 };
@@ -1351,14 +1327,8 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_5_byte_frame_with_0xFF_as_mask)
         .ValidateArgumentValue_handle(&newly_created_buffer);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&newly_created_buffer);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
 
     // act
     result = uws_frame_encoder_encode(WS_BINARY_FRAME, payload, sizeof(payload), true, true, 0);
@@ -1386,6 +1356,7 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_5_byte_frame_with_0xFF_as_mask)
 TEST_FUNCTION(uws_frame_encoder_encode_masks_a_8_byte_frame_with_different_mask_bytes)
 {
     // arrange
+    unsigned char masking_key[] = { 0x00, 0xFF, 0xAA, 0x42 };
     BUFFER_HANDLE result;
     BUFFER_HANDLE newly_created_buffer;
     unsigned char payload[] = { 0x42, 0x43, 0x44, 0x45, 0x01, 0x02, 0xFF, 0xAA };
@@ -1397,14 +1368,8 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_8_byte_frame_with_different_mask_
         .ValidateArgumentValue_handle(&newly_created_buffer);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&newly_created_buffer);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x00);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xFF);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0xAA);
-    STRICT_EXPECTED_CALL(gb_rand())
-        .SetReturn(0x42);
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
 
     // act
     result = uws_frame_encoder_encode(WS_BINARY_FRAME, payload, sizeof(payload), true, true, 0);
@@ -1420,4 +1385,411 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_8_byte_frame_with_different_mask_
     real_BUFFER_delete(result);
 }
 
+/* Tests_SRS_UWS_FRAME_ENCODER_01_070: [ If `gb_rand_bytes` fails then `uws_frame_encoder_encode` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_gb_rand_bytes_fails_uws_frame_encoder_encode_fails)
+{
+    // arrange
+    BUFFER_HANDLE result;
+    BUFFER_HANDLE newly_created_buffer;
+    unsigned char payload[] = { 0x42 };
+
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&newly_created_buffer);
+    STRICT_EXPECTED_CALL(BUFFER_enlarge(IGNORED_PTR_ARG, 7))
+        .ValidateArgumentValue_handle(&newly_created_buffer);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&newly_created_buffer);
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&newly_created_buffer);
+
+    // act
+    result = uws_frame_encoder_encode(WS_BINARY_FRAME, payload, sizeof(payload), true, true, 0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_frame_encoder_encode_header */
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_062: [ `uws_frame_encoder_encode_header` shall encode only the frame header (at most `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes) for a payload of `length` bytes into `header`, following the same rules as `uws_frame_encoder_encode`. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_068: [ On success `uws_frame_encoder_encode_header` shall set `header_length` to the number of header bytes written and return 0. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_encodes_a_header_for_a_125_byte_unmasked_frame)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    unsigned char expected_bytes[] = { 0x82, 0x7D };
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, 125, false, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), header_length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, header, sizeof(expected_bytes)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_062: [ `uws_frame_encoder_encode_header` shall encode only the frame header (at most `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes) for a payload of `length` bytes into `header`, following the same rules as `uws_frame_encoder_encode`. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_encodes_a_header_for_a_126_byte_non_final_text_frame_with_reserved_bits)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    unsigned char expected_bytes[] = { 0x41, 0x7E, 0x00, 0x7E };
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_TEXT_FRAME, 126, false, false, RESERVED_1, &header_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), header_length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, header, sizeof(expected_bytes)));
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_062: [ `uws_frame_encoder_encode_header` shall encode only the frame header (at most `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes) for a payload of `length` bytes into `header`, following the same rules as `uws_frame_encoder_encode`. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_067: [ When `is_masked` is true, the masking key shall be placed in the last 4 bytes of the header, so that the caller can mask the payload with `uws_frame_encoder_mask`. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_encodes_a_masked_header_for_a_65536_byte_frame)
+{
+    // arrange
+    unsigned char masking_key[] = { 0x01, 0x02, 0x03, 0x04 };
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    unsigned char expected_bytes[] = { 0x82, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04 };
+    size_t header_length;
+    int result;
+
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, 65536, true, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), header_length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, header, sizeof(expected_bytes)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_067: [ When `is_masked` is true, the masking key shall be placed in the last 4 bytes of the header, so that the caller can mask the payload with `uws_frame_encoder_mask`. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_and_mask_in_place_produce_the_same_bytes_as_uws_frame_encoder_encode)
+{
+    // arrange
+    unsigned char masking_key[] = { 0x11, 0x22, 0x33, 0x44 };
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    unsigned char payload[200];
+    unsigned char masked_payload[200];
+    size_t header_length;
+    BUFFER_HANDLE encoded;
+    size_t i;
+
+    for (i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (unsigned char)i;
+    }
+    (void)memcpy(masked_payload, payload, sizeof(payload));
+
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
+    STRICT_EXPECTED_CALL(BUFFER_new());
+    STRICT_EXPECTED_CALL(BUFFER_enlarge(IGNORED_PTR_ARG, 4 + 4 + sizeof(payload)));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .CopyOutArgumentBuffer_buffer(masking_key, sizeof(masking_key));
+
+    // act
+    (void)uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, sizeof(payload), true, true, 0, &header_length);
+    (void)uws_frame_encoder_mask(masked_payload, masked_payload, sizeof(masked_payload), header + header_length - 4, 0);
+    encoded = uws_frame_encoder_encode(WS_BINARY_FRAME, payload, sizeof(payload), true, true, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, header_length + sizeof(payload), real_BUFFER_length(encoded));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(header, real_BUFFER_u_char(encoded), header_length));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(masked_payload, real_BUFFER_u_char(encoded) + header_length, sizeof(masked_payload)));
+
+    // cleanup
+    real_BUFFER_delete(encoded);
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_063: [ If `header` or `header_length` is NULL, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_NULL_header_fails)
+{
+    // arrange
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(NULL, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, 1, true, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_063: [ If `header` or `header_length` is NULL, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_NULL_header_length_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, 1, true, true, 0, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_064: [ If `reserved` has any bits set except the lowest 3 then `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_reserved_8_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, 1, true, true, 8, &header_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_065: [ If `opcode` is greater than 0x0F, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_opcode_16_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), (WS_FRAME_TYPE)0x10, 1, true, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_066: [ If `header_size` is smaller than the number of bytes needed for the header, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_a_too_small_header_buffer_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, 7, WS_BINARY_FRAME, 126, true, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_071: [ If `gb_rand_bytes` fails then `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_gb_rand_bytes_fails_uws_frame_encoder_encode_header_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_length;
+    int result;
+
+    STRICT_EXPECTED_CALL(gb_rand_bytes(IGNORED_PTR_ARG, 4))
+        .SetReturn(1);
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, 1, true, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_frame_encoder_mask */
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_055: [ `uws_frame_encoder_mask` shall (un)mask `length` bytes from `source` into `destination` using the 4 byte `masking_key`, as described in RFC6455 section 5.3. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_059: [ `uws_frame_encoder_mask` shall XOR the data several bytes at a time (using SSE2 or AVX2 instructions when the CPU supports them, selected at runtime). ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_060: [ On success `uws_frame_encoder_mask` shall return 0. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_masks_payloads_of_different_lengths)
+{
+    // arrange
+    unsigned char masking_key[] = { 0x00, 0xFF, 0xAA, 0x42 };
+    unsigned char source[300];
+    unsigned char destination[300];
+    size_t length;
+    size_t i;
+
+    for (i = 0; i < sizeof(source); i++)
+    {
+        source[i] = (unsigned char)(i * 7);
+    }
+
+    for (length = 0; length <= sizeof(source); length++)
+    {
+        int result;
+
+        (void)memset(destination, 0, sizeof(destination));
+
+        // act
+        result = uws_frame_encoder_mask(destination, source, length, masking_key, 0);
+
+        // assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        for (i = 0; i < length; i++)
+        {
+            ASSERT_ARE_EQUAL(int, (int)(source[i] ^ masking_key[i % 4]), (int)destination[i]);
+        }
+        for (; i < sizeof(destination); i++)
+        {
+            ASSERT_ARE_EQUAL(int, 0, (int)destination[i]);
+        }
+    }
+
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_057: [ `destination` and `source` shall be allowed to be the same buffer (in place masking). ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_masks_in_place)
+{
+    // arrange
+    unsigned char masking_key[] = { 0x01, 0x02, 0x03, 0x04 };
+    unsigned char payload[133];
+    size_t i;
+    int result;
+
+    for (i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (unsigned char)i;
+    }
+
+    // act
+    result = uws_frame_encoder_mask(payload + 1, payload + 1, sizeof(payload) - 1, masking_key, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, (int)payload[0]);
+    for (i = 1; i < sizeof(payload); i++)
+    {
+        ASSERT_ARE_EQUAL(int, (int)(i ^ masking_key[(i - 1) % 4]), (int)payload[i]);
+    }
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_058: [ The key byte applied to octet i of `source` shall be `masking_key[(key_offset + i) % 4]`, so that a payload can be (un)masked in several calls. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_with_key_offset_continues_the_key_sequence)
+{
+    // arrange
+    unsigned char masking_key[] = { 0x10, 0x20, 0x30, 0x40 };
+    unsigned char source[200];
+    unsigned char in_one_call[200];
+    unsigned char in_two_calls[200];
+    size_t i;
+    int result_1;
+    int result_2;
+
+    for (i = 0; i < sizeof(source); i++)
+    {
+        source[i] = (unsigned char)(255 - i);
+    }
+    (void)uws_frame_encoder_mask(in_one_call, source, sizeof(source), masking_key, 0);
+
+    // act
+    result_1 = uws_frame_encoder_mask(in_two_calls, source, 71, masking_key, 0);
+    result_2 = uws_frame_encoder_mask(in_two_calls + 71, source + 71, sizeof(source) - 71, masking_key, 71);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result_1);
+    ASSERT_ARE_EQUAL(int, 0, result_2);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(in_one_call, in_two_calls, sizeof(source)));
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_040: [ The same algorithm applies regardless of the direction of the translation, e.g., the same steps are applied to mask the data as to unmask the data. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_twice_restores_the_original_payload)
+{
+    // arrange
+    unsigned char masking_key[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+    unsigned char original[1027];
+    unsigned char payload[1027];
+    size_t i;
+
+    for (i = 0; i < sizeof(original); i++)
+    {
+        original[i] = (unsigned char)(i * 13);
+    }
+    (void)memcpy(payload, original, sizeof(original));
+
+    // act
+    (void)uws_frame_encoder_mask(payload, payload, sizeof(payload), masking_key, 0);
+    (void)uws_frame_encoder_mask(payload, payload, sizeof(payload), masking_key, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, memcmp(original, payload, sizeof(original)));
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_056: [ If `length` is greater than 0 and any of `destination`, `source` or `masking_key` is NULL, `uws_frame_encoder_mask` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_with_NULL_destination_fails)
+{
+    // arrange
+    unsigned char masking_key[] = { 0x01, 0x02, 0x03, 0x04 };
+    unsigned char source[] = { 0x42 };
+    int result;
+
+    // act
+    result = uws_frame_encoder_mask(NULL, source, sizeof(source), masking_key, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_056: [ If `length` is greater than 0 and any of `destination`, `source` or `masking_key` is NULL, `uws_frame_encoder_mask` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_with_NULL_source_fails)
+{
+    // arrange
+    unsigned char masking_key[] = { 0x01, 0x02, 0x03, 0x04 };
+    unsigned char destination[1];
+    int result;
+
+    // act
+    result = uws_frame_encoder_mask(destination, NULL, sizeof(destination), masking_key, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_056: [ If `length` is greater than 0 and any of `destination`, `source` or `masking_key` is NULL, `uws_frame_encoder_mask` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_with_NULL_masking_key_fails)
+{
+    // arrange
+    unsigned char source[] = { 0x42 };
+    unsigned char destination[1];
+    int result;
+
+    // act
+    result = uws_frame_encoder_mask(destination, source, sizeof(source), NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_056: [ If `length` is greater than 0 and any of `destination`, `source` or `masking_key` is NULL, `uws_frame_encoder_mask` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_with_0_length_and_NULL_buffers_succeeds)
+{
+    // arrange
+    int result;
+
+    // act
+    result = uws_frame_encoder_mask(NULL, NULL, 0, NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+}
+
 END_TEST_SUITE(uws_frame_encoder_ut)
@@ -11,6 +11,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #endif
+#include <string.h>
 #include "testrunnerswitcher.h"
 #include "umock_c.h"
 #include "umocktypes_charptr.h"
@@ -23,6 +24,7 @@
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/optionhandler.h"
 #include "azure_c_shared_utility/uws_client.h"
+#include "azure_c_shared_utility/shared_util_options.h"
 
 static const void** list_items = NULL;
 static size_t list_item_count = 0;
@@ -193,6 +195,8 @@ static ON_WS_SEND_FRAME_COMPLETE g_on_ws_send_frame_complete;
 static void* g_on_ws_send_frame_complete_context;
 static ON_WS_FRAME_RECEIVED g_on_ws_frame_received;
 static void* g_on_ws_frame_received_context;
+static ON_WS_FRAGMENT_RECEIVED g_on_ws_fragment_received;
+static void* g_on_ws_fragment_received_context;
 static ON_WS_PEER_CLOSED g_on_ws_peer_closed;
 static void* g_on_ws_peer_closed_context;
 static ON_WS_ERROR g_on_ws_error;
@@ -234,6 +238,20 @@ static int my_uws_send_frame_async(UWS_CLIENT_HANDLE uws, unsigned char frame_ty
     return 0;
 }
 
+static int my_uws_client_set_option(UWS_CLIENT_HANDLE uws, const char* option_name, const void* value)
+{
+    (void)uws;
+    if (strcmp(option_name, OPTION_WS_ON_FRAGMENT_RECEIVED) == 0)
+    {
+        g_on_ws_fragment_received = (ON_WS_FRAGMENT_RECEIVED)value;
+    }
+    else if (strcmp(option_name, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT) == 0)
+    {
+        g_on_ws_fragment_received_context = (void*)value;
+    }
+    return 0;
+}
+
 static WSIO_CONFIG default_wsio_config;
 
 static TEST_MUTEX_HANDLE g_testByTest;
@@ -284,6 +302,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(uws_client_open_async, my_uws_open_async);
     REGISTER_GLOBAL_MOCK_HOOK(uws_client_close_async, my_uws_close_async);
     REGISTER_GLOBAL_MOCK_HOOK(uws_client_send_frame_async, my_uws_send_frame_async);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_client_set_option, my_uws_client_set_option);
     REGISTER_GLOBAL_MOCK_HOOK(OptionHandler_Create, my_OptionHandler_Create);
     REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_FeedOptions, OPTIONHANDLER_OK);
     REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_AddOption, OPTIONHANDLER_OK);
@@ -299,6 +318,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(UWS_CLIENT_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_STATISTICS*, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_OPEN_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_FRAME_RECEIVED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_ERROR, void*);
@@ -351,6 +371,7 @@ TEST_FUNCTION_CLEANUP(method_cleanup)
 /* Tests_SRS_WSIO_01_128: [ - `resource_name` set to the `resource_name` field in the `io_create_parameters` passed to `wsio_create`. ]*/
 /* Tests_SRS_WSIO_01_129: [ - `protocols` shall be filled with only one structure, that shall have the `protocol` set to the value of the `protocol` field in the `io_create_parameters` passed to `wsio_create`. ]*/
 /* Tests_SRS_WSIO_01_076: [ `wsio_create` shall create a pending send IO list that is to be used to queue send packets by calling `singlylinkedlist_create`. ]*/
+/* Tests_SRS_WSIO_01_192: [ `wsio_create` shall have the uws instance hand out received payload as it arrives by calling `uws_client_set_option` with `ws_on_fragment_received` set to a fragment handler and `ws_on_fragment_received_context` set to the new wsio instance. ]*/
 TEST_FUNCTION(wsio_create_for_secure_connection_with_valid_args_succeeds)
 {
     // arrange
@@ -359,6 +380,8 @@ TEST_FUNCTION(wsio_create_for_secure_connection_with_valid_args_succeeds)
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_client_create_with_io(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS, TEST_HOST_ADDRESS, 443, TEST_RESOURCE_NAME, IGNORED_PTR_ARG, 1));
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(uws_client_set_option(TEST_UWS_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_client_set_option(TEST_UWS_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, IGNORED_PTR_ARG));
 
     // act
     wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
@@ -505,6 +528,53 @@ TEST_FUNCTION(when_singlylinkedlist_create_fails_then_wsio_create_fails)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+/* Tests_SRS_WSIO_01_193: [ If setting either option fails then `wsio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_setting_the_fragment_callback_fails_then_wsio_create_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_client_create_with_io(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS, TEST_HOST_ADDRESS, 443, TEST_RESOURCE_NAME, IGNORED_PTR_ARG, 1));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(uws_client_set_option(TEST_UWS_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(uws_client_destroy(TEST_UWS_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+
+    // assert
+    ASSERT_IS_NULL(wsio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_WSIO_01_193: [ If setting either option fails then `wsio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_setting_the_fragment_callback_context_fails_then_wsio_create_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_client_create_with_io(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS, TEST_HOST_ADDRESS, 443, TEST_RESOURCE_NAME, IGNORED_PTR_ARG, 1));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(uws_client_set_option(TEST_UWS_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_client_set_option(TEST_UWS_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(uws_client_destroy(TEST_UWS_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+
+    // assert
+    ASSERT_IS_NULL(wsio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 /* Tests_SRS_WSIO_01_071: [ The arguments for `uws_client_create_with_io` shall be: ]*/
 /* Tests_SRS_WSIO_01_185: [ - `underlying_io_interface` shall be set to the `underlying_io_interface` field in the `io_create_parameters` passed to `wsio_create`. ]*/
 /* Tests_SRS_WSIO_01_186: [ - `underlying_io_parameters` shall be set to the `underlying_io_parameters` field in the `io_create_parameters` passed to `wsio_create`. ]*/
@@ -528,6 +598,8 @@ TEST_FUNCTION(wsio_create_for_secure_connection_with_valid_args_succeeds_2)
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_client_create_with_io(TEST_UNDERLYING_IO_INTERFACE, NULL, "another.com", 80, "haga", IGNORED_PTR_ARG, 1));
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(uws_client_set_option(TEST_UWS_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_client_set_option(TEST_UWS_HANDLE, OPTION_WS_ON_FRAGMENT_RECEIVED_CONTEXT, IGNORED_PTR_ARG));
 
     // act
     wsio = wsio_get_interface_description()->concrete_io_create(&wsio_config);
@@ -1228,6 +1300,38 @@ TEST_FUNCTION(when_adding_the_pending_item_to_the_list_fails_wsio_send_fails)
     wsio_get_interface_description()->concrete_io_destroy(wsio);
 }
 
+/* Tests_SRS_WSIO_01_191: [ If `uws_client_send_frame_async` returns `XIO_SEND_WOULD_BLOCK`, `wsio_send` shall remove the pending IO and return `XIO_SEND_WOULD_BLOCK`. ]*/
+TEST_FUNCTION(when_uws_client_send_frame_async_would_block_wsio_send_returns_XIO_SEND_WOULD_BLOCK)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    int result;
+    unsigned char test_buffer[] = { 42 };
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_client_send_frame_async(TEST_UWS_HANDLE, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(test_buffer), true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(3, test_buffer, sizeof(test_buffer))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, XIO_SEND_WOULD_BLOCK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
 /* Tests_SRS_WSIO_01_105: [ The argument `on_send_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
 TEST_FUNCTION(wsio_send_with_NULL_send_complete_callback_succeeds)
 {
@@ -1663,6 +1767,57 @@ TEST_FUNCTION(when_on_underlying_ws_frame_received_is_called_the_frame_content_i
     wsio_get_interface_description()->concrete_io_destroy(wsio);
 }
 
+/* on_underlying_ws_fragment_received */
+
+/* Tests_SRS_WSIO_01_194: [ When the fragment handler is called, the piece of payload shall be processed exactly as a received frame by `on_underlying_ws_frame_received`, as wsio exposes a byte stream without message boundaries. ]*/
+TEST_FUNCTION(when_on_underlying_ws_fragment_received_is_called_the_fragment_content_is_indicated_up)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    const unsigned char test_buffer[] = { 0x42, 0x43 };
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_bytes_received((void*)0x4243, IGNORED_PTR_ARG, sizeof(test_buffer)))
+        .ValidateArgumentBuffer(2, test_buffer, sizeof(test_buffer));
+
+    // act
+    g_on_ws_fragment_received(g_on_ws_fragment_received_context, WS_FRAME_TYPE_BINARY, test_buffer, sizeof(test_buffer), true, false);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_194: [ When the fragment handler is called, the piece of payload shall be processed exactly as a received frame by `on_underlying_ws_frame_received`, as wsio exposes a byte stream without message boundaries. ]*/
+TEST_FUNCTION(when_on_underlying_ws_fragment_received_is_called_with_a_text_fragment_an_error_is_indicated)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    const unsigned char test_buffer[] = { 0x42 };
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_io_error((void*)0x4244));
+
+    // act
+    g_on_ws_fragment_received(g_on_ws_fragment_received_context, WS_FRAME_TYPE_TEXT, test_buffer, sizeof(test_buffer), false, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
 /* Tests_SRS_WSIO_01_126: [ If `on_underlying_ws_frame_received` is called while the IO is in any state other than OPEN, it shall do nothing. ]*/
 TEST_FUNCTION(when_on_underlying_ws_frame_received_is_called_while_opening_it_shall_do_nothing)
 {
@@ -2507,4 +2662,92 @@ TEST_FUNCTION(on_underlying_ws_peer_closed_with_NULL_context_does_nothing)
     wsio_get_interface_description()->concrete_io_destroy(wsio);
 }
 
+/* wsio_get_statistics */
+
+/* Tests_SRS_WSIO_01_187: [ If any of the arguments `ws_io` or `statistics` is NULL, `wsio_get_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(wsio_get_statistics_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_get_statistics(NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_WSIO_01_187: [ If any of the arguments `ws_io` or `statistics` is NULL, `wsio_get_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(wsio_get_statistics_with_NULL_statistics_fails)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE wsio;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_get_statistics(wsio, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_188: [ `wsio_get_statistics` shall obtain the statistics by calling `uws_client_get_statistics`. ]*/
+/* Tests_SRS_WSIO_01_190: [ On success, `wsio_get_statistics` shall return 0. ]*/
+TEST_FUNCTION(wsio_get_statistics_calls_uws_client_get_statistics)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+    CONCRETE_IO_HANDLE wsio;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_client_get_statistics(TEST_UWS_HANDLE, &statistics));
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_get_statistics(wsio, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_189: [ If `uws_client_get_statistics` fails, `wsio_get_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_uws_client_get_statistics_fails_wsio_get_statistics_fails)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+    CONCRETE_IO_HANDLE wsio;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_client_get_statistics(TEST_UWS_HANDLE, &statistics))
+        .SetReturn(1);
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_get_statistics(wsio, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
 END_TEST_SUITE(wsio_ut)
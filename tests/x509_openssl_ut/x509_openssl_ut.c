@@ -12,6 +12,11 @@ static void* my_gballoc_malloc(size_t size)
     return malloc(size);
 }
 
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
 static void my_gballoc_free(void* s)
 {
     free(s);
@@ -40,6 +45,7 @@ static void my_gballoc_free(void* s)
 
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 
@@ -99,6 +105,12 @@ MOCKABLE_FUNCTION(, long, SSL_CTX_ctrl, SSL_CTX*, ctx, int, cmd, long, larg, voi
 MOCKABLE_FUNCTION(, unsigned long, ERR_peek_last_error);
 MOCKABLE_FUNCTION(, void, ERR_clear_error);
 
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || defined(LIBRESSL_VERSION_NUMBER)
+MOCKABLE_FUNCTION(, int, CRYPTO_add_lock, int*, pointer, int, amount, int, type, const char*, file, int, line);
+#else
+MOCKABLE_FUNCTION(, int, X509_up_ref, X509*, a);
+#endif
+
 #undef ENABLE_MOCKS
 
 /*the below function has different signatures on different versions of OPENSSL*/
@@ -198,6 +210,8 @@ BEGIN_TEST_SUITE(x509_openssl_unittests)
 
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
 
         REGISTER_GLOBAL_MOCK_HOOK(BIO_new_mem_buf, my_BIO_new_mem_buf);
@@ -607,6 +621,197 @@ BEGIN_TEST_SUITE(x509_openssl_unittests)
         //clean
     }
 
+    /*Tests_SRS_X509_OPENSSL_02_025: [ If pem is NULL then x509_openssl_pem_acquire shall fail and return NULL. ]*/
+    TEST_FUNCTION(x509_openssl_pem_acquire_with_NULL_pem_fails)
+    {
+        ///arrange
+        const char* result;
+
+        ///act
+        result = x509_openssl_pem_acquire(NULL);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+    }
+
+    /*Tests_SRS_X509_OPENSSL_02_027: [ Otherwise x509_openssl_pem_acquire shall intern a copy of pem, keyed by a hash of its content, with a reference count of 1 and return the copy. ]*/
+    /*Tests_SRS_X509_OPENSSL_02_030: [ x509_openssl_pem_release shall drop a reference, and free the string and the objects parsed from it when the last reference is released. ]*/
+    TEST_FUNCTION(x509_openssl_pem_acquire_interns_a_copy)
+    {
+        ///arrange
+        const char* result;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_CERTIFICATE_1) + 1));
+
+        ///act
+        result = x509_openssl_pem_acquire(TEST_CERTIFICATE_1);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_NOT_EQUAL(void_ptr, (void*)TEST_CERTIFICATE_1, (void*)result);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_CERTIFICATE_1, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_free(NULL));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        x509_openssl_pem_release(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_02_026: [ If a string with the same content is already interned, x509_openssl_pem_acquire shall add a reference to it and return it. ]*/
+    TEST_FUNCTION(x509_openssl_pem_acquire_with_the_same_content_returns_the_same_copy)
+    {
+        ///arrange
+        char same_content[sizeof(TEST_CERTIFICATE_1)];
+        const char* first;
+        const char* second;
+
+        (void)strcpy(same_content, TEST_CERTIFICATE_1);
+        first = x509_openssl_pem_acquire(TEST_CERTIFICATE_1);
+        umock_c_reset_all_calls();
+
+        ///act
+        second = x509_openssl_pem_acquire(same_content);
+
+        ///assert
+        ASSERT_ARE_EQUAL(void_ptr, (void*)first, (void*)second);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        /*the first release only drops a reference*/
+        x509_openssl_pem_release(second);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        x509_openssl_pem_release(first);
+    }
+
+    /*Tests_SRS_X509_OPENSSL_02_028: [ If any failure occurs, x509_openssl_pem_acquire shall return NULL. ]*/
+    TEST_FUNCTION(x509_openssl_pem_acquire_unhappy_paths)
+    {
+        ///arrange
+        size_t i;
+
+        umock_c_negative_tests_init();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_CERTIFICATE_1) + 1));
+        umock_c_negative_tests_snapshot();
+
+        for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+        {
+            const char* result;
+
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(i);
+
+            ///act
+            result = x509_openssl_pem_acquire(TEST_CERTIFICATE_1);
+
+            ///assert
+            ASSERT_IS_NULL(result);
+        }
+
+        ///clean
+        umock_c_negative_tests_deinit();
+    }
+
+    /*Tests_SRS_X509_OPENSSL_02_029: [ If pem is NULL then x509_openssl_pem_release shall return. ]*/
+    TEST_FUNCTION(x509_openssl_pem_release_with_NULL_pem_returns)
+    {
+        ///arrange
+
+        ///act
+        x509_openssl_pem_release(NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+    }
+
+    /*Tests_SRS_X509_OPENSSL_02_020: [ If certificates was interned by x509_openssl_pem_acquire, x509_openssl_add_certificates shall add the certificates parsed on first use instead of parsing them again. ]*/
+    TEST_FUNCTION(x509_openssl_add_certificates_with_interned_certificates_parses_them_once)
+    {
+        ///arrange
+        int result1;
+        int result2;
+        const char* certificates = x509_openssl_pem_acquire(TEST_CERTIFICATE_1);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(SSL_CTX_get_cert_store(TEST_SSL_CTX));
+        STRICT_EXPECTED_CALL(BIO_new_mem_buf((void*)certificates, (int)strlen(TEST_CERTIFICATE_1)));
+        STRICT_EXPECTED_CALL(PEM_read_bio_X509_AUX(IGNORED_PTR_ARG, NULL, NULL, NULL));
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, sizeof(X509*)));
+        STRICT_EXPECTED_CALL(PEM_read_bio_X509(IGNORED_PTR_ARG, NULL, NULL, NULL))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(ERR_clear_error());
+        STRICT_EXPECTED_CALL(BIO_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(X509_STORE_add_cert(TEST_X509_STORE, IGNORED_PTR_ARG));
+
+        STRICT_EXPECTED_CALL(SSL_CTX_get_cert_store(TEST_SSL_CTX));
+        STRICT_EXPECTED_CALL(X509_STORE_add_cert(TEST_X509_STORE, IGNORED_PTR_ARG));
+
+        ///act
+        result1 = x509_openssl_add_certificates(TEST_SSL_CTX, certificates);
+        result2 = x509_openssl_add_certificates(TEST_SSL_CTX, certificates);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result1);
+        ASSERT_ARE_EQUAL(int, 0, result2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(X509_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        x509_openssl_pem_release(certificates);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_07_008: [ If the key was interned by x509_openssl_pem_acquire, x509_openssl_add_ecc_credentials shall use the EVP_PKEY parsed on first use instead of parsing the key again. ]*/
+    TEST_FUNCTION(x509_openssl_add_ecc_credentials_with_interned_key_parses_it_once)
+    {
+        ///arrange
+        int result1;
+        int result2;
+        const char* key = x509_openssl_pem_acquire(TEST_PRIVATE_CERTIFICATE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(BIO_new_mem_buf((void*)key, (int)strlen(TEST_PRIVATE_CERTIFICATE)));
+        STRICT_EXPECTED_CALL(PEM_read_bio_PrivateKey(IGNORED_PTR_ARG, NULL, NULL, NULL));
+        STRICT_EXPECTED_CALL(BIO_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(SSL_CTX_use_PrivateKey(&TEST_SSL_CTX_STRUCTURE, TEST_PKEY));
+        setup_load_certificate_chain_mocks();
+        STRICT_EXPECTED_CALL(SSL_CTX_use_PrivateKey(&TEST_SSL_CTX_STRUCTURE, TEST_PKEY));
+        setup_load_certificate_chain_mocks();
+
+        ///act
+        result1 = x509_openssl_add_ecc_credentials(&TEST_SSL_CTX_STRUCTURE, TEST_PUBLIC_CERTIFICATE, key);
+        result2 = x509_openssl_add_ecc_credentials(&TEST_SSL_CTX_STRUCTURE, TEST_PUBLIC_CERTIFICATE, key);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result1);
+        ASSERT_ARE_EQUAL(int, 0, result2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(EVP_PKEY_free(TEST_PKEY));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        x509_openssl_pem_release(key);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
 END_TEST_SUITE(x509_openssl_unittests)
 
 
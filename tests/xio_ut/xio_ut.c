@@ -33,9 +33,13 @@ static void my_gballoc_free(void* ptr)
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/constbuffer.h"
 #undef ENABLE_MOCKS
 
 #include "azure_c_shared_utility/xio.h"
+static CONSTBUFFER_HANDLE TEST_CONSTBUFFER_HANDLE = (CONSTBUFFER_HANDLE)0x4243;
+static const unsigned char test_constbuffer_bytes[] = { 0x42, 43 };
+static const CONSTBUFFER test_constbuffer_content = { test_constbuffer_bytes, sizeof(test_constbuffer_bytes) };
 static CONCRETE_IO_HANDLE TEST_CONCRETE_IO_HANDLE = (CONCRETE_IO_HANDLE)0x4242;
 
 #define ENABLE_MOCKS
@@ -49,8 +53,12 @@ MOCK_FUNCTION_WITH_CODE(, int, test_xio_close, CONCRETE_IO_HANDLE, handle, ON_IO
 MOCK_FUNCTION_END(0)
 MOCK_FUNCTION_WITH_CODE(, int, test_xio_send, CONCRETE_IO_HANDLE, handle, const void*, buffer, size_t, size, ON_SEND_COMPLETE, on_send_complete, void*, callback_context)
 MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_send_constbuffer, CONCRETE_IO_HANDLE, handle, CONSTBUFFER_HANDLE, buffer, ON_SEND_COMPLETE, on_send_complete, void*, callback_context)
+MOCK_FUNCTION_END(0)
 MOCK_FUNCTION_WITH_CODE(, void, test_xio_dowork, CONCRETE_IO_HANDLE, handle)
 MOCK_FUNCTION_END()
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_get_statistics, CONCRETE_IO_HANDLE, handle, XIO_STATISTICS*, statistics)
+MOCK_FUNCTION_END(0)
 MOCK_FUNCTION_WITH_CODE(, int, test_xio_setoption, CONCRETE_IO_HANDLE, handle, const char*, optionName, const void*, value)
 MOCK_FUNCTION_END(0)
 
@@ -113,6 +121,33 @@ const IO_INTERFACE_DESCRIPTION test_io_description =
     test_xio_setoption
 };
 
+const IO_INTERFACE_DESCRIPTION test_io_description_with_send_constbuffer =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    test_xio_send_constbuffer
+};
+
+const IO_INTERFACE_DESCRIPTION test_io_description_with_statistics =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    NULL,
+    test_xio_get_statistics
+};
+
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
 
@@ -179,6 +214,10 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_STATISTICS*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_HANDLE, void*);
+
+    REGISTER_GLOBAL_MOCK_RETURN(CONSTBUFFER_GetContent, &test_constbuffer_content);
     
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
@@ -290,7 +329,7 @@ TEST_FUNCTION(when_io_interface_description_is_NULL_then_xio_create_fails)
     ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+/* Tests_SRS_XIO_01_004: [If any io_interface_description member other than the optional concrete_io_send_constbuffer and concrete_io_get_statistics is NULL, xio_create shall return NULL.] */
 TEST_FUNCTION(when_concrete_xio_retrieveoptions_is_NULL_then_xio_create_fails)
 {
     // arrange
@@ -314,7 +353,7 @@ TEST_FUNCTION(when_concrete_xio_retrieveoptions_is_NULL_then_xio_create_fails)
     ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+/* Tests_SRS_XIO_01_004: [If any io_interface_description member other than the optional concrete_io_send_constbuffer and concrete_io_get_statistics is NULL, xio_create shall return NULL.] */
 TEST_FUNCTION(when_concrete_xio_create_is_NULL_then_xio_create_fails)
 {
     // arrange
@@ -338,7 +377,7 @@ TEST_FUNCTION(when_concrete_xio_create_is_NULL_then_xio_create_fails)
     ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+/* Tests_SRS_XIO_01_004: [If any io_interface_description member other than the optional concrete_io_send_constbuffer and concrete_io_get_statistics is NULL, xio_create shall return NULL.] */
 TEST_FUNCTION(when_concrete_xio_destroy_is_NULL_then_xio_create_fails)
 {
     // arrange
@@ -362,7 +401,7 @@ TEST_FUNCTION(when_concrete_xio_destroy_is_NULL_then_xio_create_fails)
     ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+/* Tests_SRS_XIO_01_004: [If any io_interface_description member other than the optional concrete_io_send_constbuffer and concrete_io_get_statistics is NULL, xio_create shall return NULL.] */
 TEST_FUNCTION(when_concrete_xio_open_is_NULL_then_xio_create_fails)
 {
     // arrange
@@ -386,7 +425,7 @@ TEST_FUNCTION(when_concrete_xio_open_is_NULL_then_xio_create_fails)
     ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+/* Tests_SRS_XIO_01_004: [If any io_interface_description member other than the optional concrete_io_send_constbuffer and concrete_io_get_statistics is NULL, xio_create shall return NULL.] */
 TEST_FUNCTION(when_concrete_xio_close_is_NULL_then_xio_create_fails)
 {
     // arrange
@@ -410,7 +449,7 @@ TEST_FUNCTION(when_concrete_xio_close_is_NULL_then_xio_create_fails)
     ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+/* Tests_SRS_XIO_01_004: [If any io_interface_description member other than the optional concrete_io_send_constbuffer and concrete_io_get_statistics is NULL, xio_create shall return NULL.] */
 TEST_FUNCTION(when_concrete_xio_send_is_NULL_then_xio_create_fails)
 {
     // arrange
@@ -434,7 +473,7 @@ TEST_FUNCTION(when_concrete_xio_send_is_NULL_then_xio_create_fails)
     ASSERT_IS_NULL(result);
 }
 
-/* Tests_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+/* Tests_SRS_XIO_01_004: [If any io_interface_description member other than the optional concrete_io_send_constbuffer and concrete_io_get_statistics is NULL, xio_create shall return NULL.] */
 TEST_FUNCTION(when_concrete_xio_dowork_is_NULL_then_xio_create_fails)
 {
     // arrange
@@ -458,7 +497,7 @@ TEST_FUNCTION(when_concrete_xio_dowork_is_NULL_then_xio_create_fails)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+/* Tests_SRS_XIO_01_004: [If any io_interface_description member other than the optional concrete_io_send_constbuffer and concrete_io_get_statistics is NULL, xio_create shall return NULL.] */
 TEST_FUNCTION(when_concrete_xio_setoption_is_NULL_then_xio_create_fails)
 {
     // arrange
@@ -713,6 +752,129 @@ TEST_FUNCTION(when_the_concrete_xio_send_fails_then_xio_send_fails)
     xio_destroy(handle);
 }
 
+/* Tests_SRS_XIO_01_038: [If concrete_io_send returns XIO_SEND_WOULD_BLOCK, xio_send shall return XIO_SEND_WOULD_BLOCK.] */
+TEST_FUNCTION(when_the_concrete_xio_send_would_block_then_xio_send_returns_XIO_SEND_WOULD_BLOCK)
+{
+    // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 43 };
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, send_data, sizeof(send_data), test_on_send_complete, (void*)0x4242))
+        .SetReturn(XIO_SEND_WOULD_BLOCK);
+
+    // act
+    result = xio_send(handle, send_data, sizeof(send_data), test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, XIO_SEND_WOULD_BLOCK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_028: [If xio or buffer is NULL, xio_send_constbuffer shall return a non-zero value.] */
+TEST_FUNCTION(xio_send_constbuffer_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_send_constbuffer(NULL, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_01_028: [If xio or buffer is NULL, xio_send_constbuffer shall return a non-zero value.] */
+TEST_FUNCTION(xio_send_constbuffer_with_NULL_buffer_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_constbuffer, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_send_constbuffer(handle, NULL, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_029: [If the concrete IO implements concrete_io_send_constbuffer, xio_send_constbuffer shall call it, passing down the buffer, on_send_complete and callback_context arguments.] */
+/* Tests_SRS_XIO_01_031: [On success, xio_send_constbuffer shall return 0.] */
+TEST_FUNCTION(xio_send_constbuffer_calls_the_underlying_concrete_io_send_constbuffer)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_constbuffer, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_send_constbuffer(TEST_CONCRETE_IO_HANDLE, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, (void*)0x4242));
+
+    // act
+    result = xio_send_constbuffer(handle, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_030: [Otherwise xio_send_constbuffer shall obtain the buffer content by calling CONSTBUFFER_GetContent and pass it to concrete_io_send.] */
+TEST_FUNCTION(xio_send_constbuffer_without_concrete_io_send_constbuffer_falls_back_to_concrete_io_send)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, test_constbuffer_bytes, sizeof(test_constbuffer_bytes), test_on_send_complete, (void*)0x4242));
+
+    // act
+    result = xio_send_constbuffer(handle, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_032: [If the underlying send fails, xio_send_constbuffer shall return a non-zero value.] */
+TEST_FUNCTION(when_the_concrete_io_send_constbuffer_fails_then_xio_send_constbuffer_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_constbuffer, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_send_constbuffer(TEST_CONCRETE_IO_HANDLE, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, (void*)0x4242))
+        .SetReturn(42);
+
+    // act
+    result = xio_send_constbuffer(handle, TEST_CONSTBUFFER_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
 /* Tests_SRS_XIO_01_011: [No error check shall be performed on buffer and size.] */
 TEST_FUNCTION(xio_send_with_NULL_buffer_and_nonzero_length_passes_the_args_down_and_succeeds)
 {
@@ -993,5 +1155,104 @@ TEST_FUNCTION(xio_retrieveoptions_unhappypaths)
     umock_c_negative_tests_deinit();
 }
 
+/* Tests_SRS_XIO_01_033: [If xio or statistics is NULL, xio_get_statistics shall fail and return a non-zero value.] */
+TEST_FUNCTION(xio_get_statistics_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+
+    // act
+    result = xio_get_statistics(NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_01_033: [If xio or statistics is NULL, xio_get_statistics shall fail and return a non-zero value.] */
+TEST_FUNCTION(xio_get_statistics_with_NULL_statistics_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_statistics, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_get_statistics(handle, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_034: [If the concrete IO does not implement concrete_io_get_statistics, xio_get_statistics shall fail and return a non-zero value.] */
+TEST_FUNCTION(xio_get_statistics_without_concrete_io_get_statistics_fails)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_get_statistics(handle, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_035: [Otherwise xio_get_statistics shall call concrete_io_get_statistics, passing down the statistics argument.] */
+/* Tests_SRS_XIO_01_036: [On success, xio_get_statistics shall return 0.] */
+TEST_FUNCTION(xio_get_statistics_calls_the_underlying_concrete_io_get_statistics)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_statistics, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_get_statistics(TEST_CONCRETE_IO_HANDLE, &statistics));
+
+    // act
+    result = xio_get_statistics(handle, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_037: [If concrete_io_get_statistics fails, xio_get_statistics shall return a non-zero value.] */
+TEST_FUNCTION(when_the_concrete_io_get_statistics_fails_then_xio_get_statistics_fails)
+{
+    // arrange
+    int result;
+    XIO_STATISTICS statistics;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_statistics, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_get_statistics(TEST_CONCRETE_IO_HANDLE, &statistics))
+        .SetReturn(42);
+
+    // act
+    result = xio_get_statistics(handle, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
 
 END_TEST_SUITE(xio_unittests)